@@ -213,6 +213,46 @@ static inline block_t *block_Duplicate( block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Makes the payload of a block shareable.
+ *
+ * Moves the payload of a block into a reference counted buffer, so that
+ * block_Share() can then hand it out without copying.
+ * The given block must not be used anymore, even on error.
+ *
+ * @return the shareable block (possibly the same one if it already was),
+ * or NULL on memory error.
+ */
+VLC_API block_t *block_Shareable(block_t *) VLC_USED;
+
+/**
+ * Shares a block.
+ *
+ * Creates a new block with the same properties and the same payload as a
+ * block returned by block_Shareable() or block_Share(). Only the block header
+ * is allocated: the payload is not copied and becomes read-only as long as it
+ * is shared. Properties, as well as the payload boundaries, can still be
+ * modified independently, and block_Realloc() copies the data if it needs to
+ * grow it. Any other in-place modification of the data requires
+ * block_Unshare() first.
+ *
+ * If the block is not shareable, this is the same as block_Duplicate().
+ *
+ * @return the new block, or NULL on memory error.
+ */
+VLC_API block_t *block_Share(block_t *) VLC_USED;
+
+/**
+ * Gets a writeable block.
+ *
+ * Returns the block itself if its payload is not shared with other blocks,
+ * or a private copy of it otherwise.
+ *
+ * @return the writeable block, or NULL on memory error (the given block is
+ * released in that case).
+ */
+VLC_API block_t *block_Unshare(block_t *) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
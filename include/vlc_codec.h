@@ -47,6 +47,17 @@ typedef struct decoder_owner_sys_t decoder_owner_sys_t;
 
 typedef struct decoder_cc_desc_t decoder_cc_desc_t;
 
+/**
+ * Decoding shortcuts a decoder may take to meet the display deadlines, by
+ * increasing loss of quality
+ */
+enum decoder_skip_hint
+{
+    DECODER_SKIP_NONE = 0,      /**< decode everything */
+    DECODER_SKIP_LOOP_FILTER,   /**< skip the in-loop filtering of non-key frames */
+    DECODER_SKIP_NONREF,        /**< also skip the non-reference frames */
+};
+
 /*
  * BIG FAT WARNING : the code relies in the first 4 members of filter_t
  * and decoder_t to be the same, so if you have anything to add, do it
@@ -187,6 +198,11 @@ struct decoder_t
 
     /* Private structure for the owner of the decoder */
     decoder_owner_sys_t *p_owner;
+
+    /* Tell the decoder which shortcuts (enum decoder_skip_hint) it should
+     * take for the next block to be displayed in time. It is set by the
+     * decoder owner before each pf_decode call and can be ignored. */
+    int                 i_skip_hint;
 };
 
 /* struct for packetizer get_cc polling/decoder queue_cc
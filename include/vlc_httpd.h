@@ -117,6 +117,9 @@ VLC_API void httpd_UrlDelete( httpd_url_t * );
 
 VLC_API char* httpd_ClientIP( const httpd_client_t *cl, char *, int * );
 VLC_API char* httpd_ServerIP( const httpd_client_t *cl, char *, int * );
+/* keep calling back the url with answer->i_body_offset once the answer is
+ * sent, until the callback resets it to 0 (progressive answers) */
+VLC_API void httpd_ClientModeStream( httpd_client_t *cl );
 
 /* High level */
 
@@ -144,6 +147,15 @@ VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, const block_t *p_block );
 VLC_API int httpd_StreamSetHTTPHeaders(httpd_stream_t *, const httpd_header *, size_t);
 
+typedef struct
+{
+    unsigned i_clients;  /**< clients currently receiving the stream */
+    uint64_t i_sent;     /**< bytes sent to the clients */
+    uint64_t i_dropped;  /**< bytes skipped by clients lagging too far behind */
+    unsigned i_overruns; /**< number of times a client had to skip data */
+} httpd_stream_stats_t;
+VLC_API void httpd_StreamGetStats( httpd_stream_t *, httpd_stream_stats_t * );
+
 /* Msg functions facilities */
 VLC_API void httpd_MsgAdd( httpd_message_t *, const char *psz_name, const char *psz_value, ... ) VLC_FORMAT( 3, 4 );
 /* return "" if not found. The string is not allocated */
@@ -421,6 +421,10 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Decoding shortcuts */
+    int64_t i_hurried_video;  /* decoded without loop filter to be in time */
+    int64_t i_skipped_video;  /* decoded skipping non-reference frames */
 };
 
 /**
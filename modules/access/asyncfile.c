@@ -0,0 +1,887 @@
+/*****************************************************************************
+ * asyncfile.c: asynchronous file input
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_EVENTFD_H
+# include <sys/eventfd.h>
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <linux/io_uring.h>
+# if defined(__NR_io_uring_setup) && defined(HAVE_SYS_EVENTFD_H)
+#  define HAVE_IO_URING 1
+# endif
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_access.h>
+#include <vlc_fs.h>
+#include <vlc_interrupt.h>
+
+/*
+ * The file is read in blocks of a fixed size, several of them in flight at
+ * once, so that the demuxer only waits for the disk when it consumes data
+ * faster than it can be read. The reads are queued in file order from the
+ * reading position. Seeking outside of the queued range cancels them.
+ *
+ * The reads are done by io_uring where available, by a few threads calling
+ * pread() otherwise. Either way, completions are signaled on a file
+ * descriptor so that the demuxer waits for them interruptibly.
+ */
+
+#define BLOCK_ALIGN 4096 /* covers the O_DIRECT requirements */
+#define POOL_THREADS_MAX 4
+
+enum slot_state
+{
+    SLOT_IDLE,
+    SLOT_PENDING,
+    SLOT_DONE,
+};
+
+typedef struct
+{
+    uint8_t        *p_buffer;
+    uint64_t        i_offset;
+    struct iovec    iov;
+    ssize_t         i_result;   /* bytes read or -errno */
+    enum slot_state state;
+    bool            b_stale;    /* cancelled, released once completed */
+    bool            b_busy;     /* taken by a pool thread */
+} slot_t;
+
+typedef struct
+{
+    const char *name;
+    int  (*open)(stream_t *);
+    void (*close)(stream_t *);
+    void (*submit)(stream_t *, unsigned);
+    void (*cancel)(stream_t *, unsigned);
+    void (*reap)(stream_t *);
+} backend_t;
+
+struct access_sys_t
+{
+    int         fd;
+    uint64_t    i_size;
+    uint64_t    i_pos;      /* reading position */
+    uint64_t    i_next;     /* offset of the next read to queue */
+
+    size_t      i_block;
+    unsigned    i_depth;
+    slot_t     *slots;
+    unsigned   *queue;      /* queued slots, in file order */
+    unsigned    i_queue_start;
+    unsigned    i_queue_count;
+    unsigned    i_inflight; /* cancelled slots not completed yet */
+
+    int         event[2];   /* readable when reads completed */
+    vlc_mutex_t lock;
+
+    const backend_t *backend;
+    union
+    {
+#ifdef HAVE_IO_URING
+        struct
+        {
+            int       fd;
+            void     *sq_ring;
+            size_t    sq_ring_size;
+            void     *cq_ring;
+            size_t    cq_ring_size;
+            struct io_uring_sqe *sqes;
+            size_t    sqes_size;
+            unsigned *sq_head, *sq_tail, sq_mask, *sq_array;
+            unsigned *cq_head, *cq_tail, cq_mask;
+            struct io_uring_cqe *cqes;
+        } uring;
+#endif
+        struct
+        {
+            vlc_cond_t   wait;
+            vlc_thread_t threads[POOL_THREADS_MAX];
+            unsigned     i_threads;
+            bool         b_quit;
+        } pool;
+    };
+};
+
+/*****************************************************************************
+ * Completion events
+ *****************************************************************************/
+static int EventOpen(access_sys_t *sys)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    sys->event[0] = sys->event[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (sys->event[0] != -1)
+        return 0;
+#endif
+    if (vlc_pipe(sys->event))
+        return -1;
+    fcntl(sys->event[0], F_SETFL, fcntl(sys->event[0], F_GETFL) | O_NONBLOCK);
+    fcntl(sys->event[1], F_SETFL, fcntl(sys->event[1], F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+static void EventClose(access_sys_t *sys)
+{
+    if (sys->event[1] != sys->event[0])
+        vlc_close(sys->event[1]);
+    vlc_close(sys->event[0]);
+}
+
+static void EventSignal(access_sys_t *sys)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    if (sys->event[1] == sys->event[0])
+    {
+        uint64_t val = 1;
+        if (write(sys->event[1], &val, sizeof (val)) < 0) { /* saturated */ }
+        return;
+    }
+#endif
+    /* a full pipe already wakes the reader up */
+    if (write(sys->event[1], &(char){ 0 }, 1) < 0) { }
+}
+
+static void EventClear(access_sys_t *sys)
+{
+    uint64_t buf[8];
+
+    while (read(sys->event[0], buf, sizeof (buf)) > 0);
+}
+
+/*****************************************************************************
+ * io_uring backend
+ *****************************************************************************/
+#ifdef HAVE_IO_URING
+static int UringEnter(int fd, unsigned to_submit, unsigned min_complete,
+                      unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   NULL, 0);
+}
+
+static void UringClose(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->uring.sqes != MAP_FAILED)
+        munmap(sys->uring.sqes, sys->uring.sqes_size);
+    if (sys->uring.cq_ring != MAP_FAILED)
+        munmap(sys->uring.cq_ring, sys->uring.cq_ring_size);
+    if (sys->uring.sq_ring != MAP_FAILED)
+        munmap(sys->uring.sq_ring, sys->uring.sq_ring_size);
+    vlc_close(sys->uring.fd);
+}
+
+static int UringOpen(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    struct io_uring_params params;
+
+    /* room for a cancellation of each read */
+    memset(&params, 0, sizeof (params));
+    sys->uring.fd = syscall(__NR_io_uring_setup, 2 * sys->i_depth, &params);
+    if (sys->uring.fd == -1)
+    {
+        msg_Dbg(access, "io_uring not available: %s", vlc_strerror_c(errno));
+        return VLC_EGENERIC;
+    }
+
+    sys->uring.sq_ring_size = params.sq_off.array
+                            + params.sq_entries * sizeof (unsigned);
+    sys->uring.cq_ring_size = params.cq_off.cqes
+                            + params.cq_entries * sizeof (struct io_uring_cqe);
+    sys->uring.sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+
+    sys->uring.sq_ring = mmap(NULL, sys->uring.sq_ring_size,
+                              PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              sys->uring.fd, IORING_OFF_SQ_RING);
+    sys->uring.cq_ring = mmap(NULL, sys->uring.cq_ring_size,
+                              PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              sys->uring.fd, IORING_OFF_CQ_RING);
+    sys->uring.sqes = mmap(NULL, sys->uring.sqes_size,
+                           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           sys->uring.fd, IORING_OFF_SQES);
+    if (sys->uring.sq_ring == MAP_FAILED || sys->uring.cq_ring == MAP_FAILED
+     || sys->uring.sqes == MAP_FAILED)
+        goto error;
+
+    uint8_t *sq = sys->uring.sq_ring, *cq = sys->uring.cq_ring;
+
+    sys->uring.sq_head = (unsigned *)(sq + params.sq_off.head);
+    sys->uring.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    sys->uring.sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    sys->uring.sq_array = (unsigned *)(sq + params.sq_off.array);
+    sys->uring.cq_head = (unsigned *)(cq + params.cq_off.head);
+    sys->uring.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    sys->uring.cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    sys->uring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    if (syscall(__NR_io_uring_register, sys->uring.fd,
+                IORING_REGISTER_EVENTFD, &sys->event[0], 1))
+    {
+        msg_Dbg(access, "cannot register io_uring event: %s",
+                vlc_strerror_c(errno));
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    UringClose(access);
+    return VLC_EGENERIC;
+}
+
+/* Returns -1 with errno set if the request could not be submitted */
+static int UringPush(stream_t *access, uint8_t opcode, uint64_t addr,
+                     unsigned len, uint64_t off, uint64_t user_data)
+{
+    access_sys_t *sys = access->p_sys;
+    unsigned tail = *sys->uring.sq_tail;
+    unsigned index = tail & sys->uring.sq_mask;
+    struct io_uring_sqe *sqe = &sys->uring.sqes[index];
+
+    /* Requests are submitted one by one, so there is always room */
+    assert(tail - __atomic_load_n(sys->uring.sq_head, __ATOMIC_ACQUIRE)
+           <= sys->uring.sq_mask);
+
+    memset(sqe, 0, sizeof (*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = opcode == IORING_OP_READV ? sys->fd : -1;
+    sqe->addr = addr;
+    sqe->len = len;
+    sqe->off = off;
+    sqe->user_data = user_data;
+    sys->uring.sq_array[index] = index;
+
+    __atomic_store_n(sys->uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    int val;
+    do
+        val = UringEnter(sys->uring.fd, 1, 0, 0);
+    while (val < 0 && errno == EINTR);
+
+    if (val < 1)
+    {   /* The entry was not consumed, take it back */
+        __atomic_store_n(sys->uring.sq_tail, tail, __ATOMIC_RELEASE);
+        if (val == 0)
+            errno = EAGAIN;
+        return -1;
+    }
+    return 0;
+}
+
+static void UringSubmit(stream_t *access, unsigned i)
+{
+    access_sys_t *sys = access->p_sys;
+    slot_t *slot = &sys->slots[i];
+
+    if (UringPush(access, IORING_OP_READV, (uintptr_t)&slot->iov, 1,
+                  slot->i_offset, i + 1))
+    {   /* Out of kernel resources: read synchronously rather than leave the
+         * slot pending forever */
+        msg_Warn(access, "cannot submit read: %s", vlc_strerror_c(errno));
+
+        ssize_t val;
+        do
+            val = pread(sys->fd, slot->iov.iov_base, slot->iov.iov_len,
+                        slot->i_offset);
+        while (val < 0 && errno == EINTR);
+
+        slot->i_result = val < 0 ? -errno : val;
+        slot->state = SLOT_DONE;
+    }
+}
+
+static void UringCancel(stream_t *access, unsigned i)
+{
+    access_sys_t *sys = access->p_sys;
+
+    /* The read completes either way, cancelled or not */
+    sys->slots[i].b_stale = true;
+    (void) UringPush(access, IORING_OP_ASYNC_CANCEL, i + 1, 0, 0, 0);
+}
+
+static void UringReap(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    unsigned head = *sys->uring.cq_head;
+    unsigned tail = __atomic_load_n(sys->uring.cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++)
+    {
+        const struct io_uring_cqe *cqe =
+            &sys->uring.cqes[head & sys->uring.cq_mask];
+
+        if (cqe->user_data == 0)
+            continue; /* cancellation */
+
+        slot_t *slot = &sys->slots[cqe->user_data - 1];
+
+        assert(slot->state == SLOT_PENDING);
+        if (slot->b_stale)
+        {
+            slot->b_stale = false;
+            slot->state = SLOT_IDLE;
+            sys->i_inflight--;
+        }
+        else
+        {
+            slot->i_result = cqe->res;
+            slot->state = SLOT_DONE;
+        }
+    }
+
+    __atomic_store_n(sys->uring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+static const backend_t uring_backend = {
+    "io_uring", UringOpen, UringClose, UringSubmit, UringCancel, UringReap,
+};
+#endif
+
+/*****************************************************************************
+ * Thread pool backend
+ *****************************************************************************/
+static void *PoolThread(void *data)
+{
+    stream_t *access = data;
+    access_sys_t *sys = access->p_sys;
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        slot_t *slot = NULL;
+
+        /* Oldest queued read first */
+        for (unsigned i = 0; i < sys->i_queue_count && slot == NULL; i++)
+        {
+            slot_t *s = &sys->slots[sys->queue[(sys->i_queue_start + i)
+                                               % sys->i_depth]];
+            if (s->state == SLOT_PENDING && !s->b_busy)
+                slot = s;
+        }
+
+        if (slot == NULL)
+        {
+            if (sys->pool.b_quit)
+                break;
+            vlc_cond_wait(&sys->pool.wait, &sys->lock);
+            continue;
+        }
+
+        slot->b_busy = true;
+        vlc_mutex_unlock(&sys->lock);
+
+        ssize_t val;
+        do
+            val = pread(sys->fd, slot->iov.iov_base, slot->iov.iov_len,
+                        slot->i_offset);
+        while (val < 0 && errno == EINTR);
+        if (val < 0)
+            val = -errno;
+
+        vlc_mutex_lock(&sys->lock);
+        slot->b_busy = false;
+        if (slot->b_stale)
+        {
+            slot->b_stale = false;
+            slot->state = SLOT_IDLE;
+            sys->i_inflight--;
+        }
+        else
+        {
+            slot->i_result = val;
+            slot->state = SLOT_DONE;
+        }
+        EventSignal(sys);
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return NULL;
+}
+
+static void PoolClose(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    vlc_mutex_lock(&sys->lock);
+    sys->pool.b_quit = true;
+    vlc_cond_broadcast(&sys->pool.wait);
+    vlc_mutex_unlock(&sys->lock);
+
+    for (unsigned i = 0; i < sys->pool.i_threads; i++)
+        vlc_join(sys->pool.threads[i], NULL);
+    vlc_cond_destroy(&sys->pool.wait);
+}
+
+static int PoolOpen(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    vlc_cond_init(&sys->pool.wait);
+    sys->pool.b_quit = false;
+    sys->pool.i_threads = 0;
+
+    unsigned count = __MIN(sys->i_depth, POOL_THREADS_MAX);
+    while (sys->pool.i_threads < count)
+    {
+        if (vlc_clone(&sys->pool.threads[sys->pool.i_threads], PoolThread,
+                      access, VLC_THREAD_PRIORITY_INPUT))
+            break;
+        sys->pool.i_threads++;
+    }
+
+    if (sys->pool.i_threads == 0)
+    {
+        vlc_cond_destroy(&sys->pool.wait);
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void PoolSubmit(stream_t *access, unsigned i)
+{
+    access_sys_t *sys = access->p_sys;
+
+    VLC_UNUSED(i);
+    vlc_cond_signal(&sys->pool.wait);
+}
+
+static void PoolCancel(stream_t *access, unsigned i)
+{
+    access_sys_t *sys = access->p_sys;
+    slot_t *slot = &sys->slots[i];
+
+    if (slot->b_busy)
+        slot->b_stale = true;
+    else
+    {   /* not started yet */
+        slot->state = SLOT_IDLE;
+        sys->i_inflight--;
+    }
+}
+
+static void PoolReap(stream_t *access)
+{
+    VLC_UNUSED(access); /* done by the threads */
+}
+
+static const backend_t pool_backend = {
+    "thread pool", PoolOpen, PoolClose, PoolSubmit, PoolCancel, PoolReap,
+};
+
+/*****************************************************************************
+ * Read queue
+ *****************************************************************************/
+static slot_t *QueueHead(access_sys_t *sys)
+{
+    assert(sys->i_queue_count > 0);
+    return &sys->slots[sys->queue[sys->i_queue_start]];
+}
+
+/* Removes the oldest read from the queue, cancelling it if still running */
+static void QueuePop(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    unsigned i = sys->queue[sys->i_queue_start];
+    slot_t *slot = &sys->slots[i];
+
+    sys->i_queue_start = (sys->i_queue_start + 1) % sys->i_depth;
+    sys->i_queue_count--;
+
+    if (slot->state == SLOT_PENDING)
+    {
+        sys->i_inflight++;
+        sys->backend->cancel(access, i);
+    }
+    else
+        slot->state = SLOT_IDLE;
+}
+
+/* Queues reads from the next offset until all the slots are used */
+static void QueueFill(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    for (unsigned i = 0; i < sys->i_depth
+                      && sys->i_queue_count < sys->i_depth; i++)
+    {
+        slot_t *slot = &sys->slots[i];
+
+        if (slot->state != SLOT_IDLE)
+            continue;
+
+        if (sys->i_next >= sys->i_size)
+        {   /* The file may be growing */
+            struct stat st;
+
+            if (fstat(sys->fd, &st) || (uint64_t)st.st_size <= sys->i_next)
+                break;
+            sys->i_size = st.st_size;
+        }
+
+        slot->i_offset = sys->i_next;
+        slot->iov.iov_base = slot->p_buffer;
+        slot->iov.iov_len = sys->i_block;
+        slot->state = SLOT_PENDING;
+        sys->i_next += sys->i_block;
+
+        sys->queue[(sys->i_queue_start + sys->i_queue_count) % sys->i_depth] = i;
+        sys->i_queue_count++;
+        sys->backend->submit(access, i);
+    }
+}
+
+/* Drops the queued reads and restarts reading from the given offset */
+static void QueueReset(stream_t *access, uint64_t offset)
+{
+    access_sys_t *sys = access->p_sys;
+
+    while (sys->i_queue_count > 0)
+        QueuePop(access);
+
+    sys->i_queue_start = 0;
+    sys->i_pos = offset;
+    sys->i_next = offset - (offset % sys->i_block);
+}
+
+/* Waits for some reads to complete, returns false if interrupted */
+static bool QueueWait(stream_t *access, bool interruptible)
+{
+    access_sys_t *sys = access->p_sys;
+    struct pollfd ufd = { .fd = sys->event[0], .events = POLLIN };
+    int val;
+
+    vlc_mutex_unlock(&sys->lock);
+    if (interruptible)
+        val = vlc_poll_i11e(&ufd, 1, -1);
+    else
+        while ((val = poll(&ufd, 1, -1)) < 0 && errno == EINTR);
+    EventClear(sys);
+    vlc_mutex_lock(&sys->lock);
+
+    sys->backend->reap(access);
+    return val >= 0;
+}
+
+/*****************************************************************************
+ * Access
+ *****************************************************************************/
+static ssize_t Read(stream_t *access, void *buf, size_t len)
+{
+    access_sys_t *sys = access->p_sys;
+    ssize_t ret = -1;
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        QueueFill(access);
+
+        if (sys->i_queue_count == 0)
+        {
+            if (sys->i_inflight == 0)
+            {   /* end of file */
+                ret = 0;
+                break;
+            }
+            /* wait for the cancelled reads to release their buffers */
+            if (!QueueWait(access, true))
+                break;
+            continue;
+        }
+
+        slot_t *slot = QueueHead(sys);
+
+        if (slot->state == SLOT_PENDING)
+        {
+            if (!QueueWait(access, true))
+                break;
+            continue;
+        }
+
+        assert(slot->state == SLOT_DONE);
+        assert(sys->i_pos >= slot->i_offset);
+
+        if (slot->i_result == -EINTR || slot->i_result == -EAGAIN)
+        {   /* try again */
+            QueueReset(access, sys->i_pos);
+            continue;
+        }
+        if (slot->i_result < 0)
+        {
+            msg_Err(access, "read error: %s",
+                    vlc_strerror_c(-slot->i_result));
+            QueueReset(access, sys->i_pos);
+            ret = 0;
+            break;
+        }
+
+        size_t skip = sys->i_pos - slot->i_offset;
+        if ((size_t)slot->i_result <= skip)
+        {   /* end of file, for now: read again next time */
+            QueueReset(access, sys->i_pos);
+            ret = 0;
+            break;
+        }
+
+        size_t copy = __MIN(len, slot->i_result - skip);
+        memcpy(buf, slot->p_buffer + skip, copy);
+        sys->i_pos += copy;
+
+        if (skip + copy == (size_t)slot->i_result)
+        {
+            if ((size_t)slot->i_result < sys->i_block)
+                QueueReset(access, sys->i_pos); /* short read */
+            else
+                QueuePop(access);
+        }
+        QueueFill(access);
+        ret = copy;
+        break;
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return ret;
+}
+
+static int Seek(stream_t *access, uint64_t offset)
+{
+    access_sys_t *sys = access->p_sys;
+
+    vlc_mutex_lock(&sys->lock);
+    if (sys->i_queue_count > 0 && offset >= QueueHead(sys)->i_offset
+     && offset < sys->i_next)
+    {   /* Keep the reads following the new position */
+        while (offset >= QueueHead(sys)->i_offset + sys->i_block)
+            QueuePop(access);
+        sys->i_pos = offset;
+    }
+    else
+        QueueReset(access, offset);
+    QueueFill(access);
+    vlc_mutex_unlock(&sys->lock);
+    return VLC_SUCCESS;
+}
+
+static int Control(stream_t *access, int query, va_list args)
+{
+    access_sys_t *sys = access->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = true;
+            break;
+
+        case STREAM_GET_SIZE:
+        {
+            struct stat st;
+
+            if (fstat(sys->fd, &st))
+                return VLC_EGENERIC;
+            *va_arg(args, uint64_t *) = st.st_size;
+            break;
+        }
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, int64_t *) =
+                INT64_C(1000) * var_InheritInteger(access, "file-caching");
+            break;
+
+        case STREAM_SET_PAUSE_STATE:
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+    access_sys_t *sys = access->p_sys;
+
+    /* The buffers must not be freed while reads are still running */
+    vlc_mutex_lock(&sys->lock);
+    QueueReset(access, 0);
+    while (sys->i_inflight > 0)
+        QueueWait(access, false);
+    vlc_mutex_unlock(&sys->lock);
+
+    sys->backend->close(access);
+    EventClose(sys);
+    vlc_mutex_destroy(&sys->lock);
+
+    for (unsigned i = 0; i < sys->i_depth; i++)
+        aligned_free(sys->slots[i].p_buffer);
+    free(sys->queue);
+    free(sys->slots);
+    vlc_close(sys->fd);
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+
+    if (access->psz_filepath == NULL)
+        return VLC_EGENERIC;
+
+    int fd = vlc_open(access->psz_filepath, O_RDONLY);
+    if (fd == -1)
+        return VLC_EGENERIC;
+
+    /* Pipes, devices and directories are left to the file module */
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode))
+    {
+        vlc_close(fd);
+        return VLC_EGENERIC;
+    }
+
+    access_sys_t *sys = vlc_obj_malloc(obj, sizeof (*sys));
+    if (unlikely(sys == NULL))
+    {
+        vlc_close(fd);
+        return VLC_ENOMEM;
+    }
+
+    sys->fd = fd;
+    sys->i_size = st.st_size;
+    sys->i_pos = 0;
+    sys->i_next = 0;
+    sys->i_depth = var_InheritInteger(obj, "asyncfile-depth");
+    sys->i_block = var_InheritInteger(obj, "asyncfile-block-size") << 10;
+    sys->i_block = (sys->i_block + BLOCK_ALIGN - 1) & ~(size_t)(BLOCK_ALIGN - 1);
+    sys->i_queue_start = 0;
+    sys->i_queue_count = 0;
+    sys->i_inflight = 0;
+    sys->slots = calloc(sys->i_depth, sizeof (*sys->slots));
+    sys->queue = calloc(sys->i_depth, sizeof (*sys->queue));
+    if (unlikely(sys->slots == NULL || sys->queue == NULL))
+        goto error;
+
+    for (unsigned i = 0; i < sys->i_depth; i++)
+    {
+        sys->slots[i].p_buffer = aligned_alloc(BLOCK_ALIGN, sys->i_block);
+        if (unlikely(sys->slots[i].p_buffer == NULL))
+            goto error;
+        sys->slots[i].state = SLOT_IDLE;
+    }
+
+#ifdef O_DIRECT
+    /* Very large files are usually read once: do not evict everything else
+     * from the page cache for them. */
+    uint64_t direct_size = var_InheritInteger(obj, "asyncfile-direct-size");
+    if (direct_size > 0 && sys->i_size >= (direct_size << 20))
+    {
+        fd = vlc_open(access->psz_filepath, O_RDONLY | O_DIRECT);
+        if (fd != -1)
+        {
+            vlc_close(sys->fd);
+            sys->fd = fd;
+            msg_Dbg(access, "reading without caching");
+        }
+        else /* not supported by the file system */
+            msg_Dbg(access, "cannot use direct I/O: %s",
+                    vlc_strerror_c(errno));
+    }
+#endif
+
+    if (EventOpen(sys))
+        goto error;
+
+    vlc_mutex_init(&sys->lock);
+    access->p_sys = sys;
+
+#ifdef HAVE_IO_URING
+    sys->backend = &uring_backend;
+    if (sys->backend->open(access) == VLC_SUCCESS)
+        goto done;
+#endif
+    sys->backend = &pool_backend;
+    if (sys->backend->open(access) != VLC_SUCCESS)
+    {
+        vlc_mutex_destroy(&sys->lock);
+        EventClose(sys);
+        goto error;
+    }
+#ifdef HAVE_IO_URING
+done:
+#endif
+    msg_Dbg(access, "reading %u blocks of %zu bytes ahead with %s",
+            sys->i_depth, sys->i_block, sys->backend->name);
+
+    access->pf_read = Read;
+    access->pf_block = NULL;
+    access->pf_seek = Seek;
+    access->pf_control = Control;
+    return VLC_SUCCESS;
+
+error:
+    if (sys->slots != NULL)
+        for (unsigned i = 0; i < sys->i_depth; i++)
+            aligned_free(sys->slots[i].p_buffer);
+    free(sys->queue);
+    free(sys->slots);
+    vlc_close(sys->fd);
+    return VLC_ENOMEM;
+}
+
+vlc_module_begin()
+    set_shortname(N_("Async file"))
+    set_description(N_("Asynchronous file input"))
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_ACCESS)
+    /* Only used on request, e.g. asyncfile:///path/to/file */
+    set_capability("access", 0)
+    add_shortcut("asyncfile")
+    set_callbacks(Open, Close)
+
+    add_integer("asyncfile-depth", 8, N_("Reads ahead"),
+                N_("Number of blocks read ahead of the reading position."),
+                true)
+        change_integer_range(1, 64)
+    add_integer("asyncfile-block-size", 512, N_("Block size"),
+                N_("Size of each read (KiB)."), true)
+        change_integer_range(4, 16384)
+    add_integer("asyncfile-direct-size", 0, N_("Direct I/O size"),
+                N_("Files larger than this are read without going through "
+                   "the operating system cache (MiB). 0 disables."), true)
+        change_integer_range(0, INT64_C(1) << 30)
+vlc_module_end()
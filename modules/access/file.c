@@ -43,6 +43,9 @@
 #   include <sys/vfs.h>
 #   include <linux/magic.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #if defined( _WIN32 )
 #   include <io.h>
@@ -69,6 +72,18 @@ struct access_sys_t
     int fd;
 
     bool b_pace_control;
+
+    /* Read-ahead hints, see ReadAhead() */
+    bool     b_readahead;
+    uint64_t i_pos;
+    uint64_t i_readahead_end;
+    size_t   i_readahead_size;
+
+#ifdef HAVE_MMAP
+    /* Mapped mode, see MmapBlock() */
+    uint64_t i_size;
+    size_t   i_page;
+#endif
 };
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -126,8 +141,22 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
+
+/* The read-ahead window starts small after opening or seeking, not to load
+ * data that will not be used, and grows as long as the reads are sequential */
+#define READAHEAD_MIN (256 * 1024)
+#define READAHEAD_MAX (16 * 1024 * 1024)
+
+/* Size of the blocks of mapped pages handed out in mapped mode */
+#define MMAP_BLOCK_SIZE (1024 * 1024)
 
 static ssize_t Read (stream_t *, void *, size_t);
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *);
+#endif
 static int FileSeek (stream_t *, uint64_t);
 static int NoSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
@@ -213,6 +242,10 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+    p_sys->b_readahead = false;
+    p_sys->i_pos = 0;
+    p_sys->i_readahead_end = 0;
+    p_sys->i_readahead_size = READAHEAD_MIN;
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -231,6 +264,22 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_POSIX_FADVISE
+        /* The kernel read-ahead is sized for small reads, the one of the
+         * network file systems even more so. */
+        p_sys->b_readahead = var_InheritBool (p_access, "file-readahead");
+#endif
+#ifdef HAVE_MMAP
+        /* Hand out the mapped pages instead of copying the data. A file
+         * truncated while mapped crashes VLC, hence not by default. */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap"))
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+            p_sys->i_size = st.st_size;
+            p_sys->i_page = sysconf (_SC_PAGESIZE);
+        }
 #endif
     }
     else
@@ -253,7 +302,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_readdir != NULL)
     {
         DirClose (p_this);
         return;
@@ -265,6 +314,31 @@ void FileClose (vlc_object_t * p_this)
 }
 
 
+#ifdef HAVE_POSIX_FADVISE
+/* Asks the kernel to start loading the data following the read position */
+static void ReadAhead (access_sys_t *p_sys)
+{
+    uint64_t i_start = p_sys->i_pos;
+
+    if (p_sys->i_readahead_end > p_sys->i_pos)
+    {
+        /* Wait for half of the window to be consumed */
+        if (p_sys->i_readahead_end - p_sys->i_pos >= p_sys->i_readahead_size / 2)
+            return;
+
+        /* Reads are sequential, look further ahead */
+        i_start = p_sys->i_readahead_end;
+        if (p_sys->i_readahead_size < READAHEAD_MAX)
+            p_sys->i_readahead_size *= 2;
+    }
+
+    uint64_t i_end = p_sys->i_pos + p_sys->i_readahead_size;
+
+    posix_fadvise (p_sys->fd, i_start, i_end - i_start, POSIX_FADV_WILLNEED);
+    p_sys->i_readahead_end = i_end;
+}
+#endif
+
 static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
 {
     access_sys_t *p_sys = p_access->p_sys;
@@ -284,9 +358,65 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
         val = 0;
     }
 
+#ifdef HAVE_POSIX_FADVISE
+    if (p_sys->b_readahead && val > 0)
+    {
+        p_sys->i_pos += val;
+        ReadAhead (p_sys);
+    }
+#endif
     return val;
 }
 
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->i_pos >= p_sys->i_size)
+    {   /* The file may be growing */
+        struct stat st;
+
+        if (fstat (p_sys->fd, &st) == 0)
+            p_sys->i_size = st.st_size;
+        if (p_sys->i_pos >= p_sys->i_size)
+        {
+            *eof = true;
+            return NULL;
+        }
+    }
+
+    uint64_t i_offset = p_sys->i_pos - p_sys->i_pos % p_sys->i_page;
+    size_t i_skip = p_sys->i_pos - i_offset;
+    size_t i_length = __MIN(MMAP_BLOCK_SIZE, p_sys->i_size - i_offset);
+
+    /* Private pages, so that the data can be modified in place */
+    void *addr = mmap (NULL, i_length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       p_sys->fd, i_offset);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+    posix_madvise (addr, i_length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, i_length, POSIX_MADV_WILLNEED);
+
+    block_t *p_block = block_mmap_Alloc ((char *)addr + i_skip,
+                                         i_length - i_skip);
+    if (p_block == NULL)
+        return NULL;
+
+    p_sys->i_pos += p_block->i_buffer;
+#ifdef HAVE_POSIX_FADVISE
+    /* The following blocks are not mapped yet */
+    if (p_sys->b_readahead)
+        ReadAhead (p_sys);
+#endif
+    return p_block;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -296,6 +426,13 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
 
     if (lseek(sys->fd, i_pos, SEEK_SET) == (off_t)-1)
         return VLC_EGENERIC;
+
+    if (sys->b_readahead && (i_pos < sys->i_pos || i_pos > sys->i_readahead_end))
+    {   /* Restart with a small window outside of the current one */
+        sys->i_readahead_end = i_pos;
+        sys->i_readahead_size = READAHEAD_MIN;
+    }
+    sys->i_pos = i_pos;
     return VLC_SUCCESS;
 }
 
@@ -329,6 +466,13 @@ static int FileControl( stream_t *p_access, int i_query, va_list args )
             *pb_bool = p_sys->b_pace_control;
             break;
 
+#ifdef HAVE_MMAP
+        case STREAM_IS_MAPPED:
+            pb_bool = va_arg( args, bool * );
+            *pb_bool = (p_access->pf_block == MmapBlock);
+            break;
+#endif
+
         case STREAM_GET_SIZE:
         {
             struct stat st;
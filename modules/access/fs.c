@@ -39,6 +39,14 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+    add_bool( "file-readahead", true, N_("Read ahead"),
+              N_("Ask the operating system to load the data ahead of the "
+                 "reading position, in a window growing with sequential "
+                 "reads."), true )
+    add_bool( "file-mmap", false, N_("Map files in memory"),
+              N_("Read local files by mapping them in memory, which avoids "
+                 "copying their data. VLC crashes if a file is truncated "
+                 "while being read."), true )
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
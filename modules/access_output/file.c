@@ -39,6 +39,11 @@
 #ifdef __OS2__
 #   include <io.h>      /* setmode() */
 #endif
+#ifdef HAVE_SYS_UIO_H
+#   include <limits.h>
+#   include <sys/uio.h>
+#   define WRITE_BEHIND 1
+#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -56,6 +61,10 @@
 # define _POSIX_REALTIME_SIGNALS (-1)
 #endif
 
+#ifndef IOV_MAX
+# define IOV_MAX 16
+#endif
+
 #define SOUT_CFG_PREFIX "sout-file-"
 
 /*****************************************************************************
@@ -183,6 +192,429 @@ static ssize_t Send(sout_access_out_t *access, block_t *block)
 }
 #endif
 
+#ifdef WRITE_BEHIND
+/*****************************************************************************
+ * Write-behind: the blocks are queued and written by a thread, so that a
+ * slow disk does not stall the muxer until the queue is full. Queued blocks
+ * are written together with writev(). In direct mode, the data is gathered
+ * into aligned chunks written with O_DIRECT, the remainder being written
+ * through the page cache whenever the queue is flushed.
+ *****************************************************************************/
+#define DIRECT_ALIGN 4096
+#define DIRECT_CHUNK (1 << 20)
+
+struct sout_access_out_sys_t
+{
+    int          fd;
+    int          fd_direct;  /* -1 if not in direct mode */
+    uint64_t     i_offset;   /* file offset of the next queued byte */
+
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait_data;
+    vlc_cond_t   wait_space;
+    block_t     *p_queue;
+    block_t    **pp_queue_last;
+    size_t       i_queued;
+    size_t       i_queue_max;
+    bool         b_flush;    /* the queue must be written out */
+    bool         b_writing;
+    bool         b_error;
+    bool         b_quit;
+
+    /* Direct mode chunk, starting at an aligned file offset */
+    uint8_t     *p_chunk;
+    size_t       i_chunk;
+    uint64_t     i_chunk_offset;
+
+    /* Preallocation */
+    uint64_t     i_prealloc;
+    uint64_t     i_prealloc_end;
+};
+
+static void Preallocate( sout_access_out_sys_t *p_sys, uint64_t i_end )
+{
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+    if( p_sys->i_prealloc == 0 || i_end <= p_sys->i_prealloc_end )
+        return;
+
+    uint64_t i_start = __MAX( p_sys->i_offset, p_sys->i_prealloc_end );
+    i_end += p_sys->i_prealloc;
+    /* The file size is left alone, the extra space is released on close */
+    if( fallocate( p_sys->fd, FALLOC_FL_KEEP_SIZE, i_start, i_end - i_start ) )
+        p_sys->i_prealloc = 0; /* not supported by the file system */
+    else
+        p_sys->i_prealloc_end = i_end;
+#else
+    VLC_UNUSED(p_sys); VLC_UNUSED(i_end);
+#endif
+}
+
+/* Restarts the direct mode chunk at the current offset */
+static void ChunkReset( sout_access_out_sys_t *p_sys )
+{
+    uint64_t i_start = p_sys->i_offset - p_sys->i_offset % DIRECT_ALIGN;
+    size_t i_head = p_sys->i_offset - i_start;
+
+    /* The beginning of the aligned block is written again with the chunk */
+    ssize_t val = 0;
+    if( i_head > 0 )
+        val = pread( p_sys->fd, p_sys->p_chunk, i_head, i_start );
+    if( val < (ssize_t)i_head )
+        memset( p_sys->p_chunk + __MAX(val, 0), 0, i_head - __MAX(val, 0) );
+
+    p_sys->i_chunk_offset = i_start;
+    p_sys->i_chunk = i_head;
+}
+
+static int WriteFull( sout_access_out_t *p_access, int fd, const uint8_t *p,
+                      size_t i_size, uint64_t i_offset )
+{
+    while( i_size > 0 )
+    {
+        ssize_t val = pwrite( fd, p, i_size, i_offset );
+        if( val <= 0 )
+        {
+            if( val < 0 && errno == EINTR )
+                continue;
+            msg_Err( p_access, "cannot write: %s", vlc_strerror_c(errno) );
+            return -1;
+        }
+        p += val;
+        i_size -= val;
+        i_offset += val;
+    }
+    return 0;
+}
+
+static int WriteDirect( sout_access_out_t *p_access, block_t *p_block )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for( ; p_block != NULL; p_block = p_block->p_next )
+    {
+        const uint8_t *p = p_block->p_buffer;
+        size_t i_size = p_block->i_buffer;
+
+        Preallocate( p_sys, p_sys->i_offset + i_size );
+
+        while( i_size > 0 )
+        {
+            size_t i_copy = __MIN( i_size, DIRECT_CHUNK - p_sys->i_chunk );
+
+            memcpy( p_sys->p_chunk + p_sys->i_chunk, p, i_copy );
+            p_sys->i_chunk += i_copy;
+            p_sys->i_offset += i_copy;
+            p += i_copy;
+            i_size -= i_copy;
+
+            if( p_sys->i_chunk == DIRECT_CHUNK )
+            {
+                if( WriteFull( p_access, p_sys->fd_direct, p_sys->p_chunk,
+                               DIRECT_CHUNK, p_sys->i_chunk_offset ) )
+                    return -1;
+                p_sys->i_chunk_offset += DIRECT_CHUNK;
+                p_sys->i_chunk = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+static int WriteVector( sout_access_out_t *p_access, block_t *p_block )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    struct iovec iov[IOV_MAX];
+    size_t i_skip = 0; /* already written from the first block */
+
+    while( p_block != NULL )
+    {
+        int i_iov = 0;
+        size_t i_size = 0;
+
+        for( block_t *b = p_block; b != NULL && i_iov < IOV_MAX; b = b->p_next )
+        {
+            size_t i_off = b == p_block ? i_skip : 0;
+
+            if( b->i_buffer == i_off )
+                continue;
+            iov[i_iov].iov_base = b->p_buffer + i_off;
+            iov[i_iov].iov_len = b->i_buffer - i_off;
+            i_size += iov[i_iov].iov_len;
+            i_iov++;
+        }
+        if( i_iov == 0 )
+            break;
+
+        Preallocate( p_sys, p_sys->i_offset + i_size );
+
+        ssize_t val = writev( p_sys->fd, iov, i_iov );
+        if( val <= 0 )
+        {
+            if( val < 0 && errno == EINTR )
+                continue;
+            msg_Err( p_access, "cannot write: %s", vlc_strerror_c(errno) );
+            return -1;
+        }
+        p_sys->i_offset += val;
+
+        /* Skip what was written */
+        i_skip += val;
+        while( p_block != NULL && i_skip >= p_block->i_buffer )
+        {
+            i_skip -= p_block->i_buffer;
+            p_block = p_block->p_next;
+        }
+    }
+    return 0;
+}
+
+static void *WriteThread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        while( p_sys->p_queue == NULL && !p_sys->b_flush && !p_sys->b_quit )
+            vlc_cond_wait( &p_sys->wait_data, &p_sys->lock );
+
+        block_t *p_chain = p_sys->p_queue;
+        size_t i_size = p_sys->i_queued;
+        bool b_flush = p_sys->b_flush;
+
+        if( p_chain == NULL && !b_flush )
+            break; /* quitting */
+
+        p_sys->p_queue = NULL;
+        p_sys->pp_queue_last = &p_sys->p_queue;
+        p_sys->b_writing = true;
+        vlc_mutex_unlock( &p_sys->lock );
+
+        int i_ret = 0;
+        if( p_chain != NULL )
+        {
+            if( p_sys->fd_direct != -1 )
+                i_ret = WriteDirect( p_access, p_chain );
+            else
+                i_ret = WriteVector( p_access, p_chain );
+            block_ChainRelease( p_chain );
+        }
+
+        /* Write the incomplete chunk through the page cache, it will be
+         * written again once complete. */
+        if( b_flush && i_ret == 0 && p_sys->fd_direct != -1 )
+            i_ret = WriteFull( p_access, p_sys->fd, p_sys->p_chunk,
+                               p_sys->i_chunk, p_sys->i_chunk_offset );
+
+        vlc_mutex_lock( &p_sys->lock );
+        p_sys->b_writing = false;
+        if( i_ret )
+            p_sys->b_error = true;
+        p_sys->i_queued -= i_size;
+        if( b_flush && p_sys->p_queue == NULL )
+            p_sys->b_flush = false;
+        vlc_cond_broadcast( &p_sys->wait_space );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
+/* Waits for all the queued data to be written */
+static int Flush( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_flush = true;
+    vlc_cond_signal( &p_sys->wait_data );
+    while( p_sys->b_flush || p_sys->b_writing )
+        vlc_cond_wait( &p_sys->wait_space, &p_sys->lock );
+    int i_ret = p_sys->b_error ? -1 : 0;
+    vlc_mutex_unlock( &p_sys->lock );
+    return i_ret;
+}
+
+static ssize_t WriteBehind( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_size = 0;
+
+    for( block_t *b = p_buffer; b != NULL; b = b->p_next )
+        i_size += b->i_buffer;
+
+    vlc_mutex_lock( &p_sys->lock );
+    /* Block until there is room, but always accept a chain in an empty
+     * queue so that large blocks go through */
+    while( p_sys->i_queued > 0 && p_sys->i_queued + i_size > p_sys->i_queue_max
+        && !p_sys->b_error )
+        vlc_cond_wait( &p_sys->wait_space, &p_sys->lock );
+
+    if( p_sys->b_error )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        block_ChainRelease( p_buffer );
+        return -1;
+    }
+
+    *p_sys->pp_queue_last = p_buffer;
+    while( p_buffer->p_next != NULL )
+        p_buffer = p_buffer->p_next;
+    p_sys->pp_queue_last = &p_buffer->p_next;
+    p_sys->i_queued += i_size;
+    vlc_cond_signal( &p_sys->wait_data );
+    vlc_mutex_unlock( &p_sys->lock );
+    return i_size;
+}
+
+static ssize_t ReadBehind( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    ssize_t val;
+
+    if( Flush( p_access ) )
+        return -1;
+
+    do
+        val = pread( p_sys->fd, p_buffer->p_buffer, p_buffer->i_buffer,
+                     p_sys->i_offset );
+    while( val == -1 && errno == EINTR );
+
+    /* Writing goes on after the data read */
+    if( val > 0 )
+    {
+        p_sys->i_offset += val;
+        if( p_sys->fd_direct != -1 )
+            ChunkReset( p_sys );
+        /* writev() writes at the file position */
+        else if( lseek( p_sys->fd, p_sys->i_offset, SEEK_SET ) == (off_t)-1 )
+            return -1;
+    }
+    return val;
+}
+
+static int SeekBehind( sout_access_out_t *p_access, off_t i_pos )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( Flush( p_access ) )
+        return -1;
+
+    if( p_sys->fd_direct == -1 )
+    {
+        if( lseek( p_sys->fd, i_pos, SEEK_SET ) == (off_t)-1 )
+            return -1;
+        p_sys->i_offset = i_pos;
+    }
+    else
+    {
+        p_sys->i_offset = i_pos;
+        ChunkReset( p_sys );
+    }
+    return 0;
+}
+
+static void CloseBehind( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    Flush( p_access );
+
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_quit = true;
+    vlc_cond_signal( &p_sys->wait_data );
+    vlc_mutex_unlock( &p_sys->lock );
+    vlc_join( p_sys->thread, NULL );
+
+    /* Release the space preallocated past the end */
+    struct stat st;
+    if( p_sys->i_prealloc_end > 0 && fstat( p_sys->fd, &st ) == 0
+     && (uint64_t)st.st_size < p_sys->i_prealloc_end
+     && ftruncate( p_sys->fd, st.st_size ) )
+        msg_Warn( p_access, "cannot release preallocated space: %s",
+                  vlc_strerror_c(errno) );
+
+    vlc_cond_destroy( &p_sys->wait_space );
+    vlc_cond_destroy( &p_sys->wait_data );
+    vlc_mutex_destroy( &p_sys->lock );
+    if( p_sys->fd_direct != -1 )
+        vlc_close( p_sys->fd_direct );
+    aligned_free( p_sys->p_chunk );
+    vlc_close( p_sys->fd );
+    free( p_sys );
+}
+
+/* Takes ownership of fd_direct, if valid */
+static int OpenBehind( sout_access_out_t *p_access, int fd, int fd_direct,
+                       size_t i_queue_max )
+{
+    sout_access_out_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+    {
+        if( fd_direct != -1 )
+            vlc_close( fd_direct );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->fd = fd;
+    p_sys->fd_direct = fd_direct;
+    p_sys->p_queue = NULL;
+    p_sys->pp_queue_last = &p_sys->p_queue;
+    p_sys->i_queued = 0;
+    p_sys->i_queue_max = i_queue_max;
+    p_sys->b_flush = false;
+    p_sys->b_writing = false;
+    p_sys->b_error = false;
+    p_sys->b_quit = false;
+    p_sys->p_chunk = NULL;
+    p_sys->i_prealloc = (uint64_t)var_GetInteger( p_access,
+                                        SOUT_CFG_PREFIX "prealloc" ) << 20;
+    p_sys->i_prealloc_end = 0;
+
+    off_t i_offset = lseek( fd, 0, SEEK_CUR );
+    p_sys->i_offset = i_offset > 0 ? i_offset : 0;
+
+    if( fd_direct != -1 )
+    {
+        p_sys->p_chunk = aligned_alloc( DIRECT_ALIGN, DIRECT_CHUNK );
+        if( unlikely(p_sys->p_chunk == NULL) )
+        {
+            vlc_close( fd_direct );
+            p_sys->fd_direct = -1;
+        }
+        else
+            ChunkReset( p_sys );
+    }
+
+    vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( &p_sys->wait_data );
+    vlc_cond_init( &p_sys->wait_space );
+
+    p_access->p_sys = p_sys;
+    if( vlc_clone( &p_sys->thread, WriteThread, p_access,
+                   VLC_THREAD_PRIORITY_OUTPUT ) )
+    {
+        vlc_cond_destroy( &p_sys->wait_space );
+        vlc_cond_destroy( &p_sys->wait_data );
+        vlc_mutex_destroy( &p_sys->lock );
+        if( p_sys->fd_direct != -1 )
+            vlc_close( p_sys->fd_direct );
+        aligned_free( p_sys->p_chunk );
+        free( p_sys );
+        p_access->p_sys = (void *)(intptr_t)fd;
+        return VLC_EGENERIC;
+    }
+
+    p_access->pf_read  = ReadBehind;
+    p_access->pf_write = WriteBehind;
+    p_access->pf_seek  = SeekBehind;
+    msg_Dbg( p_access, "writing behind with a %zu bytes queue%s", i_queue_max,
+             p_sys->fd_direct != -1 ? ", without caching" : "" );
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -221,6 +653,11 @@ static const char *const ppsz_sout_options[] = {
     "overwrite",
 #ifdef O_SYNC
     "sync",
+#endif
+#ifdef WRITE_BEHIND
+    "writebehind",
+    "direct",
+    "prealloc",
 #endif
     NULL
 };
@@ -232,6 +669,9 @@ static int Open( vlc_object_t *p_this )
 {
     sout_access_out_t   *p_access = (sout_access_out_t*)p_this;
     int                 fd;
+#ifdef WRITE_BEHIND
+    int                 fd_direct = -1;
+#endif
 
     config_ChainParse( p_access, SOUT_CFG_PREFIX, ppsz_sout_options, p_access->p_cfg );
 
@@ -316,6 +756,16 @@ static int Open( vlc_object_t *p_this )
                                          _("The output file already exists. "
                                          "If recording continues, the file will be "
                                          "overridden and its content will be lost.")) == 1);
+#if defined(WRITE_BEHIND) && defined(O_DIRECT)
+        if (fd != -1 && var_GetInteger (p_access, SOUT_CFG_PREFIX"writebehind") > 0
+         && var_GetBool (p_access, SOUT_CFG_PREFIX"direct"))
+        {
+            fd_direct = vlc_open (path, O_WRONLY | O_LARGEFILE | O_DIRECT);
+            if (fd_direct == -1) /* not supported by the file system */
+                msg_Warn (p_access, "cannot use direct I/O: %s",
+                          vlc_strerror_c(errno));
+        }
+#endif
         free (buf);
         if (fd == -1)
             return VLC_EGENERIC;
@@ -326,6 +776,10 @@ static int Open( vlc_object_t *p_this )
     if (fstat (fd, &st))
     {
         msg_Err (p_access, "write error: %s", vlc_strerror_c(errno));
+#ifdef WRITE_BEHIND
+        if (fd_direct != -1)
+            vlc_close (fd_direct);
+#endif
         vlc_close (fd);
         return VLC_EGENERIC;
     }
@@ -356,6 +810,16 @@ static int Open( vlc_object_t *p_this )
     if (append)
         lseek (fd, 0, SEEK_END);
 
+#ifdef WRITE_BEHIND
+    int64_t queue = var_GetInteger (p_access, SOUT_CFG_PREFIX"writebehind");
+    if (S_ISREG(st.st_mode) && queue > 0)
+    {
+        if (OpenBehind (p_access, fd, fd_direct, (size_t)queue << 10))
+            msg_Warn (p_access, "cannot write behind");
+    }
+    else if (fd_direct != -1)
+        vlc_close (fd_direct);
+#endif
     return VLC_SUCCESS;
 }
 
@@ -366,6 +830,11 @@ static void Close( vlc_object_t * p_this )
 {
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
 
+#ifdef WRITE_BEHIND
+    if( p_access->pf_write == WriteBehind )
+        CloseBehind( p_access );
+    else
+#endif
     vlc_close( (intptr_t)p_access->p_sys );
 
     msg_Dbg( p_access, "file access output closed" );
@@ -382,6 +851,16 @@ static void Close( vlc_object_t * p_this )
     "on the file path")
 #define SYNC_TEXT N_("Synchronous writing")
 #define SYNC_LONGTEXT N_( "Open the file with synchronous writing.")
+#define WRITEBEHIND_TEXT N_("Write-behind queue size (KiB)")
+#define WRITEBEHIND_LONGTEXT N_( "Queue the data and write it to the file " \
+    "in a background thread, in large batches. This sets the amount of " \
+    "data that may be queued. 0 writes synchronously.")
+#define DIRECT_TEXT N_("Direct writing")
+#define DIRECT_LONGTEXT N_( "Bypass the system cache when writing behind " \
+    "to a regular file, if the file system supports it.")
+#define PREALLOC_TEXT N_("Preallocation size (MiB)")
+#define PREALLOC_LONGTEXT N_( "Reserve disk space ahead of the data written " \
+    "behind, to reduce file fragmentation. 0 disables preallocation.")
 
 vlc_module_begin ()
     set_description( N_("File stream output") )
@@ -399,6 +878,16 @@ vlc_module_begin ()
 #ifdef O_SYNC
     add_bool( SOUT_CFG_PREFIX "sync", false, SYNC_TEXT,SYNC_LONGTEXT,
               false )
+#endif
+#ifdef WRITE_BEHIND
+    add_integer( SOUT_CFG_PREFIX "writebehind", 0, WRITEBEHIND_TEXT,
+                 WRITEBEHIND_LONGTEXT, true )
+        change_integer_range( 0, 1 << 20 )
+    add_bool( SOUT_CFG_PREFIX "direct", false, DIRECT_TEXT, DIRECT_LONGTEXT,
+              true )
+    add_integer( SOUT_CFG_PREFIX "prealloc", 0, PREALLOC_TEXT,
+                 PREALLOC_LONGTEXT, true )
+        change_integer_range( 0, 1 << 16 )
 #endif
     set_callbacks( Open, Close )
 vlc_module_end ()
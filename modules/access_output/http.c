@@ -306,6 +306,12 @@ static void Close( vlc_object_t * p_this )
 {
     sout_access_out_t       *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t   *p_sys = p_access->p_sys;
+    httpd_stream_stats_t     stats;
+
+    httpd_StreamGetStats( p_sys->p_httpd_stream, &stats );
+    msg_Dbg( p_access, "%u client(s) connected, %"PRIu64" bytes sent, %"PRIu64
+             " bytes dropped in %u overrun(s)", stats.i_clients,
+             stats.i_sent, stats.i_dropped, stats.i_overruns );
 
     httpd_StreamDelete( p_sys->p_httpd_stream );
     httpd_HostDelete( p_sys->p_httpd_host );
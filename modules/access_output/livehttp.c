@@ -43,6 +43,9 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
+#include <vlc_atomic.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -105,6 +108,19 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define MPD_TEXT N_("DASH manifest")
+#define MPD_LONGTEXT N_("Path to the DASH manifest to create along with the "\
+                        "index when the segments are fragmented MP4 "\
+                        "(mp4frag muxer)")
+
+#define HTTPD_TEXT N_("Serve from memory")
+#define HTTPD_LONGTEXT N_("Keep the index and the segments in memory and "\
+                          "serve them with the built-in HTTP server (see "\
+                          "--http-host and --http-port) instead of writing "\
+                          "files. The index and segment paths are then URL "\
+                          "paths, and the segment being produced can already "\
+                          "be downloaded progressively.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -129,12 +145,16 @@ vlc_module_begin ()
                 INDEX_TEXT, INDEX_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
                 INDEXURL_TEXT, INDEXURL_LONGTEXT, false )
+    add_string( SOUT_CFG_PREFIX "mpd", NULL,
+                MPD_TEXT, MPD_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "key-uri", NULL,
                 KEYURI_TEXT, KEYURI_TEXT, true )
     add_loadfile( SOUT_CFG_PREFIX "key-file", NULL,
                 KEYFILE_TEXT, KEYFILE_LONGTEXT, true )
     add_loadfile( SOUT_CFG_PREFIX "key-loadfile", NULL,
                 KEYLOADFILE_TEXT, KEYLOADFILE_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "httpd", false,
+              HTTPD_TEXT, HTTPD_LONGTEXT, true )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -149,6 +169,7 @@ static const char *const ppsz_sout_options[] = {
     "delsegs",
     "index",
     "index-url",
+    "mpd",
     "ratecontrol",
     "caching",
     "key-uri",
@@ -156,12 +177,26 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "httpd",
     NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
+/* Data of a segment or of the index served from memory. The blocks are not
+ * modified once appended, so that readers can copy them without the lock. */
+typedef struct segment_data
+{
+    vlc_mutex_t lock;
+    atomic_uint refs;
+    const char *psz_mime;
+    block_t *p_first;
+    block_t **pp_last;
+    size_t i_size;
+    bool b_complete;
+} segment_data_t;
+
 typedef struct output_segment
 {
     char *psz_filename;
@@ -169,8 +204,12 @@ typedef struct output_segment
     char *psz_key_uri;
     char *psz_duration;
     float f_seglength;
+    mtime_t i_start;    /* relative to the first segment */
+    uint64_t i_size;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    segment_data_t *p_data;
+    httpd_url_t *p_url;
 } output_segment_t;
 
 struct sout_access_out_sys_t
@@ -186,6 +225,7 @@ struct sout_access_out_sys_t
     uint32_t i_segment;
     size_t  i_seglen;
     float   f_seglen;
+    uint64_t i_segsize;
     block_t *full_segments;
     block_t **full_segments_end;
     block_t *ongoing_segment;
@@ -205,6 +245,27 @@ struct sout_access_out_sys_t
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+    /* Fragmented MP4 (CMAF) segments */
+    bool b_cmaf;
+    char *psz_initPath;
+    char *psz_initUri;
+    char *psz_mpdPath;
+    char *psz_codecs;
+    unsigned i_width;
+    unsigned i_height;
+    bool b_video;
+    mtime_t i_first_opendts;
+    time_t i_availability_start;
+    /* In-memory mode */
+    httpd_host_t *p_host;
+    httpd_url_t *p_index_url;
+    httpd_url_t *p_mpd_url;
+    httpd_url_t *p_init_url;
+    vlc_mutex_t lock;
+    segment_data_t *p_index;
+    segment_data_t *p_mpd;
+    segment_data_t *p_init;
+    segment_data_t *p_segdata;
 };
 
 static int LoadCryptFile( sout_access_out_t *p_access);
@@ -212,6 +273,7 @@ static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static int OpenHttpd( sout_access_out_t *p_access );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -220,6 +282,7 @@ static int Open( vlc_object_t *p_this )
     sout_access_out_t   *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys;
     char *psz_idx;
+    bool b_httpd;
 
     config_ChainParse( p_access, SOUT_CFG_PREFIX, ppsz_sout_options, p_access->p_cfg );
 
@@ -250,6 +313,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
     p_sys->b_segment_has_data = false;
+    b_httpd = var_GetBool( p_access, SOUT_CFG_PREFIX "httpd" );
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -270,11 +334,13 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !b_httpd )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
     p_sys->psz_indexUrl = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index-url" );
+    p_sys->psz_mpdPath  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "mpd" );
+    p_sys->i_first_opendts = VLC_TS_INVALID;
     p_sys->psz_keyfile  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-loadfile" );
     p_sys->key_uri      = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-uri" );
 
@@ -284,6 +350,7 @@ static int Open( vlc_object_t *p_this )
     {
         free( p_sys->psz_indexUrl );
         free( p_sys->psz_indexPath );
+        free( p_sys->psz_mpdPath );
         free( p_sys );
         msg_Err( p_access, "Encryption init failed" );
         return VLC_EGENERIC;
@@ -292,6 +359,7 @@ static int Open( vlc_object_t *p_this )
     {
         free( p_sys->psz_indexUrl );
         free( p_sys->psz_indexPath );
+        free( p_sys->psz_mpdPath );
         free( p_sys );
         msg_Err( p_access, "Encryption init failed" );
         return VLC_EGENERIC;
@@ -301,6 +369,20 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
 
+    if( b_httpd && OpenHttpd( p_access ) )
+    {
+        if( p_sys->key_uri )
+        {
+            gcry_cipher_close( p_sys->aes_ctx );
+            free( p_sys->key_uri );
+        }
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys->psz_mpdPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
@@ -474,7 +556,721 @@ static int CryptKey( sout_access_out_t *p_access, uint32_t i_segment )
 }
 
 
+/*****************************************************************************
+ * In-memory segments served through httpd
+ *****************************************************************************/
+static segment_data_t *segmentDataNew( const char *psz_mime )
+{
+    segment_data_t *p_data = malloc( sizeof( *p_data ) );
+    if( unlikely( p_data == NULL ) )
+        return NULL;
+
+    vlc_mutex_init( &p_data->lock );
+    atomic_init( &p_data->refs, 1 );
+    p_data->psz_mime = psz_mime;
+    p_data->p_first = NULL;
+    p_data->pp_last = &p_data->p_first;
+    p_data->i_size = 0;
+    p_data->b_complete = false;
+    return p_data;
+}
+
+static segment_data_t *segmentDataHold( segment_data_t *p_data )
+{
+    atomic_fetch_add_explicit( &p_data->refs, 1, memory_order_relaxed );
+    return p_data;
+}
+
+static void segmentDataRelease( segment_data_t *p_data )
+{
+    if( atomic_fetch_sub_explicit( &p_data->refs, 1,
+                                   memory_order_acq_rel ) != 1 )
+        return;
+
+    block_ChainRelease( p_data->p_first );
+    vlc_mutex_destroy( &p_data->lock );
+    free( p_data );
+}
+
+static void segmentDataAppend( segment_data_t *p_data, block_t *p_block )
+{
+    vlc_mutex_lock( &p_data->lock );
+    *p_data->pp_last = p_block;
+    p_data->pp_last = &p_block->p_next;
+    p_data->i_size += p_block->i_buffer;
+    vlc_mutex_unlock( &p_data->lock );
+}
+
+static void segmentDataComplete( segment_data_t *p_data )
+{
+    vlc_mutex_lock( &p_data->lock );
+    p_data->b_complete = true;
+    vlc_mutex_unlock( &p_data->lock );
+}
+
+static void segmentDataCopy( const block_t *p_block, size_t i_offset,
+                             uint8_t *p_dst, size_t i_len )
+{
+    while( i_len > 0 )
+    {
+        if( i_offset >= p_block->i_buffer )
+        {
+            i_offset -= p_block->i_buffer;
+            p_block = p_block->p_next;
+            continue;
+        }
+
+        size_t i_copy = __MIN( i_len, p_block->i_buffer - i_offset );
+        memcpy( p_dst, &p_block->p_buffer[i_offset], i_copy );
+        p_dst += i_copy;
+        i_len -= i_copy;
+        i_offset = 0;
+        p_block = p_block->p_next;
+    }
+}
+
+/*****************************************************************************
+ * SegmentCallback: answer a segment request
+ *
+ * A segment still being produced is sent progressively: with chunked
+ * transfer encoding to HTTP/1.1 clients, until the connection is closed to
+ * HTTP/1.0 ones. answer->i_body_offset holds the position of the next byte to
+ * send plus one, and is reset to 0 once the segment is complete.
+ *****************************************************************************/
+static int SegmentCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                            httpd_message_t *answer,
+                            const httpd_message_t *query )
+{
+    segment_data_t *p_data = (segment_data_t *)p_cbsys;
+
+    if( answer == NULL || query == NULL )
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_data->lock );
+    const block_t *p_first = p_data->p_first;
+    size_t i_size = p_data->i_size;
+    bool b_complete = p_data->b_complete;
+    vlc_mutex_unlock( &p_data->lock );
+
+    const bool b_chunked = query->i_version > 0;
+    size_t i_pos = 0;
+
+    if( answer->i_body_offset == 0 )
+    {
+        answer->i_proto  = HTTPD_PROTO_HTTP;
+        answer->i_version= 1;
+        answer->i_type   = HTTPD_MSG_ANSWER;
+        answer->i_status = 200;
+
+        httpd_MsgAdd( answer, "Content-type", "%s", p_data->psz_mime );
+
+        if( query->i_type == HTTPD_MSG_HEAD )
+        {
+            if( b_complete )
+                httpd_MsgAdd( answer, "Content-Length", "%zu", i_size );
+            return VLC_SUCCESS;
+        }
+
+        if( b_complete )
+        {
+            answer->p_body = malloc( i_size );
+            if( likely( answer->p_body != NULL ) )
+            {
+                segmentDataCopy( p_first, 0, answer->p_body, i_size );
+                answer->i_body = i_size;
+            }
+            httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+            return VLC_SUCCESS;
+        }
+
+        httpd_ClientModeStream( cl );
+        if( b_chunked )
+            httpd_MsgAdd( answer, "Transfer-Encoding", "chunked" );
+        else
+            httpd_MsgAdd( answer, "Connection", "close" );
+    }
+    else
+    {
+        i_pos = answer->i_body_offset - 1;
+        if( i_pos >= i_size && !b_complete )
+            return VLC_SUCCESS; /* nothing new yet */
+        answer->i_type = HTTPD_MSG_ANSWER;
+    }
+
+    /* chunk header, chunk trailer and last chunk */
+    size_t i_len = i_size - i_pos;
+    uint8_t *p_body = NULL, *p = NULL;
+    if( i_len > 0 || ( b_complete && b_chunked ) )
+    {
+        p = p_body = malloc( i_len + ( b_chunked ? 32 : 0 ) );
+        if( unlikely( p_body == NULL ) )
+        {
+            answer->i_body_offset = i_pos + 1;
+            return VLC_SUCCESS;
+        }
+    }
+
+    if( i_len > 0 )
+    {
+        if( b_chunked )
+            p += sprintf( (char *)p, "%zx\r\n", i_len );
+        segmentDataCopy( p_first, i_pos, p, i_len );
+        p += i_len;
+        if( b_chunked )
+        {
+            memcpy( p, "\r\n", 2 );
+            p += 2;
+        }
+    }
+    if( b_complete && b_chunked )
+    {
+        memcpy( p, "0\r\n\r\n", 5 );
+        p += 5;
+    }
+
+    answer->p_body = p_body;
+    answer->i_body = p - p_body;
+    answer->i_body_offset = b_complete ? 0 : i_size + 1;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * PublishedCallback: answer with the last published index or manifest
+ *****************************************************************************/
+static int PublishedCallback( sout_access_out_sys_t *p_sys,
+                              segment_data_t **pp_data,
+                              httpd_message_t *answer,
+                              const httpd_message_t *query )
+{
+    if( answer == NULL || query == NULL )
+        return VLC_SUCCESS;
+
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 1;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+
+    vlc_mutex_lock( &p_sys->lock );
+    segment_data_t *p_data = *pp_data;
+    if( p_data != NULL )
+        segmentDataHold( p_data );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    if( p_data == NULL )
+    {
+        answer->i_status = 404;
+        httpd_MsgAdd( answer, "Content-Length", "0" );
+        return VLC_SUCCESS;
+    }
+
+    answer->i_status = 200;
+    httpd_MsgAdd( answer, "Content-type", "%s", p_data->psz_mime );
+    httpd_MsgAdd( answer, "Cache-Control", "%s", "no-cache" );
+
+    if( query->i_type != HTTPD_MSG_HEAD )
+    {
+        answer->p_body = malloc( p_data->i_size );
+        if( likely( answer->p_body != NULL ) )
+        {
+            segmentDataCopy( p_data->p_first, 0, answer->p_body,
+                             p_data->i_size );
+            answer->i_body = p_data->i_size;
+        }
+        httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+    }
+    else
+        httpd_MsgAdd( answer, "Content-Length", "%zu", p_data->i_size );
+
+    segmentDataRelease( p_data );
+    return VLC_SUCCESS;
+}
+
+static int IndexCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                          httpd_message_t *answer,
+                          const httpd_message_t *query )
+{
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_cbsys;
+    VLC_UNUSED(cl);
+
+    return PublishedCallback( p_sys, &p_sys->p_index, answer, query );
+}
+
+static int MpdCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                        httpd_message_t *answer,
+                        const httpd_message_t *query )
+{
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_cbsys;
+    VLC_UNUSED(cl);
+
+    return PublishedCallback( p_sys, &p_sys->p_mpd, answer, query );
+}
+
+/*****************************************************************************
+ * publishData: replace the index or manifest served from memory
+ *****************************************************************************/
+static int publishData( sout_access_out_sys_t *p_sys, segment_data_t **pp_data,
+                        const char *psz_mime, char *psz_data, size_t i_data )
+{
+    segment_data_t *p_data = segmentDataNew( psz_mime );
+    block_t *p_block = block_heap_Alloc( psz_data, i_data );
+    if( unlikely( p_data == NULL || p_block == NULL ) )
+    {
+        if( p_data != NULL )
+            segmentDataRelease( p_data );
+        if( p_block != NULL )
+            block_Release( p_block );
+        return -1;
+    }
+
+    segmentDataAppend( p_data, p_block );
+    p_data->b_complete = true;
+
+    vlc_mutex_lock( &p_sys->lock );
+    segment_data_t *p_old = *pp_data;
+    *pp_data = p_data;
+    vlc_mutex_unlock( &p_sys->lock );
+
+    if( p_old != NULL )
+        segmentDataRelease( p_old );
+    return 0;
+}
+
+/*****************************************************************************
+ * publishSegmentUrl: register the URL of a segment served from memory
+ *****************************************************************************/
+static httpd_url_t *publishSegmentUrl( sout_access_out_t *p_access,
+                                       const char *psz_url,
+                                       segment_data_t *p_data )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    httpd_url_t *p_url = httpd_UrlNew( p_sys->p_host, psz_url, NULL, NULL );
+    if( p_url == NULL )
+    {
+        msg_Err( p_access, "cannot add segment %s", psz_url );
+        return NULL;
+    }
+
+    httpd_UrlCatch( p_url, HTTPD_MSG_GET, SegmentCallback,
+                    (httpd_callback_sys_t *)p_data );
+    httpd_UrlCatch( p_url, HTTPD_MSG_HEAD, SegmentCallback,
+                    (httpd_callback_sys_t *)p_data );
+    return p_url;
+}
+
+/*****************************************************************************
+ * OpenHttpd: start serving the index from memory
+ *****************************************************************************/
+static int OpenHttpd( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->psz_indexPath == NULL || p_sys->psz_indexPath[0] != '/'
+     || p_access->psz_path[0] != '/'
+     || ( p_sys->psz_mpdPath != NULL && p_sys->psz_mpdPath[0] != '/' ) )
+    {
+        msg_Err( p_access, "serving from memory requires the index and the "
+                 "segments to be URL paths" );
+        return VLC_EGENERIC;
+    }
+    if( p_sys->i_numsegs == 0 )
+        msg_Warn( p_access, "all the segments will be kept in memory, "
+                  "consider setting the number of segments" );
+
+    p_sys->p_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if( p_sys->p_host == NULL )
+    {
+        msg_Err( p_access, "cannot start HTTP server" );
+        return VLC_EGENERIC;
+    }
+
+    p_sys->p_index_url = httpd_UrlNew( p_sys->p_host, p_sys->psz_indexPath,
+                                       NULL, NULL );
+    if( p_sys->p_index_url == NULL )
+    {
+        msg_Err( p_access, "cannot add index %s", p_sys->psz_indexPath );
+        httpd_HostDelete( p_sys->p_host );
+        p_sys->p_host = NULL;
+        return VLC_EGENERIC;
+    }
+
+    if( p_sys->psz_mpdPath != NULL )
+    {
+        p_sys->p_mpd_url = httpd_UrlNew( p_sys->p_host, p_sys->psz_mpdPath,
+                                         NULL, NULL );
+        if( p_sys->p_mpd_url == NULL )
+        {
+            msg_Err( p_access, "cannot add manifest %s", p_sys->psz_mpdPath );
+            httpd_UrlDelete( p_sys->p_index_url );
+            httpd_HostDelete( p_sys->p_host );
+            p_sys->p_host = NULL;
+            return VLC_EGENERIC;
+        }
+    }
+
+    vlc_mutex_init( &p_sys->lock );
+    p_sys->p_index = NULL;
+    p_sys->p_mpd = NULL;
+    p_sys->p_init = NULL;
+    p_sys->p_init_url = NULL;
+    p_sys->p_segdata = NULL;
+
+    httpd_UrlCatch( p_sys->p_index_url, HTTPD_MSG_GET, IndexCallback,
+                    (httpd_callback_sys_t *)p_sys );
+    httpd_UrlCatch( p_sys->p_index_url, HTTPD_MSG_HEAD, IndexCallback,
+                    (httpd_callback_sys_t *)p_sys );
+    if( p_sys->p_mpd_url != NULL )
+    {
+        httpd_UrlCatch( p_sys->p_mpd_url, HTTPD_MSG_GET, MpdCallback,
+                        (httpd_callback_sys_t *)p_sys );
+        httpd_UrlCatch( p_sys->p_mpd_url, HTTPD_MSG_HEAD, MpdCallback,
+                        (httpd_callback_sys_t *)p_sys );
+    }
+    return VLC_SUCCESS;
+}
+
+static void CloseHttpd( sout_access_out_sys_t *p_sys )
+{
+    httpd_UrlDelete( p_sys->p_index_url );
+    if( p_sys->p_mpd_url != NULL )
+        httpd_UrlDelete( p_sys->p_mpd_url );
+    if( p_sys->p_init_url != NULL )
+        httpd_UrlDelete( p_sys->p_init_url );
+    if( p_sys->p_index != NULL )
+        segmentDataRelease( p_sys->p_index );
+    if( p_sys->p_mpd != NULL )
+        segmentDataRelease( p_sys->p_mpd );
+    if( p_sys->p_init != NULL )
+        segmentDataRelease( p_sys->p_init );
+    httpd_HostDelete( p_sys->p_host );
+    vlc_mutex_destroy( &p_sys->lock );
+}
+
 #define SEG_NUMBER_PLACEHOLDER "#"
+/*****************************************************************************
+ * Fragmented MP4 (CMAF) segments
+ *****************************************************************************/
+static bool isInitSegment( const block_t *p_buffer )
+{
+    return ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) &&
+           p_buffer->i_buffer >= 8 &&
+           !memcmp( &p_buffer->p_buffer[4], "ftyp", 4 );
+}
+
+/* A fragmented MP4 segment can only start with a moof beginning with a
+ * keyframe, which the muxer flags as such */
+static bool isSplitPoint( const sout_access_out_sys_t *p_sys,
+                          const block_t *p_buffer )
+{
+    if( p_sys->b_cmaf )
+        return p_buffer->i_flags & BLOCK_FLAG_TYPE_I;
+    return p_sys->b_splitanywhere || ( p_buffer->i_flags & BLOCK_FLAG_HEADER );
+}
+
+static const uint8_t *mp4FindBox( const uint8_t *p_data, size_t i_data,
+                                  const char *psz_type, size_t *pi_box )
+{
+    while( i_data >= 8 )
+    {
+        size_t i_box = GetDWBE( p_data );
+        if( i_box < 8 || i_box > i_data )
+            return NULL;
+        if( !memcmp( &p_data[4], psz_type, 4 ) )
+        {
+            *pi_box = i_box - 8;
+            return &p_data[8];
+        }
+        p_data += i_box;
+        i_data -= i_box;
+    }
+    return NULL;
+}
+
+static const uint8_t *mp4FindDescriptor( const uint8_t *p_data, size_t i_data,
+                                         uint8_t i_tag, size_t *pi_desc )
+{
+    size_t i_hdr = 1, i_len = 0;
+
+    if( i_data < 2 || p_data[0] != i_tag )
+        return NULL;
+    for( ;; )
+    {
+        if( i_hdr >= i_data || i_hdr > 4 )
+            return NULL;
+        uint8_t i_byte = p_data[i_hdr++];
+        i_len = ( i_len << 7 ) | ( i_byte & 0x7f );
+        if( !( i_byte & 0x80 ) )
+            break;
+    }
+    if( i_len > i_data - i_hdr )
+        return NULL;
+    *pi_desc = i_len;
+    return &p_data[i_hdr];
+}
+
+/* RFC 6381 codecs parameter of a video sample entry */
+static void mp4VideoCodec( struct vlc_memstream *ms,
+                           const uint8_t *p_entry, size_t i_entry )
+{
+    const uint8_t *p_cfg;
+    size_t i_cfg;
+
+    if( ( p_cfg = mp4FindBox( &p_entry[86], i_entry - 86, "avcC", &i_cfg ) )
+        && i_cfg >= 4 )
+    {
+        vlc_memstream_printf( ms, "%4.4s.%02X%02X%02X", &p_entry[4],
+                              p_cfg[1], p_cfg[2], p_cfg[3] );
+    }
+    else if( ( p_cfg = mp4FindBox( &p_entry[86], i_entry - 86, "hvcC",
+                                   &i_cfg ) ) && i_cfg >= 13 )
+    {
+        static const char *const ppsz_space[] = { "", "A", "B", "C" };
+        uint32_t i_compat = GetDWBE( &p_cfg[2] ), i_reversed = 0;
+        for( int i = 0; i < 32; i++ )
+            i_reversed |= ( ( i_compat >> i ) & 1 ) << ( 31 - i );
+
+        vlc_memstream_printf( ms, "%4.4s.%s%u.%X.%c%u", &p_entry[4],
+                              ppsz_space[p_cfg[1] >> 6], p_cfg[1] & 0x1f,
+                              i_reversed, ( p_cfg[1] & 0x20 ) ? 'H' : 'L',
+                              p_cfg[12] );
+        int i_last = 5;
+        while( i_last >= 0 && p_cfg[6 + i_last] == 0 )
+            i_last--;
+        for( int i = 0; i <= i_last; i++ )
+            vlc_memstream_printf( ms, ".%X", p_cfg[6 + i] );
+    }
+    else
+        vlc_memstream_printf( ms, "%4.4s", &p_entry[4] );
+}
+
+/* RFC 6381 codecs parameter of an audio sample entry */
+static void mp4AudioCodec( struct vlc_memstream *ms,
+                           const uint8_t *p_entry, size_t i_entry )
+{
+    const uint8_t *p_esds, *p_desc;
+    size_t i_esds, i_desc;
+
+    if( !memcmp( &p_entry[4], "Opus", 4 ) )
+    {
+        vlc_memstream_puts( ms, "opus" );
+        return;
+    }
+    if( !memcmp( &p_entry[4], "fLaC", 4 ) )
+    {
+        vlc_memstream_puts( ms, "flac" );
+        return;
+    }
+    if( memcmp( &p_entry[4], "mp4a", 4 ) )
+    {
+        vlc_memstream_printf( ms, "%4.4s", &p_entry[4] );
+        return;
+    }
+
+    /* esds: ES_Descriptor / DecoderConfigDescriptor / DecoderSpecificInfo */
+    p_esds = mp4FindBox( &p_entry[36], i_entry - 36, "esds", &i_esds );
+    if( p_esds == NULL || i_esds < 4 ||
+        !( p_desc = mp4FindDescriptor( &p_esds[4], i_esds - 4, 0x03, &i_desc ) ) ||
+        i_desc < 3 )
+        goto fallback;
+
+    size_t i_skip = 3;
+    if( p_desc[2] & 0x80 )
+        i_skip += 2;
+    if( ( p_desc[2] & 0x40 ) && i_desc > i_skip )
+        i_skip += 1 + p_desc[i_skip];
+    if( p_desc[2] & 0x20 )
+        i_skip += 2;
+    if( i_skip >= i_desc ||
+        !( p_desc = mp4FindDescriptor( &p_desc[i_skip], i_desc - i_skip,
+                                       0x04, &i_desc ) ) || i_desc < 13 )
+        goto fallback;
+
+    uint8_t i_oti = p_desc[0];
+    if( i_oti != 0x40 )
+    {
+        vlc_memstream_printf( ms, "mp4a.%02X", i_oti );
+        return;
+    }
+
+    p_desc = mp4FindDescriptor( &p_desc[13], i_desc - 13, 0x05, &i_desc );
+    if( p_desc == NULL || i_desc < 1 )
+        goto fallback;
+
+    unsigned i_aot = p_desc[0] >> 3;
+    if( i_aot == 31 && i_desc >= 2 )
+        i_aot = 32 + ( ( ( p_desc[0] & 0x07 ) << 3 ) | ( p_desc[1] >> 5 ) );
+    vlc_memstream_printf( ms, "mp4a.40.%u", i_aot );
+    return;
+
+fallback:
+    vlc_memstream_puts( ms, "mp4a.40.2" );
+}
+
+/*****************************************************************************
+ * cmafParseInit: get the codecs and the picture size from the init segment
+ *****************************************************************************/
+static void cmafParseInit( sout_access_out_sys_t *p_sys,
+                           const uint8_t *p_data, size_t i_data )
+{
+    struct vlc_memstream ms;
+    size_t i_moov;
+    const uint8_t *p_moov = mp4FindBox( p_data, i_data, "moov", &i_moov );
+
+    if( p_moov == NULL || vlc_memstream_open( &ms ) )
+        return;
+
+    p_sys->b_video = false;
+    for( ;; )
+    {
+        size_t i_trak, i_mdia, i_hdlr = 0, i_minf = 0, i_stbl = 0, i_stsd = 0;
+        const uint8_t *p_trak = mp4FindBox( p_moov, i_moov, "trak", &i_trak );
+        if( p_trak == NULL )
+            break;
+        i_moov -= &p_trak[i_trak] - p_moov;
+        p_moov = &p_trak[i_trak];
+
+        const uint8_t *p_mdia = mp4FindBox( p_trak, i_trak, "mdia", &i_mdia );
+        if( p_mdia == NULL )
+            continue;
+        const uint8_t *p_hdlr = mp4FindBox( p_mdia, i_mdia, "hdlr", &i_hdlr );
+        const uint8_t *p_minf = mp4FindBox( p_mdia, i_mdia, "minf", &i_minf );
+        const uint8_t *p_stbl = p_minf ? mp4FindBox( p_minf, i_minf, "stbl", &i_stbl ) : NULL;
+        const uint8_t *p_stsd = p_stbl ? mp4FindBox( p_stbl, i_stbl, "stsd", &i_stsd ) : NULL;
+        /* tracks without a handler cannot be classified */
+        if( p_hdlr == NULL || i_hdlr < 12 || p_stsd == NULL || i_stsd < 16 )
+            continue;
+
+        /* first sample entry */
+        const uint8_t *p_entry = &p_stsd[8];
+        size_t i_entry = GetDWBE( p_entry );
+        if( i_entry < 8 || i_entry > i_stsd - 8 )
+            continue;
+
+        if( !memcmp( &p_hdlr[8], "vide", 4 ) && i_entry >= 86 )
+        {
+            if( ms.length > 0 )
+                vlc_memstream_putc( &ms, ',' );
+            mp4VideoCodec( &ms, p_entry, i_entry );
+            p_sys->b_video = true;
+            p_sys->i_width = GetWBE( &p_entry[32] );
+            p_sys->i_height = GetWBE( &p_entry[34] );
+        }
+        else if( !memcmp( &p_hdlr[8], "soun", 4 ) && i_entry >= 36 )
+        {
+            if( ms.length > 0 )
+                vlc_memstream_putc( &ms, ',' );
+            mp4AudioCodec( &ms, p_entry, i_entry );
+        }
+    }
+
+    if( vlc_memstream_close( &ms ) == 0 )
+    {
+        free( p_sys->psz_codecs );
+        p_sys->psz_codecs = ms.ptr;
+    }
+}
+
+/*****************************************************************************
+ * formatInitPath: create the init segment path name
+ *****************************************************************************/
+static char *formatInitPath( char *psz_path )
+{
+    char *psz_result;
+    char *psz_newResult;
+    int ret;
+
+    if ( ! ( psz_result  = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    char *psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    if ( *psz_firstNumSign )
+    {
+        size_t i_cnt = strspn( psz_firstNumSign, SEG_NUMBER_PLACEHOLDER );
+        *psz_firstNumSign = '\0';
+        ret = asprintf( &psz_newResult, "%sinit%s", psz_result, psz_firstNumSign + i_cnt );
+    }
+    else
+        ret = asprintf( &psz_newResult, "%s.init", psz_result );
+    free( psz_result );
+
+    return ret < 0 ? NULL : psz_newResult;
+}
+
+/*****************************************************************************
+ * cmafSetInit: store the init segment of fragmented MP4 segments
+ *****************************************************************************/
+static int cmafSetInit( sout_access_out_t *p_access, block_t *p_init )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->key_uri )
+    {
+        msg_Err( p_access, "AES-128 encryption of fragmented MP4 segments "
+                 "is not supported" );
+        block_Release( p_init );
+        return -1;
+    }
+
+    if( !p_sys->b_cmaf )
+    {
+        char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
+        p_sys->psz_initPath = formatInitPath( p_access->psz_path );
+        p_sys->psz_initUri = formatInitPath( psz_idxFormat );
+        if( unlikely( !p_sys->psz_initPath || !p_sys->psz_initUri ) )
+        {
+            block_Release( p_init );
+            return -1;
+        }
+        p_sys->b_cmaf = true;
+    }
+
+    cmafParseInit( p_sys, p_init->p_buffer, p_init->i_buffer );
+    msg_Dbg( p_access, "fragmented MP4 segments, codecs %s",
+             p_sys->psz_codecs ? p_sys->psz_codecs : "unknown" );
+
+    if( p_sys->p_host )
+    {
+        segment_data_t *p_data = segmentDataNew( "video/mp4" );
+        if( unlikely( p_data == NULL ) )
+        {
+            block_Release( p_init );
+            return -1;
+        }
+        segmentDataAppend( p_data, p_init );
+        segmentDataComplete( p_data );
+
+        if( p_sys->p_init_url )
+            httpd_UrlDelete( p_sys->p_init_url );
+        if( p_sys->p_init )
+            segmentDataRelease( p_sys->p_init );
+        p_sys->p_init = p_data;
+        p_sys->p_init_url = publishSegmentUrl( p_access, p_sys->psz_initPath,
+                                               p_data );
+        return p_sys->p_init_url ? 0 : -1;
+    }
+
+    int fd = vlc_open( p_sys->psz_initPath, O_WRONLY | O_CREAT | O_LARGEFILE |
+                       O_TRUNC, 0666 );
+    if ( fd == -1 )
+    {
+        msg_Err( p_access, "cannot open `%s' (%s)", p_sys->psz_initPath,
+                 vlc_strerror_c(errno) );
+        block_Release( p_init );
+        return -1;
+    }
+
+    ssize_t val = vlc_write( fd, p_init->p_buffer, p_init->i_buffer );
+    vlc_close( fd );
+    if ( val < 0 || (size_t)val != p_init->i_buffer )
+    {
+        msg_Err( p_access, "cannot write `%s'", p_sys->psz_initPath );
+        block_Release( p_init );
+        return -1;
+    }
+    block_Release( p_init );
+
+    msg_Dbg( p_access, "LiveHttpInitComplete: %s", p_sys->psz_initPath );
+    return 0;
+}
+
 /*****************************************************************************
  * formatSegmentPath: create segment path name based on seg #
  *****************************************************************************/
@@ -506,6 +1302,10 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
 
 static void destroySegment( output_segment_t *segment )
 {
+    if( segment->p_url )
+        httpd_UrlDelete( segment->p_url );
+    if( segment->p_data )
+        segmentDataRelease( segment->p_data );
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
@@ -555,6 +1355,148 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->f_seglength + (float)(p_sys->i_numsegs * p_sys->i_seglen));
 }
 
+/************************************************************************
+ * writeIndexFile: Replace an index or manifest file with the given content
+ ************************************************************************/
+static int writeIndexFile( sout_access_out_t *p_access, const char *psz_path,
+                           const char *psz_index, size_t i_index )
+{
+    int val;
+    FILE *fp;
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", psz_path ) < 0)
+        return -1;
+
+    fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    if ( fwrite( psz_index, 1, i_index, fp ) != i_index )
+    {
+        free( psz_idxTmp );
+        fclose( fp );
+        return -1;
+    }
+    fclose( fp );
+
+    val = vlc_rename ( psz_idxTmp, psz_path);
+
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+    }
+    else
+        msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , psz_path );
+
+    free( psz_idxTmp );
+    return 0;
+}
+
+/************************************************************************
+ * updateMpd: Update the DASH manifest listing the same segments as the index
+ ************************************************************************/
+static int updateMpd( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                      uint32_t i_firstseg, unsigned i_index_offset, bool b_isend )
+{
+    struct vlc_memstream ms;
+    char psz_start[32], psz_now[32];
+    mtime_t i_first = 0, i_end = 0;
+    uint64_t i_bandwidth = 0;
+    time_t now = time( NULL );
+    struct tm tm;
+
+    for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
+    {
+        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, i - i_firstseg + i_index_offset );
+        mtime_t i_length = segment->f_seglength * CLOCK_FREQ;
+
+        if ( i == i_firstseg )
+            i_first = segment->i_start;
+        i_end = segment->i_start + i_length;
+        if ( i_length > 0 && segment->i_size * 8 * CLOCK_FREQ / i_length > i_bandwidth )
+            i_bandwidth = segment->i_size * 8 * CLOCK_FREQ / i_length;
+    }
+
+    strftime( psz_start, sizeof( psz_start ), "%Y-%m-%dT%H:%M:%SZ",
+              gmtime_r( &p_sys->i_availability_start, &tm ) );
+    strftime( psz_now, sizeof( psz_now ), "%Y-%m-%dT%H:%M:%SZ",
+              gmtime_r( &now, &tm ) );
+
+    if ( vlc_memstream_open( &ms ) )
+        return -1;
+
+    vlc_memstream_puts( &ms, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                        "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" "
+                        "profiles=\"urn:mpeg:dash:profile:isoff-live:2011\"" );
+    if ( b_isend )
+        vlc_memstream_printf( &ms, " type=\"static\" mediaPresentationDuration=\"PT%.3fS\"",
+                              (double)i_end / CLOCK_FREQ );
+    else
+        vlc_memstream_printf( &ms, " type=\"dynamic\" availabilityStartTime=\"%s\" publishTime=\"%s\""
+                              " minimumUpdatePeriod=\"PT%zuS\" timeShiftBufferDepth=\"PT%.3fS\"",
+                              psz_start, psz_now, p_sys->i_seglen,
+                              (double)(i_end - i_first) / CLOCK_FREQ );
+    vlc_memstream_printf( &ms, " minBufferTime=\"PT%zuS\">\n"
+                          " <Period id=\"0\" start=\"PT0S\">\n"
+                          "  <AdaptationSet segmentAlignment=\"true\" startWithSAP=\"1\">\n"
+                          "   <Representation id=\"0\" mimeType=\"%s\" bandwidth=\"%"PRIu64"\"",
+                          p_sys->i_seglen, p_sys->b_video ? "video/mp4" : "audio/mp4",
+                          i_bandwidth );
+    if ( p_sys->psz_codecs )
+        vlc_memstream_printf( &ms, " codecs=\"%s\"", p_sys->psz_codecs );
+    if ( p_sys->b_video && p_sys->i_width && p_sys->i_height )
+        vlc_memstream_printf( &ms, " width=\"%u\" height=\"%u\"",
+                              p_sys->i_width, p_sys->i_height );
+
+    char *psz_uri = vlc_xml_encode( p_sys->psz_initUri );
+    vlc_memstream_printf( &ms, ">\n"
+                          "    <SegmentList timescale=\"1000\" startNumber=\"%"PRIu32"\">\n"
+                          "     <Initialization sourceURL=\"%s\"/>\n"
+                          "     <SegmentTimeline>\n",
+                          i_firstseg, psz_uri ? psz_uri : "" );
+    free( psz_uri );
+
+    for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
+    {
+        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, i - i_firstseg + i_index_offset );
+        vlc_memstream_printf( &ms, "      <S t=\"%"PRId64"\" d=\"%"PRId64"\"/>\n",
+                              segment->i_start / 1000,
+                              (int64_t)( segment->f_seglength * 1000 ) );
+    }
+    vlc_memstream_puts( &ms, "     </SegmentTimeline>\n" );
+
+    for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
+    {
+        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, i - i_firstseg + i_index_offset );
+        psz_uri = vlc_xml_encode( segment->psz_uri );
+        vlc_memstream_printf( &ms, "     <SegmentURL media=\"%s\"/>\n",
+                              psz_uri ? psz_uri : "" );
+        free( psz_uri );
+    }
+
+    vlc_memstream_puts( &ms, "    </SegmentList>\n"
+                        "   </Representation>\n"
+                        "  </AdaptationSet>\n"
+                        " </Period>\n"
+                        "</MPD>\n" );
+
+    if ( vlc_memstream_close( &ms ) )
+        return -1;
+
+    if ( p_sys->p_host )
+        return publishData( p_sys, &p_sys->p_mpd, "application/dash+xml",
+                            ms.ptr, ms.length );
+
+    int val = writeIndexFile( p_access, p_sys->psz_mpdPath, ms.ptr, ms.length );
+    free( ms.ptr );
+    return val;
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -579,33 +1521,21 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     // First update index
     if ( p_sys->psz_indexPath )
     {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+        struct vlc_memstream ms;
+        if ( vlc_memstream_open( &ms ) )
             return -1;
 
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
-            return -1;
-        }
-
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
-                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", p_sys->i_seglen,
+        vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:%d\n#EXT-X-ALLOW-CACHE:%s"
+                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n", p_sys->i_seglen,
+                          p_sys->b_cmaf ? 7 : 3,
                           p_sys->b_caching ? "YES" : "NO",
                           p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
-                          i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
-        {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
-        }
-        char *psz_current_uri=NULL;
-
+                          i_firstseg );
+        if ( p_sys->b_cmaf )
+            vlc_memstream_printf( &ms, "#EXT-X-MAP:URI=\"%s\"\n", p_sys->psz_initUri );
+        if ( (p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg) )
+            vlc_memstream_puts( &ms, "#EXT-X-DISCONTINUITY\n" );
+        const char *psz_current_uri = NULL;
 
         for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
         {
@@ -617,9 +1547,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                 ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
               )
             {
-                int ret = 0;
-                free( psz_current_uri );
-                psz_current_uri = strdup( segment->psz_key_uri );
+                psz_current_uri = segment->psz_key_uri;
                 if( p_sys->b_generate_iv )
                 {
                     unsigned long long iv_hi = segment->aes_ivs[0];
@@ -631,60 +1559,47 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                         iv_lo <<= 8;
                         iv_lo |= segment->aes_ivs[8+j] & 0xff;
                     }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
                                    segment->psz_key_uri, iv_hi, iv_lo );
 
                 } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
                 }
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
         }
-        free( psz_current_uri );
 
         if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
-
-        }
-        fclose( fp );
+            vlc_memstream_puts( &ms, STR_ENDLIST );
 
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+        if ( vlc_memstream_close( &ms ) )
+            return -1;
 
-        if ( val < 0 )
+        if ( p_sys->p_host )
         {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
+            if ( publishData( p_sys, &p_sys->p_index,
+                              "application/vnd.apple.mpegurl",
+                              ms.ptr, ms.length ) )
+                return -1;
         }
         else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
-
-        free( psz_idxTmp );
+        {
+            int val = writeIndexFile( p_access, p_sys->psz_indexPath, ms.ptr, ms.length );
+            free( ms.ptr );
+            if ( val < 0 )
+                return -1;
+        }
     }
 
+    // Then the DASH manifest, for fragmented MP4 segments
+    if ( p_sys->psz_mpdPath && p_sys->b_cmaf &&
+         updateMpd( p_access, p_sys, i_firstseg, i_index_offset, b_isend ) )
+        return -1;
+
     // Then take care of deletion
     // Try to follow pantos draft 11 section 6.2.2
-    while( p_sys->b_delsegs && p_sys->i_numsegs &&
+    while( ( p_sys->b_delsegs || p_sys->p_host ) && p_sys->i_numsegs &&
            isFirstItemRemovable( p_sys, i_firstseg, i_index_offset )
          )
     {
@@ -692,7 +1607,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
          vlc_array_remove( &p_sys->segments_t, 0 );
 
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->p_host )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -705,12 +1620,17 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     return 0;
 }
 
+static inline bool isSegmentOpen( const sout_access_out_sys_t *p_sys )
+{
+    return p_sys->i_handle >= 0 || p_sys->p_segdata != NULL;
+}
+
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( isSegmentOpen( p_sys ) )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -722,18 +1642,36 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
 
             if( err ) {
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
+            } else if( p_sys->p_segdata ) {
+                block_t *p_stuffing = block_Alloc( 16 );
+                if( likely( p_stuffing != NULL ) )
+                {
+                    memcpy( p_stuffing->p_buffer, p_sys->stuffing_bytes, 16 );
+                    segmentDataAppend( p_sys->p_segdata, p_stuffing );
+                    p_sys->i_segsize += 16;
+                }
             } else {
 
             int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
             if( ret != 16 )
                 msg_Err( p_access, "Couldn't write 16 bytes" );
+            else
+                p_sys->i_segsize += 16;
             }
             p_sys->stuffing_size = 0;
         }
 
 
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        if( p_sys->p_segdata )
+        {
+            segmentDataComplete( p_sys->p_segdata );
+            p_sys->p_segdata = NULL;
+        }
+        else
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", p_sys->f_seglen ) ) )
         {
@@ -741,6 +1679,7 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
             return;
         }
         segment->f_seglength = p_sys->f_seglen;
+        segment->i_size = p_sys->i_segsize;
 
         segment->i_segment_number = p_sys->i_segment;
 
@@ -808,7 +1747,8 @@ static void Close( vlc_object_t * p_this )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
         vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename &&
+            !p_sys->p_host )
         {
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
             vlc_unlink( segment->psz_filename );
@@ -817,6 +1757,15 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    if( p_sys->p_host )
+        CloseHttpd( p_sys );
+    else if( p_sys->b_delsegs && p_sys->i_numsegs && p_sys->psz_initPath )
+        vlc_unlink( p_sys->psz_initPath );
+
+    free( p_sys->psz_initPath );
+    free( p_sys->psz_initUri );
+    free( p_sys->psz_codecs );
+    free( p_sys->psz_mpdPath );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -849,7 +1798,7 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
  *****************************************************************************/
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
 {
-    int fd;
+    int fd = -1;
 
     uint32_t i_newseg = p_sys->i_segment + 1;
 
@@ -859,6 +1808,12 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
 
     segment->i_segment_number = i_newseg;
+    if( p_sys->i_first_opendts == VLC_TS_INVALID )
+    {
+        p_sys->i_first_opendts = p_sys->i_opendts;
+        p_sys->i_availability_start = time( NULL );
+    }
+    segment->i_start = p_sys->i_opendts - p_sys->i_first_opendts;
     segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg );
     char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
     segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg );
@@ -870,9 +1825,26 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
-    if ( fd == -1 )
+    if ( p_sys->p_host )
+    {
+        segment->p_data = segmentDataNew( p_sys->b_cmaf ? "video/mp4"
+                                                        : "video/MP2T" );
+        if ( unlikely( !segment->p_data ) )
+        {
+            destroySegment( segment );
+            return -1;
+        }
+
+        segment->p_url = publishSegmentUrl( p_access, segment->psz_filename,
+                                            segment->p_data );
+        if ( !segment->p_url )
+        {
+            destroySegment( segment );
+            return -1;
+        }
+    }
+    else if ( ( fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT |
+                               O_LARGEFILE | O_TRUNC, 0666 ) ) == -1 )
     {
         msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
                  vlc_strerror_c(errno) );
@@ -898,9 +1870,11 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
 
     p_sys->psz_cursegPath = strdup(segment->psz_filename);
     p_sys->i_handle = fd;
+    p_sys->p_segdata = segment->p_data;
+    p_sys->i_segsize = 0;
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
-    return fd;
+    return p_sys->p_host ? 0 : fd;
 }
 /*****************************************************************************
  * CheckSegmentChange: Check if segment needs to be closed and new opened
@@ -910,7 +1884,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     ssize_t writevalue = 0;
 
-    if( p_sys->i_handle > 0 && p_sys->b_segment_has_data &&
+    if( isSegmentOpen( p_sys ) && p_sys->b_segment_has_data &&
        (( p_buffer->i_length + p_buffer->i_dts - p_sys->i_opendts ) >= p_sys->i_seglenm ) )
     {
         writevalue = writeSegment( p_access );
@@ -923,7 +1897,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !isSegmentOpen( p_sys ) ) )
     {
         p_sys->i_opendts = p_buffer->i_dts;
 
@@ -990,6 +1964,23 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
+        p_sys->f_seglen =
+            (float)(output_last_length +
+                    output->i_dts - p_sys->i_opendts) / CLOCK_FREQ;
+
+        if ( p_sys->p_segdata )
+        {
+            /* The block is handed over to the segment data as is */
+            block_t *p_next = output->p_next;
+            output->p_next = NULL;
+            i_write += output->i_buffer;
+            p_sys->i_segsize += output->i_buffer;
+            segmentDataAppend( p_sys->p_segdata, output );
+            output = p_next;
+            crypted=false;
+            continue;
+        }
+
         ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
         if ( val == -1 )
         {
@@ -998,10 +1989,6 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
            return -1;
         }
 
-        p_sys->f_seglen =
-            (float)(output_last_length +
-                    output->i_dts - p_sys->i_opendts) / CLOCK_FREQ;
-
         if ( (size_t)val >= output->i_buffer )
         {
            block_t *p_next = output->p_next;
@@ -1015,6 +2002,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
            output->i_buffer -= val;
         }
         i_write += val;
+        p_sys->i_segsize += val;
     }
     return i_write;
 }
@@ -1028,10 +2016,24 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     while( p_buffer )
     {
+        /* The fragmented MP4 header goes to its own init segment */
+        if( isInitSegment( p_buffer ) )
+        {
+            block_t *p_next = p_buffer->p_next;
+            p_buffer->p_next = NULL;
+            if( cmafSetInit( p_access, p_buffer ) )
+            {
+                block_ChainRelease( p_next );
+                return -1;
+            }
+            p_buffer = p_next;
+            continue;
+        }
+
         /* Check if current block is already past segment-length
             and we want to write gathered blocks into segment
             and update playlist */
-        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+        if( p_sys->ongoing_segment && isSplitPoint( p_sys, p_buffer ) )
         {
             msg_Dbg( p_access, "Moving ongoing segment to full segments-queue" );
             block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
@@ -1048,6 +2050,20 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
         }
         i_write += ret;
 
+        /* Publish the gathered blocks right away when serving from memory,
+         * so that clients can download the segment while it is produced */
+        if( p_sys->p_segdata && p_sys->full_segments )
+        {
+            ret = writeSegment( p_access );
+            if( ret < 0 )
+            {
+                msg_Err( p_access, "Error in write loop");
+                block_ChainRelease( p_buffer );
+                return ret;
+            }
+            i_write += ret;
+        }
+
         block_t *p_temp = p_buffer->p_next;
         p_buffer->p_next = NULL;
         block_ChainLastAppend( &p_sys->ongoing_segment_end, p_buffer );
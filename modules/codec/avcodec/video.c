@@ -67,6 +67,8 @@ struct decoder_sys_t
     bool b_show_corrupted;
     bool b_from_preroll;
     enum AVDiscard i_skip_frame;
+    enum AVDiscard i_skip_loop_filter;
+    int  i_skip_hint;
 
     /* how many decoded frames are late */
     int     i_late_frames;
@@ -510,6 +512,8 @@ int InitVideoDec( vlc_object_t *obj )
     else if( i_val == 2 ) p_context->skip_loop_filter = AVDISCARD_BIDIR;
     else if( i_val == 1 ) p_context->skip_loop_filter = AVDISCARD_NONREF;
     else p_context->skip_loop_filter = AVDISCARD_DEFAULT;
+    p_sys->i_skip_loop_filter = p_context->skip_loop_filter;
+    p_sys->i_skip_hint = DECODER_SKIP_NONE;
 
     if( var_CreateGetBool( p_dec, "avcodec-fast" ) )
         p_context->flags2 |= AV_CODEC_FLAG2_FAST;
@@ -744,6 +748,28 @@ static bool check_frame_should_be_dropped( decoder_sys_t *p_sys, AVCodecContext
     return false;
 }
 
+/* Takes the shortcuts requested by the decoder owner to meet deadlines */
+static void apply_skip_hint( decoder_t *p_dec, AVCodecContext *p_context )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    const int i_hint = p_dec->b_frame_drop_allowed ? p_dec->i_skip_hint
+                                                   : DECODER_SKIP_NONE;
+
+    if( i_hint >= DECODER_SKIP_LOOP_FILTER )
+        p_context->skip_loop_filter = __MAX( p_sys->i_skip_loop_filter,
+                                             AVDISCARD_NONKEY );
+    else
+        p_context->skip_loop_filter = p_sys->i_skip_loop_filter;
+
+    if( i_hint >= DECODER_SKIP_NONREF )
+        p_context->skip_frame = __MAX( p_context->skip_frame,
+                                       AVDISCARD_NONREF );
+    else if( p_sys->i_skip_hint >= DECODER_SKIP_NONREF && !p_sys->b_hurry_up )
+        p_context->skip_frame = p_sys->i_skip_frame;
+
+    p_sys->i_skip_hint = i_hint;
+}
+
 static mtime_t interpolate_next_pts( decoder_t *p_dec, AVFrame *frame )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -979,6 +1005,7 @@ static picture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block, bool *error
             return NULL;
         }
     }
+    apply_skip_hint( p_dec, p_context );
     if( !b_need_output_picture )
     {
         p_context->skip_frame = __MAX( p_context->skip_frame,
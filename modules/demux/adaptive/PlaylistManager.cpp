@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "logic/BufferingLogic.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
@@ -830,6 +831,16 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             if(predictivelogic)
                 conn->setDownloadRateObserver(predictivelogic);
             logic = predictivelogic;
+            break;
+        }
+        case AbstractAdaptationLogic::Hybrid:
+        {
+            HybridAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(obj);
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
         }
 
         default:
@@ -856,6 +867,9 @@ AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
         v = var_InheritInteger(p_demux, "adaptive-maxbuffer");
         if(v)
             bl->setUserMaxBuffering(CLOCK_FREQ / 1000 * v);
+        int lowlatency = var_InheritInteger(p_demux, "adaptive-lowlatency");
+        if(lowlatency >= 0)
+            bl->setLowDelay(lowlatency > 0);
     }
     return bl;
 }
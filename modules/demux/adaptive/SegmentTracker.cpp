@@ -92,6 +92,11 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNKNOWN;
+    int64_t i_prefetch = var_InheritInteger(adaptSet->getPlaylist()->getVLCObject(),
+                                            "adaptive-prefetch");
+    maxPrefetch = i_prefetch > 0 ? i_prefetch : 0;
+    bufferingCurrent = 0;
+    bufferingTarget = 0;
 }
 
 SegmentTracker::~SegmentTracker()
@@ -203,6 +208,72 @@ void SegmentTracker::reset()
     next = Position();
     initializing = true;
     format = StreamFormat::UNKNOWN;
+    clearPrefetchedChunks();
+}
+
+SegmentChunk * SegmentTracker::getPrefetchedChunk(const Position &pos)
+{
+    SegmentChunk *chunk = NULL;
+    if(!prefetched.empty() &&
+       prefetched.front().first.rep == pos.rep &&
+       prefetched.front().first.number == pos.number)
+    {
+        chunk = prefetched.front().second;
+        prefetched.pop_front();
+    }
+    else clearPrefetchedChunks(); /* switched or moved */
+    return chunk;
+}
+
+void SegmentTracker::prefetchChunks(const Position &pos, const ISegment *segment,
+                                    AbstractConnectionManager *connManager)
+{
+    /* Keep the downloads of the following segments ahead of the demuxer,
+     * as long as they are needed to fill the buffer */
+    const Timescale timescale = pos.rep->inheritTimescale();
+    const mtime_t duration = timescale.ToTime(segment->duration.Get());
+    unsigned count = maxPrefetch;
+    if(duration > 0 && bufferingTarget > 0)
+    {
+        const mtime_t missing = bufferingTarget - bufferingCurrent - duration;
+        count = std::min<mtime_t>(count, std::max<mtime_t>(0, (missing + duration - 1) / duration));
+    }
+
+    /* Live segments can't be requested before they are published */
+    mtime_t available = std::numeric_limits<mtime_t>::max();
+    if(adaptationSet->getPlaylist()->isLive())
+        available = (duration > 0) ? pos.rep->getMinAheadTime(pos.number) : 0;
+
+    uint64_t number = pos.number;
+    if(!prefetched.empty())
+        number = prefetched.back().first.number;
+    count = (count > prefetched.size()) ? count - prefetched.size() : 0;
+    available -= duration * prefetched.size();
+
+    while(count-- > 0 && available >= duration)
+    {
+        bool b_gap;
+        uint64_t found;
+        ISegment *seg = pos.rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                                number + 1, &found, &b_gap);
+        if(!seg || b_gap || seg->discontinuity)
+            break;
+        SegmentChunk *chunk = seg->toChunk(resources, connManager, found, pos.rep);
+        if(!chunk)
+            break;
+        number = found;
+        available -= duration;
+        prefetched.push_back(std::make_pair(Position(pos.rep, number), chunk));
+    }
+}
+
+void SegmentTracker::clearPrefetchedChunks()
+{
+    while(!prefetched.empty())
+    {
+        delete prefetched.front().second;
+        prefetched.pop_front();
+    }
 }
 
 SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
@@ -326,7 +397,11 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next.number, next.rep);
+    SegmentChunk *chunk = getPrefetchedChunk(next);
+    if(!chunk)
+        chunk = segment->toChunk(resources, connManager, next.number, next.rep);
+    if(chunk && maxPrefetch)
+        prefetchChunks(next, segment, connManager);
 
     /* Notify new segment length for stats / logic */
     if(chunk)
@@ -386,6 +461,7 @@ void SegmentTracker::setPosition(const Position &pos, bool restarted)
 {
     if(restarted)
         initializing = true;
+    clearPrefetchedChunks();
     current = Position();
     next = pos;
 }
@@ -468,6 +544,8 @@ void SegmentTracker::notifyBufferingState(bool enabled) const
 
 void SegmentTracker::notifyBufferingLevel(mtime_t min, mtime_t current, mtime_t target) const
 {
+    bufferingCurrent = current;
+    bufferingTarget = target;
     notify(SegmentTrackerEvent(adaptationSet->getID(), min, current, target));
 }
 
@@ -47,6 +47,7 @@ namespace adaptive
         class BaseAdaptationSet;
         class BaseRepresentation;
         class SegmentChunk;
+        class ISegment;
     }
 
     using namespace playlist;
@@ -159,6 +160,10 @@ namespace adaptive
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            SegmentChunk * getPrefetchedChunk(const Position &);
+            void prefetchChunks(const Position &, const ISegment *,
+                                AbstractConnectionManager *);
+            void clearPrefetchedChunks();
             bool first;
             bool initializing;
             Position current;
@@ -169,6 +174,10 @@ namespace adaptive
             const AbstractBufferingLogic *bufferingLogic;
             BaseAdaptationSet *adaptationSet;
             std::list<SegmentTrackerListenerInterface *> listeners;
+            std::list<std::pair<Position, SegmentChunk *> > prefetched;
+            unsigned maxPrefetch;
+            mutable mtime_t bufferingCurrent;
+            mutable mtime_t bufferingTarget;
     };
 }
 
@@ -79,9 +79,19 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
+#define ADAPT_STARTUP_TEXT N_("Startup buffering (ms)")
+#define ADAPT_STARTUP_LONGTEXT N_("Buffer level under which the buffer and bandwidth adaptive logic " \
+                                  "only relies on the download rate")
+
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_DOWNLOADS_TEXT N_("Parallel downloads")
+#define ADAPT_DOWNLOADS_LONGTEXT N_("Maximum number of segments downloaded at the same time, over all streams")
+
+#define ADAPT_PREFETCH_TEXT N_("Segments prefetched per stream")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of segments requested ahead of the one being played, while the buffer is not full")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
@@ -89,6 +99,7 @@ static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
                                 AbstractAdaptationLogic::NearOptimal,
+                                AbstractAdaptationLogic::Hybrid,
                                 AbstractAdaptationLogic::RateBased,
                                 AbstractAdaptationLogic::FixedRate,
                                 AbstractAdaptationLogic::AlwaysLowest,
@@ -98,6 +109,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -106,6 +118,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Buffer and Bandwidth Adaptive"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -143,6 +156,14 @@ vlc_module_begin ()
         add_integer( "adaptive-maxbuffer",
                      AbstractBufferingLogic::DEFAULT_MAX_BUFFERING  / 1000,
                      ADAPT_MAXBUFFER_TEXT, NULL, true );
+        add_integer( "adaptive-startup-buffer", 10000,
+                     ADAPT_STARTUP_TEXT, ADAPT_STARTUP_LONGTEXT, true )
+        add_integer( "adaptive-downloads", 4,
+                     ADAPT_DOWNLOADS_TEXT, ADAPT_DOWNLOADS_LONGTEXT, true )
+            change_integer_range( 1, 16 )
+        add_integer( "adaptive-prefetch", 2,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT, true )
+            change_integer_range( 0, 8 )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, true );
             change_integer_list(rgi_latency, ppsz_latency)
         set_callbacks( Open, Close )
@@ -156,7 +156,7 @@ HTTPChunkSource::HTTPChunkSource(const std::string& url, AbstractConnectionManag
 HTTPChunkSource::~HTTPChunkSource()
 {
     if(connection)
-        connection->setUsed(false);
+        connManager->recycleConnection(connection);
     vlc_mutex_destroy(&lock);
 }
 
@@ -223,7 +223,8 @@ block_t * HTTPChunkSource::read(size_t readsize)
     {
         p_block->i_buffer = (size_t) ret;
         consumed += p_block->i_buffer;
-        if((size_t)ret < readsize)
+        /* chunked transfers can return short reads before the end */
+        if(ret == 0 || consumed == contentLength)
             eof = true;
         if(ret && time)
             connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
@@ -269,7 +270,7 @@ bool HTTPChunkSource::prepare()
                 HTTPConnection *httpconn = dynamic_cast<HTTPConnection *>(connection);
                 if(httpconn)
                     connparams = httpconn->getRedirection();
-                connection->setUsed(false);
+                connManager->recycleConnection(connection);
                 connection = NULL;
                 if(httpconn)
                     continue;
@@ -394,10 +395,22 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     else
     {
         p_block->i_buffer = (size_t) ret;
+        if((size_t) ret < readsize / 4)
+        {
+            /* don't queue mostly empty blocks from small transfer chunks */
+            block_t *p_small = block_Alloc(ret);
+            if(p_small)
+            {
+                memcpy(p_small->p_buffer, p_block->p_buffer, ret);
+                block_Release(p_block);
+                p_block = p_small;
+            }
+        }
         vlc_mutex_locker locker( &lock );
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        /* chunked transfers can return short reads before the end */
+        if(contentLength && buffered + consumed == contentLength)
         {
             done = true;
             rate.size = buffered + consumed;
@@ -28,37 +28,41 @@
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Downloader(unsigned threads)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
+    vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
+    max_threads = threads ? threads : 1;
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(thread_handles.size() < max_threads)
     {
-        return false;
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        thread_handles.push_back(thread_handle);
     }
-    thread_handle_valid = true;
-    return true;
+    return !thread_handles.empty();
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    std::vector<vlc_thread_t>::const_iterator it;
+    for(it = thread_handles.begin(); it != thread_handles.end(); ++it)
+        vlc_join(*it, NULL);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
+    vlc_cond_destroy(&updatedcond);
 }
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
@@ -72,6 +76,9 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
+    /* wait for the current read on this source to complete */
+    while(isDownloading(source))
+        vlc_cond_wait(&updatedcond, &lock);
     source->release();
     chunks.remove(source);
     vlc_mutex_unlock(&lock);
@@ -92,27 +99,57 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+bool Downloader::isDownloading(const HTTPChunkBufferedSource *source) const
+{
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = downloading.begin(); it != downloading.end(); ++it)
+        if(*it == source)
+            return true;
+    return false;
+}
+
+HTTPChunkBufferedSource * Downloader::getNextSource() const
+{
+    /* Sources are served in scheduling order, so the segments being
+     * played always come before the ones prefetched after them. A source
+     * can only be read by one thread at a time. */
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = chunks.begin(); it != chunks.end(); ++it)
+        if(!isDownloading(*it))
+            return *it;
+    return NULL;
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source;
+        while(!killed && (source = getNextSource()) == NULL)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        downloading.push_back(source);
+        vlc_mutex_unlock(&lock);
+
+        DownloadSource(source);
+
+        vlc_mutex_lock(&lock);
+        downloading.remove(source);
+        if(source->isDone())
+        {
+            chunks.remove(source);
+            source->release();
+        }
+        else
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
-            if(source->isDone())
-            {
-                chunks.pop_front();
-                source->release();
-            }
+            /* let an idle thread take over */
+            vlc_cond_signal(&waitcond);
         }
+        vlc_cond_broadcast(&updatedcond);
     }
     vlc_mutex_unlock(&lock);
 }
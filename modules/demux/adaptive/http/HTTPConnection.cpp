@@ -229,7 +229,9 @@ ssize_t HTTPConnection::read(void *p_buffer, size_t len)
     if(ret >= 0)
         bytesRead += ret;
 
-    if(ret < 0 || (size_t)ret < len || /* set EOF */
+    /* short reads are only EOF without chunked transfer */
+    if(ret < 0 || /* set EOF */
+       (chunked ? (ret == 0 || chunked_eof) : (size_t)ret < len) ||
        (contentLength == bytesRead && connectionClose))
     {
         transport->disconnect();
@@ -351,6 +353,10 @@ ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
             ssize_t in = transport->read(&crlf, 2);
             if(in < 2 || memcmp(crlf, "\r\n", 2))
                 return (copied == 0) ? -1 : copied;
+            /* Don't block on next chunk: data is pushed as produced
+               by server (chunked CMAF, low latency parts) */
+            if(copied > 0)
+                break;
         }
     }
 
@@ -64,8 +64,10 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    int64_t i_downloads = var_InheritInteger(p_object, "adaptive-downloads");
+    downloader = new (std::nothrow) Downloader(i_downloads > 0 ? i_downloads : 1);
+    if(downloader)
+        downloader->start();
     factory = new ConnectionFactory(storage);
 }
 
@@ -142,6 +144,14 @@ AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &para
     return conn;
 }
 
+void HTTPConnectionManager::recycleConnection(AbstractConnection *conn)
+{
+    /* Connections are released from the downloader threads */
+    vlc_mutex_lock(&lock);
+    conn->setUsed(false);
+    vlc_mutex_unlock(&lock);
+}
+
 void HTTPConnectionManager::start(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
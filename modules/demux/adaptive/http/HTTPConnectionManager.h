@@ -50,6 +50,7 @@ namespace adaptive
                 ~AbstractConnectionManager();
                 virtual void    closeAllConnections () = 0;
                 virtual AbstractConnection * getConnection(ConnectionParams &) = 0;
+                virtual void    recycleConnection(AbstractConnection *) = 0;
                 virtual void start(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
 
@@ -71,6 +72,7 @@ namespace adaptive
 
                 virtual void    closeAllConnections () /* impl */;
                 virtual AbstractConnection * getConnection(ConnectionParams &) /* impl */;
+                virtual void    recycleConnection(AbstractConnection *) /* impl */;
 
                 virtual void start(AbstractChunkSource *) /* impl */;
                 virtual void cancel(AbstractChunkSource *) /* impl */;
@@ -38,6 +38,7 @@ using namespace adaptive::playlist;
 using namespace adaptive::logic;
 
 const mtime_t AbstractBufferingLogic::BUFFERING_LOWEST_LIMIT = CLOCK_FREQ * 2;
+const mtime_t AbstractBufferingLogic::LOWLATENCY_MIN_BUFFERING = CLOCK_FREQ;
 const mtime_t AbstractBufferingLogic::DEFAULT_MIN_BUFFERING = CLOCK_FREQ * 6;
 const mtime_t AbstractBufferingLogic::DEFAULT_MAX_BUFFERING = CLOCK_FREQ * 30;
 const mtime_t AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING = CLOCK_FREQ * 15;
@@ -103,7 +104,7 @@ uint64_t DefaultBufferingLogic::getStartSegmentNumber(BaseRepresentation *rep) c
 mtime_t DefaultBufferingLogic::getMinBuffering(const AbstractPlaylist *p) const
 {
     if(isLowLatency(p))
-        return BUFFERING_LOWEST_LIMIT;
+        return LOWLATENCY_MIN_BUFFERING;
 
     mtime_t buffering = userMinBuffering ? userMinBuffering
                                          : DEFAULT_MIN_BUFFERING;
@@ -129,7 +130,14 @@ mtime_t DefaultBufferingLogic::getMaxBuffering(const AbstractPlaylist *p) const
 mtime_t DefaultBufferingLogic::getLiveDelay(const AbstractPlaylist *p) const
 {
     if(isLowLatency(p))
-        return getMinBuffering(p);
+    {
+        /* Use the server advertised hold back (parts or chunks
+           duration based), and never more than the regular delay */
+        mtime_t delay = userLiveDelay ? userLiveDelay
+                                      : p->suggestedPresentationDelay.Get();
+        delay = std::min(delay, DEFAULT_LIVE_BUFFERING);
+        return std::max(delay, getMinBuffering(p));
+    }
     mtime_t delay = userLiveDelay ? userLiveDelay
                                   : DEFAULT_LIVE_BUFFERING;
     if(p->suggestedPresentationDelay.Get())
@@ -149,7 +157,8 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
     /* Try to never buffer up to really end */
     /* Enforce no overlap for demuxers segments 3.0.0 */
     /* FIXME: check duration instead ? */
-    const unsigned SAFETY_BUFFERING_EDGE_OFFSET = 1;
+    /* Incomplete segments at edge (chunked transfer) can be read while produced */
+    const unsigned SAFETY_BUFFERING_EDGE_OFFSET = rep->inheritAvailabilityTimeComplete() ? 1 : 0;
     const unsigned SAFETY_EXPURGING_OFFSET = 2;
 
     SegmentList *segmentList = rep->inheritSegmentList();
@@ -51,6 +51,7 @@ namespace adaptive
                 void setUserLiveDelay(mtime_t);
                 void setLowDelay(bool);
                 static const mtime_t BUFFERING_LOWEST_LIMIT;
+                static const mtime_t LOWLATENCY_MIN_BUFFERING;
                 static const mtime_t DEFAULT_MIN_BUFFERING;
                 static const mtime_t DEFAULT_MAX_BUFFERING;
                 static const mtime_t DEFAULT_LIVE_BUFFERING;
@@ -0,0 +1,358 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+#include "Representationselectors.hpp"
+
+#include "../playlist/AbstractPlaylist.hpp"
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput rule while the buffer is filling up, then BOLA
+ * (Near-Optimal Bitrate Adaptation for Online Videos,
+ * http://arxiv.org/abs/1601.06748) once there is enough buffer for it,
+ * as in the DYNAMIC rule of dash.js. Throughput is the harmonic mean of the
+ * last chunk downloads, which is less sensitive to short bursts than the
+ * arithmetic one.
+ */
+
+#define minimumBufferS      (CLOCK_FREQ * 6)  /* Qmin */
+#define bufferTargetS       (CLOCK_FREQ * 30) /* Qmax */
+#define THROUGHPUT_SAMPLES  5
+#define THROUGHPUT_SAMPLES_LOWLATENCY 3
+#define THROUGHPUT_SAFETY   0.9
+
+HybridContext::HybridContext()
+    : buffering_min( minimumBufferS )
+    , buffering_level( 0 )
+    , buffering_target( bufferTargetS )
+    , use_bola( false )
+    , started( false )
+    , starving( false )
+    , decision_bps( 0 )
+    , decision_bola( false )
+    , last_level_date( 0 )
+    , played_time( 0 )
+    , starved_time( 0 )
+    , starve_count( 0 )
+    , switch_count( 0 )
+    , bitrate_time( 0 )
+    , bitrate_duration( 0 )
+    , last_switch_date( 0 )
+    , current_bitrate( 0 )
+{ }
+
+unsigned HybridContext::getHarmonicMean(unsigned count) const
+{
+    double sum = 0.0;
+    unsigned n = 0;
+    std::list<unsigned>::const_reverse_iterator it;
+    for(it = samples.rbegin(); it != samples.rend() && n < count; ++it, ++n)
+    {
+        if(*it == 0)
+            return 0;
+        sum += 1.0 / *it;
+    }
+    return n ? n / sum : 0;
+}
+
+HybridAdaptationLogic::HybridAdaptationLogic( vlc_object_t *obj )
+    : AbstractAdaptationLogic(obj)
+    , usedBps( 0 )
+{
+    startupBuffering = CLOCK_FREQ / 1000 *
+                       var_InheritInteger(obj, "adaptive-startup-buffer");
+    lowLatency = var_InheritInteger(obj, "adaptive-lowlatency");
+    vlc_mutex_init(&lock);
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+    std::map<ID, HybridContext>::const_iterator it;
+    for(it = streams.begin(); it != streams.end(); ++it)
+        reportStats((*it).first, (*it).second);
+    vlc_mutex_destroy(&lock);
+}
+
+bool HybridAdaptationLogic::isLowLatency(BaseAdaptationSet *adaptSet) const
+{
+    if(lowLatency >= 0)
+        return lowLatency;
+    return adaptSet->getPlaylist()->isLowLatency();
+}
+
+BaseRepresentation *
+HybridAdaptationLogic::getBolaRepresentation( BaseAdaptationSet *adaptSet,
+                                              RepresentationSelector &selector,
+                                              const HybridContext &ctx )
+{
+    const float umin = getUtility(selector.lowest(adaptSet));
+    const float umax = getUtility(selector.highest(adaptSet));
+    const float Q = (float)ctx.buffering_level / CLOCK_FREQ;
+
+    const float gammaP = 1.0 + (umax - umin) / ((float)ctx.buffering_target / ctx.buffering_min - 1.0);
+    const float Vd = ((float)ctx.buffering_min / CLOCK_FREQ - 1.0) / (umin + gammaP);
+
+    BaseRepresentation *ret = NULL;
+    BaseRepresentation *prev = NULL;
+    float argmax = 0;
+    for(BaseRepresentation *rep = selector.lowest(adaptSet);
+                            rep && rep != prev; rep = selector.higher(adaptSet, rep))
+    {
+        float arg = ( Vd * (getUtility(rep) - umin + gammaP) - Q ) / rep->getBandwidth();
+        if(ret == NULL || argmax <= arg)
+        {
+            ret = rep;
+            argmax = arg;
+        }
+        prev = rep;
+    }
+    return ret;
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+    const bool b_lowlatency = isLowLatency(adaptSet);
+
+    vlc_mutex_locker locker(&lock);
+
+    std::map<ID, HybridContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end())
+        return selector.lowest(adaptSet);
+    HybridContext &ctx = (*it).second;
+
+    const unsigned bps = getAvailableBw(getMaxCurrentBw(b_lowlatency ? THROUGHPUT_SAMPLES_LOWLATENCY
+                                                                     : THROUGHPUT_SAMPLES),
+                                        prevRep);
+    BaseRepresentation *m = selector.select(adaptSet, bps * THROUGHPUT_SAFETY);
+
+    /* BOLA needs some buffer to work with, which low latency streams don't
+     * have. Hysteresis avoids flipping between both rules. */
+    if(b_lowlatency || prevRep == NULL)
+        ctx.use_bola = false;
+    else if(!ctx.use_bola && ctx.buffering_level >= startupBuffering)
+        ctx.use_bola = true;
+    else if(ctx.use_bola && ctx.buffering_level < startupBuffering / 2)
+        ctx.use_bola = false;
+
+    if(ctx.use_bola && m)
+    {
+        BaseRepresentation *bola = getBolaRepresentation(adaptSet, selector, ctx);
+        /* Don't go up further than what the throughput allows */
+        if(bola && bola->getBandwidth() > prevRep->getBandwidth() &&
+           bola->getBandwidth() > m->getBandwidth())
+            bola = (prevRep->getBandwidth() > m->getBandwidth()) ? prevRep : m;
+        m = bola;
+    }
+
+    ctx.decision_bps = bps;
+    ctx.decision_bola = ctx.use_bola;
+
+    return m;
+}
+
+float HybridAdaptationLogic::getUtility(const BaseRepresentation *rep) const
+{
+    return std::log((float)rep->getBandwidth());
+}
+
+unsigned HybridAdaptationLogic::getAvailableBw(unsigned i_bw, const BaseRepresentation *curRep) const
+{
+    unsigned i_remain = i_bw;
+    if(i_remain > usedBps)
+        i_remain -= usedBps;
+    else
+        i_remain = 0;
+    if(curRep)
+        i_remain += curRep->getBandwidth();
+    return i_remain > i_bw ? i_bw : i_remain;
+}
+
+unsigned HybridAdaptationLogic::getMaxCurrentBw(unsigned count) const
+{
+    unsigned i_max_bitrate = 0;
+    for(std::map<ID, HybridContext>::const_iterator it = streams.begin();
+                                                    it != streams.end(); ++it)
+    {
+        const HybridContext &ctx = (*it).second;
+        i_max_bitrate = std::max(i_max_bitrate, ctx.getHarmonicMean(count));
+    }
+    return i_max_bitrate;
+}
+
+void HybridAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
+{
+    if(unlikely(time == 0))
+        return;
+    vlc_mutex_lock(&lock);
+    std::map<ID, HybridContext>::iterator it = streams.find(id);
+    if(it != streams.end())
+    {
+        HybridContext &ctx = (*it).second;
+        ctx.samples.push_back(CLOCK_FREQ * dlsize * 8 / time);
+        if(ctx.samples.size() > THROUGHPUT_SAMPLES)
+            ctx.samples.pop_front();
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::reportSwitch(const ID &id, HybridContext &ctx,
+                                         const BaseRepresentation *prev,
+                                         const BaseRepresentation *next,
+                                         unsigned bps, bool b_bola)
+{
+    const mtime_t now = mdate();
+    if(ctx.last_switch_date)
+    {
+        ctx.bitrate_time += ctx.current_bitrate / 1000 * (now - ctx.last_switch_date);
+        ctx.bitrate_duration += now - ctx.last_switch_date;
+    }
+    ctx.last_switch_date = now;
+    ctx.current_bitrate = next ? next->getBandwidth() : 0;
+    if(prev && next)
+        ctx.switch_count++;
+
+    msg_Dbg(p_obj, "stream %s switching %" PRIu64 " -> %" PRIu64 " kbps (%s rule,"
+                   " throughput %u kbps, buffer %" PRId64 "/%" PRId64 " ms)",
+            id.str().c_str(), prev ? prev->getBandwidth() / 1000 : 0,
+            ctx.current_bitrate / 1000, b_bola ? "buffer" : "throughput",
+            bps / 1000, ctx.buffering_level / 1000, ctx.buffering_target / 1000);
+}
+
+void HybridAdaptationLogic::reportStats(const ID &id, const HybridContext &ctx) const
+{
+    uint64_t bitrate_time = ctx.bitrate_time;
+    mtime_t bitrate_duration = ctx.bitrate_duration;
+    if(ctx.last_switch_date)
+    {
+        const mtime_t now = mdate();
+        bitrate_time += ctx.current_bitrate / 1000 * (now - ctx.last_switch_date);
+        bitrate_duration += now - ctx.last_switch_date;
+    }
+
+    msg_Info(p_obj, "stream %s: %u switch(es), average bitrate %" PRIu64 " kbps,"
+                    " %u stall(s), rebuffering ratio %.2f%%",
+             id.str().c_str(), ctx.switch_count,
+             bitrate_duration ? bitrate_time / bitrate_duration : 0,
+             ctx.starve_count,
+             ctx.played_time ? 100.0 * ctx.starved_time / ctx.played_time : 0.0);
+}
+
+void HybridAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+    case SegmentTrackerEvent::SWITCHING:
+        {
+            vlc_mutex_lock(&lock);
+            if(event.u.switching.prev)
+                usedBps -= event.u.switching.prev->getBandwidth();
+            if(event.u.switching.next)
+            {
+                usedBps += event.u.switching.next->getBandwidth();
+                const ID &id = event.u.switching.next->getAdaptationSet()->getID();
+                std::map<ID, HybridContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                {
+                    HybridContext &ctx = (*it).second;
+                    reportSwitch(id, ctx, event.u.switching.prev, event.u.switching.next,
+                                 ctx.decision_bps, ctx.decision_bola);
+                }
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_STATE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            if(event.u.buffering.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                {
+                    HybridContext ctx;
+                    streams.insert(std::pair<ID, HybridContext>(id, ctx));
+                }
+            }
+            else
+            {
+                std::map<ID, HybridContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                {
+                    reportStats(id, (*it).second);
+                    streams.erase(it);
+                }
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+        {
+            const ID &id = *event.u.buffering.id;
+            const mtime_t now = mdate();
+            vlc_mutex_lock(&lock);
+            std::map<ID, HybridContext>::iterator it = streams.find(id);
+            if(it == streams.end())
+            {
+                /* stream was disabled, don't recreate its context */
+                vlc_mutex_unlock(&lock);
+                break;
+            }
+            HybridContext &ctx = (*it).second;
+            ctx.buffering_min = std::max(event.u.buffering_level.minimum, (mtime_t) CLOCK_FREQ * 2);
+            ctx.buffering_level = event.u.buffering_level.current;
+            ctx.buffering_target = std::max(event.u.buffering_level.target,
+                                            ctx.buffering_min + CLOCK_FREQ);
+
+            /* Playback stalls when a started stream falls under its minimum */
+            if(ctx.started && ctx.last_level_date)
+            {
+                const mtime_t elapsed = now - ctx.last_level_date;
+                ctx.played_time += elapsed;
+                if(ctx.starving)
+                    ctx.starved_time += elapsed;
+            }
+            ctx.last_level_date = now;
+            const bool starving = ctx.buffering_level < event.u.buffering_level.minimum;
+            if(!starving)
+                ctx.started = true;
+            else if(ctx.started && !ctx.starving)
+                ctx.starve_count++;
+            ctx.starving = ctx.started && starving;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * HybridAdaptationLogic.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HYBRIDADAPTATIONLOGIC_HPP
+#define HYBRIDADAPTATIONLOGIC_HPP
+
+#include "AbstractAdaptationLogic.h"
+#include "Representationselectors.hpp"
+#include <map>
+#include <list>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        class HybridContext
+        {
+            friend class HybridAdaptationLogic;
+
+            public:
+                HybridContext();
+
+            private:
+                unsigned getHarmonicMean(unsigned) const;
+                mtime_t buffering_min;
+                mtime_t buffering_level;
+                mtime_t buffering_target;
+                bool    use_bola;
+                bool    started;
+                bool    starving;
+                unsigned decision_bps;  /* inputs of the last decision */
+                bool     decision_bola;
+                std::list<unsigned> samples; /* per chunk throughput, bps */
+                /* statistics */
+                mtime_t last_level_date;
+                mtime_t played_time;
+                mtime_t starved_time;
+                unsigned starve_count;
+                unsigned switch_count;
+                uint64_t bitrate_time; /* sum of kbps * duration */
+                mtime_t bitrate_duration;
+                mtime_t last_switch_date;
+                uint64_t current_bitrate;
+        };
+
+        class HybridAdaptationLogic : public AbstractAdaptationLogic
+        {
+            public:
+                HybridAdaptationLogic(vlc_object_t *);
+                virtual ~HybridAdaptationLogic();
+
+                virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
+                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t); /* reimpl */
+                virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
+
+            private:
+                BaseRepresentation *        getBolaRepresentation(BaseAdaptationSet *,
+                                                                  RepresentationSelector &,
+                                                                  const HybridContext &);
+                float                       getUtility(const BaseRepresentation *) const;
+                unsigned                    getAvailableBw(unsigned, const BaseRepresentation *) const;
+                unsigned                    getMaxCurrentBw(unsigned) const;
+                bool                        isLowLatency(BaseAdaptationSet *) const;
+                void                        reportSwitch(const ID &, HybridContext &,
+                                                         const BaseRepresentation *,
+                                                         const BaseRepresentation *,
+                                                         unsigned, bool);
+                void                        reportStats(const ID &, const HybridContext &) const;
+                std::map<adaptive::ID, HybridContext> streams;
+                unsigned                    usedBps;
+                mtime_t                     startupBuffering;
+                int                         lowLatency;
+                vlc_mutex_t                 lock;
+        };
+    }
+}
+
+#endif // HYBRIDADAPTATIONLOGIC_HPP
@@ -689,8 +689,8 @@ mtime_t SegmentInformation::inheritAvailabilityTimeOffset() const
 {
     for(const SegmentInformation *p = this; p; p = p->parent)
     {
-        if(availabilityTimeOffset.isSet())
-            return availabilityTimeOffset.value();
+        if(p->availabilityTimeOffset.isSet())
+            return p->availabilityTimeOffset.value();
     }
     return getPlaylist()->getAvailabilityTimeOffset();
 }
@@ -699,8 +699,8 @@ bool SegmentInformation::inheritAvailabilityTimeComplete() const
 {
     for(const SegmentInformation *p = this; p; p = p->parent)
     {
-        if(availabilityTimeComplete.isSet())
-            return availabilityTimeComplete.value();
+        if(p->availabilityTimeComplete.isSet())
+            return p->availabilityTimeComplete.value();
     }
     return getPlaylist()->getAvailabilityTimeComplete();
 }
@@ -73,7 +73,7 @@ namespace adaptive
                 static const int InfoTypeCount = INFOTYPE_INDEX + 1;
 
                 ISegment * getSegment(SegmentInfoType, uint64_t = 0) const;
-                ISegment * getNextSegment(SegmentInfoType, uint64_t, uint64_t *, bool *) const;
+                virtual ISegment * getNextSegment(SegmentInfoType, uint64_t, uint64_t *, bool *) const;
                 bool getSegmentNumberByTime(mtime_t, uint64_t *) const;
                 bool getPlaybackTimeDurationBySegmentNumber(uint64_t, mtime_t *, mtime_t *) const;
                 bool     getMediaPlaybackRange(mtime_t *, mtime_t *, mtime_t *) const;
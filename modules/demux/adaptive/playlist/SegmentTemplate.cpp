@@ -165,6 +165,8 @@ uint64_t MediaSegmentTemplate::getLiveTemplateNumber(mtime_t playbacktime, bool
                     parentSegmentInformation->getPlaylist()->availabilityStartTime.Get();
             streamstart += parentSegmentInformation->getPeriodStart();
             playbacktime -= streamstart;
+            /* segments are announced available ahead (chunked, low latency) */
+            playbacktime += parentSegmentInformation->inheritAvailabilityTimeOffset();
         }
         stime_t elapsed = timescale.ToScaled(playbacktime) - dur;
         if(elapsed > 0)
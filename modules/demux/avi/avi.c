@@ -43,9 +43,11 @@
 #include <vlc_codecs.h>
 #include <vlc_charset.h>
 #include <vlc_memory.h>
+#include <vlc_boxes.h>
 
 #include "libavi.h"
 #include "../rawdv.h"
+#include "../index_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -224,6 +226,8 @@ static int AVI_PacketSearch   ( demux_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static int  AVI_IndexCacheLoad( demux_t *, index_cache_t * );
+static void AVI_IndexCacheSave( demux_t *, index_cache_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -2744,6 +2748,8 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
     mtime_t i_dialog_update;
     vlc_dialog_id *p_dialog_id = NULL;
+    index_cache_t *p_cache;
+    bool b_cancelled = false;
 
     p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
     p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
@@ -2757,6 +2763,13 @@ static void AVI_IndexCreate( demux_t *p_demux )
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
         avi_index_Init( &p_sys->track[i_stream]->idx );
 
+    p_cache = index_cache_New( p_demux, p_demux->psz_file, "avi" );
+    if( p_cache != NULL && AVI_IndexCacheLoad( p_demux, p_cache ) == VLC_SUCCESS )
+    {
+        index_cache_Delete( p_cache );
+        return;
+    }
+
     i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
                         stream_Size( p_demux->s ) );
 
@@ -2782,7 +2795,10 @@ static void AVI_IndexCreate( demux_t *p_demux )
         if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
+            {
+                b_cancelled = true;
                 break;
+            }
 
             double f_current = vlc_stream_Tell( p_demux->s );
             double f_size    = stream_Size( p_demux->s );
@@ -2861,6 +2877,114 @@ print_stat:
         msg_Dbg( p_demux, "stream[%d] creating %d index entries",
                 i_stream, p_sys->track[i_stream]->idx.i_size );
     }
+
+    if( p_cache != NULL )
+    {
+        if( !b_cancelled )
+            AVI_IndexCacheSave( p_demux, p_cache );
+        index_cache_Delete( p_cache );
+    }
+}
+
+/*****************************************************************************
+ * Index cache: the index created from LIST-movi is stored as
+ *  track count(32), then for each track entry count(32) and entries
+ *  id(32) flags(32) pos(64) length(32), all values little endian.
+ *****************************************************************************/
+#define AVI_INDEX_CACHE_ENTRY 20
+
+static int AVI_IndexCacheLoad( demux_t *p_demux, index_cache_t *p_cache )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    block_t *p_block = index_cache_Load( p_cache );
+    if( p_block == NULL )
+        return VLC_EGENERIC;
+
+    const uint8_t *p = p_block->p_buffer;
+    size_t i_left = p_block->i_buffer;
+    const uint64_t i_stream_size = stream_Size( p_demux->s );
+    const uint64_t i_last_pos = p_sys->i_movi_lastchunk_pos;
+
+    if( i_left < 4 || GetDWLE( p ) != p_sys->i_track )
+        goto error;
+    p += 4; i_left -= 4;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        if( i_left < 4 )
+            goto error;
+        uint32_t i_count = GetDWLE( p );
+        p += 4; i_left -= 4;
+        if( i_count > i_left / AVI_INDEX_CACHE_ENTRY )
+            goto error;
+
+        for( uint32_t j = 0; j < i_count; j++ )
+        {
+            avi_entry_t index;
+            index.i_id      = GetDWLE( &p[0] );
+            index.i_flags   = GetDWLE( &p[4] );
+            index.i_pos     = GetQWLE( &p[8] );
+            index.i_length  = GetDWLE( &p[16] );
+            index.i_lengthtotal = index.i_length;
+            p += AVI_INDEX_CACHE_ENTRY; i_left -= AVI_INDEX_CACHE_ENTRY;
+
+            if( index.i_pos >= i_stream_size )
+                goto error;
+            avi_index_Append( p_index, &p_sys->i_movi_lastchunk_pos, &index );
+        }
+        msg_Dbg( p_demux, "stream[%u] loaded %u index entries from cache",
+                 i, p_index->i_size );
+    }
+
+    block_Release( p_block );
+    return VLC_SUCCESS;
+
+error:
+    msg_Warn( p_demux, "invalid index cache" );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        avi_index_Init( &p_sys->track[i]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = i_last_pos;
+    block_Release( p_block );
+    return VLC_EGENERIC;
+}
+
+static void AVI_IndexCacheSave( demux_t *p_demux, index_cache_t *p_cache )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    size_t i_size = 4;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        i_size += 4 + (size_t)p_sys->track[i]->idx.i_size * AVI_INDEX_CACHE_ENTRY;
+
+    bo_t bo;
+    if( !bo_init( &bo, i_size ) )
+        return;
+
+    bo_add_32le( &bo, p_sys->i_track );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        bo_add_32le( &bo, p_index->i_size );
+        for( uint32_t j = 0; j < p_index->i_size; j++ )
+        {
+            const avi_entry_t *p_entry = &p_index->p_entry[j];
+            bo_add_32le( &bo, p_entry->i_id );
+            bo_add_32le( &bo, p_entry->i_flags );
+            bo_add_64le( &bo, p_entry->i_pos );
+            bo_add_32le( &bo, p_entry->i_length );
+        }
+    }
+
+    if( bo.b != NULL && bo.b->i_buffer == i_size )
+        index_cache_Save( p_cache, bo.b->p_buffer, bo.b->i_buffer );
+    bo_deinit( &bo );
 }
 
 /* */
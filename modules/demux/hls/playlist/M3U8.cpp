@@ -32,12 +32,23 @@ M3U8::M3U8 (vlc_object_t *p_object) :
     AbstractPlaylist(p_object)
 {
     minUpdatePeriod.Set( 5 * CLOCK_FREQ );
+    lowLatency = false;
 }
 
 M3U8::~M3U8()
 {
 }
 
+bool M3U8::isLowLatency() const
+{
+    return lowLatency;
+}
+
+void M3U8::setLowLatency(bool b)
+{
+    lowLatency = b;
+}
+
 bool M3U8::isLive() const
 {
     bool b_live = false;
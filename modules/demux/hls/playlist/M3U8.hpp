@@ -36,10 +36,13 @@ namespace hls
                 virtual ~M3U8();
 
                 virtual bool                    isLive() const;
+                virtual bool                    isLowLatency() const;
+                void                            setLowLatency(bool);
                 virtual void                    debug();
 
             private:
                 std::string data;
+                bool lowLatency;
         };
     }
 }
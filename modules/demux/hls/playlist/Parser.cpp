@@ -56,7 +56,7 @@ M3U8Parser::~M3U8Parser   ()
 {
 }
 
-static std::list<Tag *> getTagsFromList(std::list<Tag *> &list, int tag)
+static std::list<Tag *> getTagsFromList(const std::list<Tag *> &list, int tag)
 {
     std::list<Tag *> ret;
     std::list<Tag *>::const_iterator it;
@@ -68,7 +68,7 @@ static std::list<Tag *> getTagsFromList(std::list<Tag *> &list, int tag)
     return ret;
 }
 
-static Tag * getTagFromList(std::list<Tag *> &list, int tag)
+static Tag * getTagFromList(const std::list<Tag *> &list, int tag)
 {
     std::list<Tag *>::const_iterator it;
     for(it = list.begin(); it != list.end(); ++it)
@@ -151,7 +151,7 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, rep->getUpdateUrl().toString());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -205,10 +205,21 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
-void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::list<Tag *> &tagslist)
+static void setSegmentByteRange(ISegment *segment, std::pair<std::size_t,std::size_t> range,
+                                std::size_t *prevbyterangeoffset)
+{
+    /* first == offset, second = size */
+    if(range.first == 0)
+        range.first = *prevbyterangeoffset;
+    *prevbyterangeoffset = range.first + range.second;
+    segment->setByteRange(range.first, *prevbyterangeoffset - 1);
+}
+
+void M3U8Parser::parseSegments(vlc_object_t *p_obj, Representation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
 
+    const bool b_firstload = !rep->b_loaded;
     rep->setTimescale(100);
     rep->b_loaded = true;
 
@@ -221,9 +232,84 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     const SingleValueTag *ctx_byterange = NULL;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
+    const AttributesTag *ctx_preloadhint = NULL;
+    std::list<const AttributesTag *> ctx_parts;
+
+    /* Low latency: publishes partial segments before the full one */
+    const AttributesTag *partinftag =
+            static_cast<const AttributesTag *>(getTagFromList(tagslist, AttributesTag::EXTXPARTINF));
+    if(partinftag && partinftag->getAttributeByName("PART-TARGET") &&
+       var_InheritInteger(p_obj, "adaptive-lowlatency") != 0)
+    {
+        rep->partTarget = CLOCK_FREQ * partinftag->getAttributeByName("PART-TARGET")->floatingPoint();
+        /* numbering can't change once segments are merged */
+        if(b_firstload)
+            rep->b_parts = true;
+        M3U8 *m3u8 = dynamic_cast<M3U8 *>(rep->getPlaylist());
+        if(m3u8 && rep->b_parts)
+            m3u8->setLowLatency(true);
+    }
+    const uint64_t numberScale = rep->b_parts ? Representation::MAX_PARTS : 1;
+
+    auto createSegment = [&](uint64_t number, const std::string &uri, mtime_t nzDuration)
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, number);
+        if(!segment)
+            return segment;
+
+        segment->setSourceUrl(uri);
+        segment->duration.Set(rep->getTimescale().ToScaled(nzDuration));
+        segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
+        nzStartTime += nzDuration;
+        totalduration += nzDuration;
+        if(absReferenceTime > VLC_TS_INVALID)
+        {
+            segment->utcTime = absReferenceTime;
+            absReferenceTime += nzDuration;
+        }
+
+        segmentList->addSegment(segment);
+
+        if(discontinuity)
+        {
+            segment->discontinuity = true;
+            discontinuity = false;
+        }
+
+        if(encryption.method != CommonEncryption::Method::NONE)
+            segment->setEncryption(encryption);
+
+        return segment;
+    };
+
+    /* Creates the listed parts of segment sequenceNumber, returns next part index */
+    auto createParts = [&]()
+    {
+        uint64_t index = 0;
+        std::size_t prevpartoffset = 0;
+        for(auto it = ctx_parts.cbegin(); it != ctx_parts.cend() && index < Representation::MAX_PARTS; ++it)
+        {
+            const Attribute *uriAttr = (*it)->getAttributeByName("URI");
+            const Attribute *durAttr = (*it)->getAttributeByName("DURATION");
+            const Attribute *gapAttr = (*it)->getAttributeByName("GAP");
+            if(uriAttr && durAttr && !(gapAttr && gapAttr->value == "YES"))
+            {
+                HLSSegment *segment = createSegment(sequenceNumber * numberScale + index,
+                                                    uriAttr->quotedString(),
+                                                    CLOCK_FREQ * durAttr->floatingPoint());
+                const Attribute *rangeAttr = (*it)->getAttributeByName("BYTERANGE");
+                if(segment && rangeAttr)
+                    setSegmentByteRange(segment, rangeAttr->unescapeQuotes().getByteRange(),
+                                        &prevpartoffset);
+            }
+            index++;
+        }
+        ctx_parts.clear();
+        return index;
+    };
 
     std::list<Tag *>::const_iterator it;
-    for(it = tagslist.begin(); it != tagslist.end(); ++it)
+    for(it = tagslist.begin(); it != tagslist.end() && segmentList; ++it)
     {
         const Tag *tag = *it;
         switch(tag->getType())
@@ -251,11 +337,15 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     break;
                 }
 
-                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
-                if(!segment)
+                /* Parts of the segment are already listed, don't fetch it twice */
+                if(rep->b_parts && !ctx_parts.empty())
+                {
+                    createParts();
+                    sequenceNumber++;
+                    ctx_extinf = NULL;
+                    ctx_byterange = NULL;
                     break;
-
-                segment->setSourceUrl(uritag->getValue().value);
+                }
 
                 /* Need to use EXTXTARGETDURATION as default as some can't properly set segment one */
                 mtime_t nzDuration = CLOCK_FREQ * rep->targetDuration;
@@ -266,36 +356,18 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                         nzDuration = CLOCK_FREQ * durAttribute->floatingPoint();
                     ctx_extinf = NULL;
                 }
-                segment->duration.Set(rep->getTimescale().ToScaled(nzDuration));
-                segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
-                nzStartTime += nzDuration;
-                totalduration += nzDuration;
-                if(absReferenceTime > VLC_TS_INVALID)
-                {
-                    segment->utcTime = absReferenceTime;
-                    absReferenceTime += nzDuration;
-                }
 
-                segmentList->addSegment(segment);
+                HLSSegment *segment = createSegment(sequenceNumber++ * numberScale,
+                                                    uritag->getValue().value, nzDuration);
+                if(!segment)
+                    break;
 
                 if(ctx_byterange)
                 {
-                    std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
-                    if(range.first == 0) /* first == size, second = offset */
-                        range.first = prevbyterangeoffset;
-                    prevbyterangeoffset = range.first + range.second;
-                    segment->setByteRange(range.first, prevbyterangeoffset - 1);
+                    setSegmentByteRange(segment, ctx_byterange->getValue().getByteRange(),
+                                        &prevbyterangeoffset);
                     ctx_byterange = NULL;
                 }
-
-                if(discontinuity)
-                {
-                    segment->discontinuity = true;
-                    discontinuity = false;
-                }
-
-                if(encryption.method != CommonEncryption::Method::NONE)
-                    segment->setEncryption(encryption);
             }
             break;
 
@@ -345,6 +417,32 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
             }
             break;
 
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *ctrltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = ctrltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canBlockReload = (attr && attr->value == "YES");
+                attr = ctrltag->getAttributeByName("PART-HOLD-BACK");
+                if(attr && rep->b_parts && attr->floatingPoint() > 0)
+                    rep->getPlaylist()->suggestedPresentationDelay.Set(CLOCK_FREQ * attr->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXPART:
+                if(rep->b_parts)
+                    ctx_parts.push_back(static_cast<const AttributesTag *>(tag));
+                break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const AttributesTag *hinttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *typeAttr = hinttag->getAttributeByName("TYPE");
+                if(rep->b_parts && typeAttr && typeAttr->value == "PART" &&
+                   hinttag->getAttributeByName("URI"))
+                    ctx_preloadhint = hinttag;
+            }
+            break;
+
             case Tag::EXTXDISCONTINUITY:
                 discontinuity  = true;
                 break;
@@ -355,6 +453,27 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         }
     }
 
+    if(rep->b_parts && segmentList)
+    {
+        /* Parts of the segment being produced */
+        const uint64_t index = createParts();
+        rep->nextMSN = sequenceNumber;
+        rep->nextPart = index;
+
+        /* Hinted next part: request is held by server until published */
+        if(ctx_preloadhint && rep->isLive() && index < Representation::MAX_PARTS)
+        {
+            HLSSegment *segment = createSegment(sequenceNumber * numberScale + index,
+                                                ctx_preloadhint->getAttributeByName("URI")->quotedString(),
+                                                rep->partTarget);
+            const Attribute *startAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-START");
+            const Attribute *lengthAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-LENGTH");
+            if(segment && lengthAttr)
+                segment->setByteRange(startAttr ? startAttr->decimal() : 0,
+                                      (startAttr ? startAttr->decimal() : 0) + lengthAttr->decimal() - 1);
+        }
+    }
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
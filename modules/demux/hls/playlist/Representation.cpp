@@ -33,20 +33,28 @@
 #include "../../adaptive/playlist/SegmentList.h"
 
 #include <ctime>
+#include <sstream>
 #include <limits>
 #include <cassert>
 
 using namespace hls;
 using namespace hls::playlist;
 
+const uint64_t Representation::MAX_PARTS = 1000;
+
 Representation::Representation  ( BaseAdaptationSet *set ) :
                 BaseRepresentation( set )
 {
     b_live = true;
     b_loaded = false;
     b_failed = false;
+    b_parts = false;
+    b_canBlockReload = false;
     lastUpdateTime = 0;
     targetDuration = 0;
+    partTarget = 0;
+    nextMSN = 0;
+    nextPart = 0;
     streamFormat = StreamFormat::UNKNOWN;
 }
 
@@ -89,6 +97,21 @@ Url Representation::getPlaylistUrl() const
     }
 }
 
+Url Representation::getUpdateUrl() const
+{
+    Url url = getPlaylistUrl();
+    if(!b_loaded || !b_live || !b_parts || !b_canBlockReload)
+        return url;
+
+    /* Blocking reload: server holds the reply until next part is published */
+    const std::string str = url.toString();
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << str << ((str.find('?') == std::string::npos) ? "?" : "&");
+    ss << "_HLS_msn=" << nextMSN << "&_HLS_part=" << nextPart;
+    return Url(ss.str());
+}
+
 void Representation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -135,9 +158,11 @@ bool Representation::needsUpdate(uint64_t number) const
     {
         const mtime_t now = mdate();
         const mtime_t elapsed = now - lastUpdateTime;
-        const mtime_t duration = targetDuration
-                                  ? CLOCK_FREQ * targetDuration
-                                  : CLOCK_FREQ * 2;
+        mtime_t duration = targetDuration
+                            ? CLOCK_FREQ * targetDuration
+                            : CLOCK_FREQ * 2;
+        if(b_parts && partTarget)
+            duration = partTarget;
         if(elapsed < duration)
             return false;
 
@@ -161,6 +186,17 @@ bool Representation::runLocalUpdates(SharedResources *res)
     return true;
 }
 
+ISegment * Representation::getNextSegment(SegmentInfoType type, uint64_t i_pos,
+                                          uint64_t *pi_newpos, bool *pb_gap) const
+{
+    ISegment *seg = BaseRepresentation::getNextSegment(type, i_pos, pi_newpos, pb_gap);
+    /* Moving from last part to the first one of next segment isn't a gap */
+    if(seg && *pb_gap && b_parts &&
+       *pi_newpos == (i_pos / MAX_PARTS + 1) * MAX_PARTS)
+        *pb_gap = false;
+    return seg;
+}
+
 uint64_t Representation::translateSegmentNumber(uint64_t num, const SegmentInformation *from) const
 {
     if(consistentSegmentNumber())
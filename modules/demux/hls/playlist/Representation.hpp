@@ -52,6 +52,12 @@ namespace hls
                 virtual void debug(vlc_object_t *, int) const;  /* reimpl */
                 virtual bool runLocalUpdates(SharedResources *); /* reimpl */
                 virtual uint64_t translateSegmentNumber(uint64_t, const SegmentInformation *) const; /* reimpl */
+                virtual ISegment * getNextSegment(SegmentInfoType, uint64_t,
+                                                  uint64_t *, bool *) const; /* reimpl */
+                Url getUpdateUrl() const;
+
+                /* low latency parts are numbered MSN * MAX_PARTS + part index */
+                static const uint64_t MAX_PARTS;
 
             private:
                 StreamFormat streamFormat;
@@ -61,6 +67,11 @@ namespace hls
                 mtime_t lastUpdateTime;
                 time_t targetDuration;
                 Url playlistUrl;
+                bool b_parts;
+                bool b_canBlockReload;
+                mtime_t partTarget;
+                uint64_t nextMSN;
+                uint64_t nextPart;
         };
     }
 }
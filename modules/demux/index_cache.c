@@ -0,0 +1,335 @@
+/*****************************************************************************
+ * index_cache.c: persistent demuxer seek index cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+#include "index_cache.h"
+
+/*
+ * An entry is a header followed by the payload, all values little endian.
+ *
+ * header: "VLCINDEX" version(32) reserved(32) file size(64) file mtime(64)
+ *         payload size(32) reserved(32)
+ */
+#define INDEX_CACHE_MAGIC       "VLCINDEX"
+#define INDEX_CACHE_VERSION     1
+#define INDEX_CACHE_HEADER      40
+#define INDEX_CACHE_MAX_PAYLOAD (64 << 20)
+#define INDEX_CACHE_MAX_TOTAL   (128 << 20)
+#define INDEX_CACHE_MAX_ENTRIES 1000
+
+struct index_cache_t
+{
+    vlc_object_t *p_obj;
+    char         *psz_path;
+    uint64_t      i_size;
+    int64_t       i_mtime;
+};
+
+#undef index_cache_New
+index_cache_t *index_cache_New( vlc_object_t *p_obj, const char *psz_file,
+                                const char *psz_name )
+{
+    struct stat st;
+
+    if( psz_file == NULL || !var_InheritBool( p_obj, "index-cache" ) )
+        return NULL;
+    if( vlc_stat( psz_file, &st ) || !S_ISREG( st.st_mode ) )
+        return NULL;
+
+    index_cache_t *p_cache = malloc( sizeof( *p_cache ) );
+    if( unlikely(p_cache == NULL) )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_file, strlen( psz_file ) + 1 );
+    AddMD5( &md5, psz_name, strlen( psz_name ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_hash == NULL || psz_cachedir == NULL ||
+        asprintf( &p_cache->psz_path, "%s" DIR_SEP "index" DIR_SEP "%s.idx",
+                  psz_cachedir, psz_hash ) == -1 )
+        p_cache->psz_path = NULL;
+    free( psz_cachedir );
+    free( psz_hash );
+
+    if( p_cache->psz_path == NULL )
+    {
+        free( p_cache );
+        return NULL;
+    }
+
+    p_cache->p_obj = p_obj;
+    p_cache->i_size = st.st_size;
+    p_cache->i_mtime = st.st_mtime;
+    return p_cache;
+}
+
+block_t *index_cache_Load( index_cache_t *p_cache )
+{
+    FILE *p_file = vlc_fopen( p_cache->psz_path, "rb" );
+    if( p_file == NULL )
+        return NULL;
+
+    block_t *p_block = NULL;
+    uint8_t header[INDEX_CACHE_HEADER];
+
+    if( fread( header, 1, sizeof(header), p_file ) != sizeof(header) ||
+        memcmp( header, INDEX_CACHE_MAGIC, 8 ) ||
+        GetDWLE( &header[8] ) != INDEX_CACHE_VERSION )
+        goto end;
+
+    if( GetQWLE( &header[16] ) != p_cache->i_size ||
+        (int64_t)GetQWLE( &header[24] ) != p_cache->i_mtime )
+    {
+        msg_Dbg( p_cache->p_obj, "index cache is stale" );
+        goto end;
+    }
+
+    uint32_t i_data = GetDWLE( &header[32] );
+    if( i_data == 0 || i_data > INDEX_CACHE_MAX_PAYLOAD )
+        goto end;
+
+    p_block = block_Alloc( i_data );
+    if( p_block &&
+        fread( p_block->p_buffer, 1, i_data, p_file ) != i_data )
+    {
+        block_Release( p_block );
+        p_block = NULL;
+    }
+
+end:
+    fclose( p_file );
+    return p_block;
+}
+
+static void CreateDir( const char *psz_path )
+{
+    char psz_dir[strlen( psz_path ) + 1];
+    strcpy( psz_dir, psz_path );
+
+    for( char *psz = psz_dir + 1; *psz; psz++ )
+    {
+        if( *psz != DIR_SEP_CHAR )
+            continue;
+        *psz = '\0';
+        vlc_mkdir( psz_dir, 0700 );
+        *psz = DIR_SEP_CHAR;
+    }
+}
+
+static int WriteAll( int fd, const void *p_data, size_t i_data )
+{
+    const uint8_t *p = p_data;
+    while( i_data > 0 )
+    {
+        ssize_t i_ret = vlc_write( fd, p, i_data );
+        if( i_ret < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            return VLC_EGENERIC;
+        }
+        p += i_ret;
+        i_data -= i_ret;
+    }
+    return VLC_SUCCESS;
+}
+
+typedef struct
+{
+    char    *psz_path;
+    uint64_t i_size;
+    time_t   i_mtime;
+} index_cache_entry_t;
+
+static int EntryCmp( const void *a, const void *b )
+{
+    const index_cache_entry_t *p_a = a, *p_b = b;
+
+    return (p_a->i_mtime > p_b->i_mtime) - (p_a->i_mtime < p_b->i_mtime);
+}
+
+/* Removes the least recently saved entries (other than psz_keep) until
+ * the cache fits within INDEX_CACHE_MAX_TOTAL and INDEX_CACHE_MAX_ENTRIES */
+static void Prune( vlc_object_t *p_obj, const char *psz_keep )
+{
+    const char *psz_sep = strrchr( psz_keep, DIR_SEP_CHAR );
+    if( psz_sep == NULL )
+        return;
+
+    char *psz_dir = strndup( psz_keep, psz_sep - psz_keep );
+    if( unlikely(psz_dir == NULL) )
+        return;
+
+    DIR *p_dir = vlc_opendir( psz_dir );
+    if( p_dir == NULL )
+    {
+        free( psz_dir );
+        return;
+    }
+
+    index_cache_entry_t *p_entries = NULL;
+    size_t i_entries = 0, i_alloc = 0;
+    uint64_t i_total = 0;
+    const char *psz_name;
+
+    while( (psz_name = vlc_readdir( p_dir )) != NULL )
+    {
+        size_t i_len = strlen( psz_name );
+        if( i_len < 4 || strcmp( &psz_name[i_len - 4], ".idx" ) )
+            continue;
+
+        char *psz_path;
+        struct stat st;
+        if( asprintf( &psz_path, "%s" DIR_SEP "%s", psz_dir, psz_name ) == -1 )
+            break;
+        if( vlc_stat( psz_path, &st ) || !S_ISREG( st.st_mode ) )
+        {
+            free( psz_path );
+            continue;
+        }
+
+        i_total += st.st_size;
+        if( !strcmp( psz_path, psz_keep ) )
+        {
+            free( psz_path );
+            continue;
+        }
+
+        if( i_entries == i_alloc )
+        {
+            size_t i_new = i_alloc ? i_alloc * 2 : 64;
+            index_cache_entry_t *p_new =
+                realloc( p_entries, i_new * sizeof( *p_new ) );
+            if( unlikely(p_new == NULL) )
+            {
+                free( psz_path );
+                break;
+            }
+            p_entries = p_new;
+            i_alloc = i_new;
+        }
+        p_entries[i_entries].psz_path = psz_path;
+        p_entries[i_entries].i_size = st.st_size;
+        p_entries[i_entries].i_mtime = st.st_mtime;
+        i_entries++;
+    }
+    closedir( p_dir );
+    free( psz_dir );
+
+    if( i_entries > 0 )
+        qsort( p_entries, i_entries, sizeof( *p_entries ), EntryCmp );
+
+    /* the kept entry counts towards the limits too */
+    size_t i_count = i_entries + 1;
+    for( size_t i = 0; i < i_entries; i++ )
+    {
+        if( i_total > INDEX_CACHE_MAX_TOTAL ||
+            i_count > INDEX_CACHE_MAX_ENTRIES )
+        {
+            if( vlc_unlink( p_entries[i].psz_path ) == 0 )
+            {
+                msg_Dbg( p_obj, "pruned index cache file %s",
+                         p_entries[i].psz_path );
+                i_total -= p_entries[i].i_size;
+                i_count--;
+            }
+        }
+        free( p_entries[i].psz_path );
+    }
+    free( p_entries );
+}
+
+int index_cache_Save( index_cache_t *p_cache, const void *p_data, size_t i_data )
+{
+    if( i_data == 0 || i_data > INDEX_CACHE_MAX_PAYLOAD )
+        return VLC_EGENERIC;
+
+    uint8_t header[INDEX_CACHE_HEADER] = { 0 };
+    memcpy( header, INDEX_CACHE_MAGIC, 8 );
+    SetDWLE( &header[8], INDEX_CACHE_VERSION );
+    SetQWLE( &header[16], p_cache->i_size );
+    SetQWLE( &header[24], p_cache->i_mtime );
+    SetDWLE( &header[32], i_data );
+
+    CreateDir( p_cache->psz_path );
+
+    /* Write to a temporary file first, so that a concurrent reader never
+     * sees a partial entry */
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.XXXXXX", p_cache->psz_path ) == -1 )
+        return VLC_ENOMEM;
+
+    int fd = vlc_mkstemp( psz_tmp );
+    if( fd == -1 )
+    {
+        msg_Dbg( p_cache->p_obj, "cannot create index cache file %s",
+                 psz_tmp );
+        free( psz_tmp );
+        return VLC_EGENERIC;
+    }
+
+    int i_ret = WriteAll( fd, header, sizeof(header) );
+    if( i_ret == VLC_SUCCESS )
+        i_ret = WriteAll( fd, p_data, i_data );
+    if( close( fd ) )
+        i_ret = VLC_EGENERIC;
+
+    if( i_ret == VLC_SUCCESS &&
+        vlc_rename( psz_tmp, p_cache->psz_path ) == 0 )
+    {
+        msg_Dbg( p_cache->p_obj, "saved %zu bytes of index to %s",
+                 i_data, p_cache->psz_path );
+        Prune( p_cache->p_obj, p_cache->psz_path );
+    }
+    else
+    {
+        vlc_unlink( psz_tmp );
+        i_ret = VLC_EGENERIC;
+    }
+
+    free( psz_tmp );
+    return i_ret;
+}
+
+void index_cache_Delete( index_cache_t *p_cache )
+{
+    free( p_cache->psz_path );
+    free( p_cache );
+}
@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * index_cache.h: persistent demuxer seek index cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_DEMUX_INDEX_CACHE_H
+#define VLC_DEMUX_INDEX_CACHE_H
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/*
+ * Demuxers that have to scan a file to build their seek index can store the
+ * result in the user cache directory and get it back the next time the same
+ * file is opened. An entry is keyed by the file path and a name chosen by the
+ * demuxer, and is only returned while the file size and modification time
+ * match the ones recorded when it was saved.
+ *
+ * The payload is opaque to the cache: it must carry its own version and be
+ * validated by the demuxer when it is read back.
+ */
+typedef struct index_cache_t index_cache_t;
+
+/**
+ * Creates a cache handle for a local file.
+ * Returns NULL if the file is not local, cannot be stat'ed or if the cache
+ * is disabled by the "index-cache" option.
+ */
+index_cache_t *index_cache_New( vlc_object_t *, const char *psz_file,
+                                const char *psz_name );
+#define index_cache_New( a, b, c ) index_cache_New( VLC_OBJECT(a), b, c )
+
+/**
+ * Returns the payload stored for the file, or NULL if there is none or if
+ * the file changed since it was saved.
+ */
+block_t *index_cache_Load( index_cache_t * );
+
+/**
+ * Replaces the payload stored for the file.
+ */
+int index_cache_Save( index_cache_t *, const void *p_data, size_t i_data );
+
+void index_cache_Delete( index_cache_t * );
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif
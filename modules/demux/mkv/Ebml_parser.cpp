@@ -341,6 +341,75 @@ next:
     return m_el[mi_level];
 }
 
+/* Fast path for the Cluster -> SimpleBlock case: if the next element of the
+ * cluster is a SimpleBlock, its position and data size are returned and the
+ * stream is left at the start of its data, without creating any element.
+ * The caller is responsible for reading or skipping the data. */
+bool EbmlParser::GetRawSimpleBlock( uint64_t *pi_pos, uint64_t *pi_size )
+{
+    if( mi_user_level != mi_level || m_got || mi_level != 2 ||
+        !MKV_IS_ID( m_el[1], KaxCluster ) )
+        return false;
+
+    EbmlElement *p_prev = m_el[mi_level];
+    if( p_prev && !p_prev->IsFiniteSize() )
+        return false;
+
+    IOCallback & io = m_es->I_O();
+    const uint64_t i_pos = p_prev ? p_prev->GetEndPosition() : io.getFilePointer();
+    const uint64_t i_end = m_el[1]->IsFiniteSize() ? m_el[1]->GetEndPosition() : UINT64_MAX;
+
+    if( i_pos >= i_end )
+        return false;
+
+    /* SimpleBlock id followed by its size */
+    uint8_t header[9];
+    io.setFilePointer( i_pos );
+    uint32 i_read = io.read( header, sizeof( header ) );
+
+    if( i_read < 2 || header[0] != 0xA3 || header[1] == 0 )
+    {
+        io.setFilePointer( i_pos );
+        return false;
+    }
+
+    size_t i_len = 1;
+    while( !( header[1] & ( 0x80 >> ( i_len - 1 ) ) ) )
+        i_len++;
+
+    uint64_t i_size = header[1] & ( 0xFF >> i_len );
+    bool b_unknown = i_size == uint64_t( 0xFF >> i_len );
+    for( size_t i = 1; i < i_len && 1 + i < i_read; i++ )
+    {
+        i_size = ( i_size << 8 ) | header[1 + i];
+        b_unknown &= header[1 + i] == 0xFF;
+    }
+
+    const uint64_t i_data = i_pos + 1 + i_len;
+    if( 1 + i_len > i_read || b_unknown || i_data > i_end || i_size > i_end - i_data )
+    {
+        io.setFilePointer( i_pos );
+        return false;
+    }
+
+    if( p_prev )
+    {
+        if( !mb_keep )
+        {
+            if( MKV_IS_ID( p_prev, KaxBlockVirtual ) )
+                static_cast<KaxBlockVirtualWorkaround*>(p_prev)->Fix();
+            delete p_prev;
+        }
+        mb_keep = false;
+        m_el[mi_level] = NULL;
+    }
+
+    io.setFilePointer( i_data );
+    *pi_pos  = i_pos;
+    *pi_size = i_size;
+    return true;
+}
+
 bool EbmlParser::IsTopPresent( EbmlElement *el ) const
 {
     for( int i = 0; i < mi_level; i++ )
@@ -42,6 +42,7 @@ class EbmlParser
     void Down( void );
     void Reset( demux_t *p_demux );
     EbmlElement *Get( bool allow_overshoot = true );
+    bool        GetRawSimpleBlock( uint64_t *pi_pos, uint64_t *pi_size );
     void        Keep( void );
     void        Unkeep( void );
 
@@ -0,0 +1,224 @@
+/*****************************************************************************
+ * cluster_scanner.cpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "cluster_scanner.hpp"
+
+#include <vlc_url.h>
+
+namespace {
+    enum {
+        ID_CLUSTER          = 0x1F43B675,
+        ID_CLUSTER_TIMECODE = 0xE7,
+        ID_CUES             = 0x1C53BB6B,
+        ID_TAGS             = 0x1254C367,
+        ID_CHAPTERS         = 0x1043A770,
+        ID_ATTACHMENTS      = 0x1941A469,
+        ID_SEEKHEAD         = 0x114D9B74,
+        ID_INFO             = 0x1549A966,
+        ID_TRACKS           = 0x1654AE6B,
+        ID_VOID             = 0xEC,
+        ID_CRC32            = 0xBF,
+    };
+
+    /* the header is enough to find the cluster timecode, which has to come
+     * before any block */
+    const size_t SCAN_PEEK_SIZE = 64;
+
+    /* reads an EBML id (marker kept) or size (marker removed, UINT64_MAX
+     * when unknown), returns its length or 0 if invalid */
+    size_t read_vint( uint8_t const* p, size_t i_max, bool b_id, uint64_t *pi_value )
+    {
+        if( i_max == 0 || p[0] == 0 )
+            return 0;
+
+        size_t i_len = 1;
+        while( !( p[0] & ( 0x80 >> ( i_len - 1 ) ) ) )
+            i_len++;
+
+        if( i_len > i_max || i_len > ( b_id ? 4 : 8 ) )
+            return 0;
+
+        uint8_t const i_mask = 0xFF >> i_len;
+        uint64_t i_value = b_id ? p[0] : p[0] & i_mask;
+        bool b_unknown = ( p[0] & i_mask ) == i_mask;
+
+        for( size_t i = 1; i < i_len; i++ )
+        {
+            i_value = ( i_value << 8 ) | p[i];
+            b_unknown &= p[i] == 0xFF;
+        }
+
+        *pi_value = ( !b_id && b_unknown ) ? UINT64_MAX : i_value;
+        return i_len;
+    }
+
+    bool is_level1_id( uint64_t i_id )
+    {
+        switch( i_id )
+        {
+            case ID_CLUSTER: case ID_CUES: case ID_TAGS: case ID_CHAPTERS:
+            case ID_ATTACHMENTS: case ID_SEEKHEAD: case ID_INFO: case ID_TRACKS:
+            case ID_VOID: case ID_CRC32:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+cluster_scanner_c::cluster_scanner_c( demux_t *p_demux_, uint64_t i_start_, uint64_t i_end_ )
+    : p_demux( p_demux_ )
+    , i_start( i_start_ )
+    , i_end( i_end_ )
+    , is_running( false )
+    , p_interrupt( NULL )
+    , b_done( false )
+{
+    vlc_mutex_init( &lock );
+}
+
+cluster_scanner_c::~cluster_scanner_c()
+{
+    if( is_running )
+    {
+        vlc_interrupt_kill( p_interrupt );
+        vlc_join( thread, NULL );
+    }
+    if( p_interrupt )
+        vlc_interrupt_destroy( p_interrupt );
+    vlc_mutex_destroy( &lock );
+}
+
+bool cluster_scanner_c::Start()
+{
+    p_interrupt = vlc_interrupt_create();
+    if( unlikely( p_interrupt == NULL ) )
+        return false;
+
+    is_running = !vlc_clone( &thread, ScanThread, this, VLC_THREAD_PRIORITY_LOW );
+    return is_running;
+}
+
+bool cluster_scanner_c::Fetch( std::vector<cluster_t> & clusters )
+{
+    vlc_mutex_locker l( &lock );
+
+    clusters.swap( found );
+    found.clear();
+
+    return b_done;
+}
+
+void *cluster_scanner_c::ScanThread( void *data )
+{
+    static_cast<cluster_scanner_c*>( data )->ScanThread();
+    return NULL;
+}
+
+void cluster_scanner_c::ScanThread()
+{
+    vlc_interrupt_set( p_interrupt );
+
+    char *psz_url = NULL;
+    if( p_demux->psz_file )
+        psz_url = vlc_path2uri( p_demux->psz_file, "file" );
+    else if( asprintf( &psz_url, "%s://%s", p_demux->psz_access,
+                       p_demux->psz_location ) == -1 )
+        psz_url = NULL;
+
+    stream_t *s = psz_url ? vlc_stream_NewURL( p_demux, psz_url ) : NULL;
+    free( psz_url );
+
+    if( s != NULL )
+    {
+        mtime_t i_scan_start = mdate();
+        bool b_complete = Scan( s );
+        msg_Dbg( p_demux, "cluster scan %s after %" PRId64 " ms",
+                 b_complete ? "done" : "stopped",
+                 ( mdate() - i_scan_start ) / 1000 );
+        vlc_stream_Delete( s );
+    }
+
+    vlc_mutex_lock( &lock );
+    b_done = true;
+    vlc_mutex_unlock( &lock );
+}
+
+bool cluster_scanner_c::Scan( stream_t *s )
+{
+    uint8_t buf[SCAN_PEEK_SIZE];
+
+    for( uint64_t i_pos = i_start; i_pos < i_end; )
+    {
+        if( vlc_killed() || vlc_stream_Seek( s, i_pos ) )
+            return false;
+
+        ssize_t i_read = vlc_stream_Read( s, buf, sizeof( buf ) );
+        if( i_read <= 0 )
+            return false;
+
+        uint64_t i_id, i_size;
+        size_t i_id_len = read_vint( buf, i_read, true, &i_id );
+        size_t i_size_len = i_id_len ? read_vint( &buf[i_id_len], i_read - i_id_len, false, &i_size ) : 0;
+
+        /* stop on anything that cannot be skipped, Preload() and the seeker
+         * will deal with it */
+        if( i_size_len == 0 || !is_level1_id( i_id ) || i_size == UINT64_MAX )
+            return false;
+
+        size_t i_header = i_id_len + i_size_len;
+
+        if( i_id == ID_CLUSTER )
+        {
+            for( size_t i_offset = i_header; i_offset < (size_t)i_read; )
+            {
+                uint64_t i_child_id, i_child_size;
+                size_t i_child_id_len = read_vint( &buf[i_offset], i_read - i_offset, true, &i_child_id );
+                size_t i_child_size_len = i_child_id_len ? read_vint( &buf[i_offset + i_child_id_len],
+                                                                      i_read - i_offset - i_child_id_len,
+                                                                      false, &i_child_size ) : 0;
+                if( i_child_size_len == 0 || i_child_size == UINT64_MAX )
+                    break;
+
+                i_offset += i_child_id_len + i_child_size_len;
+
+                if( i_child_id == ID_CLUSTER_TIMECODE )
+                {
+                    if( i_child_size > 8 || i_offset + i_child_size > (size_t)i_read )
+                        break;
+
+                    cluster_t cluster = { i_pos, i_header + i_size, 0 };
+                    for( size_t i = 0; i < i_child_size; i++ )
+                        cluster.i_timecode = ( cluster.i_timecode << 8 ) | buf[i_offset + i];
+
+                    vlc_mutex_locker l( &lock );
+                    found.push_back( cluster );
+                    break;
+                }
+
+                i_offset += i_child_size;
+            }
+        }
+
+        i_pos += i_header + i_size;
+    }
+
+    return true;
+}
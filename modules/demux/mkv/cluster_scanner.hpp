@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * cluster_scanner.hpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_MKV_CLUSTER_SCANNER_HPP_
+#define VLC_MKV_CLUSTER_SCANNER_HPP_
+
+#include "mkv.hpp"
+
+#include <vlc_interrupt.h>
+
+#include <vector>
+
+/*****************************************************************************
+ * Background cluster scanner
+ *****************************************************************************
+ * Segments without Cues can only be seeked by reading blocks from a known
+ * cluster. The scanner hops from cluster to cluster on its own stream, only
+ * reading the element headers and the cluster timecode, so that the seeker
+ * knows every cluster boundary by the time the user seeks.
+ *****************************************************************************/
+class cluster_scanner_c
+{
+public:
+    struct cluster_t
+    {
+        uint64_t i_pos;      /* element position */
+        uint64_t i_size;     /* element size, header included */
+        uint64_t i_timecode; /* in segment timescale units */
+    };
+
+    cluster_scanner_c( demux_t *, uint64_t i_start, uint64_t i_end );
+    virtual ~cluster_scanner_c();
+
+    bool Start();
+    /* moves the clusters found so far, returns true once the scan is over */
+    bool Fetch( std::vector<cluster_t> & );
+
+private:
+    void ScanThread();
+    static void *ScanThread( void * );
+    bool Scan( stream_t * );
+
+    demux_t         *p_demux;
+    uint64_t         i_start;
+    uint64_t         i_end;
+
+    bool             is_running;
+    vlc_thread_t     thread;
+    vlc_interrupt_t *p_interrupt;
+
+    vlc_mutex_t      lock;
+    std::vector<cluster_t> found;
+    bool             b_done;
+};
+
+#endif
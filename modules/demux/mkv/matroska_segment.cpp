@@ -61,11 +61,18 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,ep( EbmlParser(&estream, p_seg, &demuxer.demuxer ))
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
+    ,p_index_cache(NULL)
+    ,i_index_cache_size(0)
+    ,p_cluster_scanner(NULL)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    ClusterScanFetch();
+    delete p_cluster_scanner;
+    IndexCacheSave();
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -482,6 +489,117 @@ void matroska_segment_c::IndexAppendCluster( KaxCluster *cluster )
     _seeker.add_cluster( cluster );
 }
 
+/* Segments without Cues are indexed while playing and seeking; keep what was
+ * learned in the index cache so that it is not scanned again next time. */
+bool matroska_segment_c::IsOnMainStream() const
+{
+    return !sys.streams.empty() && &es == &sys.streams[0]->estream;
+}
+
+bool matroska_segment_c::IndexCacheLoad()
+{
+    if( b_cues || !IsOnMainStream() )
+        return false;
+
+    char psz_name[32];
+    snprintf( psz_name, sizeof(psz_name), "mkv-%" PRIu64,
+              segment->GetElementPosition() );
+
+    p_index_cache = index_cache_New( &sys.demuxer, sys.demuxer.psz_file, psz_name );
+    if( p_index_cache == NULL )
+        return false;
+
+    block_t *p_block = index_cache_Load( p_index_cache );
+    if( p_block == NULL )
+        return false;
+
+    bool b_loaded = _seeker.deserialize( p_block->p_buffer, p_block->i_buffer );
+    if( b_loaded )
+    {
+        i_index_cache_size = p_block->i_buffer;
+        msg_Dbg( &sys.demuxer, "loaded %zu clusters from the index cache",
+                 _seeker._clusters.size() );
+    }
+    else
+        msg_Warn( &sys.demuxer, "invalid index cache" );
+
+    block_Release( p_block );
+    return b_loaded;
+}
+
+void matroska_segment_c::IndexCacheSave()
+{
+    if( p_index_cache == NULL )
+        return;
+
+    std::vector<uint8_t> data;
+    _seeker.serialize( data );
+
+    /* the seeker only ever grows, nothing new was learned if the size is
+     * the one that was loaded */
+    if( data.size() != i_index_cache_size )
+        index_cache_Save( p_index_cache, &data[0], data.size() );
+
+    index_cache_Delete( p_index_cache );
+    p_index_cache = NULL;
+}
+
+/* Without Cues, find the remaining cluster boundaries in the background
+ * instead of scanning the file linearly when seeking. The scan opens the
+ * source a second time and seeks once per cluster, so it is only done on
+ * sources that seek fast (local files), not on network ones. */
+void matroska_segment_c::ClusterScanStart()
+{
+    demux_t *p_demux = &sys.demuxer;
+    bool b_fast_seek;
+
+    if( b_cues || cluster == NULL || p_demux->b_preparsing || !IsOnMainStream() ||
+        !var_InheritBool( p_demux, "mkv-scan-clusters" ) ||
+        vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fast_seek ) || !b_fast_seek )
+        return;
+
+    uint64_t i_start = _seeker._cluster_positions.empty()
+                     ? cluster->GetElementPosition()
+                     : *_seeker._cluster_positions.rbegin();
+    uint64_t i_end = segment->IsFiniteSize() ? segment->GetEndPosition()
+                                             : stream_Size( p_demux->s );
+
+    p_cluster_scanner = new (std::nothrow) cluster_scanner_c( p_demux, i_start, i_end );
+    if( p_cluster_scanner && !p_cluster_scanner->Start() )
+    {
+        delete p_cluster_scanner;
+        p_cluster_scanner = NULL;
+    }
+}
+
+void matroska_segment_c::ClusterScanFetch()
+{
+    if( p_cluster_scanner == NULL )
+        return;
+
+    std::vector<cluster_scanner_c::cluster_t> clusters;
+    bool b_done = p_cluster_scanner->Fetch( clusters );
+
+    for( size_t i = 0; i < clusters.size(); i++ )
+    {
+        SegmentSeeker::Cluster cinfo = {
+            /* fpos     */ clusters[i].i_pos,
+            /* pts      */ mtime_t( clusters[i].i_timecode * i_timescale / INT64_C( 1000 ) ),
+            /* duration */ mtime_t( -1 ),
+            /* size     */ clusters[i].i_size
+        };
+        _seeker.add_cluster( cinfo );
+    }
+
+    if( b_done )
+    {
+        msg_Dbg( &sys.demuxer, "%zu clusters known after background scan",
+                 _seeker._clusters.size() );
+        delete p_cluster_scanner;
+        p_cluster_scanner = NULL;
+    }
+}
+
 bool matroska_segment_c::PreloadClusters(uint64 i_cluster_pos)
 {
     struct ClusterHandlerPayload
@@ -636,7 +754,8 @@ bool matroska_segment_c::Preload( )
         }
         else if( MKV_CHECKED_PTR_DECL ( kc_ptr, KaxCluster, el ) )
         {
-            if( var_InheritBool( &sys.demuxer, "mkv-preload-clusters" ) )
+            if( !IndexCacheLoad() &&
+                var_InheritBool( &sys.demuxer, "mkv-preload-clusters" ) )
             {
                 PreloadClusters        ( kc_ptr->GetElementPosition() );
                 es.I_O().setFilePointer( kc_ptr->GetElementPosition() );
@@ -700,6 +819,8 @@ bool matroska_segment_c::Preload( )
     if( cluster )
         EnsureDuration();
 
+    ClusterScanStart();
+
     return true;
 }
 
@@ -848,6 +969,8 @@ bool matroska_segment_c::Seek( demux_t &demuxer, mtime_t i_absolute_mk_date, mti
 
     // find appropriate seekpoints //
 
+    ClusterScanFetch();
+
     try {
         seekpoints = _seeker.get_seekpoints( *this, i_mk_date, priority, selected_tracks );
     }
@@ -927,6 +1050,199 @@ mkv_track_t * matroska_segment_c::FindTrackByBlock(
     return track_it->second.get();
 }
 
+mkv_track_t * matroska_segment_c::FindTrackByNumber( unsigned i_number )
+{
+    tracks_map_t::iterator track_it = tracks.find( i_number );
+
+    if (track_it == tracks.end())
+        return NULL;
+
+    return track_it->second.get();
+}
+
+namespace {
+    /* EBML coded integer, marker removed, returns its length or 0 */
+    size_t ReadVint( const uint8_t *p, size_t i_max, uint64_t *pi_value )
+    {
+        if( i_max == 0 || p[0] == 0 )
+            return 0;
+
+        size_t i_len = 1;
+        while( !( p[0] & ( 0x80 >> ( i_len - 1 ) ) ) )
+            i_len++;
+        if( i_len > i_max )
+            return 0;
+
+        uint64_t i_value = p[0] & ( 0xFF >> i_len );
+        for( size_t i = 1; i < i_len; i++ )
+            i_value = ( i_value << 8 ) | p[i];
+
+        *pi_value = i_value;
+        return i_len;
+    }
+
+    /* splits the laced frames of a block, see the Matroska lacing spec */
+    bool ParseLacing( mkv_simpleblock_t & sb, const uint8_t *p, size_t i_size, unsigned i_lacing )
+    {
+        if( i_lacing == 0 )
+        {
+            sb.i_frames = 1;
+            sb.frame_size[0] = i_size;
+            return true;
+        }
+
+        if( i_size < 1 )
+            return false;
+
+        sb.i_frames = p[0] + 1;
+        size_t i_offset = 1;
+        uint64_t i_total = 0;
+
+        switch( i_lacing )
+        {
+            case 1: /* Xiph */
+                for( unsigned i = 0; i < sb.i_frames - 1; i++ )
+                {
+                    uint64_t i_frame = 0;
+                    uint8_t i_byte;
+                    do
+                    {
+                        if( i_offset >= i_size )
+                            return false;
+                        i_byte = p[i_offset++];
+                        i_frame += i_byte;
+                    } while( i_byte == 0xFF );
+                    sb.frame_size[i] = i_frame;
+                    i_total += i_frame;
+                }
+                break;
+
+            case 2: /* fixed size */
+                if( ( i_size - i_offset ) % sb.i_frames )
+                    return false;
+                for( unsigned i = 0; i < sb.i_frames - 1; i++ )
+                    sb.frame_size[i] = ( i_size - i_offset ) / sb.i_frames;
+                i_total = uint64_t( sb.i_frames - 1 ) * ( ( i_size - i_offset ) / sb.i_frames );
+                break;
+
+            case 3: /* EBML */
+            {
+                int64_t i_frame = 0;
+                for( unsigned i = 0; i < sb.i_frames - 1; i++ )
+                {
+                    uint64_t i_value;
+                    size_t i_len = ReadVint( &p[i_offset], i_size - i_offset, &i_value );
+                    if( i_len == 0 )
+                        return false;
+                    i_offset += i_len;
+
+                    /* following sizes are signed differences */
+                    if( i == 0 )
+                        i_frame = i_value;
+                    else
+                        i_frame += int64_t( i_value ) - ( ( INT64_C(1) << ( 7 * i_len - 1 ) ) - 1 );
+
+                    if( i_frame < 0 || i_frame > UINT32_MAX )
+                        return false;
+                    sb.frame_size[i] = i_frame;
+                    i_total += i_frame;
+                }
+                break;
+            }
+        }
+
+        if( i_offset > i_size || i_total > i_size - i_offset )
+            return false;
+        sb.frame_size[sb.i_frames - 1] = i_size - i_offset - i_total;
+        return true;
+    }
+}
+
+/* Returns 1 if a SimpleBlock was read, 0 if the next element is something
+ * else and -1 if an invalid SimpleBlock was skipped */
+int matroska_segment_c::ReadSimpleBlock( mkv_simpleblock_t & sb )
+{
+    uint64_t i_pos, i_size;
+
+    if( !ep.GetRawSimpleBlock( &i_pos, &i_size ) )
+        return 0;
+
+    IOCallback & io = es.I_O();
+    const uint64_t i_end = io.getFilePointer() + i_size;
+
+    /* track number (up to 8 bytes), timecode and flags */
+    uint8_t header[11];
+    const uint8_t *p_header = header;
+
+    sb.p_data = NULL;
+    if( sb.b_read_data )
+    {
+        if( i_size < 4 || i_size > UINT32_MAX ||
+            ( sb.p_data = block_Alloc( i_size ) ) == NULL )
+            goto skip;
+        if( io.read( sb.p_data->p_buffer, i_size ) != i_size )
+            goto skip;
+        p_header = sb.p_data->p_buffer;
+    }
+    else
+    {
+        size_t i_header = std::min( i_size, uint64_t( sizeof( header ) ) );
+        if( i_size < 4 || io.read( header, i_header ) != i_header )
+            goto skip;
+        io.setFilePointer( i_end );
+    }
+
+    {
+        uint64_t i_track;
+        size_t i_len = ReadVint( p_header, std::min( i_size, uint64_t( 8 ) ), &i_track );
+        if( i_len == 0 || i_len + 3 > i_size || FindTrackByNumber( i_track ) == NULL )
+            goto skip;
+
+        const int16_t i_local = int16_t( GetWBE( &p_header[i_len] ) );
+        const uint8_t i_flags = p_header[i_len + 2];
+
+        sb.i_fpos        = i_pos;
+        sb.i_track       = i_track;
+        sb.i_timecode    = cluster->GlobalTimecode() + int64_t( i_local ) * int64_t( i_timescale );
+        sb.b_keyframe    = i_flags & 0x80;
+        sb.b_discardable = i_flags & 0x01;
+        sb.i_frames      = 0;
+
+        if( sb.p_data != NULL )
+        {
+            size_t i_offset = i_len + 3;
+            if( !ParseLacing( sb, &sb.p_data->p_buffer[i_offset], i_size - i_offset,
+                              ( i_flags >> 1 ) & 0x03 ) )
+            {
+                msg_Warn( &sys.demuxer, "invalid lacing in SimpleBlock at %" PRIu64, i_pos );
+                goto skip;
+            }
+
+            i_offset = i_size;
+            for( unsigned i = sb.i_frames; i > 0; i-- )
+            {
+                i_offset -= sb.frame_size[i - 1];
+                sb.frame_offset[i - 1] = i_offset;
+            }
+        }
+    }
+
+    if( sb.b_keyframe )
+        _seeker.add_seekpoint( sb.i_track,
+            SegmentSeeker::Seekpoint( sb.i_fpos, sb.i_timecode / 1000 ) );
+
+    return 1;
+
+skip:
+    if( sb.p_data != NULL )
+    {
+        block_Release( sb.p_data );
+        sb.p_data = NULL;
+    }
+    io.setFilePointer( i_end );
+    return -1;
+}
+
 void matroska_segment_c::ComputeTrackPriority()
 {
     bool b_has_default_video = false;
@@ -1178,7 +1494,7 @@ void matroska_segment_c::ESDestroy( )
 int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_simpleblock,
                                   KaxBlockAdditions * & pp_additions,
                                   bool *pb_key_picture, bool *pb_discardable_picture,
-                                  int64_t *pi_duration )
+                                  int64_t *pi_duration, mkv_simpleblock_t *p_simpleblock_raw )
 {
     pp_simpleblock = NULL;
     pp_block = NULL;
@@ -1352,6 +1668,22 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
         EbmlElement *el = NULL;
         int         i_level;
 
+        /* SimpleBlocks of the current cluster are read without libmatroska */
+        if( p_simpleblock_raw != NULL && pp_block == NULL && pp_simpleblock == NULL &&
+            payload.b_cluster_timecode && cluster != NULL &&
+            ep.GetLevel() == 2 && ep.IsTopPresent( cluster ) )
+        {
+            int i_ret = ReadSimpleBlock( *p_simpleblock_raw );
+            if( i_ret > 0 )
+            {
+                *pb_key_picture         = p_simpleblock_raw->b_keyframe;
+                *pb_discardable_picture = p_simpleblock_raw->b_discardable;
+                return VLC_SUCCESS;
+            }
+            if( i_ret < 0 )
+                continue;
+        }
+
         if( pp_simpleblock != NULL || ((el = ep.Get()) == NULL && pp_block != NULL) )
         {
             /* Check blocks validity to protect againts broken files */
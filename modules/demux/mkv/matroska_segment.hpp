@@ -27,6 +27,8 @@
 
 #include "mkv.hpp"
 #include "matroska_segment_seeker.hpp"
+#include "cluster_scanner.hpp"
+#include "../index_cache.h"
 #include <vector>
 #include <string>
 
@@ -144,9 +146,10 @@ public:
     bool Seek( demux_t &, mtime_t i_mk_date, mtime_t i_mk_time_offset, bool b_accurate );
 
     int BlockGet( KaxBlock * &, KaxSimpleBlock * &, KaxBlockAdditions * &,
-                  bool *, bool *, int64_t *);
+                  bool *, bool *, int64_t *, mkv_simpleblock_t * = NULL );
 
     mkv_track_t * FindTrackByBlock(const KaxBlock *, const KaxSimpleBlock * );
+    mkv_track_t * FindTrackByNumber( unsigned );
 
     bool ESCreate( );
     void ESDestroy( );
@@ -169,11 +172,20 @@ private:
     bool ParseCluster( KaxCluster *cluster, bool b_update_start_time = true, ScopeMode read_fully = SCOPE_ALL_DATA );
     bool ParseSimpleTags( SimpleTag* out, KaxTagSimple *tag, int level = 50 );
     void IndexAppendCluster( KaxCluster *cluster );
+    int  ReadSimpleBlock( mkv_simpleblock_t & );
     bool TrackInit( mkv_track_t * p_tk );
     void ComputeTrackPriority();
     void EnsureDuration();
+    bool IsOnMainStream() const;
+    bool IndexCacheLoad();
+    void IndexCacheSave();
+    void ClusterScanStart();
+    void ClusterScanFetch();
 
     SegmentSeeker _seeker;
+    index_cache_t *p_index_cache;
+    size_t        i_index_cache_size;
+    cluster_scanner_c *p_cluster_scanner;
 
     friend SegmentSeeker;
 };
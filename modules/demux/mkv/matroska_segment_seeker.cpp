@@ -47,6 +47,58 @@ namespace {
 
     template<class It> It prev_( It it ) { return --it; }
     template<class It> It next_( It it ) { return ++it; }
+
+    // little endian helpers for the index cache serialization
+
+    void put_32( std::vector<uint8_t>& out, uint32_t value )
+    {
+        uint8_t buf[4];
+        SetDWLE( buf, value );
+        out.insert( out.end(), buf, buf + sizeof( buf ) );
+    }
+
+    void put_64( std::vector<uint8_t>& out, uint64_t value )
+    {
+        uint8_t buf[8];
+        SetQWLE( buf, value );
+        out.insert( out.end(), buf, buf + sizeof( buf ) );
+    }
+
+    struct reader
+    {
+        reader( uint8_t const* p, size_t size ) : p( p ), left( size ), error( false ) { }
+
+        uint8_t const* get( size_t size )
+        {
+            if( error || left < size )
+            {
+                error = true;
+                return NULL;
+            }
+            uint8_t const* ret = p;
+            p += size;
+            left -= size;
+            return ret;
+        }
+
+        uint32_t get_32() { uint8_t const* b = get( 4 ); return b ? GetDWLE( b ) : 0; }
+        uint64_t get_64() { uint8_t const* b = get( 8 ); return b ? GetQWLE( b ) : 0; }
+
+        /* element count, rejected if the remaining data cannot hold it */
+        uint32_t get_count( size_t element_size )
+        {
+            uint32_t count = get_32();
+            if( count > left / element_size )
+                error = true;
+            return error ? 0 : count;
+        }
+
+        uint8_t const* p;
+        size_t left;
+        bool error;
+    };
+
+    const uint32_t SEEKER_CACHE_VERSION = 1;
 }
 
 SegmentSeeker::cluster_positions_t::iterator
@@ -58,6 +110,9 @@ SegmentSeeker::add_cluster_position( fptr_t fpos )
       fpos
     );
 
+    if( insertion_point != _cluster_positions.begin() && *prev_( insertion_point ) == fpos )
+        return prev_( insertion_point ); // already known
+
     return _cluster_positions.insert( insertion_point, fpos );
 }
 
@@ -73,6 +128,12 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
             : UINT64_MAX
     };
 
+    return add_cluster( cinfo );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( Cluster const& cinfo )
+{
     add_cluster_position( cinfo.fpos );
 
     cluster_map_t::iterator it = _clusters.lower_bound( cinfo.pts );
@@ -348,6 +409,10 @@ SegmentSeeker::index_unsearched_range( matroska_segment_c& ms, Range search_area
     fptr_t  block_pos = search_area.start;
     mtime_t block_pts;
 
+    /* only the block headers are needed to build the index */
+    mkv_simpleblock_t rawblock;
+    rawblock.b_read_data = false;
+
     while( block_pos < search_area.end )
     {
         KaxBlock * block;
@@ -360,21 +425,30 @@ SegmentSeeker::index_unsearched_range( matroska_segment_c& ms, Range search_area
         track_id_t track_id;
 
         if( ms.BlockGet( block, simpleblock, additions,
-                         &b_key_picture, &b_discardable_picture, &i_block_duration ) )
+                         &b_key_picture, &b_discardable_picture, &i_block_duration,
+                         &rawblock ) )
             break;
 
+        bool b_valid_track;
+
         if( simpleblock ) {
             block_pos = simpleblock->GetElementPosition();
             block_pts = simpleblock->GlobalTimecode() / 1000;
             track_id  = simpleblock->TrackNum();
+            b_valid_track = ms.FindTrackByBlock( block, simpleblock ) != NULL;
         }
-        else {
+        else if( block ) {
             block_pos = block->GetElementPosition();
             block_pts = block->GlobalTimecode() / 1000;
             track_id  = block->TrackNum();
+            b_valid_track = ms.FindTrackByBlock( block, simpleblock ) != NULL;
+        }
+        else {
+            block_pos = rawblock.i_fpos;
+            block_pts = rawblock.i_timecode / 1000;
+            track_id  = rawblock.i_track;
+            b_valid_track = true; /* checked by BlockGet() */
         }
-
-        bool const b_valid_track = ms.FindTrackByBlock( block, simpleblock ) != NULL;
 
         delete block;
 
@@ -518,3 +592,122 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
     ms.es.I_O().setFilePointer( fpos );
 }
 
+/* The seeker state is stored as version(32) followed by the searched ranges,
+ * the seekpoints of each track, the cluster positions and the clusters, each
+ * list prefixed by its element count(32). All values are little endian. */
+
+void
+SegmentSeeker::serialize( std::vector<uint8_t>& out ) const
+{
+    put_32( out, SEEKER_CACHE_VERSION );
+
+    put_32( out, _ranges_searched.size() );
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+    {
+        put_64( out, it->start );
+        put_64( out, it->end );
+    }
+
+    put_32( out, _tracks_seekpoints.size() );
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+    {
+        put_32( out, it->first );
+        put_32( out, it->second.size() );
+
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+        {
+            put_64( out, sp->fpos );
+            put_64( out, sp->pts );
+            put_32( out, sp->trust_level );
+        }
+    }
+
+    put_32( out, _cluster_positions.size() );
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin(); it != _cluster_positions.end(); ++it )
+        put_64( out, *it );
+
+    put_32( out, _clusters.size() );
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+    {
+        put_64( out, it->second.fpos );
+        put_64( out, it->second.pts );
+        put_64( out, it->second.duration );
+        put_64( out, it->second.size );
+    }
+}
+
+bool
+SegmentSeeker::deserialize( uint8_t const* p_data, size_t i_data )
+{
+    reader r( p_data, i_data );
+
+    if( r.get_32() != SEEKER_CACHE_VERSION )
+        return false;
+
+    ranges_t ranges;
+    for( uint32_t i = r.get_count( 16 ); i > 0; --i )
+    {
+        fptr_t start = r.get_64();
+        fptr_t end   = r.get_64();
+
+        if( start > end || ( ranges.size() && ranges.rbegin()->end >= start ) )
+            return false;
+
+        ranges.push_back( Range( start, end ) );
+    }
+
+    tracks_seekpoints_t tracks_seekpoints;
+    for( uint32_t i = r.get_count( 8 ); i > 0; --i )
+    {
+        seekpoints_t& seekpoints = tracks_seekpoints[ r.get_32() ];
+
+        for( uint32_t j = r.get_count( 20 ); j > 0; --j )
+        {
+            fptr_t  fpos  = r.get_64();
+            mtime_t pts   = r.get_64();
+            int32_t trust = r.get_32();
+
+            if( trust != Seekpoint::TRUSTED && trust != Seekpoint::QUESTIONABLE &&
+                trust != Seekpoint::DISABLED )
+                return false;
+
+            if( seekpoints.size() && pts <= seekpoints.rbegin()->pts )
+                return false;
+
+            seekpoints.push_back( Seekpoint( fpos, pts, Seekpoint::TrustLevel( trust ) ) );
+        }
+    }
+
+    cluster_positions_t cluster_positions;
+    for( uint32_t i = r.get_count( 8 ); i > 0; --i )
+    {
+        fptr_t fpos = r.get_64();
+
+        if( cluster_positions.size() && fpos < *cluster_positions.rbegin() )
+            return false;
+
+        cluster_positions.push_back( fpos );
+    }
+
+    cluster_map_t clusters;
+    for( uint32_t i = r.get_count( 32 ); i > 0; --i )
+    {
+        Cluster cinfo;
+        cinfo.fpos     = r.get_64();
+        cinfo.pts      = r.get_64();
+        cinfo.duration = r.get_64();
+        cinfo.size     = r.get_64();
+
+        clusters.insert( clusters.end(), cluster_map_t::value_type( cinfo.pts, cinfo ) );
+    }
+
+    if( r.error || r.left )
+        return false;
+
+    _ranges_searched.swap( ranges );
+    _tracks_seekpoints.swap( tracks_seekpoints );
+    _cluster_positions.swap( cluster_positions );
+    _clusters.swap( clusters );
+
+    return true;
+}
@@ -80,6 +80,10 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-scan-clusters", true,
+            N_("Scan clusters in the background"),
+            N_("Find the cluster positions of local files without index in the background, to speed up seeking"), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -485,22 +489,13 @@ static int Seek( demux_t *p_demux, mtime_t i_mk_date, double f_percent, virtual_
     return p_vsegment->Seek( *p_demux, i_mk_date, p_vchapter, b_precise ) ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
-/* Needed by matroska_segment::Seek() and Seek */
-void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
-                  KaxBlockAdditions *additions,
-                  mtime_t i_pts, int64_t i_duration, bool b_key_picture,
-                  bool b_discardable_picture )
+/* Returns the track a block should be sent to, NULL if it must be dropped */
+static mkv_track_t *BlockTrack( demux_t *p_demux, mkv_track_t *p_track )
 {
-    demux_sys_t        *p_sys = p_demux->p_sys;
-    matroska_segment_c *p_segment = p_sys->p_current_vsegment->CurrentSegment();
-
-    if( !p_segment ) return;
-
-    mkv_track_t *p_track = p_segment->FindTrackByBlock( block, simpleblock );
     if( p_track == NULL )
     {
         msg_Err( p_demux, "invalid track number" );
-        return;
+        return NULL;
     }
 
     mkv_track_t &track = *p_track;
@@ -508,11 +503,9 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     if( track.fmt.i_cat != DATA_ES && track.p_es == NULL )
     {
         msg_Err( p_demux, "unknown track number" );
-        return;
+        return NULL;
     }
 
-    i_pts -= track.i_codec_delay;
-
     if ( track.fmt.i_cat != DATA_ES )
     {
         bool b;
@@ -522,10 +515,191 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
         {
             if( track.fmt.i_cat == VIDEO_ES || track.fmt.i_cat == AUDIO_ES )
                 track.i_last_dts = VLC_TS_INVALID;
-            return;
+            return NULL;
+        }
+    }
+
+    return p_track;
+}
+
+/* Sends one frame of a block, returns false if the following frames of the
+ * block must not be sent. If pp_source points to a block holding the frame,
+ * it can be used instead of a copy, in which case it is set to NULL. */
+static bool FrameDecode( demux_t *p_demux, matroska_segment_c *p_segment, mkv_track_t &track,
+                         uint8_t *p_data, size_t i_data, block_t **pp_source,
+                         KaxBlockAdditions *additions, mtime_t &i_pts, int64_t i_duration,
+                         unsigned int i_number_frames, bool b_key_picture,
+                         bool b_discardable_picture )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    block_t *p_block;
+
+    size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
+
+    if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
+        track.p_compression_data != NULL &&
+        track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
+        p_block = MemToBlock( p_data, i_data, track.p_compression_data->GetSize() + extra_data );
+    else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
+        p_block = packetize_wavpack( track, p_data, i_data );
+    else if( pp_source != NULL && *pp_source != NULL && extra_data == 0 )
+    {
+        /* hand the data over without copying it */
+        p_block = *pp_source;
+        *pp_source = NULL;
+        p_block->p_buffer = p_data;
+        p_block->i_buffer = i_data;
+    }
+    else
+        p_block = MemToBlock( p_data, i_data, extra_data );
+
+    if( p_block == NULL )
+    {
+        return false;
+    }
+
+#if defined(HAVE_ZLIB_H)
+    if( track.i_compression_type == MATROSKA_COMPRESSION_ZLIB &&
+        track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
+    {
+        p_block = block_zlib_decompress( VLC_OBJECT(p_demux), p_block );
+        if( p_block == NULL )
+            return false;
+    }
+    else
+#endif
+    if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
+        track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
+    {
+        memcpy( p_block->p_buffer, track.p_compression_data->GetBuffer(), track.p_compression_data->GetSize() );
+    }
+    if ( track.fmt.i_codec == VLC_CODEC_PRORES )
+        memcpy( p_block->p_buffer + 4, "icpf", 4 );
+
+    if ( b_key_picture )
+        p_block->i_flags |= BLOCK_FLAG_TYPE_I;
+
+    switch( track.fmt.i_codec )
+    {
+    case VLC_CODEC_COOK:
+    case VLC_CODEC_ATRAC3:
+    {
+        handle_real_audio(p_demux, &track, p_block, i_pts);
+        block_Release(p_block);
+        i_pts = ( track.i_default_duration )?
+            i_pts + ( mtime_t )track.i_default_duration:
+            VLC_TS_INVALID;
+        return true;
+     }
+
+     case VLC_CODEC_WEBVTT:
+        {
+            const uint8_t *p_addition = NULL;
+            size_t i_addition = 0;
+            if(additions)
+            {
+                KaxBlockMore *blockmore = FindChild<KaxBlockMore>(*additions);
+                if(blockmore)
+                {
+                    KaxBlockAdditional *addition = FindChild<KaxBlockAdditional>(*blockmore);
+                    if(addition)
+                    {
+                        i_addition = static_cast<std::string::size_type>(addition->GetSize());
+                        p_addition = reinterpret_cast<const uint8_t *>(addition->GetBuffer());
+                    }
+                }
+            }
+            p_block = WEBVTT_Repack_Sample( p_block, /* D_WEBVTT -> webm */
+                                            !track.codec.compare( 0, 1, "D" ),
+                                            p_addition, i_addition );
+            if( !p_block )
+                return true;
+        }
+        break;
+
+     case VLC_CODEC_OPUS:
+        {
+            mtime_t i_length = i_duration * track. f_timecodescale *
+                    (double) p_segment->i_timescale / 1000.0;
+            if ( i_length < 0 ) i_length = 0;
+            p_block->i_nb_samples = i_length * track.fmt.audio.i_rate
+                    / CLOCK_FREQ;
+            break;
+        }
+
+      case VLC_CODEC_AV1:
+        p_block = AV1_Unpack_Sample( p_block );
+        if( unlikely( !p_block ) )
+            return true;
+        break;
+    }
+
+    if( track.fmt.i_cat != VIDEO_ES )
+    {
+        if ( track.fmt.i_cat == DATA_ES )
+        {
+            // TODO handle the start/stop times of this packet
+            if( p_block->i_size >= sizeof(pci_t))
+                p_sys->p_ev->SetPci( (const pci_t *)&p_block->p_buffer[1]);
+            block_Release( p_block );
+            return false;
+        }
+        p_block->i_dts = p_block->i_pts = i_pts;
+    }
+    else
+    {
+        // correct timestamping when B frames are used
+        if( track.b_dts_only )
+        {
+            p_block->i_pts = VLC_TS_INVALID;
+            p_block->i_dts = i_pts;
+        }
+        else if( track.b_pts_only )
+        {
+            p_block->i_pts = i_pts;
+            p_block->i_dts = i_pts;
+        }
+        else
+        {
+            p_block->i_pts = i_pts;
+            // condition when the DTS is correct (keyframe or B frame == NOT P frame)
+            if ( b_key_picture || b_discardable_picture )
+                    p_block->i_dts = p_block->i_pts;
+            else if ( track.i_last_dts == VLC_TS_INVALID )
+                p_block->i_dts = i_pts;
+            else
+                p_block->i_dts = std::min( i_pts, track.i_last_dts + ( mtime_t )track.i_default_duration );
         }
     }
 
+    send_Block( p_demux, &track, p_block, i_number_frames, i_duration );
+
+    /* use time stamp only for first block */
+    i_pts = ( track.i_default_duration )?
+             i_pts + ( mtime_t )track.i_default_duration:
+             ( track.fmt.b_packetized ) ? VLC_TS_INVALID : i_pts + 1;
+    return true;
+}
+
+/* Needed by matroska_segment::Seek() and Seek */
+void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
+                  KaxBlockAdditions *additions,
+                  mtime_t i_pts, int64_t i_duration, bool b_key_picture,
+                  bool b_discardable_picture )
+{
+    demux_sys_t        *p_sys = p_demux->p_sys;
+    matroska_segment_c *p_segment = p_sys->p_current_vsegment->CurrentSegment();
+
+    if( !p_segment ) return;
+
+    mkv_track_t *p_track = BlockTrack( p_demux, p_segment->FindTrackByBlock( block, simpleblock ) );
+    if( p_track == NULL )
+        return;
+
+    mkv_track_t &track = *p_track;
+
+    i_pts -= track.i_codec_delay;
+
     size_t frame_size = 0;
     size_t block_size = 0;
 
@@ -539,7 +713,6 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
 
     for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
     {
-        block_t *p_block;
         DataBuffer *data;
         if( simpleblock != NULL )
         {
@@ -555,143 +728,49 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
             msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
             break;
         }
-        size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
-
-        if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
-            track.p_compression_data != NULL &&
-            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
-        else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
-        else
-            p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
 
-        if( p_block == NULL )
-        {
+        if( !FrameDecode( p_demux, p_segment, track, data->Buffer(), data->Size(), NULL,
+                          additions, i_pts, i_duration, i_number_frames,
+                          b_key_picture, b_discardable_picture ) )
             break;
-        }
+    }
+}
 
-#if defined(HAVE_ZLIB_H)
-        if( track.i_compression_type == MATROSKA_COMPRESSION_ZLIB &&
-            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-        {
-            p_block = block_zlib_decompress( VLC_OBJECT(p_demux), p_block );
-            if( p_block == NULL )
-                break;
-        }
-        else
-#endif
-        if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
-            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-        {
-            memcpy( p_block->p_buffer, track.p_compression_data->GetBuffer(), track.p_compression_data->GetSize() );
-        }
-        if ( track.fmt.i_codec == VLC_CODEC_PRORES )
-            memcpy( p_block->p_buffer + 4, "icpf", 4 );
+/* Same for a SimpleBlock read by matroska_segment_c::BlockGet(), the frames
+ * are sent as slices of its data, which is released */
+void BlockDecode( demux_t *p_demux, mkv_simpleblock_t &simpleblock, mtime_t i_pts )
+{
+    demux_sys_t        *p_sys = p_demux->p_sys;
+    matroska_segment_c *p_segment = p_sys->p_current_vsegment->CurrentSegment();
+    block_t            *p_data = simpleblock.p_data;
 
-        if ( b_key_picture )
-            p_block->i_flags |= BLOCK_FLAG_TYPE_I;
+    simpleblock.p_data = NULL;
 
-        switch( track.fmt.i_codec )
-        {
-        case VLC_CODEC_COOK:
-        case VLC_CODEC_ATRAC3:
-        {
-            handle_real_audio(p_demux, &track, p_block, i_pts);
-            block_Release(p_block);
-            i_pts = ( track.i_default_duration )?
-                i_pts + ( mtime_t )track.i_default_duration:
-                VLC_TS_INVALID;
-            continue;
-         }
-
-         case VLC_CODEC_WEBVTT:
-            {
-                const uint8_t *p_addition = NULL;
-                size_t i_addition = 0;
-                if(additions)
-                {
-                    KaxBlockMore *blockmore = FindChild<KaxBlockMore>(*additions);
-                    if(blockmore)
-                    {
-                        KaxBlockAdditional *addition = FindChild<KaxBlockAdditional>(*blockmore);
-                        if(addition)
-                        {
-                            i_addition = static_cast<std::string::size_type>(addition->GetSize());
-                            p_addition = reinterpret_cast<const uint8_t *>(addition->GetBuffer());
-                        }
-                    }
-                }
-                p_block = WEBVTT_Repack_Sample( p_block, /* D_WEBVTT -> webm */
-                                                !p_track->codec.compare( 0, 1, "D" ),
-                                                p_addition, i_addition );
-                if( !p_block )
-                    continue;
-            }
-            break;
+    mkv_track_t *p_track = p_segment ?
+        BlockTrack( p_demux, p_segment->FindTrackByNumber( simpleblock.i_track ) ) : NULL;
 
-         case VLC_CODEC_OPUS:
-            {
-                mtime_t i_length = i_duration * track. f_timecodescale *
-                        (double) p_segment->i_timescale / 1000.0;
-                if ( i_length < 0 ) i_length = 0;
-                p_block->i_nb_samples = i_length * track.fmt.audio.i_rate
-                        / CLOCK_FREQ;
-                break;
-            }
+    if( p_track != NULL )
+    {
+        mkv_track_t &track = *p_track;
 
-          case VLC_CODEC_AV1:
-            p_block = AV1_Unpack_Sample( p_block );
-            if( unlikely( !p_block ) )
-                continue;
-            break;
-        }
+        i_pts -= track.i_codec_delay;
 
-        if( track.fmt.i_cat != VIDEO_ES )
+        for( unsigned int i_frame = 0; i_frame < simpleblock.i_frames; i_frame++ )
         {
-            if ( track.fmt.i_cat == DATA_ES )
-            {
-                // TODO handle the start/stop times of this packet
-                if( p_block->i_size >= sizeof(pci_t))
-                    p_sys->p_ev->SetPci( (const pci_t *)&p_block->p_buffer[1]);
-                block_Release( p_block );
-                return;
-            }
-            p_block->i_dts = p_block->i_pts = i_pts;
-        }
-        else
-        {
-            // correct timestamping when B frames are used
-            if( track.b_dts_only )
-            {
-                p_block->i_pts = VLC_TS_INVALID;
-                p_block->i_dts = i_pts;
-            }
-            else if( track.b_pts_only )
-            {
-                p_block->i_pts = i_pts;
-                p_block->i_dts = i_pts;
-            }
-            else
-            {
-                p_block->i_pts = i_pts;
-                // condition when the DTS is correct (keyframe or B frame == NOT P frame)
-                if ( b_key_picture || b_discardable_picture )
-                        p_block->i_dts = p_block->i_pts;
-                else if ( track.i_last_dts == VLC_TS_INVALID )
-                    p_block->i_dts = i_pts;
-                else
-                    p_block->i_dts = std::min( i_pts, track.i_last_dts + ( mtime_t )track.i_default_duration );
-            }
+            uint8_t *p_frame = p_data->p_buffer + simpleblock.frame_offset[i_frame];
+            bool b_last = i_frame + 1 == simpleblock.i_frames;
+
+            if( !FrameDecode( p_demux, p_segment, track,
+                              p_frame, simpleblock.frame_size[i_frame],
+                              b_last ? &p_data : NULL, NULL, i_pts, 0,
+                              simpleblock.i_frames,
+                              simpleblock.b_keyframe, simpleblock.b_discardable ) )
+                break;
         }
-
-        send_Block( p_demux, &track, p_block, i_number_frames, i_duration );
-
-        /* use time stamp only for first block */
-        i_pts = ( track.i_default_duration )?
-                 i_pts + ( mtime_t )track.i_default_duration:
-                 ( track.fmt.b_packetized ) ? VLC_TS_INVALID : i_pts + 1;
     }
+
+    if( p_data != NULL )
+        block_Release( p_data );
 }
 
 /*****************************************************************************
@@ -724,9 +803,14 @@ static int Demux( demux_t *p_demux)
     int64_t i_block_duration = 0;
     bool b_key_picture;
     bool b_discardable_picture;
+    mkv_simpleblock_t rawblock;
+
+    rawblock.b_read_data = true;
+    rawblock.p_data = NULL;
 
     if( p_segment->BlockGet( block, simpleblock, additions,
-                             &b_key_picture, &b_discardable_picture, &i_block_duration ) )
+                             &b_key_picture, &b_discardable_picture, &i_block_duration,
+                             &rawblock ) )
     {
         if ( p_vsegment->CurrentEdition() && p_vsegment->CurrentEdition()->b_ordered )
         {
@@ -748,13 +832,16 @@ static int Demux( demux_t *p_demux)
     }
 
     {
-        mkv_track_t *p_track = p_segment->FindTrackByBlock( block, simpleblock );
+        mkv_track_t *p_track = ( block || simpleblock ) ?
+                               p_segment->FindTrackByBlock( block, simpleblock ) :
+                               p_segment->FindTrackByNumber( rawblock.i_track );
 
         if( p_track == NULL )
         {
             msg_Err( p_demux, "invalid track number" );
             delete block;
             delete additions;
+            if( rawblock.p_data ) block_Release( rawblock.p_data );
             return 0;
         }
 
@@ -765,13 +852,15 @@ static int Demux( demux_t *p_demux)
 
             uint64_t block_fpos = 0;
 
-            if( block ) block_fpos = block->GetElementPosition();
-            else        block_fpos = simpleblock->GetElementPosition();
+            if( block )            block_fpos = block->GetElementPosition();
+            else if( simpleblock ) block_fpos = simpleblock->GetElementPosition();
+            else                   block_fpos = rawblock.i_fpos;
 
             if ( track.i_skip_until_fpos > block_fpos )
             {
                 delete block;
                 delete additions;
+                if( rawblock.p_data ) block_Release( rawblock.p_data );
 	        return 1; // this block shall be ignored
             }
         }
@@ -806,6 +895,7 @@ static int Demux( demux_t *p_demux)
                 msg_Err( p_demux, "ES_OUT_SET_PCR failed, aborting." );
                 delete block;
                 delete additions;
+                if( rawblock.p_data ) block_Release( rawblock.p_data );
                 return 0;
             }
 
@@ -818,7 +908,8 @@ static int Demux( demux_t *p_demux)
         p_sys->i_pts = p_sys->i_mk_chapter_time + VLC_TS_0;
 
         if( simpleblock != NULL ) p_sys->i_pts += simpleblock->GlobalTimecode() / INT64_C( 1000 );
-        else                      p_sys->i_pts +=       block->GlobalTimecode() / INT64_C( 1000 );
+        else if( block != NULL )  p_sys->i_pts +=       block->GlobalTimecode() / INT64_C( 1000 );
+        else                      p_sys->i_pts +=       rawblock.i_timecode / INT64_C( 1000 );
     }
 
     if ( p_vsegment->CurrentEdition() &&
@@ -828,11 +919,15 @@ static int Demux( demux_t *p_demux)
         /* nothing left to read in this ordered edition */
         delete block;
         delete additions;
+        if( rawblock.p_data ) block_Release( rawblock.p_data );
         return 0;
     }
 
-    BlockDecode( p_demux, block, simpleblock, additions,
-                 p_sys->i_pts, i_block_duration, b_key_picture, b_discardable_picture );
+    if( block != NULL || simpleblock != NULL )
+        BlockDecode( p_demux, block, simpleblock, additions,
+                     p_sys->i_pts, i_block_duration, b_key_picture, b_discardable_picture );
+    else
+        BlockDecode( p_demux, rawblock, p_sys->i_pts );
 
     delete block;
     delete additions;
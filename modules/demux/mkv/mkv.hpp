@@ -120,10 +120,32 @@ enum
 
 using namespace LIBMATROSKA_NAMESPACE;
 
+/* SimpleBlock read straight from the stream by matroska_segment_c::BlockGet(),
+ * without going through libmatroska objects. It is filled when BlockGet()
+ * returns neither a KaxBlock nor a KaxSimpleBlock. */
+struct mkv_simpleblock_t
+{
+    static const unsigned MAX_FRAMES = 256;
+
+    bool     b_read_data;   /* set by the caller, false to only parse the header */
+
+    uint64_t i_fpos;        /* element position */
+    unsigned i_track;
+    int64_t  i_timecode;    /* same as KaxInternalBlock::GlobalTimecode() */
+    bool     b_keyframe;
+    bool     b_discardable;
+
+    block_t *p_data;        /* the block data, frames are slices of it */
+    unsigned i_frames;
+    uint32_t frame_offset[MAX_FRAMES];
+    uint32_t frame_size[MAX_FRAMES];
+};
+
 void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
                   KaxBlockAdditions *additions,
                   mtime_t i_pts, mtime_t i_duration, bool b_key_picture,
                   bool b_discardable_picture );
+void BlockDecode( demux_t *p_demux, mkv_simpleblock_t &simpleblock, mtime_t i_pts );
 
 class attachment_c
 {
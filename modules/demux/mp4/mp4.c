@@ -50,6 +50,10 @@ static void Close( vlc_object_t * );
 #define MP4_M4A_TEXT     N_("M4A audio only")
 #define MP4_M4A_LONGTEXT N_("Ignore non audio tracks from iTunes audio files")
 
+#define MP4_LAZY_TEXT     N_("Load samples tables on demand")
+#define MP4_LAZY_LONGTEXT N_("Expand the timing tables of large files around " \
+                             "the playback position only, instead of at opening")
+
 vlc_module_begin ()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_DEMUX )
@@ -60,6 +64,7 @@ vlc_module_begin ()
 
     add_category_hint("Hacks", NULL, true)
     add_bool( CFG_PREFIX"m4a-audioonly", false, MP4_M4A_TEXT, MP4_M4A_LONGTEXT, true )
+    add_bool( CFG_PREFIX"lazy-tables", true, MP4_LAZY_TEXT, MP4_LAZY_LONGTEXT, true )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -70,6 +75,19 @@ static int   DemuxRef( demux_t *p_demux ){ (void)p_demux; return 0;}
 static int   DemuxFrag( demux_t * );
 static int   Control ( demux_t *, int, va_list );
 
+/* Range of the file read at once for the samples of several tracks */
+typedef struct
+{
+    uint64_t i_pos;
+    block_t *p_data;
+    uint64_t i_last_use;
+} mp4_extent_t;
+
+#define MP4_READ_EXTENTS      4
+#define MP4_READ_EXTENT_MAX   (2 * 1024 * 1024)
+#define MP4_READ_GAP_MAX      (128 * 1024)
+#define MP4_READ_PLAN_CHUNKS  16
+
 struct demux_sys_t
 {
     MP4_Box_t    *p_root;      /* container for the whole file */
@@ -121,6 +139,14 @@ struct demux_sys_t
     } hacks;
 
     mp4_fragments_index_t *p_fragsindex;
+
+    /* coalesced reads of interleaved tracks, on slow seeking streams */
+    struct
+    {
+        bool         b_enabled;
+        mp4_extent_t extents[MP4_READ_EXTENTS];
+        uint64_t     i_use;
+    } reader;
 };
 
 #define DEMUX_INCREMENT (CLOCK_FREQ / 4) /* How far the pcr will go, each round */
@@ -154,6 +180,7 @@ static uint64_t MP4_TrackGetPos    ( mp4_track_t * );
 static uint32_t MP4_TrackGetReadSize( mp4_track_t *, uint32_t * );
 static int      MP4_TrackNextSample( demux_t *, mp4_track_t *, uint32_t );
 static void     MP4_TrackSetELST( demux_t *, mp4_track_t *, int64_t );
+static void     MP4_TrackLoadChunk( demux_t *, mp4_track_t *, uint32_t );
 
 static void     MP4_UpdateSeekpoint( demux_t *, int64_t );
 
@@ -298,6 +325,7 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
 static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
+    MP4_TrackLoadChunk( p_demux, p_track, p_track->i_chunk );
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
 
     unsigned int i_index = 0;
@@ -347,7 +375,7 @@ static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
 static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
                                          int64_t *pi_delta )
 {
-    VLC_UNUSED( p_demux );
+    MP4_TrackLoadChunk( p_demux, p_track, p_track->i_chunk );
     mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
 
     unsigned int i_index = 0;
@@ -1010,6 +1038,7 @@ static int Open( vlc_object_t * p_this )
             msg_Warn( p_demux, "that media doesn't look interleaved, will need to seek");
         else if( i_max_continuity > DEMUX_TRACK_MAX_PRELOAD )
             msg_Warn( p_demux, "that media doesn't look properly interleaved, will need to seek");
+        p_sys->reader.b_enabled = p_sys->b_seekable;
     }
 
     /* */
@@ -1190,6 +1219,146 @@ static uint64_t OverflowCheck( demux_t *p_demux, mp4_track_t *tk,
     return i_samplessize;
 }
 
+/*****************************************************************************
+ * Reader: serves the samples from extents of the file covering the
+ * upcoming chunks of all the selected tracks, sorted by position, so
+ * that interleaved tracks don't cause one seek and small read per chunk.
+ *****************************************************************************/
+typedef struct
+{
+    uint64_t i_start;
+    uint64_t i_end;
+} mp4_range_t;
+
+static int RangeCmp( const void *a, const void *b )
+{
+    const mp4_range_t *ra = a, *rb = b;
+    return ( ra->i_start > rb->i_start ) - ( ra->i_start < rb->i_start );
+}
+
+static uint64_t MP4_ChunkGetSize( const mp4_track_t *tk, uint32_t i_chunk )
+{
+    const mp4_chunk_t *ck = &tk->chunk[i_chunk];
+
+    if( tk->i_sample_size )
+        return (uint64_t)ck->i_sample_count * tk->i_sample_size;
+
+    uint64_t i_size = 0;
+    for( uint32_t i = ck->i_sample_first;
+         i < ck->i_sample_first + ck->i_sample_count && i < tk->i_sample_count; i++ )
+        i_size += tk->p_sample_size[i];
+    return i_size;
+}
+
+static mp4_extent_t * MP4_ReaderLoad( demux_t *p_demux, uint64_t i_pos,
+                                      uint32_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_end = i_pos + i_size;
+
+    /* Plan: upcoming chunks of the selected tracks after the position */
+    mp4_range_t *p_ranges = vlc_alloc( p_sys->i_tracks * MP4_READ_PLAN_CHUNKS,
+                                       sizeof( *p_ranges ) );
+    if( p_ranges )
+    {
+        size_t i_ranges = 0;
+        for( unsigned i = 0; i < p_sys->i_tracks; i++ )
+        {
+            const mp4_track_t *tk = &p_sys->track[i];
+            if( !tk->b_ok || !tk->b_selected || tk->b_chapters_source ||
+                tk->i_sample >= tk->i_sample_count )
+                continue;
+
+            for( uint32_t j = tk->i_chunk; j < tk->i_chunk_count &&
+                                           j < tk->i_chunk + MP4_READ_PLAN_CHUNKS; j++ )
+            {
+                mp4_range_t r;
+                r.i_start = tk->chunk[j].i_offset;
+                r.i_end = r.i_start + MP4_ChunkGetSize( tk, j );
+                if( r.i_start >= i_pos )
+                    p_ranges[i_ranges++] = r;
+            }
+        }
+
+        /* Extend the read over the ranges following each other closely */
+        qsort( p_ranges, i_ranges, sizeof( *p_ranges ), RangeCmp );
+        for( size_t i = 0; i < i_ranges; i++ )
+        {
+            if( p_ranges[i].i_start > i_end + MP4_READ_GAP_MAX )
+                break;
+            if( p_ranges[i].i_end - i_pos <= MP4_READ_EXTENT_MAX &&
+                p_ranges[i].i_end > i_end )
+                i_end = p_ranges[i].i_end;
+        }
+        free( p_ranges );
+    }
+
+    /* Replace the least recently used extent */
+    mp4_extent_t *p_extent = &p_sys->reader.extents[0];
+    for( unsigned i = 1; i < MP4_READ_EXTENTS; i++ )
+        if( p_sys->reader.extents[i].i_last_use < p_extent->i_last_use )
+            p_extent = &p_sys->reader.extents[i];
+
+    if( p_extent->p_data )
+    {
+        block_Release( p_extent->p_data );
+        p_extent->p_data = NULL;
+    }
+
+    if( vlc_stream_Tell( p_demux->s ) != i_pos &&
+        MP4_Seek( p_demux->s, i_pos ) != VLC_SUCCESS )
+        return NULL;
+
+    p_extent->p_data = vlc_stream_Block( p_demux->s, i_end - i_pos );
+    if( !p_extent->p_data )
+        return NULL;
+    p_extent->i_pos = i_pos;
+
+    return p_extent;
+}
+
+/* Returns the samples at the position, or NULL to read them directly */
+static block_t * MP4_ReaderBlock( demux_t *p_demux, uint64_t i_pos,
+                                  uint32_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->reader.b_enabled || i_size > MP4_READ_EXTENT_MAX / 2 )
+        return NULL;
+
+    mp4_extent_t *p_extent = NULL;
+    for( unsigned i = 0; i < MP4_READ_EXTENTS && !p_extent; i++ )
+    {
+        mp4_extent_t *p_cur = &p_sys->reader.extents[i];
+        if( p_cur->p_data && i_pos >= p_cur->i_pos &&
+            i_pos + i_size <= p_cur->i_pos + p_cur->p_data->i_buffer )
+            p_extent = p_cur;
+    }
+
+    if( !p_extent )
+        p_extent = MP4_ReaderLoad( p_demux, i_pos, i_size );
+    if( !p_extent || i_pos + i_size > p_extent->i_pos + p_extent->p_data->i_buffer )
+        return NULL;
+
+    p_extent->i_last_use = ++p_sys->reader.i_use;
+
+    block_t *p_block = block_Alloc( i_size );
+    if( p_block )
+        memcpy( p_block->p_buffer,
+                &p_extent->p_data->p_buffer[i_pos - p_extent->i_pos], i_size );
+    return p_block;
+}
+
+static void MP4_ReaderClean( demux_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < MP4_READ_EXTENTS; i++ )
+    {
+        if( p_sys->reader.extents[i].p_data )
+            block_Release( p_sys->reader.extents[i].p_data );
+        p_sys->reader.extents[i].p_data = NULL;
+    }
+}
+
 /*****************************************************************************
  * Demux: read packet and send them to decoders
  *****************************************************************************
@@ -1230,7 +1399,10 @@ static int DemuxTrack( demux_t *p_demux, mp4_track_t *tk, uint64_t i_readpos,
             block_t *p_block;
             int64_t i_delta;
 
-            if( vlc_stream_Tell( p_demux->s ) != i_readpos )
+            /* from the coalesced reads first */
+            p_block = MP4_ReaderBlock( p_demux, i_readpos, i_samplessize );
+
+            if( !p_block && vlc_stream_Tell( p_demux->s ) != i_readpos )
             {
                 if( MP4_Seek( p_demux->s, i_readpos ) != VLC_SUCCESS )
                 {
@@ -1245,7 +1417,8 @@ static int DemuxTrack( demux_t *p_demux, mp4_track_t *tk, uint64_t i_readpos,
             i_samplessize = OverflowCheck( p_demux, tk, i_readpos, i_samplessize );
 
             /* now read pes */
-            if( !(p_block = vlc_stream_Block( p_demux->s, i_samplessize )) )
+            if( !p_block &&
+                !(p_block = vlc_stream_Block( p_demux->s, i_samplessize )) )
             {
                 msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)"
                                    ": Failed to read %d bytes sample at %"PRIu64,
@@ -2127,6 +2300,7 @@ static void Close ( vlc_object_t * p_this )
         vlc_meta_Delete( p_sys->p_meta );
 
     MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+    MP4_ReaderClean( p_sys );
 
     for( i_track = 0; i_track < p_sys->i_tracks; i_track++ )
         MP4_TrackClean( p_demux->out, &p_sys->track[i_track] );
@@ -2389,49 +2563,124 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
+/* Walks the stts or ctts entries covering the samples of a chunk, and
+ * stores them when pi_count is not NULL. Returns the number of entries. */
+static uint32_t xTTS_WalkChunk( const mp4_chunk_t *ck, mp4_tts_cursor_t *p_cur,
+                                const uint32_t *pi_entry_count,
+                                const int32_t *pi_entry_value,
+                                uint32_t i_entry_count, int64_t i_shift,
+                                uint32_t *pi_count, int32_t *pi_value,
+                                uint64_t *pi_duration )
 {
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
+    uint32_t i_entries = 0;
+    uint32_t i_sample_count = ck->i_sample_count;
+    uint64_t i_duration = 0;
+
+    while( i_sample_count > 0 && p_cur->i_index < i_entry_count )
     {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
+        const uint32_t i_avail = p_cur->i_left ? p_cur->i_left
+                                               : pi_entry_count[p_cur->i_index];
+        const uint32_t i_count = __MIN( i_avail, i_sample_count );
+        const int32_t i_value = pi_entry_value[p_cur->i_index];
 
-        if ( i_array_offset >= i_table_count )
+        if( pi_count )
         {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_ENOVAR;
+            pi_count[i_entries] = i_count;
+            pi_value[i_entries] = i_value + i_shift;
         }
+        i_duration += (uint64_t)i_count * (uint32_t)i_value;
+        i_entries++;
 
-        if ( i_index_samples_left )
+        i_sample_count -= i_count;
+        if( i_count < i_avail )
         {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
+            p_cur->i_left = i_avail - i_count;
         }
         else
         {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
+            p_cur->i_left = 0;
+            p_cur->i_index++;
+        }
+    }
+
+    if( pi_duration )
+        *pi_duration = i_duration;
+    return i_entries;
+}
+
+static void TrackGetTTS( const mp4_track_t *p_track,
+                         const MP4_Box_data_stts_t **pp_stts,
+                         const MP4_Box_data_ctts_t **pp_ctts,
+                         int64_t *pi_cts_shift )
+{
+    const MP4_Box_t *p_box = MP4_BoxGet( p_track->p_stbl, "stts" );
+    *pp_stts = p_box ? p_box->data.p_stts : NULL;
+
+    p_box = MP4_BoxGet( p_track->p_stbl, "ctts" );
+    *pp_ctts = p_box ? p_box->data.p_ctts : NULL;
+
+    *pi_cts_shift = 0;
+    const MP4_Box_t *p_cslg = MP4_BoxGet( p_track->p_stbl, "cslg" );
+    if( p_cslg && BOXDATA(p_cslg) )
+        *pi_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
+}
+
+static void TrackReleaseChunk( mp4_chunk_t *ck )
+{
+    free( ck->p_sample_count_dts );
+    free( ck->p_sample_delta_dts );
+    free( ck->p_sample_count_pts );
+    free( ck->p_sample_offset_pts );
+    ck->i_entries_dts = 0;
+    ck->p_sample_count_dts = NULL;
+    ck->p_sample_delta_dts = NULL;
+    ck->i_entries_pts = 0;
+    ck->p_sample_count_pts = NULL;
+    ck->p_sample_offset_pts = NULL;
+}
+
+/* Expands the sample -> dts and pts-dts tables of a chunk */
+static int TrackExpandChunk( mp4_chunk_t *ck,
+                             mp4_tts_cursor_t *p_dts, mp4_tts_cursor_t *p_pts,
+                             const MP4_Box_data_stts_t *stts,
+                             const MP4_Box_data_ctts_t *ctts,
+                             int64_t i_cts_shift, uint64_t *pi_duration )
+{
+    mp4_tts_cursor_t cur = *p_dts;
+    ck->i_entries_dts = xTTS_WalkChunk( ck, &cur, stts->pi_sample_count,
+                                        stts->pi_sample_delta,
+                                        stts->i_entry_count, 0,
+                                        NULL, NULL, NULL );
+    ck->p_sample_count_dts = vlc_alloc( ck->i_entries_dts, sizeof( uint32_t ) );
+    ck->p_sample_delta_dts = vlc_alloc( ck->i_entries_dts, sizeof( uint32_t ) );
+    if( ck->i_entries_dts &&
+        ( !ck->p_sample_count_dts || !ck->p_sample_delta_dts ) )
+    {
+        TrackReleaseChunk( ck );
+        return VLC_ENOMEM;
+    }
+    xTTS_WalkChunk( ck, p_dts, stts->pi_sample_count, stts->pi_sample_delta,
+                    stts->i_entry_count, 0, ck->p_sample_count_dts,
+                    (int32_t *)ck->p_sample_delta_dts, pi_duration );
+
+    if( ctts )
+    {
+        cur = *p_pts;
+        ck->i_entries_pts = xTTS_WalkChunk( ck, &cur, ctts->pi_sample_count,
+                                            ctts->pi_sample_offset,
+                                            ctts->i_entry_count, 0,
+                                            NULL, NULL, NULL );
+        ck->p_sample_count_pts = vlc_alloc( ck->i_entries_pts, sizeof( uint32_t ) );
+        ck->p_sample_offset_pts = vlc_alloc( ck->i_entries_pts, sizeof( int32_t ) );
+        if( ck->i_entries_pts &&
+            ( !ck->p_sample_count_pts || !ck->p_sample_offset_pts ) )
+        {
+            TrackReleaseChunk( ck );
+            return VLC_ENOMEM;
         }
+        xTTS_WalkChunk( ck, p_pts, ctts->pi_sample_count, ctts->pi_sample_offset,
+                        ctts->i_entry_count, i_cts_shift, ck->p_sample_count_pts,
+                        ck->p_sample_offset_pts, NULL );
     }
 
     return VLC_SUCCESS;
@@ -2445,6 +2694,18 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     /* TODO use also stss and stsh table for seeking */
     /* FIXME use edit table */
 
+    /* Large tracks only keep the boxes and expand pages of chunks
+     * timing tables when needed */
+    if( p_demux_track->i_chunk_count > MP4_CHUNK_PAGE_SIZE &&
+        var_InheritBool( p_demux, CFG_PREFIX"lazy-tables" ) )
+    {
+        p_demux_track->p_chunk_pages =
+            calloc( ( p_demux_track->i_chunk_count + MP4_CHUNK_PAGE_SIZE - 1 )
+                    / MP4_CHUNK_PAGE_SIZE, sizeof( mp4_chunk_page_t ) );
+        if( p_demux_track->p_chunk_pages == NULL )
+            return VLC_ENOMEM;
+    }
+
     /* Find stsz
      *  Gives the sample size for each samples. There is also a stz2 table
      *  (compressed form) that we need to implement TODO */
@@ -2472,9 +2733,15 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         p_demux_track->i_sample_size = stsz->i_sample_size;
         p_demux_track->p_sample_size = NULL;
     }
+    else if( p_demux_track->p_chunk_pages )
+    {
+        /* 2: each sample can have a different size, use the box table */
+        p_demux_track->i_sample_size = 0;
+        p_demux_track->p_sample_size = stsz->i_entry_size;
+    }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 3: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
         p_demux_track->p_sample_size =
             calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
@@ -2498,229 +2765,146 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         }
     }
 
-    /* Use stts table to create a sample number -> dts table.
+    /* Use stts table to create a sample number -> dts table, and ctts table
+     * to create the pts-dts one.
      * XXX: if we don't want to waste too much memory, we can't expand
      *  the box! so each chunk will contain an "extract" of this table
      *  for fast research (problem with raw stream where a sample is sometime
      *  just channels*bits_per_sample/8 */
+    const MP4_Box_data_stts_t *stts;
+    const MP4_Box_data_ctts_t *ctts;
+    int64_t i_cts_shift;
 
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
-
-    mtime_t i_next_dts = 0;
-    /* Find stts
-     *  Gives mapping between sample and decoding time
-     */
-    p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    TrackGetTTS( p_demux_track, &stts, &ctts, &i_cts_shift );
+    if( !stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
-    else
-    {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
-
-        msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
-
-        /* Create sample -> dts table per chunk */
-        uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
-
-        for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
-        {
-            mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
 
-            /* save first dts */
-            ck->i_first_dts = i_next_dts;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
+    msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
+    if( ctts )
+        msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
+    mp4_tts_cursor_t dts = { 0, 0 };
+    mp4_tts_cursor_t pts = { 0, 0 };
+    uint64_t i_next_dts = 0;
 
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
-            {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
-            }
+    for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
+    {
+        mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+        /* save first dts */
+        ck->i_first_dts = i_next_dts;
 
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
+        if( p_demux_track->p_chunk_pages )
+        {
+            /* only keep where the page starts in the tables */
+            if( i_chunk % MP4_CHUNK_PAGE_SIZE == 0 )
             {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
+                mp4_chunk_page_t *p_page =
+                    &p_demux_track->p_chunk_pages[i_chunk / MP4_CHUNK_PAGE_SIZE];
+                p_page->dts = dts;
+                p_page->pts = pts;
             }
+            xTTS_WalkChunk( ck, &dts, stts->pi_sample_count,
+                            stts->pi_sample_delta, stts->i_entry_count, 0,
+                            NULL, NULL, &ck->i_duration );
+            if( ctts )
+                xTTS_WalkChunk( ck, &pts, ctts->pi_sample_count,
+                                ctts->pi_sample_offset, ctts->i_entry_count, 0,
+                                NULL, NULL, NULL );
+        }
+        else if( TrackExpandChunk( ck, &dts, &pts, stts, ctts, i_cts_shift,
+                                   &ck->i_duration ) )
+        {
+            msg_Err( p_demux, "can't allocate memory for chunk %"PRIu32, i_chunk );
+            return VLC_ENOMEM;
         }
+
+        i_next_dts += ck->i_duration;
     }
 
+    msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples length:%"PRId64"s",
+             p_demux_track->i_track_ID, p_demux_track->i_sample_count,
+             i_next_dts / p_demux_track->i_timescale );
 
-    /* Find ctts
-     *  Gives the delta between decoding time (dts) and composition table (pts)
-     */
-    p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
-    if( p_box && p_box->data.p_ctts )
-    {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+    return VLC_SUCCESS;
+}
 
-        msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
+static void TrackUnloadChunkPage( mp4_track_t *p_track, uint32_t i_page )
+{
+    const uint32_t i_last = __MIN( (i_page + 1) * MP4_CHUNK_PAGE_SIZE,
+                                   p_track->i_chunk_count );
 
-        int64_t i_cts_shift = 0;
-        const MP4_Box_t *p_cslg = MP4_BoxGet( p_demux_track->p_stbl, "cslg" );
-        if( p_cslg && BOXDATA(p_cslg) )
-            i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
-
-        /* Create pts-dts table per chunk */
-        uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
-
-        for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
-        {
-            mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
+    for( uint32_t i = i_page * MP4_CHUNK_PAGE_SIZE; i < i_last; i++ )
+        TrackReleaseChunk( &p_track->chunk[i] );
 
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
-            {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
-            }
+    p_track->p_chunk_pages[i_page].i_last_use = 0;
+    p_track->i_chunk_pages_loaded--;
+}
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+/****************************************************************************
+ * MP4_TrackLoadChunk:
+ ****************************************************************************
+ * Expands the timing tables of the page containing the chunk, dropping the
+ * least recently used page when too many are expanded.
+ ****************************************************************************/
+static void MP4_TrackLoadChunk( demux_t *p_demux, mp4_track_t *p_track,
+                                uint32_t i_chunk )
+{
+    if( p_track->p_chunk_pages == NULL || i_chunk >= p_track->i_chunk_count )
+        return;
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
+    const uint32_t i_page = i_chunk / MP4_CHUNK_PAGE_SIZE;
+    mp4_chunk_page_t *p_page = &p_track->p_chunk_pages[i_page];
+    const bool b_loaded = p_page->i_last_use != 0;
 
+    p_page->i_last_use = ++p_track->i_chunk_pages_use;
+    if( b_loaded )
+        return;
 
-            }
+    const uint32_t i_pages = ( p_track->i_chunk_count + MP4_CHUNK_PAGE_SIZE - 1 )
+                             / MP4_CHUNK_PAGE_SIZE;
+    if( p_track->i_chunk_pages_loaded >= MP4_CHUNK_PAGES_MAX )
+    {
+        uint32_t i_lru = i_page;
+        for( uint32_t i = 0; i < i_pages; i++ )
+        {
+            if( i != i_page && p_track->p_chunk_pages[i].i_last_use &&
+                ( i_lru == i_page || p_track->p_chunk_pages[i].i_last_use <
+                                     p_track->p_chunk_pages[i_lru].i_last_use ) )
+                i_lru = i;
         }
+        if( i_lru != i_page )
+            TrackUnloadChunkPage( p_track, i_lru );
     }
 
-    msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples length:%"PRId64"s",
-             p_demux_track->i_track_ID, p_demux_track->i_sample_count,
-             i_next_dts / p_demux_track->i_timescale );
+    const MP4_Box_data_stts_t *stts;
+    const MP4_Box_data_ctts_t *ctts;
+    int64_t i_cts_shift;
+    TrackGetTTS( p_track, &stts, &ctts, &i_cts_shift );
+    if( !stts )
+        return;
 
-    return VLC_SUCCESS;
-}
+    mp4_tts_cursor_t dts = p_page->dts;
+    mp4_tts_cursor_t pts = p_page->pts;
+    const uint32_t i_last = __MIN( (i_page + 1) * MP4_CHUNK_PAGE_SIZE,
+                                   p_track->i_chunk_count );
+    p_track->i_chunk_pages_loaded++;
 
+    for( uint32_t i = i_page * MP4_CHUNK_PAGE_SIZE; i < i_last; i++ )
+    {
+        uint64_t i_duration;
+        if( TrackExpandChunk( &p_track->chunk[i], &dts, &pts, stts, ctts,
+                              i_cts_shift, &i_duration ) )
+        {
+            msg_Err( p_demux, "can't allocate memory for chunk %"PRIu32, i );
+            TrackUnloadChunkPage( p_track, i_page );
+            break;
+        }
+    }
+}
 
 /**
  * It computes the sample rate for a video track using the given sample
@@ -3030,6 +3214,7 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
     }
 
     /* *** find sample in the chunk *** */
+    MP4_TrackLoadChunk( p_demux, p_track, i_chunk );
     i_sample = p_track->chunk[i_chunk].i_sample_first;
     i_dts    = p_track->chunk[i_chunk].i_first_dts;
     for( i_index = 0;  i_index < p_track->chunk[i_chunk].i_entries_dts &&
@@ -3486,10 +3671,7 @@ static void MP4_TrackSetup( demux_t *p_demux, mp4_track_t *p_track,
 
 static void DestroyChunk( mp4_chunk_t *ck )
 {
-    free( ck->p_sample_count_dts );
-    free( ck->p_sample_delta_dts );
-    free( ck->p_sample_count_pts );
-    free( ck->p_sample_offset_pts );
+    TrackReleaseChunk( ck );
     free( ck->p_sample_size );
 }
 
@@ -3512,8 +3694,10 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
+    /* lazy tables use the stsz box table */
+    if( !p_track->i_sample_size && !p_track->p_chunk_pages )
         free( p_track->p_sample_size );
+    free( p_track->p_chunk_pages );
 
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
@@ -61,6 +61,24 @@ typedef struct
 
 } mp4_chunk_t;
 
+/* Position in a stts or ctts table */
+typedef struct
+{
+    uint32_t i_index;   /* current entry */
+    uint32_t i_left;    /* samples left in the current entry, 0 if untouched */
+} mp4_tts_cursor_t;
+
+/* Timing tables of a range of chunks, expanded on demand */
+#define MP4_CHUNK_PAGE_SIZE 64  /* chunks per page */
+#define MP4_CHUNK_PAGES_MAX 32  /* expanded pages per track */
+
+typedef struct
+{
+    mp4_tts_cursor_t dts;        /* stts position of the first chunk */
+    mp4_tts_cursor_t pts;        /* ctts position of the first chunk */
+    uint64_t         i_last_use; /* 0 if not expanded */
+} mp4_chunk_page_t;
+
 typedef struct
 {
     uint64_t i_offset;
@@ -117,6 +135,11 @@ typedef struct
 
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
 
+    /* pages of chunks timing tables, NULL when all tables are expanded */
+    mp4_chunk_page_t *p_chunk_pages;
+    uint32_t         i_chunk_pages_loaded;
+    uint64_t         i_chunk_pages_use;
+
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
@@ -54,6 +54,7 @@
 
 #include "../../codec/scte18.h"
 #include "../opus.h"
+#include "../index_cache.h"
 #include "../../mux/mpeg/csa.h"
 
 #ifdef HAVE_ARIBB24
@@ -194,6 +195,8 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, mtime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
+static void IndexLoad( demux_t * );
+static void IndexSave( demux_t * );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, mtime_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
@@ -527,6 +530,10 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    ARRAY_INIT( p_sys->index.points );
+    if( p_sys->b_canfastseek )
+        IndexLoad( p_demux );
+
     if( !p_sys->b_access_control && var_CreateGetBool( p_demux, "ts-pmtfix-waitdata" ) )
         p_sys->es_creation = DELAY_ES;
     else
@@ -589,6 +596,9 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    IndexSave( p_demux );
+    ARRAY_RESET( p_sys->index.points );
+
     free( p_sys );
 }
 
@@ -1884,6 +1894,163 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
     }
 }
 
+/*****************************************************************************
+ * Seek index: every time position found while bisecting is kept, sorted by
+ * program and time, to narrow the next searches. The points are stored in
+ * the index cache as version(32) count(32) then program(16) time(64) pos(64)
+ * for each point, all values little endian.
+ *****************************************************************************/
+#define INDEX_VERSION     1
+#define INDEX_POINT_SIZE  18
+#define INDEX_MAX_POINTS  4096
+
+static int IndexPointCmp( const ts_seekpoint_t *a, uint16_t i_program, int64_t i_time )
+{
+    if( a->i_program != i_program )
+        return a->i_program < i_program ? -1 : 1;
+    if( a->i_time != i_time )
+        return a->i_time < i_time ? -1 : 1;
+    return 0;
+}
+
+static void IndexAddPoint( demux_sys_t *p_sys, uint16_t i_program,
+                           int64_t i_time, uint64_t i_pos )
+{
+    if( p_sys->index.points.i_size >= INDEX_MAX_POINTS )
+        return;
+
+    int i_insert = p_sys->index.points.i_size;
+    for( int i = 0; i < p_sys->index.points.i_size; i++ )
+    {
+        int i_cmp = IndexPointCmp( &p_sys->index.points.p_elems[i], i_program, i_time );
+        if( i_cmp == 0 )
+            return;
+        if( i_cmp > 0 )
+        {
+            i_insert = i;
+            break;
+        }
+    }
+
+    ts_seekpoint_t point = { .i_program = i_program, .i_time = i_time, .i_pos = i_pos };
+    ARRAY_INSERT( p_sys->index.points, point, i_insert );
+    p_sys->index.b_dirty = true;
+}
+
+/* Restricts the search to the known points surrounding the time, returns
+ * true if a point is close enough to be used directly */
+static bool IndexNarrow( demux_sys_t *p_sys, const ts_pmt_t *p_pmt, int64_t i_scaledtime,
+                         uint64_t *pi_head, uint64_t *pi_tail, uint64_t *pi_found )
+{
+    for( int i = 0; i < p_sys->index.points.i_size; i++ )
+    {
+        const ts_seekpoint_t *p_point = &p_sys->index.points.p_elems[i];
+        if( p_point->i_program != p_pmt->i_number )
+            continue;
+
+        int64_t i_diff = i_scaledtime - p_point->i_time;
+        if( i_diff < 0 )
+        {
+            uint64_t i_tail = (p_point->i_pos >= p_sys->i_packet_size) ?
+                              p_point->i_pos - p_sys->i_packet_size : 0;
+            if( i_tail < *pi_tail )
+                *pi_tail = i_tail;
+            break;
+        }
+        else if( i_diff < TO_SCALE(VLC_TS_0 + CLOCK_FREQ / 2) ) // 500ms
+        {
+            *pi_found = p_point->i_pos;
+            return true;
+        }
+        else if( p_point->i_pos > *pi_head )
+            *pi_head = p_point->i_pos;
+    }
+    return false;
+}
+
+static void IndexLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    p_sys->index.p_cache = index_cache_New( p_demux, p_demux->psz_file, "ts" );
+    if( p_sys->index.p_cache == NULL )
+        return;
+
+    block_t *p_block = index_cache_Load( p_sys->index.p_cache );
+    if( p_block == NULL )
+        return;
+
+    const uint8_t *p = p_block->p_buffer;
+    const uint64_t i_stream_size = stream_Size( p_sys->stream );
+    uint32_t i_count = 0;
+
+    if( p_block->i_buffer >= 8 && GetDWLE( p ) == INDEX_VERSION )
+        i_count = GetDWLE( &p[4] );
+
+    if( i_count == 0 || i_count > INDEX_MAX_POINTS ||
+        p_block->i_buffer != 8 + (size_t)i_count * INDEX_POINT_SIZE )
+    {
+        block_Release( p_block );
+        return;
+    }
+
+    p += 8;
+    for( uint32_t i = 0; i < i_count; i++, p += INDEX_POINT_SIZE )
+    {
+        ts_seekpoint_t point;
+        point.i_program = GetWLE( p );
+        point.i_time = GetQWLE( &p[2] );
+        point.i_pos = GetQWLE( &p[10] );
+
+        if( point.i_pos >= i_stream_size ||
+            ( i > 0 && IndexPointCmp( &p_sys->index.points.p_elems[i - 1],
+                                      point.i_program, point.i_time ) >= 0 ) )
+        {
+            msg_Warn( p_demux, "invalid index cache" );
+            ARRAY_RESET( p_sys->index.points );
+            break;
+        }
+        ARRAY_APPEND( p_sys->index.points, point );
+    }
+
+    msg_Dbg( p_demux, "loaded %d seek points from the index cache",
+             p_sys->index.points.i_size );
+    block_Release( p_block );
+}
+
+static void IndexSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->index.p_cache == NULL )
+        return;
+
+    if( p_sys->index.b_dirty )
+    {
+        const size_t i_size = 8 + (size_t)p_sys->index.points.i_size * INDEX_POINT_SIZE;
+        uint8_t *p_data = malloc( i_size );
+        if( p_data )
+        {
+            uint8_t *p = p_data;
+            SetDWLE( p, INDEX_VERSION );
+            SetDWLE( &p[4], p_sys->index.points.i_size );
+            p += 8;
+            for( int i = 0; i < p_sys->index.points.i_size; i++, p += INDEX_POINT_SIZE )
+            {
+                const ts_seekpoint_t *p_point = &p_sys->index.points.p_elems[i];
+                SetWLE( p, p_point->i_program );
+                SetQWLE( &p[2], p_point->i_time );
+                SetQWLE( &p[10], p_point->i_pos );
+            }
+            index_cache_Save( p_sys->index.p_cache, p_data, i_size );
+            free( p_data );
+        }
+    }
+
+    index_cache_Delete( p_sys->index.p_cache );
+    p_sys->index.p_cache = NULL;
+}
+
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaledtime )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -1904,6 +2071,11 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
     if( i_head_pos >= i_tail_pos )
         return VLC_EGENERIC;
 
+    uint64_t i_found_pos;
+    if( IndexNarrow( p_sys, p_pmt, i_scaledtime, &i_head_pos, &i_tail_pos, &i_found_pos ) &&
+        vlc_stream_Seek( p_sys->stream, i_found_pos ) == VLC_SUCCESS )
+        return VLC_SUCCESS;
+
     bool b_found = false;
     while( (i_head_pos + p_sys->i_packet_size) <= i_tail_pos && !b_found )
     {
@@ -1965,7 +2137,10 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
 
             if( i_pcr != -1 )
             {
-                int64_t i_diff = i_scaledtime - TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+                const int64_t i_time = TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+                IndexAddPoint( p_sys, p_pmt->i_number, i_time, i_splitpos );
+
+                int64_t i_diff = i_scaledtime - i_time;
                 if ( i_diff < 0 )
                     i_tail_pos = (i_splitpos >= p_sys->i_packet_size) ? i_splitpos - p_sys->i_packet_size : 0;
                 else if( i_diff < TO_SCALE(VLC_TS_0 + CLOCK_FREQ / 2) ) // 500ms
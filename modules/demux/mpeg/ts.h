@@ -24,6 +24,7 @@
     typedef struct arib_instance_t arib_instance_t;
 #endif
 typedef struct csa_t csa_t;
+typedef struct index_cache_t index_cache_t;
 
 #define TS_USER_PMT_NUMBER (0)
 
@@ -44,6 +45,13 @@ typedef struct
     int i_service;
 } vdr_info_t;
 
+typedef struct
+{
+    uint16_t i_program;
+    int64_t  i_time;  /* scaled, unwrapped against the program first pcr */
+    uint64_t i_pos;
+} ts_seekpoint_t;
+
 struct demux_sys_t
 {
     stream_t   *stream;
@@ -130,6 +138,14 @@ struct demux_sys_t
 
     /* */
     bool        b_start_record;
+
+    /* Positions found by SeekToTime(), kept across opens in the index cache */
+    struct
+    {
+        index_cache_t *p_cache;
+        DECL_ARRAY( ts_seekpoint_t ) points;
+        bool           b_dirty;
+    } index;
 };
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
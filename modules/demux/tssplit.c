@@ -0,0 +1,676 @@
+/*****************************************************************************
+ * tssplit.c: MPEG transport stream program splitter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_demux.h>
+#include <vlc_sout.h>
+
+#define ACCESS_TEXT N_("Output module")
+#define DST_TEXT N_("Program outputs")
+#define DST_LONGTEXT N_( \
+    "Comma separated list of program=destination pairs. Each program of the " \
+    "input transport stream is sent, as a single program transport stream, " \
+    "to its destination. The destination can be prefixed with the output " \
+    "module, as in 1001=udp://239.0.0.1:1234." )
+
+static int  Open( vlc_object_t * );
+static void Close ( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( "TS split" )
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_DEMUX )
+    set_description( N_("MPEG-TS program splitter") )
+    set_capability( "demux", 0 )
+    add_module( "tssplit-access", "sout access", "udp", ACCESS_TEXT,
+                ACCESS_TEXT, true )
+    add_string( "tssplit-dst", NULL, DST_TEXT, DST_LONGTEXT, false )
+    set_callbacks( Open, Close )
+    add_shortcut( "tssplit" )
+vlc_module_end ()
+
+#define TS_PACKET_SIZE      188
+#define TS_PID_COUNT        8192
+#define TS_PID_TDT          0x14
+#define TS_PSI_MAX          1024
+
+/* Packets read at once */
+#define TSSPLIT_PACKETS     100
+/* Packets sent at once to each output */
+#define TSSPLIT_BURST       7
+
+typedef struct ts_section_t ts_section_t;
+
+typedef void (*ts_section_cb)( demux_t *, ts_section_t * );
+
+struct ts_section_t
+{
+    uint16_t i_pid;
+    int      i_cc;
+    size_t   i_data;
+    size_t   i_size;
+    uint8_t  p_data[TS_PSI_MAX];
+};
+
+typedef struct
+{
+    uint16_t           i_program;
+    uint16_t           i_pmt_pid;   /* 0 until found in the PAT */
+    uint32_t           i_pmt_crc;
+    sout_access_out_t *p_access;
+
+    uint8_t            i_pat_cc;
+    uint8_t            i_pat_version;
+
+    block_t           *p_burst;
+
+    uint8_t            pids[TS_PID_COUNT / 8];
+} tssplit_output_t;
+
+struct demux_sys_t
+{
+    tssplit_output_t **pp_outputs;
+    int                i_outputs;
+
+    ts_section_t       pat;
+    ts_section_t     **pp_pmts;
+    int                i_pmts;
+    uint16_t           i_tsid;
+
+    /* Real time pacing of non live inputs, on the first PCR found */
+    bool               b_pace;
+    int                i_pcr_pid;
+    mtime_t            i_pcr_ref;
+    mtime_t            i_pcr_date;
+
+    bool               b_lost_sync;
+};
+
+static int Demux( demux_t * );
+static int Control( demux_t *, int,va_list );
+
+/*****************************************************************************
+ * PSI
+ *****************************************************************************/
+static uint32_t ts_crc32( const uint8_t *p, size_t i_size )
+{
+    uint32_t i_crc = 0xffffffff;
+
+    while( i_size-- )
+    {
+        i_crc ^= (uint32_t)*p++ << 24;
+        for( int i = 0; i < 8; i++ )
+            i_crc = (i_crc << 1) ^ ((i_crc & 0x80000000) ? 0x04c11db7 : 0);
+    }
+    return i_crc;
+}
+
+static void SectionInit( ts_section_t *p_sec, uint16_t i_pid )
+{
+    p_sec->i_pid = i_pid;
+    p_sec->i_cc = -1;
+    p_sec->i_data = 0;
+    p_sec->i_size = 0;
+}
+
+/* Appends data to the current section, returns the number of bytes used */
+static size_t SectionAppend( demux_t *p_demux, ts_section_t *p_sec,
+                             const uint8_t *p, size_t i_size,
+                             ts_section_cb pf_section )
+{
+    size_t i_used = 0;
+
+    if( p_sec->i_data < 3 )
+    {
+        size_t i_copy = __MIN( 3 - p_sec->i_data, i_size );
+        memcpy( &p_sec->p_data[p_sec->i_data], p, i_copy );
+        p_sec->i_data += i_copy;
+        i_used += i_copy;
+        if( p_sec->i_data < 3 )
+            return i_used;
+
+        p_sec->i_size = 3 + (((p_sec->p_data[1] & 0x0f) << 8) |
+                             p_sec->p_data[2]);
+        if( p_sec->i_size > TS_PSI_MAX || p_sec->i_size < 3 + 4 )
+        {
+            p_sec->i_data = 0;
+            return i_size;
+        }
+    }
+
+    size_t i_copy = __MIN( p_sec->i_size - p_sec->i_data, i_size - i_used );
+    memcpy( &p_sec->p_data[p_sec->i_data], &p[i_used], i_copy );
+    p_sec->i_data += i_copy;
+    i_used += i_copy;
+
+    if( p_sec->i_data == p_sec->i_size )
+    {
+        if( (p_sec->p_data[1] & 0x80) &&
+            ts_crc32( p_sec->p_data, p_sec->i_size ) == 0 )
+            pf_section( p_demux, p_sec );
+        p_sec->i_data = 0;
+    }
+    return i_used;
+}
+
+static void SectionGather( demux_t *p_demux, ts_section_t *p_sec,
+                           const uint8_t *p_pkt, ts_section_cb pf_section )
+{
+    if( !(p_pkt[3] & 0x10) )
+        return;
+
+    const int i_cc = p_pkt[3] & 0x0f;
+    if( i_cc == p_sec->i_cc )
+        return; /* duplicate */
+    if( p_sec->i_cc >= 0 && i_cc != ((p_sec->i_cc + 1) & 0x0f) )
+        p_sec->i_data = 0;
+    p_sec->i_cc = i_cc;
+
+    size_t i_start = 4;
+    if( p_pkt[3] & 0x20 )
+        i_start += 1 + p_pkt[4];
+    if( i_start >= TS_PACKET_SIZE )
+        return;
+
+    const uint8_t *p = &p_pkt[i_start];
+    size_t i_size = TS_PACKET_SIZE - i_start;
+
+    if( p_pkt[1] & 0x40 )
+    {
+        size_t i_pointer = *p++;
+        i_size--;
+        if( i_pointer > i_size )
+        {
+            p_sec->i_data = 0;
+            return;
+        }
+        /* End of the previous section */
+        if( p_sec->i_data > 0 )
+            SectionAppend( p_demux, p_sec, p, i_pointer, pf_section );
+        p_sec->i_data = 0;
+        p += i_pointer;
+        i_size -= i_pointer;
+
+        while( i_size > 0 && *p != 0xff )
+        {
+            size_t i_used = SectionAppend( p_demux, p_sec, p, i_size,
+                                           pf_section );
+            p += i_used;
+            i_size -= i_used;
+        }
+    }
+    else if( p_sec->i_data > 0 )
+        SectionAppend( p_demux, p_sec, p, i_size, pf_section );
+}
+
+/*****************************************************************************
+ * Outputs
+ *****************************************************************************/
+static inline void PidSet( tssplit_output_t *p_out, uint16_t i_pid )
+{
+    p_out->pids[i_pid >> 3] |= 1 << (i_pid & 7);
+}
+
+static inline bool PidIsSet( const tssplit_output_t *p_out, uint16_t i_pid )
+{
+    return p_out->pids[i_pid >> 3] & (1 << (i_pid & 7));
+}
+
+static void OutputFlush( tssplit_output_t *p_out )
+{
+    if( p_out->p_burst == NULL )
+        return;
+
+    p_out->p_burst->i_dts = mdate();
+    sout_AccessOutWrite( p_out->p_access, p_out->p_burst );
+    p_out->p_burst = NULL;
+}
+
+static void OutputSend( tssplit_output_t *p_out, const uint8_t *p_pkt )
+{
+    if( p_out->p_burst == NULL )
+    {
+        p_out->p_burst = block_Alloc( TSSPLIT_BURST * TS_PACKET_SIZE );
+        if( unlikely(p_out->p_burst == NULL) )
+            return;
+        p_out->p_burst->i_buffer = 0;
+    }
+
+    memcpy( &p_out->p_burst->p_buffer[p_out->p_burst->i_buffer], p_pkt,
+            TS_PACKET_SIZE );
+    p_out->p_burst->i_buffer += TS_PACKET_SIZE;
+
+    if( p_out->p_burst->i_buffer == TSSPLIT_BURST * TS_PACKET_SIZE )
+        OutputFlush( p_out );
+}
+
+/* Sends a PAT listing only the program of the output */
+static void OutputSendPAT( demux_t *p_demux, tssplit_output_t *p_out )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_pkt[TS_PACKET_SIZE];
+
+    memset( p_pkt, 0xff, sizeof( p_pkt ) );
+    p_pkt[0] = 0x47;
+    p_pkt[1] = 0x40;
+    p_pkt[2] = 0x00;
+    p_pkt[3] = 0x10 | p_out->i_pat_cc;
+    p_pkt[4] = 0x00;
+    p_out->i_pat_cc = (p_out->i_pat_cc + 1) & 0x0f;
+
+    uint8_t *p_sec = &p_pkt[5];
+    p_sec[0] = 0x00;
+    p_sec[1] = 0xb0;
+    p_sec[2] = 5 + 4 + 4;
+    SetWBE( &p_sec[3], p_sys->i_tsid );
+    p_sec[5] = 0xc1 | (p_out->i_pat_version << 1);
+    p_sec[6] = 0x00;
+    p_sec[7] = 0x00;
+    SetWBE( &p_sec[8], p_out->i_program );
+    SetWBE( &p_sec[10], 0xe000 | p_out->i_pmt_pid );
+    SetDWBE( &p_sec[12], ts_crc32( p_sec, 12 ) );
+
+    OutputSend( p_out, p_pkt );
+}
+
+static ts_section_t *GetPMT( demux_t *p_demux, uint16_t i_pid )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = 0; i < p_sys->i_pmts; i++ )
+        if( p_sys->pp_pmts[i]->i_pid == i_pid )
+            return p_sys->pp_pmts[i];
+    return NULL;
+}
+
+static void ParsePAT( demux_t *p_demux, ts_section_t *p_sec )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p = p_sec->p_data;
+
+    if( p[0] != 0x00 || !(p[5] & 0x01) )
+        return;
+
+    p_sys->i_tsid = GetWBE( &p[3] );
+
+    for( size_t i = 8; i + 4 <= p_sec->i_size - 4; i += 4 )
+    {
+        const uint16_t i_program = GetWBE( &p[i] );
+        const uint16_t i_pid = GetWBE( &p[i + 2] ) & 0x1fff;
+
+        if( i_program == 0 )
+            continue;
+
+        for( int j = 0; j < p_sys->i_outputs; j++ )
+        {
+            tssplit_output_t *p_out = p_sys->pp_outputs[j];
+
+            if( p_out->i_program != i_program || p_out->i_pmt_pid == i_pid )
+                continue;
+
+            msg_Dbg( p_demux, "program %u: PMT on PID %u", i_program, i_pid );
+            p_out->i_pmt_pid = i_pid;
+            p_out->i_pmt_crc = 0;
+            p_out->i_pat_version = (p_out->i_pat_version + 1) & 0x1f;
+            memset( p_out->pids, 0, sizeof( p_out->pids ) );
+            PidSet( p_out, i_pid );
+            PidSet( p_out, TS_PID_TDT );
+
+            if( GetPMT( p_demux, i_pid ) == NULL )
+            {
+                ts_section_t *p_pmt = malloc( sizeof( *p_pmt ) );
+                if( likely(p_pmt != NULL) )
+                {
+                    SectionInit( p_pmt, i_pid );
+                    TAB_APPEND( p_sys->i_pmts, p_sys->pp_pmts, p_pmt );
+                }
+            }
+        }
+    }
+
+    /* Repeat the rewritten PATs at the rate of the input one */
+    for( int i = 0; i < p_sys->i_outputs; i++ )
+        if( p_sys->pp_outputs[i]->i_pmt_pid != 0 )
+            OutputSendPAT( p_demux, p_sys->pp_outputs[i] );
+}
+
+static void SetCAPids( tssplit_output_t *p_out, const uint8_t *p, size_t i_size )
+{
+    while( i_size >= 2 && i_size >= 2u + p[1] )
+    {
+        /* CA_descriptor */
+        if( p[0] == 0x09 && p[1] >= 4 )
+            PidSet( p_out, GetWBE( &p[4] ) & 0x1fff );
+        i_size -= 2 + p[1];
+        p += 2 + p[1];
+    }
+}
+
+static void ParsePMT( demux_t *p_demux, ts_section_t *p_sec )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p = p_sec->p_data;
+    const size_t i_end = p_sec->i_size - 4;
+
+    if( p[0] != 0x02 || !(p[5] & 0x01) || i_end < 12 )
+        return;
+
+    const uint16_t i_program = GetWBE( &p[3] );
+    const uint32_t i_crc = GetDWBE( &p[i_end] );
+
+    for( int j = 0; j < p_sys->i_outputs; j++ )
+    {
+        tssplit_output_t *p_out = p_sys->pp_outputs[j];
+
+        if( p_out->i_program != i_program || p_out->i_pmt_pid != p_sec->i_pid ||
+            p_out->i_pmt_crc == i_crc )
+            continue;
+        p_out->i_pmt_crc = i_crc;
+
+        memset( p_out->pids, 0, sizeof( p_out->pids ) );
+        PidSet( p_out, p_sec->i_pid );
+        PidSet( p_out, TS_PID_TDT );
+        PidSet( p_out, GetWBE( &p[8] ) & 0x1fff );
+
+        size_t i_info = GetWBE( &p[10] ) & 0x0fff;
+        if( 12 + i_info > i_end )
+            continue;
+        SetCAPids( p_out, &p[12], i_info );
+
+        unsigned i_es = 0;
+        for( size_t i = 12 + i_info; i + 5 <= i_end; )
+        {
+            const uint16_t i_pid = GetWBE( &p[i + 1] ) & 0x1fff;
+            const size_t i_es_info = GetWBE( &p[i + 3] ) & 0x0fff;
+
+            if( i + 5 + i_es_info > i_end )
+                break;
+            PidSet( p_out, i_pid );
+            SetCAPids( p_out, &p[i + 5], i_es_info );
+            i += 5 + i_es_info;
+            i_es++;
+        }
+        msg_Dbg( p_demux, "program %u: %u elementary streams", i_program,
+                 i_es );
+    }
+}
+
+/*****************************************************************************
+ * Open / Close
+ *****************************************************************************/
+static int AddOutput( demux_t *p_demux, const char *psz_access, char *psz_entry )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    char *psz_dst = strchr( psz_entry, '=' );
+    if( psz_dst == NULL )
+    {
+        msg_Err( p_demux, "invalid output \"%s\"", psz_entry );
+        return VLC_EGENERIC;
+    }
+    *psz_dst++ = '\0';
+
+    unsigned long i_program = strtoul( psz_entry, NULL, 0 );
+    if( i_program == 0 || i_program > 0xffff )
+    {
+        msg_Err( p_demux, "invalid program number \"%s\"", psz_entry );
+        return VLC_EGENERIC;
+    }
+
+    char *psz_scheme = strstr( psz_dst, "://" );
+    if( psz_scheme != NULL )
+    {
+        *psz_scheme = '\0';
+        psz_access = psz_dst;
+        psz_dst = psz_scheme + 3;
+    }
+
+    tssplit_output_t *p_out = calloc( 1, sizeof( *p_out ) );
+    if( unlikely(p_out == NULL) )
+        return VLC_ENOMEM;
+
+    p_out->i_program = i_program;
+    p_out->p_access = sout_AccessOutNew( p_demux, psz_access, psz_dst );
+    if( p_out->p_access == NULL )
+    {
+        msg_Err( p_demux, "cannot create output %s://%s", psz_access,
+                 psz_dst );
+        free( p_out );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_demux, "program %lu to %s://%s", i_program, psz_access,
+             psz_dst );
+    TAB_APPEND( p_sys->i_outputs, p_sys->pp_outputs, p_out );
+    return VLC_SUCCESS;
+}
+
+static int Open( vlc_object_t * p_this )
+{
+    demux_t *p_demux = (demux_t*)p_this;
+    demux_sys_t *p_sys;
+    const uint8_t *p_peek;
+
+    /* Accept only if forced */
+    if( !p_demux->obj.force )
+        return VLC_EGENERIC;
+
+    if( vlc_stream_Peek( p_demux->s, &p_peek, TS_PACKET_SIZE ) <
+            TS_PACKET_SIZE || p_peek[0] != 0x47 )
+    {
+        msg_Err( p_demux, "not a transport stream" );
+        return VLC_EGENERIC;
+    }
+
+    char *psz_dst = var_InheritString( p_demux, "tssplit-dst" );
+    char *psz_access = var_InheritString( p_demux, "tssplit-access" );
+    if( psz_dst == NULL || psz_access == NULL )
+    {
+        msg_Err( p_demux, "no program outputs given" );
+        free( psz_dst );
+        free( psz_access );
+        return VLC_EGENERIC;
+    }
+
+    p_demux->p_sys = p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+    {
+        free( psz_dst );
+        free( psz_access );
+        return VLC_ENOMEM;
+    }
+
+    TAB_INIT( p_sys->i_outputs, p_sys->pp_outputs );
+    TAB_INIT( p_sys->i_pmts, p_sys->pp_pmts );
+    SectionInit( &p_sys->pat, 0 );
+    p_sys->i_tsid = 0;
+    p_sys->i_pcr_pid = -1;
+    p_sys->i_pcr_ref = VLC_TS_INVALID;
+    p_sys->i_pcr_date = VLC_TS_INVALID;
+    p_sys->b_lost_sync = false;
+    if( vlc_stream_Control( p_demux->s, STREAM_CAN_CONTROL_PACE,
+                            &p_sys->b_pace ) )
+        p_sys->b_pace = false;
+
+    char *psz_save;
+    for( char *psz_entry = strtok_r( psz_dst, ",", &psz_save );
+         psz_entry != NULL; psz_entry = strtok_r( NULL, ",", &psz_save ) )
+    {
+        if( AddOutput( p_demux, psz_access, psz_entry ) == VLC_ENOMEM )
+            break;
+    }
+    free( psz_dst );
+    free( psz_access );
+
+    if( p_sys->i_outputs == 0 )
+    {
+        Close( p_this );
+        return VLC_EGENERIC;
+    }
+
+    p_demux->pf_demux = Demux;
+    p_demux->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    demux_t *p_demux = (demux_t*)p_this;
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = 0; i < p_sys->i_outputs; i++ )
+    {
+        tssplit_output_t *p_out = p_sys->pp_outputs[i];
+
+        OutputFlush( p_out );
+        sout_AccessOutDelete( p_out->p_access );
+        free( p_out );
+    }
+    TAB_CLEAN( p_sys->i_outputs, p_sys->pp_outputs );
+
+    for( int i = 0; i < p_sys->i_pmts; i++ )
+        free( p_sys->pp_pmts[i] );
+    TAB_CLEAN( p_sys->i_pmts, p_sys->pp_pmts );
+
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Demux
+ *****************************************************************************/
+static void FlushOutputs( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = 0; i < p_sys->i_outputs; i++ )
+        OutputFlush( p_sys->pp_outputs[i] );
+}
+
+/* Waits for the date of the PCR, when the input is not live */
+static void Pace( demux_t *p_demux, const uint8_t *p_pkt, uint16_t i_pid )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_pace || !(p_pkt[3] & 0x20) || p_pkt[4] < 7 ||
+        !(p_pkt[5] & 0x10) )
+        return;
+
+    if( p_sys->i_pcr_pid < 0 )
+        p_sys->i_pcr_pid = i_pid;
+    else if( p_sys->i_pcr_pid != i_pid )
+        return;
+
+    const mtime_t i_pcr = ( ((uint64_t)GetDWBE( &p_pkt[6] ) << 1) |
+                            (p_pkt[10] >> 7) ) * 100 / 9;
+    const mtime_t i_now = mdate();
+
+    if( p_sys->i_pcr_ref > VLC_TS_INVALID && !(p_pkt[5] & 0x80) )
+    {
+        const mtime_t i_date = p_sys->i_pcr_date + i_pcr - p_sys->i_pcr_ref;
+
+        /* Resynchronize on discontinuities and wrap around */
+        if( i_date >= i_now - CLOCK_FREQ && i_date <= i_now + CLOCK_FREQ )
+        {
+            FlushOutputs( p_demux );
+            mwait( i_date );
+            return;
+        }
+    }
+
+    p_sys->i_pcr_ref = i_pcr;
+    p_sys->i_pcr_date = i_now;
+}
+
+static void ProcessPacket( demux_t *p_demux, const uint8_t *p_pkt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint16_t i_pid = GetWBE( &p_pkt[1] ) & 0x1fff;
+
+    if( i_pid == 0 )
+    {
+        /* Replaced by a PAT per output */
+        SectionGather( p_demux, &p_sys->pat, p_pkt, ParsePAT );
+        return;
+    }
+
+    ts_section_t *p_pmt = GetPMT( p_demux, i_pid );
+    if( p_pmt != NULL )
+        SectionGather( p_demux, p_pmt, p_pkt, ParsePMT );
+
+    Pace( p_demux, p_pkt, i_pid );
+
+    for( int i = 0; i < p_sys->i_outputs; i++ )
+    {
+        tssplit_output_t *p_out = p_sys->pp_outputs[i];
+
+        if( PidIsSet( p_out, i_pid ) )
+            OutputSend( p_out, p_pkt );
+    }
+}
+
+static int Demux( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p_peek;
+
+    ssize_t i_peek = vlc_stream_Peek( p_demux->s, &p_peek,
+                                      TSSPLIT_PACKETS * TS_PACKET_SIZE );
+    if( i_peek < TS_PACKET_SIZE )
+        return VLC_DEMUXER_EOF;
+
+    size_t i_pos = 0;
+    while( i_pos + TS_PACKET_SIZE <= (size_t)i_peek )
+    {
+        const uint8_t *p_pkt = &p_peek[i_pos];
+
+        if( p_pkt[0] != 0x47 ||
+            ( i_pos + 2 * TS_PACKET_SIZE <= (size_t)i_peek &&
+              p_pkt[TS_PACKET_SIZE] != 0x47 ) )
+        {
+            if( !p_sys->b_lost_sync )
+                msg_Warn( p_demux, "lost synchro" );
+            p_sys->b_lost_sync = true;
+            i_pos++;
+            continue;
+        }
+        p_sys->b_lost_sync = false;
+
+        ProcessPacket( p_demux, p_pkt );
+        i_pos += TS_PACKET_SIZE;
+    }
+
+    FlushOutputs( p_demux );
+
+    if( vlc_stream_Read( p_demux->s, NULL, i_pos ) < (ssize_t)i_pos )
+        return VLC_DEMUXER_EOF;
+    return VLC_DEMUXER_SUCCESS;
+}
+
+static int Control( demux_t *p_demux, int i_query, va_list args )
+{
+    return demux_vaControlHelper( p_demux->s, 0, -1, 0, 1, i_query, args );
+}
@@ -0,0 +1,628 @@
+/*****************************************************************************
+ * vlts.c: VLC timeshift recording demuxer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_demux.h>
+#include <vlc_interrupt.h>
+
+#include "vlts.h"
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define FOLLOW_TEXT N_("Follow recordings in progress")
+#define FOLLOW_LONGTEXT N_( \
+    "Wait for more data at the end of a recording that is still being " \
+    "written, instead of stopping." )
+
+vlc_module_begin ()
+    set_description( N_("VLC timeshift recording demuxer") )
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_DEMUX )
+    set_capability( "demux", 10 )
+    add_bool( "vlts-follow", true, FOLLOW_TEXT, FOLLOW_LONGTEXT, true )
+    set_callbacks( Open, Close )
+    add_shortcut( "vlts" )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int Demux  ( demux_t * );
+static int Control( demux_t *, int i_query, va_list args );
+
+/* Delay between two checks of a recording in progress */
+#define VLTS_POLL_DELAY    (CLOCK_FREQ / 10)
+#define VLTS_REFRESH_DELAY CLOCK_FREQ
+/* Delay after which a recording that stopped growing without being closed
+ * (i.e. its recorder died) is considered over */
+#define VLTS_STALL_DELAY   (10 * CLOCK_FREQ)
+
+/* Sanity limits */
+#define VLTS_CHUNK_MAX     (64 * 1024 * 1024)
+#define VLTS_INDEX_DEPTH   (1 << 20)
+
+typedef struct
+{
+    uint32_t     i_id;
+    es_out_id_t *p_es;
+} vlts_track_t;
+
+struct demux_sys_t
+{
+    bool         b_seekable;
+    bool         b_follow;
+    bool         b_closed;
+
+    mtime_t      i_start;
+    mtime_t      i_end;
+    mtime_t      i_pcr;
+    mtime_t      i_refresh;
+
+    /* Size of the recording when it last grew, and date of that */
+    uint64_t     i_size;
+    mtime_t      i_grown;
+
+    /* Offset of the last index chunk loaded */
+    uint64_t     i_index;
+
+    /* Sync points, in time order */
+    vlts_entry_t *p_sync;
+    size_t        i_sync;
+    size_t        i_sync_max;
+
+    vlts_track_t **pp_tracks;
+    int            i_tracks;
+};
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+static vlts_track_t *GetTrack( demux_t *p_demux, uint32_t i_id )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = 0; i < p_sys->i_tracks; i++ )
+        if( p_sys->pp_tracks[i]->i_id == i_id )
+            return p_sys->pp_tracks[i];
+    return NULL;
+}
+
+static void AddTrack( demux_t *p_demux, const uint8_t *p_data, size_t i_data )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    es_format_t fmt;
+
+    if( i_data < 4 || GetTrack( p_demux, GetDWBE( p_data ) ) != NULL )
+        return;
+
+    if( vlts_format_Read( &fmt, &p_data[4], i_data - 4 ) )
+    {
+        msg_Warn( p_demux, "invalid format for stream %u", GetDWBE( p_data ) );
+        return;
+    }
+
+    vlts_track_t *p_track = malloc( sizeof( *p_track ) );
+    if( p_track )
+    {
+        p_track->i_id = GetDWBE( p_data );
+        /* Recordings are single program */
+        fmt.i_group = 0;
+        fmt.i_id = p_track->i_id;
+        p_track->p_es = es_out_Add( p_demux->out, &fmt );
+        if( p_track->p_es )
+            TAB_APPEND( p_sys->i_tracks, p_sys->pp_tracks, p_track );
+        else
+            free( p_track );
+    }
+    es_format_Clean( &fmt );
+}
+
+static void AddSync( demux_t *p_demux, mtime_t i_time, uint64_t i_offset )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->i_sync > 0 &&
+        p_sys->p_sync[p_sys->i_sync - 1].i_offset >= i_offset )
+        return;
+
+    if( p_sys->i_sync >= p_sys->i_sync_max )
+    {
+        size_t i_max = __MAX( 1024, p_sys->i_sync_max * 2 );
+        vlts_entry_t *p_sync = realloc( p_sys->p_sync,
+                                        i_max * sizeof( *p_sync ) );
+        if( !p_sync )
+            return;
+        p_sys->p_sync = p_sync;
+        p_sys->i_sync_max = i_max;
+    }
+
+    vlts_entry_t *p_entry = &p_sys->p_sync[p_sys->i_sync++];
+    p_entry->i_type = VLTS_ENTRY_SYNC;
+    p_entry->i_time = i_time;
+    p_entry->i_offset = i_offset;
+}
+
+static bool ReadChunkHeader( demux_t *p_demux, char *psz_tag,
+                             uint32_t *pi_size )
+{
+    uint8_t p_header[VLTS_CHUNK_HEADER];
+
+    if( vlc_stream_Read( p_demux->s, p_header, VLTS_CHUNK_HEADER )
+                                                    < VLTS_CHUNK_HEADER )
+        return false;
+
+    memcpy( psz_tag, p_header, 4 );
+    psz_tag[4] = '\0';
+    *pi_size = GetDWBE( &p_header[4] );
+    return true;
+}
+
+/* Reads the chunk at the given offset, the stream position is not kept */
+static block_t *ReadChunkAt( demux_t *p_demux, uint64_t i_offset,
+                             const char *psz_expected )
+{
+    char psz_tag[5];
+    uint32_t i_size;
+
+    if( vlc_stream_Seek( p_demux->s, i_offset ) ||
+        !ReadChunkHeader( p_demux, psz_tag, &i_size ) ||
+        strcmp( psz_tag, psz_expected ) || i_size > VLTS_CHUNK_MAX )
+        return NULL;
+
+    block_t *p_chunk = vlc_stream_Block( p_demux->s, i_size );
+    if( p_chunk && p_chunk->i_buffer < i_size )
+    {
+        block_Release( p_chunk );
+        return NULL;
+    }
+    return p_chunk;
+}
+
+static void ParseIndex( demux_t *p_demux, const block_t *p_index,
+                        bool b_formats )
+{
+    if( p_index->i_buffer < VLTS_INDEX_HEADER )
+        return;
+
+    uint32_t i_count = GetDWBE( &p_index->p_buffer[8] );
+    if( i_count > (p_index->i_buffer - VLTS_INDEX_HEADER) / VLTS_INDEX_ENTRY )
+        return;
+
+    const uint8_t *p = &p_index->p_buffer[VLTS_INDEX_HEADER];
+    for( uint32_t i = 0; i < i_count; i++, p += VLTS_INDEX_ENTRY )
+    {
+        const uint32_t i_type = GetDWBE( p );
+        const mtime_t i_time = GetQWBE( &p[4] );
+        const uint64_t i_offset = GetQWBE( &p[12] );
+
+        if( i_type == VLTS_ENTRY_SYNC )
+            AddSync( p_demux, i_time, i_offset );
+        else if( i_type == VLTS_ENTRY_FORMAT && b_formats )
+        {
+            block_t *p_fmt = ReadChunkAt( p_demux, i_offset,
+                                          VLTS_CHUNK_FORMAT );
+            if( p_fmt )
+            {
+                AddTrack( p_demux, p_fmt->p_buffer, p_fmt->i_buffer );
+                block_Release( p_fmt );
+            }
+        }
+    }
+}
+
+/* Loads the index chunks written after the last one loaded, following
+ * the chain backward from the given one */
+static void LoadIndex( demux_t *p_demux, uint64_t i_head )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t *pi_chain = NULL;
+    size_t i_chain = 0;
+
+    for( uint64_t i_offset = i_head;
+         i_offset > p_sys->i_index && i_chain < VLTS_INDEX_DEPTH; )
+    {
+        uint8_t p_prev[8];
+        char psz_tag[5];
+        uint32_t i_size;
+
+        if( vlc_stream_Seek( p_demux->s, i_offset ) ||
+            !ReadChunkHeader( p_demux, psz_tag, &i_size ) ||
+            strcmp( psz_tag, VLTS_CHUNK_INDEX ) ||
+            vlc_stream_Read( p_demux->s, p_prev, 8 ) < 8 )
+        {
+            msg_Warn( p_demux, "broken index at %"PRIu64, i_offset );
+            break;
+        }
+
+        uint64_t *pi_new = realloc( pi_chain, (i_chain + 1) * sizeof(*pi_new) );
+        if( !pi_new )
+            break;
+        pi_chain = pi_new;
+        pi_chain[i_chain++] = i_offset;
+
+        /* The chain only goes backward */
+        if( GetQWBE( p_prev ) >= i_offset )
+            break;
+        i_offset = GetQWBE( p_prev );
+    }
+
+    while( i_chain > 0 )
+    {
+        block_t *p_index = ReadChunkAt( p_demux, pi_chain[--i_chain],
+                                        VLTS_CHUNK_INDEX );
+        if( p_index )
+        {
+            ParseIndex( p_demux, p_index, true );
+            block_Release( p_index );
+        }
+    }
+    free( pi_chain );
+
+    if( i_head > p_sys->i_index )
+        p_sys->i_index = i_head;
+}
+
+static int ParseHeader( demux_t *p_demux, const uint8_t *p_header,
+                        uint64_t *pi_index )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( memcmp( p_header, "VLTS", 4 ) || GetWBE( &p_header[4] ) != VLTS_VERSION )
+        return VLC_EGENERIC;
+
+    p_sys->b_closed = GetWBE( &p_header[6] ) & VLTS_FLAG_CLOSED;
+    *pi_index = GetQWBE( &p_header[8] );
+    p_sys->i_start = GetQWBE( &p_header[16] );
+    p_sys->i_end = GetQWBE( &p_header[24] );
+    return VLC_SUCCESS;
+}
+
+/* Reloads the header and the new index entries of a recording in progress,
+ * fails if the stream position could not be restored */
+static int Refresh( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_header[VLTS_HEADER_SIZE];
+    uint64_t i_index;
+
+    p_sys->i_refresh = mdate();
+
+    if( !p_sys->b_seekable || p_sys->b_closed )
+        return VLC_SUCCESS;
+
+    const uint64_t i_pos = vlc_stream_Tell( p_demux->s );
+    if( vlc_stream_Seek( p_demux->s, 0 ) == VLC_SUCCESS &&
+        vlc_stream_Read( p_demux->s, p_header, VLTS_HEADER_SIZE )
+                                                    == VLTS_HEADER_SIZE &&
+        ParseHeader( p_demux, p_header, &i_index ) == VLC_SUCCESS &&
+        i_index > p_sys->i_index )
+        LoadIndex( p_demux, i_index );
+
+    if( vlc_stream_Seek( p_demux->s, i_pos ) )
+    {
+        msg_Err( p_demux, "cannot seek back to %"PRIu64, i_pos );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Open
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    demux_t *p_demux = (demux_t*)p_this;
+    demux_sys_t *p_sys;
+    const uint8_t *p_peek;
+    uint64_t i_index;
+
+    if( vlc_stream_Peek( p_demux->s, &p_peek, VLTS_HEADER_SIZE )
+                                                    < VLTS_HEADER_SIZE ||
+        memcmp( p_peek, "VLTS", 4 ) )
+        return VLC_EGENERIC;
+
+    if( GetWBE( &p_peek[4] ) != VLTS_VERSION )
+    {
+        msg_Err( p_demux, "unsupported version %u", GetWBE( &p_peek[4] ) );
+        return VLC_EGENERIC;
+    }
+
+    p_demux->p_sys = p_sys = calloc( 1, sizeof( *p_sys ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    if( ParseHeader( p_demux, p_peek, &i_index ) )
+    {
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+    p_sys->b_follow = var_InheritBool( p_demux, "vlts-follow" );
+    p_sys->i_pcr = VLC_TS_INVALID;
+    p_sys->i_refresh = p_sys->i_grown = mdate();
+    TAB_INIT( p_sys->i_tracks, p_sys->pp_tracks );
+
+    if( vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &p_sys->b_seekable ) )
+        p_sys->b_seekable = false;
+
+    /* Load the streams and sync points of the whole recording, the formats
+     * are read from the index as the streams can start anywhere */
+    if( p_sys->b_seekable && i_index > 0 )
+    {
+        LoadIndex( p_demux, i_index );
+        msg_Dbg( p_demux, "%zu sync points, %d streams", p_sys->i_sync,
+                 p_sys->i_tracks );
+    }
+
+    if( vlc_stream_Seek( p_demux->s, VLTS_HEADER_SIZE ) )
+    {
+        Close( p_this );
+        return VLC_EGENERIC;
+    }
+
+    p_demux->pf_demux = Demux;
+    p_demux->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    demux_t *p_demux = (demux_t*)p_this;
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = 0; i < p_sys->i_tracks; i++ )
+    {
+        es_out_Del( p_demux->out, p_sys->pp_tracks[i]->p_es );
+        free( p_sys->pp_tracks[i] );
+    }
+    TAB_CLEAN( p_sys->i_tracks, p_sys->pp_tracks );
+    free( p_sys->p_sync );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Demux
+ *****************************************************************************/
+
+/* Called at the end of the data, returns to the start of the incomplete chunk
+ * and waits for it if the recording is in progress */
+static int Wait( demux_t *p_demux, uint64_t i_chunk )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_follow || !p_sys->b_seekable )
+        return VLC_DEMUXER_EOF;
+
+    /* Check whether the recording ended in the meantime */
+    if( Refresh( p_demux ) )
+        return VLC_DEMUXER_EGENERIC;
+
+    uint64_t i_size;
+    if( vlc_stream_GetSize( p_demux->s, &i_size ) )
+        return VLC_DEMUXER_EOF;
+    if( p_sys->b_closed && vlc_stream_Tell( p_demux->s ) >= i_size )
+        return VLC_DEMUXER_EOF;
+
+    const mtime_t i_now = mdate();
+    if( i_size != p_sys->i_size )
+    {
+        p_sys->i_size = i_size;
+        p_sys->i_grown = i_now;
+    }
+    else if( i_now - p_sys->i_grown >= VLTS_STALL_DELAY )
+    {
+        msg_Warn( p_demux, "recording stopped growing without being closed" );
+        return VLC_DEMUXER_EOF;
+    }
+
+    if( vlc_stream_Seek( p_demux->s, i_chunk ) )
+        return VLC_DEMUXER_EOF;
+
+    if( vlc_msleep_i11e( VLTS_POLL_DELAY ) )
+        return VLC_DEMUXER_EOF;
+    return VLC_DEMUXER_SUCCESS;
+}
+
+static int Demux( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint64_t i_chunk = vlc_stream_Tell( p_demux->s );
+    char psz_tag[5];
+    uint32_t i_size;
+
+    if( !p_sys->b_closed && mdate() >= p_sys->i_refresh + VLTS_REFRESH_DELAY &&
+        Refresh( p_demux ) )
+        return VLC_DEMUXER_EGENERIC;
+
+    if( !ReadChunkHeader( p_demux, psz_tag, &i_size ) )
+        return Wait( p_demux, i_chunk );
+
+    if( i_size > VLTS_CHUNK_MAX )
+    {
+        msg_Err( p_demux, "invalid chunk size %"PRIu32" at %"PRIu64,
+                 i_size, i_chunk );
+        return VLC_DEMUXER_EOF;
+    }
+
+    if( !strcmp( psz_tag, VLTS_CHUNK_BLOCK ) && i_size >= VLTS_BLOCK_HEADER )
+    {
+        block_t *p_block = vlc_stream_Block( p_demux->s, i_size );
+        if( p_block == NULL || p_block->i_buffer < i_size )
+        {
+            if( p_block )
+                block_Release( p_block );
+            return Wait( p_demux, i_chunk );
+        }
+
+        const uint8_t *p = p_block->p_buffer;
+        vlts_track_t *p_track = GetTrack( p_demux, GetDWBE( p ) );
+        if( p_track == NULL )
+        {
+            block_Release( p_block );
+            return VLC_DEMUXER_SUCCESS;
+        }
+
+        p_block->i_flags = GetDWBE( &p[4] ) & ~BLOCK_FLAG_PRIVATE_MASK;
+        p_block->i_dts = GetQWBE( &p[8] );
+        p_block->i_pts = GetQWBE( &p[16] );
+        p_block->i_length = GetQWBE( &p[24] );
+        p_block->p_buffer += VLTS_BLOCK_HEADER;
+        p_block->i_buffer -= VLTS_BLOCK_HEADER;
+
+        if( p_block->i_dts > p_sys->i_pcr )
+        {
+            p_sys->i_pcr = p_block->i_dts;
+            es_out_SetPCR( p_demux->out, p_sys->i_pcr );
+        }
+        es_out_Send( p_demux->out, p_track->p_es, p_block );
+    }
+    else if( !strcmp( psz_tag, VLTS_CHUNK_FORMAT ) ||
+             !strcmp( psz_tag, VLTS_CHUNK_INDEX ) )
+    {
+        block_t *p_chunk = vlc_stream_Block( p_demux->s, i_size );
+        if( p_chunk == NULL || p_chunk->i_buffer < i_size )
+        {
+            if( p_chunk )
+                block_Release( p_chunk );
+            return Wait( p_demux, i_chunk );
+        }
+
+        if( psz_tag[0] == 'f' )
+            AddTrack( p_demux, p_chunk->p_buffer, p_chunk->i_buffer );
+        else if( i_chunk > p_sys->i_index )
+        {
+            /* Not in the header chain yet (or the recording could not be
+             * rewritten): the formats were read on the way */
+            ParseIndex( p_demux, p_chunk, false );
+            p_sys->i_index = i_chunk;
+        }
+        block_Release( p_chunk );
+    }
+    else if( vlc_stream_Read( p_demux->s, NULL, i_size ) < i_size )
+        return Wait( p_demux, i_chunk );
+
+    return VLC_DEMUXER_SUCCESS;
+}
+
+/*****************************************************************************
+ * Control
+ *****************************************************************************/
+static int Seek( demux_t *p_demux, mtime_t i_time, bool b_precise )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_seekable )
+        return VLC_EGENERIC;
+
+    /* The position is set below either way */
+    (void) Refresh( p_demux );
+
+    /* Last sync point before the requested time */
+    uint64_t i_offset = VLTS_HEADER_SIZE;
+    size_t i_low = 0, i_high = p_sys->i_sync;
+    while( i_low < i_high )
+    {
+        size_t i_mid = (i_low + i_high) / 2;
+        if( p_sys->p_sync[i_mid].i_time <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    if( i_low > 0 )
+        i_offset = p_sys->p_sync[i_low - 1].i_offset;
+
+    if( vlc_stream_Seek( p_demux->s, i_offset ) )
+        return VLC_EGENERIC;
+
+    p_sys->i_pcr = VLC_TS_INVALID;
+    if( b_precise )
+        es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME, i_time );
+    return VLC_SUCCESS;
+}
+
+static int Control( demux_t *p_demux, int i_query, va_list args )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const mtime_t i_length = p_sys->i_start > VLC_TS_INVALID &&
+                             p_sys->i_end > p_sys->i_start ?
+                             p_sys->i_end - p_sys->i_start : 0;
+    double f, *pf;
+    int64_t i64, *pi64;
+    bool b_precise;
+
+    switch( i_query )
+    {
+        case DEMUX_CAN_SEEK:
+            *va_arg( args, bool * ) = p_sys->b_seekable;
+            return VLC_SUCCESS;
+
+        case DEMUX_GET_LENGTH:
+            pi64 = va_arg( args, int64_t * );
+            *pi64 = i_length;
+            return VLC_SUCCESS;
+
+        case DEMUX_GET_TIME:
+            pi64 = va_arg( args, int64_t * );
+            if( p_sys->i_pcr <= VLC_TS_INVALID || i_length == 0 )
+                return VLC_EGENERIC;
+            *pi64 = p_sys->i_pcr - p_sys->i_start;
+            return VLC_SUCCESS;
+
+        case DEMUX_SET_TIME:
+            i64 = va_arg( args, int64_t );
+            b_precise = va_arg( args, int );
+            if( i_length == 0 )
+                return VLC_EGENERIC;
+            return Seek( p_demux, p_sys->i_start + i64, b_precise );
+
+        case DEMUX_GET_POSITION:
+            pf = va_arg( args, double * );
+            if( p_sys->i_pcr <= VLC_TS_INVALID || i_length == 0 )
+                return VLC_EGENERIC;
+            *pf = (double)( p_sys->i_pcr - p_sys->i_start ) / i_length;
+            return VLC_SUCCESS;
+
+        case DEMUX_SET_POSITION:
+            f = va_arg( args, double );
+            b_precise = va_arg( args, int );
+            if( i_length == 0 )
+                return VLC_EGENERIC;
+            return Seek( p_demux, p_sys->i_start + f * i_length, b_precise );
+
+        default:
+            return demux_vaControlHelper( p_demux->s, 0, -1, 0, 1,
+                                          i_query, args );
+    }
+}
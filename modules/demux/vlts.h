@@ -0,0 +1,336 @@
+/*****************************************************************************
+ * vlts.h: VLC timeshift recording format
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_VLTS_H
+#define VLC_VLTS_H
+
+#include <limits.h>
+
+#include <vlc_boxes.h>
+
+/*
+ * A recording is a header followed by chunks, all values are big endian.
+ *
+ * header:   "VLTS" version(16) flags(16) index(64) start(64) end(64)
+ *           index is the offset of the last index chunk (0 if none), start
+ *           and end are the first and last block dts covered by the index.
+ *           The header is rewritten in place every time an index chunk is
+ *           appended, so that a recording in progress can be read back.
+ * chunk:    tag(32) size(32) payload[size]
+ *  "fmt ":  id(32) es format, see vlts_format_Write()
+ *  "blk ":  id(32) flags(32) dts(64) pts(64) length(64) data
+ *  "idx ":  previous index chunk offset(64) count(32) entries[count]
+ *           entry: type(32) time(64) offset(64)
+ */
+
+#define VLTS_HEADER_SIZE      32
+#define VLTS_VERSION          1
+#define VLTS_FLAG_CLOSED      0x0001 /* the recording is complete */
+
+#define VLTS_CHUNK_HEADER     8
+#define VLTS_CHUNK_FORMAT     "fmt "
+#define VLTS_CHUNK_BLOCK      "blk "
+#define VLTS_CHUNK_INDEX      "idx "
+
+#define VLTS_BLOCK_HEADER     32
+#define VLTS_INDEX_HEADER     12
+#define VLTS_INDEX_ENTRY      20
+
+enum vlts_entry_type_e
+{
+    VLTS_ENTRY_SYNC = 0,   /* a block decoding can start from */
+    VLTS_ENTRY_FORMAT,     /* a "fmt " chunk */
+};
+
+typedef struct
+{
+    uint32_t i_type;
+    mtime_t  i_time;
+    uint64_t i_offset;
+} vlts_entry_t;
+
+static inline void vlts_string_Write( bo_t *p_bo, const char *psz )
+{
+    size_t i_len = psz ? strnlen( psz, UINT16_MAX ) : 0;
+    bo_add_16be( p_bo, i_len );
+    if( i_len > 0 )
+        bo_add_mem( p_bo, i_len, psz );
+}
+
+/**
+ * Appends the serialized form of an es_format_t.
+ */
+static inline void vlts_format_Write( bo_t *p_bo, const es_format_t *p_fmt )
+{
+    bo_add_32be( p_bo, p_fmt->i_cat );
+    bo_add_32be( p_bo, p_fmt->i_codec );
+    bo_add_32be( p_bo, p_fmt->i_original_fourcc );
+    bo_add_32be( p_bo, p_fmt->i_group );
+    bo_add_32be( p_bo, p_fmt->i_priority );
+    bo_add_32be( p_bo, p_fmt->i_bitrate );
+    bo_add_32be( p_bo, p_fmt->i_profile );
+    bo_add_32be( p_bo, p_fmt->i_level );
+    bo_add_8( p_bo, p_fmt->b_packetized );
+    vlts_string_Write( p_bo, p_fmt->psz_language );
+    vlts_string_Write( p_bo, p_fmt->psz_description );
+
+    switch( p_fmt->i_cat )
+    {
+        case VIDEO_ES:
+        {
+            const video_format_t *v = &p_fmt->video;
+            bo_add_32be( p_bo, v->i_chroma );
+            bo_add_32be( p_bo, v->i_width );
+            bo_add_32be( p_bo, v->i_height );
+            bo_add_32be( p_bo, v->i_x_offset );
+            bo_add_32be( p_bo, v->i_y_offset );
+            bo_add_32be( p_bo, v->i_visible_width );
+            bo_add_32be( p_bo, v->i_visible_height );
+            bo_add_32be( p_bo, v->i_bits_per_pixel );
+            bo_add_32be( p_bo, v->i_sar_num );
+            bo_add_32be( p_bo, v->i_sar_den );
+            bo_add_32be( p_bo, v->i_frame_rate );
+            bo_add_32be( p_bo, v->i_frame_rate_base );
+            bo_add_8( p_bo, v->orientation );
+            bo_add_8( p_bo, v->primaries );
+            bo_add_8( p_bo, v->transfer );
+            bo_add_8( p_bo, v->space );
+            bo_add_8( p_bo, v->b_color_range_full );
+            bo_add_8( p_bo, v->chroma_location );
+            bo_add_8( p_bo, v->multiview_mode );
+            bo_add_8( p_bo, v->projection_mode );
+            for( int i = 0; i < 6; i++ )
+                bo_add_16be( p_bo, v->mastering.primaries[i] );
+            bo_add_16be( p_bo, v->mastering.white_point[0] );
+            bo_add_16be( p_bo, v->mastering.white_point[1] );
+            bo_add_32be( p_bo, v->mastering.max_luminance );
+            bo_add_32be( p_bo, v->mastering.min_luminance );
+            bo_add_16be( p_bo, v->lighting.MaxCLL );
+            bo_add_16be( p_bo, v->lighting.MaxFALL );
+            break;
+        }
+        case AUDIO_ES:
+        {
+            const audio_format_t *a = &p_fmt->audio;
+            bo_add_32be( p_bo, a->i_format );
+            bo_add_32be( p_bo, a->i_rate );
+            bo_add_16be( p_bo, a->i_physical_channels );
+            bo_add_16be( p_bo, a->i_chan_mode );
+            bo_add_32be( p_bo, a->i_bytes_per_frame );
+            bo_add_32be( p_bo, a->i_frame_length );
+            bo_add_32be( p_bo, a->i_bitspersample );
+            bo_add_32be( p_bo, a->i_blockalign );
+            bo_add_8( p_bo, a->i_channels );
+            break;
+        }
+        case SPU_ES:
+        {
+            const subs_format_t *s = &p_fmt->subs;
+            vlts_string_Write( p_bo, s->psz_encoding );
+            bo_add_32be( p_bo, s->i_x_origin );
+            bo_add_32be( p_bo, s->i_y_origin );
+            for( int i = 0; i < 16 + 1; i++ )
+                bo_add_32be( p_bo, s->spu.palette[i] );
+            bo_add_32be( p_bo, s->spu.i_original_frame_width );
+            bo_add_32be( p_bo, s->spu.i_original_frame_height );
+            bo_add_32be( p_bo, s->dvb.i_id );
+            bo_add_32be( p_bo, s->teletext.i_magazine );
+            bo_add_32be( p_bo, s->teletext.i_page );
+            bo_add_8( p_bo, s->cc.i_channel );
+            bo_add_32be( p_bo, s->cc.i_reorder_depth );
+            break;
+        }
+        default:
+            break;
+    }
+
+    bo_add_32be( p_bo, p_fmt->i_extra );
+    if( p_fmt->i_extra > 0 )
+        bo_add_mem( p_bo, p_fmt->i_extra, p_fmt->p_extra );
+}
+
+typedef struct
+{
+    const uint8_t *p_data;
+    size_t         i_data;
+    bool           b_error;
+} vlts_reader_t;
+
+static inline const uint8_t *vlts_reader_Get( vlts_reader_t *r, size_t i_size )
+{
+    if( r->b_error || r->i_data < i_size )
+    {
+        r->b_error = true;
+        return NULL;
+    }
+    const uint8_t *p = r->p_data;
+    r->p_data += i_size;
+    r->i_data -= i_size;
+    return p;
+}
+
+static inline uint8_t vlts_reader_8( vlts_reader_t *r )
+{
+    const uint8_t *p = vlts_reader_Get( r, 1 );
+    return p ? *p : 0;
+}
+
+static inline uint16_t vlts_reader_16( vlts_reader_t *r )
+{
+    const uint8_t *p = vlts_reader_Get( r, 2 );
+    return p ? GetWBE( p ) : 0;
+}
+
+static inline uint32_t vlts_reader_32( vlts_reader_t *r )
+{
+    const uint8_t *p = vlts_reader_Get( r, 4 );
+    return p ? GetDWBE( p ) : 0;
+}
+
+static inline char *vlts_reader_String( vlts_reader_t *r )
+{
+    uint16_t i_len = vlts_reader_16( r );
+    const uint8_t *p = vlts_reader_Get( r, i_len );
+    if( p == NULL || i_len == 0 )
+        return NULL;
+    return strndup( (const char *)p, i_len );
+}
+
+/**
+ * Reads back an es_format_t written by vlts_format_Write().
+ * The format is initialized here, and cleaned on error.
+ */
+static inline int vlts_format_Read( es_format_t *p_fmt,
+                                    const uint8_t *p_data, size_t i_data )
+{
+    vlts_reader_t r = { p_data, i_data, false };
+
+    uint32_t i_cat = vlts_reader_32( &r );
+    if( i_cat != VIDEO_ES && i_cat != AUDIO_ES && i_cat != SPU_ES &&
+        i_cat != DATA_ES )
+        return VLC_EGENERIC;
+
+    es_format_Init( p_fmt, i_cat, vlts_reader_32( &r ) );
+    p_fmt->i_original_fourcc = vlts_reader_32( &r );
+    p_fmt->i_group = (int32_t)vlts_reader_32( &r );
+    p_fmt->i_priority = (int32_t)vlts_reader_32( &r );
+    p_fmt->i_bitrate = vlts_reader_32( &r );
+    p_fmt->i_profile = (int32_t)vlts_reader_32( &r );
+    p_fmt->i_level = (int32_t)vlts_reader_32( &r );
+    p_fmt->b_packetized = vlts_reader_8( &r );
+    p_fmt->psz_language = vlts_reader_String( &r );
+    p_fmt->psz_description = vlts_reader_String( &r );
+
+    switch( i_cat )
+    {
+        case VIDEO_ES:
+        {
+            video_format_t *v = &p_fmt->video;
+            v->i_chroma = vlts_reader_32( &r );
+            v->i_width = vlts_reader_32( &r );
+            v->i_height = vlts_reader_32( &r );
+            v->i_x_offset = vlts_reader_32( &r );
+            v->i_y_offset = vlts_reader_32( &r );
+            v->i_visible_width = vlts_reader_32( &r );
+            v->i_visible_height = vlts_reader_32( &r );
+            v->i_bits_per_pixel = vlts_reader_32( &r );
+            v->i_sar_num = vlts_reader_32( &r );
+            v->i_sar_den = vlts_reader_32( &r );
+            v->i_frame_rate = vlts_reader_32( &r );
+            v->i_frame_rate_base = vlts_reader_32( &r );
+            v->orientation = vlts_reader_8( &r );
+            v->primaries = vlts_reader_8( &r );
+            v->transfer = vlts_reader_8( &r );
+            v->space = vlts_reader_8( &r );
+            v->b_color_range_full = vlts_reader_8( &r );
+            v->chroma_location = vlts_reader_8( &r );
+            v->multiview_mode = vlts_reader_8( &r );
+            v->projection_mode = vlts_reader_8( &r );
+            for( int i = 0; i < 6; i++ )
+                v->mastering.primaries[i] = vlts_reader_16( &r );
+            v->mastering.white_point[0] = vlts_reader_16( &r );
+            v->mastering.white_point[1] = vlts_reader_16( &r );
+            v->mastering.max_luminance = vlts_reader_32( &r );
+            v->mastering.min_luminance = vlts_reader_32( &r );
+            v->lighting.MaxCLL = vlts_reader_16( &r );
+            v->lighting.MaxFALL = vlts_reader_16( &r );
+            if( v->orientation > ORIENT_RIGHT_BOTTOM ||
+                v->primaries > COLOR_PRIMARIES_MAX ||
+                v->transfer > TRANSFER_FUNC_MAX ||
+                v->space > COLOR_SPACE_MAX ||
+                v->chroma_location > CHROMA_LOCATION_MAX )
+                r.b_error = true;
+            break;
+        }
+        case AUDIO_ES:
+        {
+            audio_format_t *a = &p_fmt->audio;
+            a->i_format = vlts_reader_32( &r );
+            a->i_rate = vlts_reader_32( &r );
+            a->i_physical_channels = vlts_reader_16( &r );
+            a->i_chan_mode = vlts_reader_16( &r );
+            a->i_bytes_per_frame = vlts_reader_32( &r );
+            a->i_frame_length = vlts_reader_32( &r );
+            a->i_bitspersample = vlts_reader_32( &r );
+            a->i_blockalign = vlts_reader_32( &r );
+            a->i_channels = vlts_reader_8( &r );
+            break;
+        }
+        case SPU_ES:
+        {
+            subs_format_t *s = &p_fmt->subs;
+            s->psz_encoding = vlts_reader_String( &r );
+            s->i_x_origin = (int32_t)vlts_reader_32( &r );
+            s->i_y_origin = (int32_t)vlts_reader_32( &r );
+            for( int i = 0; i < 16 + 1; i++ )
+                s->spu.palette[i] = vlts_reader_32( &r );
+            s->spu.i_original_frame_width = (int32_t)vlts_reader_32( &r );
+            s->spu.i_original_frame_height = (int32_t)vlts_reader_32( &r );
+            s->dvb.i_id = (int32_t)vlts_reader_32( &r );
+            s->teletext.i_magazine = (int32_t)vlts_reader_32( &r );
+            s->teletext.i_page = (int32_t)vlts_reader_32( &r );
+            s->cc.i_channel = vlts_reader_8( &r );
+            s->cc.i_reorder_depth = (int32_t)vlts_reader_32( &r );
+            break;
+        }
+        default:
+            break;
+    }
+
+    uint32_t i_extra = vlts_reader_32( &r );
+    const uint8_t *p_extra = vlts_reader_Get( &r, i_extra );
+    if( p_extra != NULL && i_extra > 0 && i_extra <= INT_MAX )
+    {
+        p_fmt->p_extra = malloc( i_extra );
+        if( p_fmt->p_extra != NULL )
+        {
+            memcpy( p_fmt->p_extra, p_extra, i_extra );
+            p_fmt->i_extra = i_extra;
+        }
+    }
+
+    if( r.b_error )
+    {
+        es_format_Clean( p_fmt );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+#endif
@@ -593,6 +593,10 @@ InputStatsPanel::InputStatsPanel( QWidget *parent ): QWidget( parent )
                            "0", video, qtr("frames") );
     CREATE_AND_ADD_TO_CAT( vlost_frames_stat, qtr("Lost"),
                            "0", video, qtr("frames") );
+    CREATE_AND_ADD_TO_CAT( vhurried_stat, qtr("Decoded without loop filter"),
+                           "0", video, qtr("blocks") );
+    CREATE_AND_ADD_TO_CAT( vskipped_stat, qtr("Decoded skipping non-reference frames"),
+                           "0", video, qtr("blocks") );
 
     CREATE_AND_ADD_TO_CAT( adecoded_stat, qtr("Decoded"),
                            "0", audio, qtr("blocks") );
@@ -664,6 +668,8 @@ void InputStatsPanel::update( input_item_t *p_item )
     UPDATE_INT( vdecoded_stat,     p_item->p_stats->i_decoded_video );
     UPDATE_INT( vdisplayed_stat,   p_item->p_stats->i_displayed_pictures );
     UPDATE_INT( vlost_frames_stat, p_item->p_stats->i_lost_pictures );
+    UPDATE_INT( vhurried_stat,     p_item->p_stats->i_hurried_video );
+    UPDATE_INT( vskipped_stat,     p_item->p_stats->i_skipped_video );
 
     /* Audio*/
     UPDATE_INT( adecoded_stat, p_item->p_stats->i_decoded_audio );
@@ -129,6 +129,8 @@ private:
     QTreeWidgetItem *vdecoded_stat;
     QTreeWidgetItem *vdisplayed_stat;
     QTreeWidgetItem *vlost_frames_stat;
+    QTreeWidgetItem *vhurried_stat;
+    QTreeWidgetItem *vskipped_stat;
     QTreeWidgetItem *vfps_stat;
 
     QTreeWidgetItem *audio;
@@ -52,6 +52,13 @@
     "Create \"Fast Start\" files. " \
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
+#define MOOV_RESERVE_TEXT N_("Reserved header space (KiB)")
+#define MOOV_RESERVE_LONGTEXT N_(\
+    "Space reserved in front of the media data for the index, so that " \
+    "\"Fast Start\" files are finished without moving the media data. " \
+    "The index takes about 16 bytes per sample. When it does not fit, it " \
+    "is written at the end of the file and the space is left unused. " \
+    "0 disables the reservation.")
 
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
@@ -69,6 +76,8 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", true,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_integer_with_range(SOUT_CFG_PREFIX "moov-reserve", 0, 0, 1048576,
+                           MOOV_RESERVE_TEXT, MOOV_RESERVE_LONGTEXT, true)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -88,7 +97,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "moov-reserve", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -163,6 +172,8 @@ struct sout_mux_sys_t
 
     uint64_t i_mdat_pos;
     uint64_t i_pos;
+    uint64_t i_moov_reserve_pos;
+    uint64_t i_moov_reserve;
     mtime_t  i_read_duration;
     mtime_t  i_start_dts;
 
@@ -183,6 +194,27 @@ static block_t *ConvertSUBT(block_t *);
 static bool CreateCurrentEdit(mp4_stream_t *, mtime_t, bool);
 static void DebugEdits(sout_mux_t *, const mp4_stream_t *);
 
+static int WriteFreeBox(sout_mux_t *p_mux, uint64_t i_size)
+{
+    bo_t *box = box_new("free");
+    if(!box)
+        return VLC_ENOMEM;
+    box_fix(box, i_size);
+    box_send(p_mux, box);
+
+    for(i_size -= 8; i_size > 0;)
+    {
+        size_t i_chunk = __MIN(i_size, 65536);
+        block_t *p_buf = block_Alloc(i_chunk);
+        if(!p_buf)
+            return VLC_ENOMEM;
+        memset(p_buf->p_buffer, 0, i_chunk);
+        sout_AccessOutWrite(p_mux->p_access, p_buf);
+        i_size -= i_chunk;
+    }
+    return VLC_SUCCESS;
+}
+
 static int WriteSlowStartHeader(sout_mux_t *p_mux)
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
@@ -209,6 +241,15 @@ static int WriteSlowStartHeader(sout_mux_t *p_mux)
         box_send(p_mux, box);
     }
 
+    if (p_sys->i_moov_reserve > 0) {
+        /* Room for the moov header, a free box until then */
+        if (WriteFreeBox(p_mux, p_sys->i_moov_reserve) != VLC_SUCCESS)
+            return VLC_ENOMEM;
+        p_sys->i_moov_reserve_pos = p_sys->i_pos;
+        p_sys->i_pos += p_sys->i_moov_reserve;
+        p_sys->i_mdat_pos = p_sys->i_pos;
+    }
+
     /* Now add mdat header */
     box = box_new("mdat");
     if(!box)
@@ -246,6 +287,9 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_nb_streams = 0;
     p_sys->pp_streams   = NULL;
     p_sys->i_mdat_pos   = 0;
+    p_sys->i_moov_reserve_pos = 0;
+    p_sys->i_moov_reserve = 1024 * (uint64_t)
+        var_GetInteger(p_mux, SOUT_CFG_PREFIX "moov-reserve");
     p_sys->b_mov        = p_mux->psz_mux && !strcmp(p_mux->psz_mux, "mov");
     p_sys->b_3gp        = p_mux->psz_mux && !strcmp(p_mux->psz_mux, "3gp");
     p_sys->i_read_duration   = 0;
@@ -294,8 +338,29 @@ static void Close(vlc_object_t *p_this)
     uint64_t i_moov_pos = p_sys->i_pos;
     bo_t *moov = BuildMoov(p_mux);
 
-    /* Check we need to create "fast start" files */
-    p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
+    /* Use the reserved space if the header fits in it */
+    if (p_sys->i_moov_reserve > 0 && p_sys->b_header_sent && moov && moov->b) {
+        const uint64_t i_moov_size = moov->b->i_buffer;
+
+        if (i_moov_size == p_sys->i_moov_reserve ||
+            i_moov_size + 8 <= p_sys->i_moov_reserve) {
+            i_moov_pos = p_sys->i_moov_reserve_pos;
+            /* The rest of the reserved space stays a free box */
+            if (i_moov_size < p_sys->i_moov_reserve) {
+                bo_add_32be  (moov, p_sys->i_moov_reserve - i_moov_size);
+                bo_add_fourcc(moov, "free");
+            }
+        } else {
+            msg_Warn(p_mux, "moov header of %"PRIu64" bytes does not fit in "
+                     "the %"PRIu64" reserved ones, writing it at the end",
+                     i_moov_size, p_sys->i_moov_reserve);
+        }
+    }
+
+    /* Check we need to create "fast start" files, with the media data
+     * moved after the moov header, when no space was reserved for it */
+    p_sys->b_fast_start = p_sys->i_moov_reserve == 0 &&
+                          var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
     while (p_sys->b_fast_start && moov && moov->b) {
         /* Move data to the end of the file so we can fit the moov header
          * at the start */
@@ -872,6 +937,24 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
 
     *pi_mdat_total_size = 0;
 
+    /* The fragment is a random access point if every video track starts
+     * with a keyframe */
+    mtime_t i_fragment_dts = VLC_TS_INVALID;
+    mtime_t i_fragment_length = 0;
+    bool b_random_access = true;
+    for (unsigned int i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++)
+    {
+        const mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
+        if (!p_stream->read.p_first)
+            continue;
+        const block_t *p_block = p_stream->read.p_first->p_block;
+        if (i_fragment_dts == VLC_TS_INVALID || p_block->i_dts < i_fragment_dts)
+            i_fragment_dts = p_block->i_dts;
+        if (p_stream->b_hasiframes && p_stream->mux.fmt.i_cat == VIDEO_ES &&
+            !(p_block->i_flags & BLOCK_FLAG_TYPE_I))
+            b_random_access = false;
+    }
+
     moof = box_new("moof");
     if(!moof)
         return NULL;
@@ -1054,6 +1137,9 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
             box_gather(traf, trun);
         }
 
+        if (i_time - p_stream->i_written_duration > i_fragment_length)
+            i_fragment_length = i_time - p_stream->i_written_duration;
+
         box_gather(moof, traf);
     }
 
@@ -1072,13 +1158,18 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
         bo_set_32be(moof, i_fixupoffset, moof->b->i_buffer + 8);
     }
 
-    /* set iframe flag, so the streaming server always starts from moof */
-    moof->b->i_flags |= BLOCK_FLAG_TYPE_I;
+    /* set iframe flag, so the streaming server and the segmenters always
+     * start from a moof that can be decoded on its own */
+    if (b_random_access)
+        moof->b->i_flags |= BLOCK_FLAG_TYPE_I;
+    moof->b->i_dts = moof->b->i_pts = i_fragment_dts;
+    moof->b->i_length = i_fragment_length;
 
     return moof;
 }
 
-static void WriteFragmentMDAT(sout_mux_t *p_mux, size_t i_total_size)
+static void WriteFragmentMDAT(sout_mux_t *p_mux, size_t i_total_size,
+                              mtime_t i_dts)
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
 
@@ -1089,6 +1180,7 @@ static void WriteFragmentMDAT(sout_mux_t *p_mux, size_t i_total_size)
     /* force update of real size */
     assert(mdat->b->i_buffer==8);
     box_fix(mdat, mdat->b->i_buffer + i_total_size);
+    mdat->b->i_dts = mdat->b->i_pts = i_dts;
     p_sys->i_pos += mdat->b->i_buffer;
     /* only write header */
     sout_AccessOutWrite(p_mux->p_access, mdat->b);
@@ -1281,10 +1373,10 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
     {
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += moof->b->i_buffer;
-        assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
+        mtime_t i_dts = moof->b->i_dts;
         box_send(p_mux, moof);
         msg_Dbg(p_mux, "writing mdat @ %"PRId64, p_sys->i_pos);
-        WriteFragmentMDAT(p_mux, i_mdat_size);
+        WriteFragmentMDAT(p_mux, i_mdat_size, i_dts);
 
         /* update iframe point */
         for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
@@ -0,0 +1,553 @@
+/*****************************************************************************
+ * vlts.c: VLC timeshift recording muxer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+
+#include "../demux/vlts.h"
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open   ( vlc_object_t * );
+static void Close  ( vlc_object_t * );
+
+#define INDEX_TEXT N_("Index interval")
+#define INDEX_LONGTEXT N_( \
+    "Maximum duration (in seconds) of the recording not covered by the " \
+    "index written in the file. A recording in progress can only be " \
+    "seeked up to that point." )
+
+#define SOUT_CFG_PREFIX "sout-vlts-"
+
+vlc_module_begin ()
+    set_description( N_("VLC timeshift recording muxer") )
+    set_capability( "sout mux", 5 )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_MUX )
+    add_integer_with_range( SOUT_CFG_PREFIX "index-interval", 5, 1, 3600,
+                            INDEX_TEXT, INDEX_LONGTEXT, true )
+    set_callbacks( Open, Close )
+    add_shortcut( "vlts" )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Exported prototypes
+ *****************************************************************************/
+static const char *const ppsz_sout_options[] = {
+    "index-interval", NULL
+};
+
+static int Control  ( sout_mux_t *, int, va_list );
+static int AddStream( sout_mux_t *, sout_input_t * );
+static void DelStream( sout_mux_t *, sout_input_t * );
+static int Mux      ( sout_mux_t * );
+
+static void *Thread( void * );
+static void WriteHeader( sout_mux_t *, bool );
+
+/* Marks the header blocks given to the writing thread, to be written at the
+ * beginning of the file */
+#define BLOCK_FLAG_VLTS_HEADER (1 << BLOCK_FLAG_PRIVATE_SHIFT)
+
+/* Amount of data the writing thread can lag behind */
+#define VLTS_QUEUE_MAX  (32 * 1024 * 1024)
+
+/* Number of blocks buffered on one stream before the others are assumed to
+ * have stalled and interleaving is ignored */
+#define VLTS_INTERLEAVE_MAX 64
+
+/* Interval between sync entries when there is no video */
+#define VLTS_SYNC_INTERVAL (CLOCK_FREQ / 2)
+
+#define VLTS_ENTRIES_MAX 1024
+
+typedef struct
+{
+    uint32_t i_id;
+    bool     b_written;
+} vlts_stream_t;
+
+struct sout_mux_sys_t
+{
+    vlc_thread_t thread;
+    block_fifo_t *p_queue;
+    bool         b_done;    /* protected by the p_queue lock */
+
+    /* Offset of the next chunk in the file */
+    uint64_t     i_pos;
+    uint32_t     i_next_id;
+
+    /* Stream used to place sync points */
+    sout_input_t *p_ref;
+    bool          b_ref_video;
+
+    mtime_t      i_start;
+    mtime_t      i_end;
+    mtime_t      i_last_sync;
+
+    /* Index entries not yet written */
+    vlts_entry_t *p_entries;
+    size_t        i_entries;
+    uint64_t      i_index;
+    mtime_t       i_index_interval;
+    mtime_t       i_index_time;
+};
+
+/*****************************************************************************
+ * Open:
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    sout_mux_t *p_mux = (sout_mux_t*)p_this;
+    sout_mux_sys_t *p_sys;
+
+    config_ChainParse( p_mux, SOUT_CFG_PREFIX, ppsz_sout_options,
+                       p_mux->p_cfg );
+
+    p_sys = malloc( sizeof( *p_sys ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    p_sys->p_entries = vlc_alloc( VLTS_ENTRIES_MAX,
+                                  sizeof( *p_sys->p_entries ) );
+    p_sys->p_queue = block_FifoNew();
+    if( !p_sys->p_entries || !p_sys->p_queue )
+        goto error;
+
+    p_sys->b_done = false;
+    p_sys->i_pos = VLTS_HEADER_SIZE;
+    p_sys->i_next_id = 0;
+    p_sys->p_ref = NULL;
+    p_sys->b_ref_video = false;
+    p_sys->i_start = VLC_TS_INVALID;
+    p_sys->i_end = VLC_TS_INVALID;
+    p_sys->i_last_sync = VLC_TS_INVALID;
+    p_sys->i_entries = 0;
+    p_sys->i_index = 0;
+    p_sys->i_index_interval = CLOCK_FREQ *
+        var_GetInteger( p_mux, SOUT_CFG_PREFIX "index-interval" );
+    p_sys->i_index_time = VLC_TS_INVALID;
+
+    p_mux->p_sys = p_sys;
+
+    if( vlc_clone( &p_sys->thread, Thread, p_mux, VLC_THREAD_PRIORITY_LOW ) )
+        goto error;
+
+    p_mux->pf_control  = Control;
+    p_mux->pf_addstream = AddStream;
+    p_mux->pf_delstream = DelStream;
+    p_mux->pf_mux       = Mux;
+
+    /* Written as is: the index gets appended and the header rewritten as
+     * the recording goes */
+    WriteHeader( p_mux, false );
+
+    return VLC_SUCCESS;
+
+error:
+    if( p_sys->p_queue )
+        block_FifoRelease( p_sys->p_queue );
+    free( p_sys->p_entries );
+    free( p_sys );
+    return VLC_ENOMEM;
+}
+
+/*****************************************************************************
+ * Writing thread
+ *****************************************************************************/
+static void Queue( sout_mux_t *p_mux, block_t *p_block )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    vlc_fifo_Lock( p_sys->p_queue );
+    while( vlc_fifo_GetBytes( p_sys->p_queue ) > VLTS_QUEUE_MAX )
+        vlc_fifo_Wait( p_sys->p_queue );
+    vlc_fifo_QueueUnlocked( p_sys->p_queue, p_block );
+    vlc_fifo_Unlock( p_sys->p_queue );
+}
+
+static void *Thread( void *data )
+{
+    sout_mux_t *p_mux = data;
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    bool b_can_seek = false;
+    uint64_t i_written = 0;
+
+    sout_AccessOutControl( p_mux->p_access, ACCESS_OUT_CAN_SEEK, &b_can_seek );
+    if( !b_can_seek )
+        msg_Warn( p_mux, "output is not seekable, the recording will not "
+                  "be indexed" );
+
+    for( ;; )
+    {
+        vlc_fifo_Lock( p_sys->p_queue );
+        while( vlc_fifo_IsEmpty( p_sys->p_queue ) && !p_sys->b_done )
+            vlc_fifo_Wait( p_sys->p_queue );
+        block_t *p_block = vlc_fifo_DequeueUnlocked( p_sys->p_queue );
+        vlc_fifo_Signal( p_sys->p_queue );
+        vlc_fifo_Unlock( p_sys->p_queue );
+
+        if( p_block == NULL )
+            break;
+
+        if( p_block->i_flags & BLOCK_FLAG_VLTS_HEADER )
+        {
+            p_block->i_flags &= ~BLOCK_FLAG_VLTS_HEADER;
+            if( i_written == 0 )
+            {
+                i_written += p_block->i_buffer;
+                sout_AccessOutWrite( p_mux->p_access, p_block );
+            }
+            else if( b_can_seek &&
+                     sout_AccessOutSeek( p_mux->p_access, 0 ) == VLC_SUCCESS )
+            {
+                sout_AccessOutWrite( p_mux->p_access, p_block );
+                sout_AccessOutSeek( p_mux->p_access, i_written );
+            }
+            else
+                block_Release( p_block );
+        }
+        else
+        {
+            i_written += p_block->i_buffer;
+            sout_AccessOutWrite( p_mux->p_access, p_block );
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+ * Chunks
+ *****************************************************************************/
+static void WriteHeader( sout_mux_t *p_mux, bool b_closed )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    bo_t bo;
+
+    if( !bo_init( &bo, VLTS_HEADER_SIZE ) )
+        return;
+    bo_add_mem( &bo, 4, "VLTS" );
+    bo_add_16be( &bo, VLTS_VERSION );
+    bo_add_16be( &bo, b_closed ? VLTS_FLAG_CLOSED : 0 );
+    bo_add_64be( &bo, p_sys->i_index );
+    bo_add_64be( &bo, p_sys->i_start );
+    bo_add_64be( &bo, p_sys->i_end );
+
+    bo.b->i_flags |= BLOCK_FLAG_VLTS_HEADER;
+    Queue( p_mux, bo.b );
+}
+
+static void WriteIndex( sout_mux_t *p_mux, bool b_closed )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    if( p_sys->i_entries > 0 )
+    {
+        bo_t bo;
+        const size_t i_size = VLTS_INDEX_HEADER +
+                              p_sys->i_entries * VLTS_INDEX_ENTRY;
+
+        if( !bo_init( &bo, VLTS_CHUNK_HEADER + i_size ) )
+            return;
+        bo_add_mem( &bo, 4, VLTS_CHUNK_INDEX );
+        bo_add_32be( &bo, i_size );
+        bo_add_64be( &bo, p_sys->i_index );
+        bo_add_32be( &bo, p_sys->i_entries );
+        for( size_t i = 0; i < p_sys->i_entries; i++ )
+        {
+            bo_add_32be( &bo, p_sys->p_entries[i].i_type );
+            bo_add_64be( &bo, p_sys->p_entries[i].i_time );
+            bo_add_64be( &bo, p_sys->p_entries[i].i_offset );
+        }
+
+        p_sys->i_index = p_sys->i_pos;
+        p_sys->i_pos += bo.b->i_buffer;
+        p_sys->i_entries = 0;
+        Queue( p_mux, bo.b );
+    }
+
+    /* Always rewrite the header, as it also holds the end of the recording */
+    WriteHeader( p_mux, b_closed );
+    p_sys->i_index_time = p_sys->i_end;
+}
+
+static void AddEntry( sout_mux_t *p_mux, uint32_t i_type, mtime_t i_time )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    if( p_sys->i_entries >= VLTS_ENTRIES_MAX )
+        WriteIndex( p_mux, false );
+
+    vlts_entry_t *p_entry = &p_sys->p_entries[p_sys->i_entries++];
+    p_entry->i_type = i_type;
+    p_entry->i_time = i_time;
+    p_entry->i_offset = p_sys->i_pos;
+}
+
+static bool IsSyncPoint( sout_mux_t *p_mux, sout_input_t *p_input,
+                         const block_t *p_data )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    if( p_sys->p_ref == NULL && ( p_input->p_fmt->i_cat == VIDEO_ES ||
+                                  p_input->p_fmt->i_cat == AUDIO_ES ) )
+    {
+        p_sys->p_ref = p_input;
+        p_sys->b_ref_video = p_input->p_fmt->i_cat == VIDEO_ES;
+    }
+
+    if( p_input != p_sys->p_ref || p_data->i_dts <= VLC_TS_INVALID )
+        return false;
+
+    if( p_sys->b_ref_video )
+        return (p_data->i_flags & BLOCK_FLAG_TYPE_I) != 0;
+
+    return p_sys->i_last_sync <= VLC_TS_INVALID ||
+           p_data->i_dts >= p_sys->i_last_sync + VLTS_SYNC_INTERVAL;
+}
+
+static void WriteBlock( sout_mux_t *p_mux, sout_input_t *p_input,
+                        block_t *p_data )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    vlts_stream_t *p_stream = p_input->p_sys;
+
+    if( IsSyncPoint( p_mux, p_input, p_data ) )
+    {
+        AddEntry( p_mux, VLTS_ENTRY_SYNC, p_data->i_dts );
+        p_sys->i_last_sync = p_data->i_dts;
+    }
+
+    if( p_data->i_dts > VLC_TS_INVALID )
+    {
+        if( p_sys->i_start <= VLC_TS_INVALID )
+            p_sys->i_start = p_data->i_dts;
+        if( p_data->i_dts > p_sys->i_end )
+            p_sys->i_end = p_data->i_dts;
+    }
+
+    const size_t i_payload = p_data->i_buffer;
+    p_data = block_Realloc( p_data, VLTS_CHUNK_HEADER + VLTS_BLOCK_HEADER,
+                            p_data->i_buffer );
+    if( p_data == NULL )
+        return;
+
+    uint8_t *p = p_data->p_buffer;
+    memcpy( p, VLTS_CHUNK_BLOCK, 4 );
+    SetDWBE( &p[4], VLTS_BLOCK_HEADER + i_payload );
+    SetDWBE( &p[8], p_stream->i_id );
+    SetDWBE( &p[12], p_data->i_flags & ~BLOCK_FLAG_PRIVATE_MASK );
+    SetQWBE( &p[16], p_data->i_dts );
+    SetQWBE( &p[24], p_data->i_pts );
+    SetQWBE( &p[32], p_data->i_length );
+    p_data->i_flags &= ~BLOCK_FLAG_PRIVATE_MASK;
+
+    p_stream->b_written = true;
+    p_sys->i_pos += p_data->i_buffer;
+    Queue( p_mux, p_data );
+
+    if( p_sys->i_index_time <= VLC_TS_INVALID )
+        p_sys->i_index_time = p_sys->i_end;
+    else if( p_sys->i_end - p_sys->i_index_time >= p_sys->i_index_interval )
+        WriteIndex( p_mux, false );
+}
+
+static size_t FifoCount( block_fifo_t *p_fifo )
+{
+    vlc_fifo_Lock( p_fifo );
+    size_t i_count = vlc_fifo_GetCount( p_fifo );
+    vlc_fifo_Unlock( p_fifo );
+    return i_count;
+}
+
+/* Writes what is left of a stream, without interleaving */
+static void Drain( sout_mux_t *p_mux, sout_input_t *p_input )
+{
+    vlc_fifo_Lock( p_input->p_fifo );
+    block_t *p_data = vlc_fifo_DequeueAllUnlocked( p_input->p_fifo );
+    vlc_fifo_Unlock( p_input->p_fifo );
+
+    while( p_data )
+    {
+        block_t *p_next = p_data->p_next;
+        p_data->p_next = NULL;
+        WriteBlock( p_mux, p_input, p_data );
+        p_data = p_next;
+    }
+}
+
+/*****************************************************************************
+ * Close:
+ *****************************************************************************/
+static void Close( vlc_object_t * p_this )
+{
+    sout_mux_t *p_mux = (sout_mux_t*)p_this;
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    for( int i = 0; i < p_mux->i_nb_inputs; i++ )
+        if( p_mux->pp_inputs[i]->p_sys )
+            Drain( p_mux, p_mux->pp_inputs[i] );
+    WriteIndex( p_mux, true );
+
+    vlc_fifo_Lock( p_sys->p_queue );
+    p_sys->b_done = true;
+    vlc_fifo_Signal( p_sys->p_queue );
+    vlc_fifo_Unlock( p_sys->p_queue );
+    vlc_join( p_sys->thread, NULL );
+
+    block_FifoRelease( p_sys->p_queue );
+    free( p_sys->p_entries );
+    free( p_sys );
+}
+
+static int Control( sout_mux_t *p_mux, int i_query, va_list args )
+{
+    VLC_UNUSED(p_mux);
+    bool *pb_bool;
+    char **ppsz;
+
+    switch( i_query )
+    {
+        case MUX_CAN_ADD_STREAM_WHILE_MUXING:
+            pb_bool = va_arg( args, bool * );
+            *pb_bool = true;
+            return VLC_SUCCESS;
+
+        case MUX_GET_ADD_STREAM_WAIT:
+            pb_bool = va_arg( args, bool * );
+            *pb_bool = false;
+            return VLC_SUCCESS;
+
+        case MUX_GET_MIME:
+            ppsz = va_arg( args, char ** );
+            *ppsz = strdup( "application/x-vlc-timeshift" );
+            return VLC_SUCCESS;
+
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static int AddStream( sout_mux_t *p_mux, sout_input_t *p_input )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    vlts_stream_t *p_stream = malloc( sizeof( *p_stream ) );
+    bo_t bo;
+
+    if( !p_stream || !bo_init( &bo, 1024 ) )
+    {
+        free( p_stream );
+        return VLC_ENOMEM;
+    }
+    p_stream->i_id = p_sys->i_next_id++;
+    p_stream->b_written = false;
+
+    bo_add_mem( &bo, 4, VLTS_CHUNK_FORMAT );
+    bo_add_32be( &bo, 0 );
+    bo_add_32be( &bo, p_stream->i_id );
+    vlts_format_Write( &bo, p_input->p_fmt );
+    if( bo.b == NULL )
+    {
+        free( p_stream );
+        return VLC_ENOMEM;
+    }
+    bo_swap_32be( &bo, 4, bo.b->i_buffer - VLTS_CHUNK_HEADER );
+
+    msg_Dbg( p_mux, "adding stream %u (%4.4s)", p_stream->i_id,
+             (const char *)&p_input->p_fmt->i_codec );
+
+    AddEntry( p_mux, VLTS_ENTRY_FORMAT, p_sys->i_end );
+    p_sys->i_pos += bo.b->i_buffer;
+    Queue( p_mux, bo.b );
+
+    /* Prefer a video stream for sync points */
+    if( p_input->p_fmt->i_cat == VIDEO_ES && !p_sys->b_ref_video )
+        p_sys->p_ref = NULL;
+
+    p_input->p_sys = p_stream;
+    return VLC_SUCCESS;
+}
+
+static void DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    Drain( p_mux, p_input );
+
+    if( p_sys->p_ref == p_input )
+    {
+        p_sys->p_ref = NULL;
+        p_sys->b_ref_video = false;
+    }
+
+    free( p_input->p_sys );
+    p_input->p_sys = NULL;
+}
+
+/* Returns whether the next block can be written without breaking the dts
+ * order, that is if no other stream still has to deliver an older block */
+static bool CanInterleave( sout_mux_t *p_mux, sout_input_t *p_next )
+{
+    if( FifoCount( p_next->p_fifo ) >= VLTS_INTERLEAVE_MAX )
+        return true;
+
+    for( int i = 0; i < p_mux->i_nb_inputs; i++ )
+    {
+        sout_input_t *p_input = p_mux->pp_inputs[i];
+        const vlts_stream_t *p_stream = p_input->p_sys;
+
+        if( p_input != p_next && p_stream != NULL && p_stream->b_written &&
+            p_input->p_fmt->i_cat != SPU_ES &&
+            FifoCount( p_input->p_fifo ) == 0 )
+            return false;
+    }
+    return true;
+}
+
+static int Mux( sout_mux_t *p_mux )
+{
+    for( ;; )
+    {
+        int i_stream = sout_MuxGetStream( p_mux, 1, NULL );
+        if( i_stream < 0 )
+            return VLC_SUCCESS;
+
+        sout_input_t *p_input = p_mux->pp_inputs[i_stream];
+        if( !CanInterleave( p_mux, p_input ) )
+            return VLC_SUCCESS;
+
+        block_t *p_data = block_FifoGet( p_input->p_fifo );
+        WriteBlock( p_mux, p_input, p_data );
+    }
+}
@@ -36,7 +36,6 @@
 
 /* TODO:
  *  - tune the 2 methods (block/stream)
- *  - compute cost for seek
  *  - improve stream mode seeking with closest segments
  *  - ...
  */
@@ -82,6 +81,10 @@ struct stream_sys_t
         uint64_t i_read_count;
         uint64_t i_bytes;
         uint64_t i_read_time;
+
+        /* Stat about seeking, until the first data is received */
+        uint64_t i_seek_count;
+        uint64_t i_seek_time;
     } stat;
 };
 
@@ -286,24 +289,44 @@ static int AStreamSeekBlock(stream_t *s, uint64_t i_pos)
         {
             int64_t i_skip = i_offset - sys->i_size;
 
-            /* Avg bytes per packets */
-            int i_avg = sys->stat.i_bytes / sys->stat.i_read_count;
-            /* TODO compute a seek cost instead of fixed threshold */
-            int i_th = b_aseekfast ? 1 : 5;
-
-            if (i_skip <= i_th * i_avg &&
-                i_skip < STREAM_CACHE_SIZE)
-                b_seek = false;
+            if (sys->stat.i_seek_count > 0 && sys->stat.i_bytes > 0)
+            {
+                /* Compare the time spent reading the skipped data with
+                 * the time it took to get data after previous seeks */
+                uint64_t i_seek_time = sys->stat.i_seek_time /
+                                       sys->stat.i_seek_count;
+                uint64_t i_skip_time = i_skip * sys->stat.i_read_time /
+                                       sys->stat.i_bytes;
+
+                b_seek = i_skip_time > i_seek_time ||
+                         i_skip >= STREAM_CACHE_SIZE;
+
+                msg_Dbg(s, "b_seek=%d seek=%"PRIu64"us skip=%"PRId64
+                         " (%"PRIu64"us)", b_seek, i_seek_time, i_skip,
+                         i_skip_time);
+            }
             else
-                b_seek = true;
-
-            msg_Dbg(s, "b_seek=%d th*avg=%d skip=%"PRId64,
-                     b_seek, i_th*i_avg, i_skip);
+            {
+                /* Avg bytes per packets */
+                int i_avg = sys->stat.i_bytes / sys->stat.i_read_count;
+                int i_th = b_aseekfast ? 1 : 5;
+
+                if (i_skip <= i_th * i_avg &&
+                    i_skip < STREAM_CACHE_SIZE)
+                    b_seek = false;
+                else
+                    b_seek = true;
+
+                msg_Dbg(s, "b_seek=%d th*avg=%d skip=%"PRId64,
+                         b_seek, i_th*i_avg, i_skip);
+            }
         }
     }
 
     if (b_seek)
     {
+        const mtime_t start = mdate();
+
         /* Do the access seek */
         if (vlc_stream_Seek(s->p_source, i_pos)) return VLC_EGENERIC;
 
@@ -322,6 +345,8 @@ static int AStreamSeekBlock(stream_t *s, uint64_t i_pos)
         if (AStreamRefillBlock(s))
             return VLC_EGENERIC;
 
+        sys->stat.i_seek_count++;
+        sys->stat.i_seek_time += mdate() - start;
         return VLC_SUCCESS;
     }
     else
@@ -450,6 +475,8 @@ static int Open(vlc_object_t *obj)
     sys->stat.i_bytes = 0;
     sys->stat.i_read_time = 0;
     sys->stat.i_read_count = 0;
+    sys->stat.i_seek_count = 0;
+    sys->stat.i_seek_time = 0;
 
     msg_Dbg(s, "Using block method for AStream*");
 
@@ -486,6 +513,13 @@ static void Close(vlc_object_t *obj)
     stream_t *s = (stream_t *)obj;
     stream_sys_t *sys = s->p_sys;
 
+    if (sys->stat.i_read_time > 0)
+        msg_Dbg(s, "%"PRIu64" bytes in %"PRIu64" blocks, %"PRIu64" KiB/s, "
+                "%"PRIu64" seeks (%"PRIu64" ms)", sys->stat.i_bytes,
+                sys->stat.i_read_count,
+                CLOCK_FREQ * sys->stat.i_bytes / sys->stat.i_read_time / 1024,
+                sys->stat.i_seek_count, sys->stat.i_seek_time / 1000);
+
     block_ChainRelease(sys->p_first);
     free(sys);
 }
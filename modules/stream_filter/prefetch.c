@@ -61,8 +61,41 @@ struct stream_sys_t
     char        *buffer;
     size_t       read_size;
     size_t       seek_threshold;
+
+    /* Adaptive sizing, see Adapt() */
+    bool         adaptive;
+    size_t       buffer_target;
+    size_t       read_max;
+    mtime_t      rate_date;
+    uint64_t     rate_bytes;
+    unsigned     rate_seeks;
+
+    struct
+    {
+        uint64_t hits;      /* reads served from the buffer */
+        uint64_t misses;    /* reads that had to wait for data */
+        mtime_t  wait_time;
+        uint64_t seeks;     /* seeks outside of the buffer */
+        uint64_t reads;     /* upstream reads */
+        uint64_t bytes;
+        mtime_t  read_time;
+    } stats;
 };
 
+/* Upstream reads filling the whole request faster than this are made bigger,
+ * the ones slower than the maximum are made smaller. */
+#define READ_LATENCY_MIN (CLOCK_FREQ / 50)
+#define READ_LATENCY_MAX (CLOCK_FREQ / 4)
+#define READ_SIZE_MIN 4096
+
+/* Duration of playback the buffer tries to hold */
+#define BUFFER_DURATION (8 * CLOCK_FREQ)
+#ifdef OPTIMIZE_MEMORY
+# define BUFFER_SIZE_MAX (1 << 20)
+#else
+# define BUFFER_SIZE_MAX (64 << 20)
+#endif
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -71,10 +104,30 @@ static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
     vlc_mutex_unlock(&sys->lock);
     assert(length > 0);
 
+    mtime_t start = mdate();
     ssize_t val = vlc_stream_ReadPartial(stream->p_source, buf, length);
+    mtime_t latency = mdate() - start;
 
     vlc_mutex_lock(&sys->lock);
     vlc_restorecancel(canc);
+
+    if (val > 0)
+    {
+        sys->stats.reads++;
+        sys->stats.bytes += val;
+        sys->stats.read_time += latency;
+
+        /* Only the accesses waiting for all the requested data need their
+         * read size tuned, the others return what they have. */
+        if (sys->adaptive && (size_t)val == length && length == sys->read_size)
+        {
+            if (latency > READ_LATENCY_MAX && sys->read_size > READ_SIZE_MIN)
+                sys->read_size /= 2;
+            else if (latency < READ_LATENCY_MIN
+                  && sys->read_size * 2 <= sys->read_max)
+                sys->read_size *= 2;
+        }
+    }
     return val;
 }
 
@@ -117,6 +170,48 @@ static int ThreadControl(stream_t *stream, int query, ...)
 #define MAX_READ 65536
 #define SEEK_THRESHOLD MAX_READ
 
+/* Grows the circular buffer to the target size, keeping its content */
+static void ThreadResize(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    size_t size = sys->buffer_target;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_unlock(&sys->lock);
+    char *buffer = malloc(size);
+    vlc_mutex_lock(&sys->lock);
+    vlc_restorecancel(canc);
+
+    if (buffer == NULL)
+    {   /* Stick to the current size */
+        sys->buffer_target = sys->buffer_size;
+        return;
+    }
+
+    assert(size >= sys->buffer_size);
+
+    for (size_t done = 0; done < sys->buffer_length;)
+    {
+        uint64_t pos = sys->buffer_offset + done;
+        size_t from = pos % sys->buffer_size, to = pos % size;
+        size_t len = sys->buffer_length - done;
+
+        /* Do not step past the sharp edge of either buffer */
+        if (len > sys->buffer_size - from)
+            len = sys->buffer_size - from;
+        if (len > size - to)
+            len = size - to;
+
+        memcpy(buffer + to, sys->buffer + from, len);
+        done += len;
+    }
+
+    free(sys->buffer);
+    sys->buffer = buffer;
+    sys->buffer_size = size;
+    msg_Dbg(stream, "buffer resized to %zu bytes", size);
+}
+
 static void *Thread(void *data)
 {
     stream_t *stream = data;
@@ -162,6 +257,12 @@ static void *Thread(void *data)
             continue;
         }
 
+        if (sys->buffer_target > sys->buffer_size)
+        {
+            ThreadResize(stream);
+            continue;
+        }
+
         if (sys->eof)
         {   /* Do not attempt to read at EOF - would busy loop */
             vlc_cond_wait(&sys->wait_space, &sys->lock);
@@ -264,6 +365,12 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    if (offset < sys->buffer_offset
+     || offset > sys->buffer_offset + sys->buffer_length + sys->seek_threshold)
+    {
+        sys->stats.seeks++;
+        sys->rate_seeks++;
+    }
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -287,6 +394,43 @@ static size_t BufferLevel(const stream_t *stream, bool *eof)
     return sys->buffer_offset + sys->buffer_length - sys->stream_offset;
 }
 
+/* Sizes the buffer from the rate at which the demuxer consumes data. Streams
+ * mostly accessed randomly do not benefit from a bigger buffer, as the
+ * prefetched data is thrown away on every seek. */
+static void Adapt(stream_t *stream, size_t consumed)
+{
+    stream_sys_t *sys = stream->p_sys;
+    mtime_t now = mdate();
+
+    sys->rate_bytes += consumed;
+    if (sys->rate_date == 0)
+        sys->rate_date = now;
+    if (now - sys->rate_date < CLOCK_FREQ)
+        return;
+
+    uint64_t byterate = sys->rate_bytes * CLOCK_FREQ / (now - sys->rate_date);
+    bool random = sys->rate_seeks > 1;
+
+    sys->rate_date = now;
+    sys->rate_bytes = 0;
+    sys->rate_seeks = 0;
+
+    if (random || sys->paused)
+        return;
+
+    uint64_t target = byterate * BUFFER_DURATION / CLOCK_FREQ;
+    if (target > BUFFER_SIZE_MAX)
+        target = BUFFER_SIZE_MAX;
+    if (sys->size != (uint64_t)-1 && target > sys->size)
+        target = sys->size;
+    /* Only grow by large steps to avoid reallocating over and over */
+    if (target >= 2 * sys->buffer_target)
+    {
+        sys->buffer_target = target;
+        vlc_cond_signal(&sys->wait_space);
+    }
+}
+
 static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -304,6 +448,8 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         vlc_cond_signal(&sys->wait_space);
     }
 
+    mtime_t wait_start = VLC_TS_INVALID;
+
     while ((copy = BufferLevel(stream, &eof)) == 0 && !eof)
     {
         void *data[2];
@@ -314,11 +460,22 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
             return 0;
         }
 
+        if (wait_start == VLC_TS_INVALID)
+            wait_start = mdate();
+
         vlc_interrupt_forward_start(sys->interrupt, data);
         vlc_cond_wait(&sys->wait_data, &sys->lock);
         vlc_interrupt_forward_stop(data);
     }
 
+    if (wait_start == VLC_TS_INVALID)
+        sys->stats.hits++;
+    else
+    {
+        sys->stats.misses++;
+        sys->stats.wait_time += mdate() - wait_start;
+    }
+
     offset = sys->stream_offset % sys->buffer_size;
     if (copy > buflen)
         copy = buflen;
@@ -328,6 +485,8 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 
     memcpy(buf, sys->buffer + offset, copy);
     sys->stream_offset += copy;
+    if (sys->adaptive)
+        Adapt(stream, copy);
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -452,6 +611,11 @@ static int Open(vlc_object_t *obj)
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->read_size = var_InheritInteger(obj, "prefetch-read-size");
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->adaptive = var_InheritBool(obj, "prefetch-adaptive");
+    sys->rate_date = 0;
+    sys->rate_bytes = 0;
+    sys->rate_seeks = 0;
+    memset(&sys->stats, 0, sizeof (sys->stats));
 
     uint64_t size = stream_Size(stream->p_source);
     if (size > 0)
@@ -463,6 +627,10 @@ static int Open(vlc_object_t *obj)
     }
     if (sys->buffer_size < sys->read_size)
         sys->buffer_size = sys->read_size;
+    sys->buffer_target = sys->buffer_size;
+    sys->read_max = sys->read_size;
+    if (sys->adaptive && sys->read_size > MAX_READ)
+        sys->read_size = MAX_READ; /* grown by ThreadRead() */
 
     sys->buffer = malloc(sys->buffer_size);
     if (sys->buffer == NULL)
@@ -514,6 +682,16 @@ static void Close (vlc_object_t *obj)
     vlc_interrupt_kill(sys->interrupt);
     vlc_join(sys->thread, NULL);
     vlc_interrupt_destroy(sys->interrupt);
+
+    msg_Dbg(stream, "%"PRIu64" hits, %"PRIu64" misses (%"PRId64" ms waited), "
+            "%"PRIu64" seeks", sys->stats.hits, sys->stats.misses,
+            sys->stats.wait_time / 1000, sys->stats.seeks);
+    if (sys->stats.reads > 0)
+        msg_Dbg(stream, "%"PRIu64" bytes in %"PRIu64" reads, "
+                "%"PRId64" us average latency, %zu bytes read size",
+                sys->stats.bytes, sys->stats.reads,
+                sys->stats.read_time / (mtime_t)sys->stats.reads,
+                sys->read_size);
     vlc_cond_destroy(&sys->wait_space);
     vlc_cond_destroy(&sys->wait_data);
     vlc_mutex_destroy(&sys->lock);
@@ -540,4 +718,7 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_bool("prefetch-adaptive", true, N_("Adaptive buffering"),
+             N_("Tune the read size from the upstream latency and grow the "
+                "buffer with the stream bitrate."), true)
 vlc_module_end()
@@ -225,6 +225,7 @@ static const char *getMuxFromAlias( const char *psz_alias )
         { "ps",  "ps" },
         { "mpeg1","mpeg1" },
         { "wav", "wav" },
+        { "vlts", "vlts" },
         { "flv", "avformat{mux=flv}" },
         { "mkv", "avformat{mux=matroska}"},
         { "webm", "avformat{mux=webm}"},
@@ -272,6 +272,15 @@ int transcode_audio_process( sout_stream_t *p_stream,
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     *out = NULL;
 
+    /* the payload may be shared with other duplicated outputs, and
+     * decoders may modify it in place */
+    if( in != NULL )
+    {
+        in = block_Unshare( in );
+        if( in == NULL )
+            return VLC_ENOMEM;
+    }
+
     int ret = id->p_decoder->pf_decode( id->p_decoder, in );
     if( ret != VLCDEC_SUCCESS )
         return VLC_EGENERIC;
@@ -145,6 +145,15 @@ int transcode_spu_process( sout_stream_t *p_stream,
     *out = NULL;
     bool b_error = false;
 
+    /* the payload may be shared with other duplicated outputs, and
+     * decoders may modify it in place */
+    if( in != NULL )
+    {
+        in = block_Unshare( in );
+        if( in == NULL )
+            return VLC_ENOMEM;
+    }
+
     int ret = id->p_decoder->pf_decode( id->p_decoder, in );
     if( ret != VLCDEC_SUCCESS )
         return VLC_EGENERIC;
@@ -1365,6 +1365,10 @@ static int Create( vlc_object_t *p_this )
     vlc_dictionary_init( &p_sys->family_map, 50 );
     vlc_dictionary_init( &p_sys->fallback_map, 20 );
 
+    /* Loaded glyphs cache, rendering still works without it */
+    p_sys->p_glyph_cache = calloc( FREETYPE_GLYPH_CACHE_SIZE,
+                                   sizeof( *p_sys->p_glyph_cache ) );
+
     p_sys->i_scale = 100;
 
     /* default style to apply to uncomplete segmeents styles */
@@ -1489,6 +1493,10 @@ static void Destroy( vlc_object_t *p_this )
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
 
+    /* Glyphs must be released before their faces */
+    ClearGlyphCache( p_sys );
+    free( p_sys->p_glyph_cache );
+
     /* Fonts dicts */
     vlc_dictionary_clear( &p_sys->fallback_map, FreeFamilies, p_filter );
     vlc_dictionary_clear( &p_sys->face_map, FreeFace, p_filter );
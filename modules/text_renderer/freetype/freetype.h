@@ -66,6 +66,24 @@ typedef uint32_t uni_char_t;
 # endif
 #endif
 
+/* Size of the loaded glyphs cache (power of 2) */
+#define FREETYPE_GLYPH_CACHE_SIZE 1024
+
+/**
+ * Loaded glyph, with synthetic styles and stroking applied.
+ * Entries are direct mapped from the (face, glyph index, style) key.
+ */
+typedef struct
+{
+    FT_Face        p_face;          /* sized face the glyph belongs to */
+    FT_UInt        i_index;         /* glyph index within the face */
+    uint16_t       i_style_flags;   /* STYLE_BOLD/ITALIC/OUTLINE applied */
+    FT_Fixed       i_radius;        /* stroker radius for the outline */
+    FT_Glyph       p_glyph;
+    FT_Glyph       p_outline;
+    FT_Vector      advance;
+} glyph_cache_entry_t;
+
 /*****************************************************************************
  * filter_sys_t: freetype local data
  *****************************************************************************
@@ -111,6 +129,9 @@ struct filter_sys_t
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /** Loaded glyphs cache, see \ref glyph_cache_entry_t */
+    glyph_cache_entry_t *p_glyph_cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
@@ -190,6 +190,38 @@ void FreeLines( line_desc_t *p_lines )
     }
 }
 
+void ClearGlyphCache( filter_sys_t *p_sys )
+{
+    if( !p_sys->p_glyph_cache )
+        return;
+
+    for( int i = 0; i < FREETYPE_GLYPH_CACHE_SIZE; ++i )
+    {
+        glyph_cache_entry_t *p_entry = p_sys->p_glyph_cache + i;
+        if( p_entry->p_glyph )
+            FT_Done_Glyph( p_entry->p_glyph );
+        if( p_entry->p_outline )
+            FT_Done_Glyph( p_entry->p_outline );
+        memset( p_entry, 0, sizeof( *p_entry ) );
+    }
+}
+
+static glyph_cache_entry_t *GetGlyphCacheEntry( filter_sys_t *p_sys,
+                                                FT_Face p_face, FT_UInt i_index,
+                                                uint16_t i_style_flags,
+                                                FT_Fixed i_radius )
+{
+    if( !p_sys->p_glyph_cache )
+        return NULL;
+
+    uint32_t i_hash = (uint32_t)( (uintptr_t)p_face >> 4 ) * 2654435761u;
+    i_hash ^= i_index * 40503u;
+    i_hash ^= ( i_style_flags << 16 ) ^ (uint32_t)i_radius;
+    i_hash ^= i_hash >> 15;
+
+    return p_sys->p_glyph_cache + ( i_hash & ( FREETYPE_GLYPH_CACHE_SIZE - 1 ) );
+}
+
 line_desc_t *NewLine( int i_count )
 {
     line_desc_t *p_line = malloc( sizeof(*p_line) );
@@ -973,18 +1005,23 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_radius = 0;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        /* Only the styles altering the glyph shapes are part of the key */
+        const uint16_t i_cache_flags = p_style->i_style_flags &
+                                       ( STYLE_BOLD | STYLE_ITALIC | STYLE_OUTLINE );
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1035,39 +1072,89 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            glyph_cache_entry_t *p_cached =
+                GetGlyphCacheEntry( p_sys, p_face, i_glyph_index,
+                                    i_cache_flags, i_radius );
+            FT_Vector advance;
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+            if( p_cached && p_cached->p_glyph
+             && p_cached->p_face == p_face
+             && p_cached->i_index == (FT_UInt) i_glyph_index
+             && p_cached->i_style_flags == i_cache_flags
+             && p_cached->i_radius == i_radius )
+            {
+                /* Hinting and stroking already done, only copy the outlines */
+                if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+                p_bitmaps->p_outline = 0;
+                if( p_cached->p_outline
+                 && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+                    p_bitmaps->p_outline = 0;
+                advance = p_cached->advance;
+            }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                if( ( p_style->i_style_flags & STYLE_BOLD )
+                      && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( ( p_style->i_style_flags & STYLE_ITALIC )
+                      && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-#undef SKIP_GLYPH
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_filter->p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                p_bitmaps->p_outline = 0;
+                if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_filter->p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
+
+                advance = p_face->glyph->advance;
+
+                if( p_cached )
+                {
+                    if( p_cached->p_glyph )
+                        FT_Done_Glyph( p_cached->p_glyph );
+                    if( p_cached->p_outline )
+                        FT_Done_Glyph( p_cached->p_outline );
+                    p_cached->p_outline = 0;
+
+                    if( FT_Glyph_Copy( p_bitmaps->p_glyph, &p_cached->p_glyph ) )
+                        p_cached->p_glyph = 0;
+                    else if( p_bitmaps->p_outline
+                          && FT_Glyph_Copy( p_bitmaps->p_outline, &p_cached->p_outline ) )
+                    {
+                        FT_Done_Glyph( p_cached->p_glyph );
+                        p_cached->p_glyph = 0;
+                    }
+                    p_cached->p_face = p_face;
+                    p_cached->i_index = i_glyph_index;
+                    p_cached->i_style_flags = i_cache_flags;
+                    p_cached->i_radius = i_radius;
+                    p_cached->advance = advance;
+                }
             }
 
+#undef SKIP_GLYPH
+
+            p_bitmaps->p_shadow = 0;
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
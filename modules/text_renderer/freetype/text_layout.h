@@ -61,6 +61,11 @@ struct line_desc_t
 };
 
 void FreeLines( line_desc_t *p_lines );
+
+/**
+ * Release all the glyphs held by the loaded glyphs cache.
+ */
+void ClearGlyphCache( filter_sys_t *p_sys );
 line_desc_t *NewLine( int i_count );
 
 /**
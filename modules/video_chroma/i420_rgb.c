@@ -39,7 +39,15 @@
 #include <vlc_cpu.h>
 
 #include "i420_rgb.h"
-#ifdef PLAIN
+#if defined (AVX2)
+static picture_t *I420_RGB32_AVX2_Filter( filter_t *, picture_t * );
+static picture_t *NV12_RGB32_AVX2_Filter( filter_t *, picture_t * );
+static picture_t *I42010L_RGB32_AVX2_Filter( filter_t *, picture_t * );
+static picture_t *P010_RGB32_AVX2_Filter( filter_t *, picture_t * );
+
+static int  SetShifts( filter_t * );
+static void SetMatrix( filter_t * );
+#elif defined (PLAIN)
 # include "i420_rgb_c.h"
 static picture_t *I420_RGB8_Filter( filter_t *, picture_t * );
 static picture_t *I420_RGB16_Filter( filter_t *, picture_t * );
@@ -75,7 +83,13 @@ static int  Activate   ( vlc_object_t * );
 static void Deactivate ( vlc_object_t * );
 
 vlc_module_begin ()
-#if defined (SSE2)
+#if defined (AVX2)
+    set_description( N_( "AVX2 I420,YV12,NV12,NV21,I420_10L,P010 to "
+                        "RV32,RGBA,BGRA,ARGB conversions") )
+    /* Above swscale, but only for unscaled conversions */
+    set_capability( "video converter", 160 )
+# define vlc_CPU_capable() vlc_CPU_AVX2()
+#elif defined (SSE2)
     set_description( N_( "SSE2 I420,IYUV,YV12 to "
                         "RV15,RV16,RV24,RV32 conversions") )
     set_capability( "video converter", 120 )
@@ -119,6 +133,56 @@ static int Activate( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+#ifdef AVX2
+    /* Scaling is left to the other converters. The input offsets must not
+     * split the chroma samples. */
+    if( p_filter->fmt_in.video.i_visible_width
+     != p_filter->fmt_out.video.i_visible_width
+     || p_filter->fmt_in.video.i_visible_height
+     != p_filter->fmt_out.video.i_visible_height
+     || (p_filter->fmt_in.video.i_x_offset & 1)
+     || (p_filter->fmt_in.video.i_y_offset & 1) )
+    {
+        return VLC_EGENERIC;
+    }
+
+    switch( p_filter->fmt_in.video.i_chroma )
+    {
+        case VLC_CODEC_YV12:
+        case VLC_CODEC_I420:
+        case VLC_CODEC_J420:
+            p_filter->pf_video_filter = I420_RGB32_AVX2_Filter;
+            break;
+        case VLC_CODEC_NV12:
+        case VLC_CODEC_NV21:
+            p_filter->pf_video_filter = NV12_RGB32_AVX2_Filter;
+            break;
+        case VLC_CODEC_I420_10L:
+            p_filter->pf_video_filter = I42010L_RGB32_AVX2_Filter;
+            break;
+        case VLC_CODEC_P010:
+            p_filter->pf_video_filter = P010_RGB32_AVX2_Filter;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    p_filter->p_sys = malloc( sizeof( filter_sys_t ) );
+    if( p_filter->p_sys == NULL )
+        return VLC_ENOMEM;
+    p_filter->p_sys->p_buffer = NULL;
+    p_filter->p_sys->p_offset = NULL;
+
+    if( SetShifts( p_filter ) )
+    {
+        free( p_filter->p_sys );
+        return VLC_EGENERIC;
+    }
+    SetMatrix( p_filter );
+
+    return VLC_SUCCESS;
+#else
+
     switch( p_filter->fmt_in.video.i_chroma )
     {
         case VLC_CODEC_YV12:
@@ -277,6 +341,7 @@ static int Activate( vlc_object_t *p_this )
 #endif
 
     return 0;
+#endif
 }
 
 /*****************************************************************************
@@ -296,7 +361,118 @@ static void Deactivate( vlc_object_t *p_this )
     free( p_filter->p_sys );
 }
 
-#ifndef PLAIN
+#if defined (AVX2)
+VIDEO_FILTER_WRAPPER( I420_RGB32_AVX2 )
+VIDEO_FILTER_WRAPPER( NV12_RGB32_AVX2 )
+VIDEO_FILTER_WRAPPER( I42010L_RGB32_AVX2 )
+VIDEO_FILTER_WRAPPER( P010_RGB32_AVX2 )
+
+/*****************************************************************************
+ * SetShifts: find the position of the components in an output pixel
+ *****************************************************************************/
+static int SetShifts( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    uint32_t i_rmask, i_gmask, i_bmask;
+
+    /* Pixels are handled as native 32 bits words, x86 is little endian */
+    switch( p_filter->fmt_out.video.i_chroma )
+    {
+        case VLC_CODEC_RGB32:
+            i_rmask = p_filter->fmt_out.video.i_rmask;
+            i_gmask = p_filter->fmt_out.video.i_gmask;
+            i_bmask = p_filter->fmt_out.video.i_bmask;
+            break;
+        case VLC_CODEC_RGBA:
+            i_rmask = 0x000000ff; i_gmask = 0x0000ff00; i_bmask = 0x00ff0000;
+            break;
+        case VLC_CODEC_BGRA:
+            i_rmask = 0x00ff0000; i_gmask = 0x0000ff00; i_bmask = 0x000000ff;
+            break;
+        case VLC_CODEC_ARGB:
+            i_rmask = 0x0000ff00; i_gmask = 0x00ff0000; i_bmask = 0xff000000;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    /* Only byte aligned 8 bits components are supported */
+    const uint32_t i_amask = ~(i_rmask | i_gmask | i_bmask);
+    const uint32_t pi_mask[4] = { i_rmask, i_gmask, i_bmask, i_amask };
+    uint8_t pi_shift[4];
+    for( int i = 0; i < 4; i++ )
+    {
+        if( pi_mask[i] == 0 || (pi_mask[i] >> ctz( pi_mask[i] )) != 0xff
+         || ctz( pi_mask[i] ) % 8 )
+            return VLC_EGENERIC;
+        pi_shift[i] = ctz( pi_mask[i] );
+    }
+
+    p_sys->i_red_shift   = pi_shift[0];
+    p_sys->i_green_shift = pi_shift[1];
+    p_sys->i_blue_shift  = pi_shift[2];
+    p_sys->i_alpha_shift = pi_shift[3];
+    msg_Dbg( p_filter, "RGB pixel format has R,G,B,A at bits %u,%u,%u,%u",
+             pi_shift[0], pi_shift[1], pi_shift[2], pi_shift[3] );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * SetMatrix: compute the fixed point YCbCr to RGB coefficients
+ *****************************************************************************
+ * Samples are first brought to a common 14 bits scale whatever their depth,
+ * the coefficients are then applied in Q13 and the result has 3 fractional
+ * bits.
+ *****************************************************************************/
+static void SetMatrix( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmt = &p_filter->fmt_in.video;
+    double f_kr, f_kb;
+
+    switch( p_fmt->space )
+    {
+        case COLOR_SPACE_BT2020:
+            f_kr = 0.2627; f_kb = 0.0593;
+            break;
+        case COLOR_SPACE_BT709:
+            f_kr = 0.2126; f_kb = 0.0722;
+            break;
+        case COLOR_SPACE_BT601:
+            f_kr = 0.299;  f_kb = 0.114;
+            break;
+        default:
+            /* Same guess as video_format_AdjustColorSpace() */
+            if( p_fmt->i_visible_height > 576 )
+            {
+                f_kr = 0.2126; f_kb = 0.0722;
+            }
+            else
+            {
+                f_kr = 0.299;  f_kb = 0.114;
+            }
+            break;
+    }
+    const double f_kg = 1. - f_kr - f_kb;
+
+    const bool b_full = p_fmt->b_color_range_full
+                     || p_fmt->i_chroma == VLC_CODEC_J420;
+    const double f_y_scale  = b_full ? 1. : 255. / 219.;
+    const double f_uv_scale = b_full ? 1. : 255. / 224.;
+
+#define Q13( x ) ((int16_t)lround( (x) * (1 << 13) ))
+    p_sys->i_y_offset     = b_full ? 0 : 16 << 6;
+    p_sys->i_y_coef       = Q13( f_y_scale );
+    p_sys->i_v_red_coef   = Q13( 2. * (1. - f_kr) * f_uv_scale );
+    p_sys->i_u_green_coef = Q13( -2. * f_kb * (1. - f_kb) / f_kg * f_uv_scale );
+    p_sys->i_v_green_coef = Q13( -2. * f_kr * (1. - f_kr) / f_kg * f_uv_scale );
+    p_sys->i_u_blue_coef  = Q13( 2. * (1. - f_kb) * f_uv_scale );
+#undef Q13
+
+    p_sys->b_swap_uv = p_fmt->i_chroma == VLC_CODEC_YV12
+                    || p_fmt->i_chroma == VLC_CODEC_NV21;
+}
+#elif !defined (PLAIN)
 VIDEO_FILTER_WRAPPER( I420_R5G5B5 )
 VIDEO_FILTER_WRAPPER( I420_R5G6B5 )
 VIDEO_FILTER_WRAPPER( I420_A8R8G8B8 )
@@ -21,7 +21,7 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
-#if !defined (SSE2) && !defined (MMX)
+#if !defined (SSE2) && !defined (MMX) && !defined (AVX2)
 # define PLAIN
 #endif
 
@@ -54,12 +54,31 @@ struct filter_sys_t
     uint16_t  p_rgb_g[CMAP_RGB2_SIZE];  /**< Green values of palette */
     uint16_t  p_rgb_b[CMAP_RGB2_SIZE];  /**< Blue values of palette */
 #endif
+#ifdef AVX2
+    /**< Conversion parameters, see SetMatrix() */
+    int16_t   i_y_offset;              /**< black level, 14 bits scale */
+    int16_t   i_y_coef;                /**< luma gain, Q13 */
+    int16_t   i_v_red_coef;            /**< chroma coefficients, Q13 */
+    int16_t   i_u_green_coef;
+    int16_t   i_v_green_coef;
+    int16_t   i_u_blue_coef;
+    uint8_t   i_red_shift;             /**< bit position of each component */
+    uint8_t   i_green_shift;           /**< in an output pixel */
+    uint8_t   i_blue_shift;
+    uint8_t   i_alpha_shift;
+    bool      b_swap_uv;               /**< YV12 or NV21 input */
+#endif
 };
 
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
-#ifdef PLAIN
+#if defined (AVX2)
+void I420_RGB32_AVX2   ( filter_t *, picture_t *, picture_t * );
+void NV12_RGB32_AVX2   ( filter_t *, picture_t *, picture_t * );
+void I42010L_RGB32_AVX2( filter_t *, picture_t *, picture_t * );
+void P010_RGB32_AVX2   ( filter_t *, picture_t *, picture_t * );
+#elif defined (PLAIN)
 void I420_RGB8         ( filter_t *, picture_t *, picture_t * );
 void I420_RGB16        ( filter_t *, picture_t *, picture_t * );
 void I420_RGB32        ( filter_t *, picture_t *, picture_t * );
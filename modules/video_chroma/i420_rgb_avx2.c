@@ -0,0 +1,339 @@
+/*****************************************************************************
+ * i420_rgb_avx2.c : AVX2 YUV to 32 bits RGB conversion functions for vlc
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <immintrin.h>
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#include "i420_rgb.h"
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+/*****************************************************************************
+ * Conversion arithmetic
+ *****************************************************************************
+ * All the samples are scaled to 14 bits (8 bits << 6, 10 bits << 4) so that
+ * every input depth shares the same coefficients. The vector and the scalar
+ * versions compute exactly the same values.
+ *****************************************************************************/
+#define UV_OFFSET (1 << 13)
+
+static inline uint32_t ConvertPixel( const filter_sys_t *p_sys,
+                                     int i_y, int i_u, int i_v )
+{
+    const int y = ((i_y - p_sys->i_y_offset) * p_sys->i_y_coef) >> 16;
+    const int u = i_u - UV_OFFSET;
+    const int v = i_v - UV_OFFSET;
+
+    int r = y + ((v * p_sys->i_v_red_coef) >> 16);
+    int g = y + ((u * p_sys->i_u_green_coef) >> 16)
+              + ((v * p_sys->i_v_green_coef) >> 16);
+    int b = y + ((u * p_sys->i_u_blue_coef) >> 16);
+
+    r = VLC_CLIP( (r + 4) >> 3, 0, 255 );
+    g = VLC_CLIP( (g + 4) >> 3, 0, 255 );
+    b = VLC_CLIP( (b + 4) >> 3, 0, 255 );
+
+    return ((uint32_t)r << p_sys->i_red_shift)
+         | ((uint32_t)g << p_sys->i_green_shift)
+         | ((uint32_t)b << p_sys->i_blue_shift)
+         | (UINT32_C(0xff) << p_sys->i_alpha_shift);
+}
+
+typedef struct
+{
+    __m256i y_offset, y_coef, uv_offset;
+    __m256i v_red, u_green, v_green, u_blue;
+    __m256i round, zero, max, alpha;
+    __m128i red_shift, green_shift, blue_shift;
+} matrix_avx2_t;
+
+VLC_TARGET
+static inline void LoadMatrix( matrix_avx2_t *m, const filter_sys_t *p_sys )
+{
+    m->y_offset    = _mm256_set1_epi16( p_sys->i_y_offset );
+    m->y_coef      = _mm256_set1_epi16( p_sys->i_y_coef );
+    m->uv_offset   = _mm256_set1_epi16( UV_OFFSET );
+    m->v_red       = _mm256_set1_epi16( p_sys->i_v_red_coef );
+    m->u_green     = _mm256_set1_epi16( p_sys->i_u_green_coef );
+    m->v_green     = _mm256_set1_epi16( p_sys->i_v_green_coef );
+    m->u_blue      = _mm256_set1_epi16( p_sys->i_u_blue_coef );
+    m->round       = _mm256_set1_epi16( 4 );
+    m->zero        = _mm256_setzero_si256();
+    m->max         = _mm256_set1_epi16( 255 );
+    m->alpha       = _mm256_set1_epi32( (int32_t)(UINT32_C(0xff)
+                                                  << p_sys->i_alpha_shift) );
+    m->red_shift   = _mm_cvtsi32_si128( p_sys->i_red_shift );
+    m->green_shift = _mm_cvtsi32_si128( p_sys->i_green_shift );
+    m->blue_shift  = _mm_cvtsi32_si128( p_sys->i_blue_shift );
+}
+
+VLC_TARGET
+static inline __m256i Clip( const matrix_avx2_t *m, __m256i x )
+{
+    x = _mm256_srai_epi16( _mm256_add_epi16( x, m->round ), 3 );
+    return _mm256_min_epi16( _mm256_max_epi16( x, m->zero ), m->max );
+}
+
+VLC_TARGET
+static inline __m256i Pack( const matrix_avx2_t *m,
+                            __m128i r, __m128i g, __m128i b )
+{
+    __m256i px = _mm256_sll_epi32( _mm256_cvtepu16_epi32( r ), m->red_shift );
+    px = _mm256_or_si256( px, _mm256_sll_epi32( _mm256_cvtepu16_epi32( g ),
+                                                m->green_shift ) );
+    px = _mm256_or_si256( px, _mm256_sll_epi32( _mm256_cvtepu16_epi32( b ),
+                                                m->blue_shift ) );
+    return _mm256_or_si256( px, m->alpha );
+}
+
+/* Converts 16 pixels, from 16 Y and 16 (upsampled) U and V on 14 bits */
+VLC_TARGET
+static inline void Convert16( const matrix_avx2_t *m, uint32_t *p_dst,
+                              __m256i y, __m256i u, __m256i v )
+{
+    y = _mm256_mulhi_epi16( _mm256_sub_epi16( y, m->y_offset ), m->y_coef );
+    u = _mm256_sub_epi16( u, m->uv_offset );
+    v = _mm256_sub_epi16( v, m->uv_offset );
+
+    __m256i r = _mm256_add_epi16( y, _mm256_mulhi_epi16( v, m->v_red ) );
+    __m256i g = _mm256_add_epi16( y,
+                    _mm256_add_epi16( _mm256_mulhi_epi16( u, m->u_green ),
+                                      _mm256_mulhi_epi16( v, m->v_green ) ) );
+    __m256i b = _mm256_add_epi16( y, _mm256_mulhi_epi16( u, m->u_blue ) );
+
+    r = Clip( m, r );
+    g = Clip( m, g );
+    b = Clip( m, b );
+
+    _mm256_storeu_si256( (__m256i *)p_dst,
+                         Pack( m, _mm256_castsi256_si128( r ),
+                                  _mm256_castsi256_si128( g ),
+                                  _mm256_castsi256_si128( b ) ) );
+    _mm256_storeu_si256( (__m256i *)(p_dst + 8),
+                         Pack( m, _mm256_extracti128_si256( r, 1 ),
+                                  _mm256_extracti128_si256( g, 1 ),
+                                  _mm256_extracti128_si256( b, 1 ) ) );
+}
+
+/* Duplicates each of 8 16 bits samples */
+VLC_TARGET
+static inline __m256i Upsample16( __m128i x )
+{
+    return _mm256_inserti128_si256(
+                _mm256_castsi128_si256( _mm_unpacklo_epi16( x, x ) ),
+                _mm_unpackhi_epi16( x, x ), 1 );
+}
+
+/*****************************************************************************
+ * Geometry helpers
+ *****************************************************************************
+ * Only the visible area is converted, from the input offsets to the output
+ * ones, scaling is not supported. The input offsets are even.
+ *****************************************************************************/
+#define WIDTH(p_filter)  ((p_filter)->fmt_in.video.i_visible_width)
+#define HEIGHT(p_filter) ((p_filter)->fmt_in.video.i_visible_height)
+
+#define LINE(p_pic, plane, y) \
+    ((p_pic)->p[plane].p_pixels + (size_t)(y) * (p_pic)->p[plane].i_pitch)
+
+/* First line of the visible area of the input, and output pixel */
+#define SRC_Y(p_filter, y) ((p_filter)->fmt_in.video.i_y_offset + (y))
+#define SRC_X(p_filter)    ((p_filter)->fmt_in.video.i_x_offset)
+#define DST_PIXEL(p_filter, p_pic, y) \
+    ((uint32_t *)LINE( p_pic, 0, (p_filter)->fmt_out.video.i_y_offset + (y) ) \
+     + (p_filter)->fmt_out.video.i_x_offset)
+
+/*****************************************************************************
+ * I420_RGB32_AVX2: 8 bits planar 4:2:0 (I420, J420, YV12)
+ *****************************************************************************/
+VLC_TARGET
+void I420_RGB32_AVX2( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_width = WIDTH(p_filter), i_height = HEIGHT(p_filter);
+    const unsigned i_x = SRC_X(p_filter);
+    const int i_u = p_sys->b_swap_uv ? V_PLANE : U_PLANE;
+    const int i_v = p_sys->b_swap_uv ? U_PLANE : V_PLANE;
+    matrix_avx2_t m;
+
+    LoadMatrix( &m, p_sys );
+
+    for( unsigned i_line = 0; i_line < i_height; i_line++ )
+    {
+        const unsigned i_src = SRC_Y( p_filter, i_line );
+        const uint8_t *p_y = LINE( p_src, Y_PLANE, i_src ) + i_x;
+        const uint8_t *p_u = LINE( p_src, i_u, i_src / 2 ) + i_x / 2;
+        const uint8_t *p_v = LINE( p_src, i_v, i_src / 2 ) + i_x / 2;
+        uint32_t *p_dst = DST_PIXEL( p_filter, p_dest, i_line );
+        unsigned x = 0;
+
+        for( ; x + 16 <= i_width; x += 16 )
+        {
+            __m128i u = _mm_loadl_epi64( (const __m128i *)&p_u[x / 2] );
+            __m128i v = _mm_loadl_epi64( (const __m128i *)&p_v[x / 2] );
+            __m256i y = _mm256_cvtepu8_epi16(
+                            _mm_loadu_si128( (const __m128i *)&p_y[x] ) );
+
+            Convert16( &m, &p_dst[x], _mm256_slli_epi16( y, 6 ),
+                _mm256_slli_epi16( _mm256_cvtepu8_epi16( _mm_unpacklo_epi8( u, u ) ), 6 ),
+                _mm256_slli_epi16( _mm256_cvtepu8_epi16( _mm_unpacklo_epi8( v, v ) ), 6 ) );
+        }
+        for( ; x < i_width; x++ )
+            p_dst[x] = ConvertPixel( p_sys, p_y[x] << 6,
+                                     p_u[x / 2] << 6, p_v[x / 2] << 6 );
+    }
+}
+
+/*****************************************************************************
+ * NV12_RGB32_AVX2: 8 bits semi-planar 4:2:0 (NV12, NV21)
+ *****************************************************************************/
+VLC_TARGET
+void NV12_RGB32_AVX2( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_width = WIDTH(p_filter), i_height = HEIGHT(p_filter);
+    const unsigned i_x = SRC_X(p_filter);
+    const unsigned i_u = p_sys->b_swap_uv ? 1 : 0;
+    matrix_avx2_t m;
+
+    LoadMatrix( &m, p_sys );
+
+    for( unsigned i_line = 0; i_line < i_height; i_line++ )
+    {
+        const unsigned i_src = SRC_Y( p_filter, i_line );
+        const uint8_t *p_y  = LINE( p_src, Y_PLANE, i_src ) + i_x;
+        const uint8_t *p_uv = LINE( p_src, 1, i_src / 2 ) + i_x;
+        uint32_t *p_dst = DST_PIXEL( p_filter, p_dest, i_line );
+        unsigned x = 0;
+
+        for( ; x + 16 <= i_width; x += 16 )
+        {
+            __m256i uv = _mm256_slli_epi16( _mm256_cvtepu8_epi16(
+                            _mm_loadu_si128( (const __m128i *)&p_uv[x] ) ), 6 );
+            __m256i y = _mm256_slli_epi16( _mm256_cvtepu8_epi16(
+                            _mm_loadu_si128( (const __m128i *)&p_y[x] ) ), 6 );
+            /* u0 v0 u1 v1 -> u0 u0 u1 u1 and v0 v0 v1 v1 */
+            __m256i u = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( uv,
+                            _MM_SHUFFLE(2,2,0,0) ), _MM_SHUFFLE(2,2,0,0) );
+            __m256i v = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( uv,
+                            _MM_SHUFFLE(3,3,1,1) ), _MM_SHUFFLE(3,3,1,1) );
+
+            if( i_u )
+                Convert16( &m, &p_dst[x], y, v, u );
+            else
+                Convert16( &m, &p_dst[x], y, u, v );
+        }
+        for( ; x < i_width; x++ )
+        {
+            const uint8_t *p_c = &p_uv[x & ~1u];
+            p_dst[x] = ConvertPixel( p_sys, p_y[x] << 6,
+                                     p_c[i_u] << 6, p_c[1 - i_u] << 6 );
+        }
+    }
+}
+
+/*****************************************************************************
+ * I42010L_RGB32_AVX2: 10 bits planar 4:2:0, LSB aligned
+ *****************************************************************************/
+VLC_TARGET
+void I42010L_RGB32_AVX2( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_width = WIDTH(p_filter), i_height = HEIGHT(p_filter);
+    const unsigned i_x = SRC_X(p_filter);
+    matrix_avx2_t m;
+
+    LoadMatrix( &m, p_sys );
+
+    for( unsigned i_line = 0; i_line < i_height; i_line++ )
+    {
+        const unsigned i_src = SRC_Y( p_filter, i_line );
+        const uint16_t *p_y = (const uint16_t *)LINE( p_src, Y_PLANE, i_src ) + i_x;
+        const uint16_t *p_u = (const uint16_t *)LINE( p_src, U_PLANE, i_src / 2 ) + i_x / 2;
+        const uint16_t *p_v = (const uint16_t *)LINE( p_src, V_PLANE, i_src / 2 ) + i_x / 2;
+        uint32_t *p_dst = DST_PIXEL( p_filter, p_dest, i_line );
+        unsigned x = 0;
+
+        for( ; x + 16 <= i_width; x += 16 )
+        {
+            __m256i y = _mm256_loadu_si256( (const __m256i *)&p_y[x] );
+            __m128i u = _mm_loadu_si128( (const __m128i *)&p_u[x / 2] );
+            __m128i v = _mm_loadu_si128( (const __m128i *)&p_v[x / 2] );
+
+            Convert16( &m, &p_dst[x], _mm256_slli_epi16( y, 4 ),
+                       _mm256_slli_epi16( Upsample16( u ), 4 ),
+                       _mm256_slli_epi16( Upsample16( v ), 4 ) );
+        }
+        for( ; x < i_width; x++ )
+            p_dst[x] = ConvertPixel( p_sys, p_y[x] << 4,
+                                     p_u[x / 2] << 4, p_v[x / 2] << 4 );
+    }
+}
+
+/*****************************************************************************
+ * P010_RGB32_AVX2: 10 bits semi-planar 4:2:0, MSB aligned
+ *****************************************************************************/
+VLC_TARGET
+void P010_RGB32_AVX2( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_width = WIDTH(p_filter), i_height = HEIGHT(p_filter);
+    const unsigned i_x = SRC_X(p_filter);
+    matrix_avx2_t m;
+
+    LoadMatrix( &m, p_sys );
+
+    for( unsigned i_line = 0; i_line < i_height; i_line++ )
+    {
+        const unsigned i_src = SRC_Y( p_filter, i_line );
+        const uint16_t *p_y  = (const uint16_t *)LINE( p_src, Y_PLANE, i_src ) + i_x;
+        const uint16_t *p_uv = (const uint16_t *)LINE( p_src, 1, i_src / 2 ) + i_x;
+        uint32_t *p_dst = DST_PIXEL( p_filter, p_dest, i_line );
+        unsigned x = 0;
+
+        for( ; x + 16 <= i_width; x += 16 )
+        {
+            __m256i y  = _mm256_srli_epi16(
+                            _mm256_loadu_si256( (const __m256i *)&p_y[x] ), 2 );
+            __m256i uv = _mm256_srli_epi16(
+                            _mm256_loadu_si256( (const __m256i *)&p_uv[x] ), 2 );
+            __m256i u = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( uv,
+                            _MM_SHUFFLE(2,2,0,0) ), _MM_SHUFFLE(2,2,0,0) );
+            __m256i v = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( uv,
+                            _MM_SHUFFLE(3,3,1,1) ), _MM_SHUFFLE(3,3,1,1) );
+
+            Convert16( &m, &p_dst[x], y, u, v );
+        }
+        for( ; x < i_width; x++ )
+        {
+            const uint16_t *p_c = &p_uv[x & ~1u];
+            p_dst[x] = ConvertPixel( p_sys, p_y[x] >> 2,
+                                     p_c[0] >> 2, p_c[1] >> 2 );
+        }
+    }
+}
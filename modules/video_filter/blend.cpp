@@ -32,17 +32,32 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(__GNUC__) || defined(__clang__)
+# if defined(CAN_COMPILE_SSE4_1) || defined(CAN_COMPILE_AVX2)
+#  include <immintrin.h>
+# endif
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SIMD_TEXT N_("Use SIMD blending")
+#define SIMD_LONGTEXT N_("Use the vectorized blending routines for the " \
+    "most common overlay formats when the CPU supports them.")
+
 vlc_module_begin()
     set_description(N_("Video pictures blending"))
     set_capability("video blending", 100)
+    add_bool("blend-simd", true, SIMD_TEXT, SIMD_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end()
 
@@ -551,6 +566,223 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+/*****************************************************************************
+ * SIMD blending
+ *****************************************************************************
+ * The most used overlays (YUVA and RGBA subpictures) are blended one row
+ * at a time by vectorized routines. They give the same results as the
+ * templated C code above, which stays the fallback for everything else.
+ *****************************************************************************/
+struct blend_rows_t {
+    const char *name;
+    void (*merge8)(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                   unsigned count, unsigned alpha);
+    void (*merge8_sub2)(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                        unsigned count, unsigned alpha);
+    void (*merge8_interleaved)(uint8_t *dst, const uint8_t *src_u,
+                               const uint8_t *src_v, const uint8_t *src_a,
+                               unsigned count, unsigned alpha);
+    void (*merge10)(uint16_t *dst, const uint8_t *src, const uint8_t *src_a,
+                    unsigned count, unsigned alpha);
+    void (*merge10_sub2)(uint16_t *dst, const uint8_t *src,
+                         const uint8_t *src_a, unsigned count, unsigned alpha);
+    void (*merge_rgbx)(uint8_t *dst, const uint8_t *src, unsigned count,
+                       unsigned alpha, const unsigned offset[3]);
+};
+
+#if defined(__GNUC__) || defined(__clang__)
+#ifdef CAN_COMPILE_AVX2
+#define HAVE_BLEND_AVX2
+#define COMPILE_TEMPLATE_AVX2 1
+#define BLEND_TEMPLATE_NAME "AVX2"
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+#define RENAME(a) a ## _avx2
+#include "blend_template.h"
+#undef COMPILE_TEMPLATE_AVX2
+#undef BLEND_TEMPLATE_NAME
+#undef VLC_TARGET
+#undef RENAME
+#endif
+
+#ifdef CAN_COMPILE_SSE4_1
+#define HAVE_BLEND_SSE4_1
+#define COMPILE_TEMPLATE_SSE4_1 1
+#define BLEND_TEMPLATE_NAME "SSE4.1"
+#define VLC_TARGET __attribute__ ((__target__ ("sse4.1")))
+#define RENAME(a) a ## _sse4_1
+#include "blend_template.h"
+#undef COMPILE_TEMPLATE_SSE4_1
+#undef BLEND_TEMPLATE_NAME
+#undef VLC_TARGET
+#undef RENAME
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_BLEND_NEON
+#define COMPILE_TEMPLATE_NEON 1
+#define BLEND_TEMPLATE_NAME "NEON"
+#define VLC_TARGET
+#define RENAME(a) a ## _neon
+#include "blend_template.h"
+#undef COMPILE_TEMPLATE_NEON
+#undef BLEND_TEMPLATE_NAME
+#undef VLC_TARGET
+#undef RENAME
+#endif
+
+static const blend_rows_t *GetBlendRows()
+{
+#ifdef HAVE_BLEND_AVX2
+    if (vlc_CPU_AVX2())
+        return &blend_rows_avx2;
+#endif
+#ifdef HAVE_BLEND_SSE4_1
+    if (vlc_CPU_SSE4_1())
+        return &blend_rows_sse4_1;
+#endif
+#ifdef HAVE_BLEND_NEON
+    return &blend_rows_neon;
+#endif
+    return NULL;
+}
+
+struct CPlane {
+    CPlane(const picture_t *picture, unsigned plane,
+           unsigned x, unsigned y, unsigned pixel_size = 1)
+        : pixels(&picture->p[plane].p_pixels[y * picture->p[plane].i_pitch +
+                                             x * pixel_size])
+    {
+    }
+    uint8_t *pixels;
+};
+
+typedef void (*blend_simd_function_t)(const blend_rows_t *rows,
+                                      const picture_t *dst,
+                                      const video_format_t *dst_fmt,
+                                      unsigned dst_x, unsigned dst_y,
+                                      const picture_t *src,
+                                      unsigned src_x, unsigned src_y,
+                                      unsigned width, unsigned height,
+                                      int alpha);
+
+/* YUVA onto 4:2:0 planar, the chroma of a 2x2 block is blended with the
+ * top left source pixel as the templated code does */
+template <typename pixel, bool swap_uv>
+void BlendYUVAToPlanar420(const blend_rows_t *rows,
+                          const picture_t *dst, const video_format_t *,
+                          unsigned dst_x, unsigned dst_y,
+                          const picture_t *src,
+                          unsigned src_x, unsigned src_y,
+                          unsigned width, unsigned height, int alpha)
+{
+    const unsigned dx0   = dst_x % 2;
+    const unsigned count = width > dx0 ? (width - dx0 + 1) / 2 : 0;
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned dy = dst_y + y;
+        const uint8_t *s_y = CPlane(src, 0, src_x, src_y + y).pixels;
+        const uint8_t *s_u = CPlane(src, 1, src_x, src_y + y).pixels;
+        const uint8_t *s_v = CPlane(src, 2, src_x, src_y + y).pixels;
+        const uint8_t *s_a = CPlane(src, 3, src_x, src_y + y).pixels;
+
+        pixel *dst_y_row = (pixel *)CPlane(dst, 0, dst_x, dy,
+                                           sizeof(pixel)).pixels;
+        if (sizeof(pixel) == 1)
+            rows->merge8((uint8_t *)dst_y_row, s_y, s_a, width, alpha);
+        else
+            rows->merge10((uint16_t *)dst_y_row, s_y, s_a, width, alpha);
+
+        if ((dy % 2) != 0 || count == 0)
+            continue;
+
+        pixel *dst_u = (pixel *)CPlane(dst, swap_uv ? 2 : 1, (dst_x + dx0) / 2,
+                                       dy / 2, sizeof(pixel)).pixels;
+        pixel *dst_v = (pixel *)CPlane(dst, swap_uv ? 1 : 2, (dst_x + dx0) / 2,
+                                       dy / 2, sizeof(pixel)).pixels;
+        if (sizeof(pixel) == 1) {
+            rows->merge8_sub2((uint8_t *)dst_u, &s_u[dx0], &s_a[dx0],
+                              count, alpha);
+            rows->merge8_sub2((uint8_t *)dst_v, &s_v[dx0], &s_a[dx0],
+                              count, alpha);
+        } else {
+            rows->merge10_sub2((uint16_t *)dst_u, &s_u[dx0], &s_a[dx0],
+                               count, alpha);
+            rows->merge10_sub2((uint16_t *)dst_v, &s_v[dx0], &s_a[dx0],
+                               count, alpha);
+        }
+    }
+}
+
+/* YUVA onto NV12/NV21 */
+template <bool swap_uv>
+void BlendYUVAToSemiPlanar420(const blend_rows_t *rows,
+                              const picture_t *dst, const video_format_t *,
+                              unsigned dst_x, unsigned dst_y,
+                              const picture_t *src,
+                              unsigned src_x, unsigned src_y,
+                              unsigned width, unsigned height, int alpha)
+{
+    const unsigned dx0   = dst_x % 2;
+    const unsigned count = width > dx0 ? (width - dx0 + 1) / 2 : 0;
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned dy = dst_y + y;
+        const uint8_t *s_y = CPlane(src, 0, src_x, src_y + y).pixels;
+        const uint8_t *s_u = CPlane(src, 1, src_x, src_y + y).pixels;
+        const uint8_t *s_v = CPlane(src, 2, src_x, src_y + y).pixels;
+        const uint8_t *s_a = CPlane(src, 3, src_x, src_y + y).pixels;
+
+        rows->merge8(CPlane(dst, 0, dst_x, dy).pixels, s_y, s_a,
+                     width, alpha);
+
+        if ((dy % 2) != 0 || count == 0)
+            continue;
+
+        uint8_t *dst_uv = CPlane(dst, 1, (dst_x + dx0) / 2 * 2, dy / 2).pixels;
+        rows->merge8_interleaved(dst_uv,
+                                 swap_uv ? &s_v[dx0] : &s_u[dx0],
+                                 swap_uv ? &s_u[dx0] : &s_v[dx0],
+                                 &s_a[dx0], count, alpha);
+    }
+}
+
+/* RGBA onto 32 bits RGB without alpha */
+static void BlendRGBAToRGB32(const blend_rows_t *rows,
+                             const picture_t *dst, const video_format_t *dst_fmt,
+                             unsigned dst_x, unsigned dst_y,
+                             const picture_t *src,
+                             unsigned src_x, unsigned src_y,
+                             unsigned width, unsigned height, int alpha)
+{
+    const unsigned offset[3] = {
+        (unsigned)dst_fmt->i_lrshift / 8,
+        (unsigned)dst_fmt->i_lgshift / 8,
+        (unsigned)dst_fmt->i_lbshift / 8,
+    };
+
+    for (unsigned y = 0; y < height; y++)
+        rows->merge_rgbx(CPlane(dst, 0, dst_x, dst_y + y, 4).pixels,
+                         CPlane(src, 0, src_x, src_y + y, 4).pixels,
+                         width, alpha, offset);
+}
+
+static const struct {
+    vlc_fourcc_t          dst;
+    vlc_fourcc_t          src;
+    blend_simd_function_t blend;
+} blends_simd[] = {
+    { VLC_CODEC_I420,     VLC_CODEC_YUVA, BlendYUVAToPlanar420<uint8_t, false> },
+    { VLC_CODEC_J420,     VLC_CODEC_YUVA, BlendYUVAToPlanar420<uint8_t, false> },
+    { VLC_CODEC_YV12,     VLC_CODEC_YUVA, BlendYUVAToPlanar420<uint8_t, true> },
+    { VLC_CODEC_NV12,     VLC_CODEC_YUVA, BlendYUVAToSemiPlanar420<false> },
+    { VLC_CODEC_NV21,     VLC_CODEC_YUVA, BlendYUVAToSemiPlanar420<true> },
+#ifndef WORDS_BIGENDIAN
+    { VLC_CODEC_I420_10L, VLC_CODEC_YUVA, BlendYUVAToPlanar420<uint16_t, false> },
+    { VLC_CODEC_RGB32,    VLC_CODEC_RGBA, BlendRGBAToRGB32 },
+#endif
+};
+
 static const struct {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
@@ -624,12 +856,30 @@ static const struct {
 };
 
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_simd(NULL), rows(NULL)
     {
     }
     blend_function_t blend;
+    blend_simd_function_t blend_simd;
+    const blend_rows_t *rows;
 };
 
+static bool IsSIMDCompatible(const video_format_t *dst,
+                             const video_format_t *src)
+{
+    if (src->i_chroma == VLC_CODEC_RGBA) {
+        /* The padding byte and the RGB ones must be distinct bytes */
+        const unsigned r = dst->i_lrshift, g = dst->i_lgshift, b = dst->i_lbshift;
+        return r % 8 == 0 && g % 8 == 0 && b % 8 == 0 &&
+               r < 32 && g < 32 && b < 32 &&
+               r != g && g != b && r != b &&
+               dst->i_rmask == 0xffu << r &&
+               dst->i_gmask == 0xffu << g &&
+               dst->i_bmask == 0xffu << b;
+    }
+    return true;
+}
+
 /**
  * It blends 2 picture together.
  */
@@ -655,6 +905,19 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
+    if (sys->blend_simd &&
+        IsSIMDCompatible(&filter->fmt_out.video, &filter->fmt_in.video)) {
+        sys->blend_simd(sys->rows,
+                        dst, &filter->fmt_out.video,
+                        filter->fmt_out.video.i_x_offset + x_offset,
+                        filter->fmt_out.video.i_y_offset + y_offset,
+                        src,
+                        filter->fmt_in.video.i_x_offset,
+                        filter->fmt_in.video.i_y_offset,
+                        width, height, alpha);
+        return;
+    }
+
     sys->blend(CPicture(dst, &filter->fmt_out.video,
                         filter->fmt_out.video.i_x_offset + x_offset,
                         filter->fmt_out.video.i_y_offset + y_offset),
@@ -683,6 +946,15 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    sys->rows = var_InheritBool(filter, "blend-simd") ? GetBlendRows() : NULL;
+    for (size_t i = 0; sys->rows && i < sizeof(blends_simd) / sizeof(*blends_simd); i++) {
+        if (blends_simd[i].src == src && blends_simd[i].dst == dst)
+            sys->blend_simd = blends_simd[i].blend;
+    }
+    if (sys->blend_simd)
+        msg_Dbg(filter, "using %s blending (chroma: %4.4s -> %4.4s)",
+                sys->rows->name, (char *)&src, (char *)&dst);
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
@@ -0,0 +1,515 @@
+/*****************************************************************************
+ * blend_template.h: SIMD row blenders for blend.cpp
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by blend.cpp with
+ *  - RENAME(a) giving the suffixed name of the generated functions,
+ *  - VLC_TARGET the matching target attribute,
+ *  - BLEND_TEMPLATE_NAME the instruction set name,
+ *  - one of COMPILE_TEMPLATE_SSE4_1, COMPILE_TEMPLATE_AVX2 or
+ *    COMPILE_TEMPLATE_NEON selecting the primitives.
+ *
+ * The primitives work on vectors of VL unsigned 16 bits lanes and compute
+ * exactly the same values as div255() and merge() of the C code, so that
+ * the SIMD and the templated C paths are interchangeable. */
+
+#if defined(COMPILE_TEMPLATE_AVX2)
+
+typedef __m256i RENAME(vec);
+#define VL 16
+
+VLC_TARGET static inline __m256i RENAME(VLoad8)(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+VLC_TARGET static inline __m256i RENAME(VLoad8Even)(const uint8_t *p)
+{
+    return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                            _mm256_set1_epi16(0xff));
+}
+VLC_TARGET static inline __m256i RENAME(VLoad8Odd)(const uint8_t *p)
+{
+    return _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)p), 8);
+}
+VLC_TARGET static inline void RENAME(VStore8)(uint8_t *p, __m256i v)
+{
+    __m256i x = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xd8);
+    _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(x));
+}
+VLC_TARGET static inline void RENAME(VStore8Interleaved)(uint8_t *p,
+                                                        __m256i e, __m256i o)
+{
+    _mm256_storeu_si256((__m256i *)p,
+                        _mm256_or_si256(e, _mm256_slli_epi16(o, 8)));
+}
+VLC_TARGET static inline __m256i RENAME(VLoad16)(const uint16_t *p)
+{
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+VLC_TARGET static inline void RENAME(VStore16)(uint16_t *p, __m256i v)
+{
+    _mm256_storeu_si256((__m256i *)p, v);
+}
+VLC_TARGET static inline __m256i RENAME(VSet)(unsigned v)
+{
+    return _mm256_set1_epi16(v);
+}
+VLC_TARGET static inline __m256i RENAME(VDiv255)(__m256i v)
+{
+    /* ((v >> 8) + v + 1) >> 8, v <= 255 * 255 */
+    v = _mm256_add_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+                         _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(v, 8);
+}
+VLC_TARGET static inline __m256i RENAME(VWeight)(__m256i src_a, __m256i alpha)
+{
+    return RENAME(VDiv255)(_mm256_mullo_epi16(src_a, alpha));
+}
+VLC_TARGET static inline __m256i RENAME(VMerge8)(__m256i dst, __m256i src,
+                                                 __m256i a)
+{
+    __m256i na = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return RENAME(VDiv255)(_mm256_add_epi16(_mm256_mullo_epi16(dst, na),
+                                            _mm256_mullo_epi16(src, a)));
+}
+VLC_TARGET static inline __m256i RENAME(VDiv255x32)(__m256i v)
+{
+    v = _mm256_add_epi32(_mm256_add_epi32(v, _mm256_srli_epi32(v, 8)),
+                         _mm256_set1_epi32(1));
+    return _mm256_srli_epi32(v, 8);
+}
+VLC_TARGET static inline __m256i RENAME(VMerge10)(__m256i dst, __m256i src,
+                                                  __m256i a)
+{
+    __m256i na = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    __m256i dl = _mm256_mullo_epi16(dst, na), dh = _mm256_mulhi_epu16(dst, na);
+    __m256i sl = _mm256_mullo_epi16(src, a),  sh = _mm256_mulhi_epu16(src, a);
+    __m256i lo = _mm256_add_epi32(_mm256_unpacklo_epi16(dl, dh),
+                                  _mm256_unpacklo_epi16(sl, sh));
+    __m256i hi = _mm256_add_epi32(_mm256_unpackhi_epi16(dl, dh),
+                                  _mm256_unpackhi_epi16(sl, sh));
+    __m256i r = _mm256_packus_epi32(RENAME(VDiv255x32)(lo),
+                                    RENAME(VDiv255x32)(hi));
+    /* div255() does not keep 1023, null weights must leave dst alone */
+    return _mm256_blendv_epi8(r, dst,
+                              _mm256_cmpeq_epi16(a, _mm256_setzero_si256()));
+}
+VLC_TARGET static inline __m256i RENAME(VTo10Bits)(__m256i v)
+{
+    /* v * 1023 / 255 == 4 * v + (v > 84) + (v > 169) + (v > 254) */
+    __m256i r = _mm256_slli_epi16(v, 2);
+    r = _mm256_sub_epi16(r, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(84)));
+    r = _mm256_sub_epi16(r, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(169)));
+    return _mm256_sub_epi16(r, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(254)));
+}
+
+#elif defined(COMPILE_TEMPLATE_SSE4_1)
+
+typedef __m128i RENAME(vec);
+#define VL 8
+
+VLC_TARGET static inline __m128i RENAME(VLoad8)(const uint8_t *p)
+{
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)p));
+}
+VLC_TARGET static inline __m128i RENAME(VLoad8Even)(const uint8_t *p)
+{
+    return _mm_and_si128(_mm_loadu_si128((const __m128i *)p),
+                         _mm_set1_epi16(0xff));
+}
+VLC_TARGET static inline __m128i RENAME(VLoad8Odd)(const uint8_t *p)
+{
+    return _mm_srli_epi16(_mm_loadu_si128((const __m128i *)p), 8);
+}
+VLC_TARGET static inline void RENAME(VStore8)(uint8_t *p, __m128i v)
+{
+    _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(v, v));
+}
+VLC_TARGET static inline void RENAME(VStore8Interleaved)(uint8_t *p,
+                                                        __m128i e, __m128i o)
+{
+    _mm_storeu_si128((__m128i *)p, _mm_or_si128(e, _mm_slli_epi16(o, 8)));
+}
+VLC_TARGET static inline __m128i RENAME(VLoad16)(const uint16_t *p)
+{
+    return _mm_loadu_si128((const __m128i *)p);
+}
+VLC_TARGET static inline void RENAME(VStore16)(uint16_t *p, __m128i v)
+{
+    _mm_storeu_si128((__m128i *)p, v);
+}
+VLC_TARGET static inline __m128i RENAME(VSet)(unsigned v)
+{
+    return _mm_set1_epi16(v);
+}
+VLC_TARGET static inline __m128i RENAME(VDiv255)(__m128i v)
+{
+    /* ((v >> 8) + v + 1) >> 8, v <= 255 * 255 */
+    v = _mm_add_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)),
+                      _mm_set1_epi16(1));
+    return _mm_srli_epi16(v, 8);
+}
+VLC_TARGET static inline __m128i RENAME(VWeight)(__m128i src_a, __m128i alpha)
+{
+    return RENAME(VDiv255)(_mm_mullo_epi16(src_a, alpha));
+}
+VLC_TARGET static inline __m128i RENAME(VMerge8)(__m128i dst, __m128i src,
+                                                 __m128i a)
+{
+    __m128i na = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return RENAME(VDiv255)(_mm_add_epi16(_mm_mullo_epi16(dst, na),
+                                         _mm_mullo_epi16(src, a)));
+}
+VLC_TARGET static inline __m128i RENAME(VDiv255x32)(__m128i v)
+{
+    v = _mm_add_epi32(_mm_add_epi32(v, _mm_srli_epi32(v, 8)),
+                      _mm_set1_epi32(1));
+    return _mm_srli_epi32(v, 8);
+}
+VLC_TARGET static inline __m128i RENAME(VMerge10)(__m128i dst, __m128i src,
+                                                  __m128i a)
+{
+    __m128i na = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    __m128i dl = _mm_mullo_epi16(dst, na), dh = _mm_mulhi_epu16(dst, na);
+    __m128i sl = _mm_mullo_epi16(src, a),  sh = _mm_mulhi_epu16(src, a);
+    __m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(dl, dh),
+                               _mm_unpacklo_epi16(sl, sh));
+    __m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(dl, dh),
+                               _mm_unpackhi_epi16(sl, sh));
+    __m128i r = _mm_packus_epi32(RENAME(VDiv255x32)(lo),
+                                 RENAME(VDiv255x32)(hi));
+    /* div255() does not keep 1023, null weights must leave dst alone */
+    return _mm_blendv_epi8(r, dst, _mm_cmpeq_epi16(a, _mm_setzero_si128()));
+}
+VLC_TARGET static inline __m128i RENAME(VTo10Bits)(__m128i v)
+{
+    /* v * 1023 / 255 == 4 * v + (v > 84) + (v > 169) + (v > 254) */
+    __m128i r = _mm_slli_epi16(v, 2);
+    r = _mm_sub_epi16(r, _mm_cmpgt_epi16(v, _mm_set1_epi16(84)));
+    r = _mm_sub_epi16(r, _mm_cmpgt_epi16(v, _mm_set1_epi16(169)));
+    return _mm_sub_epi16(r, _mm_cmpgt_epi16(v, _mm_set1_epi16(254)));
+}
+
+#elif defined(COMPILE_TEMPLATE_NEON)
+
+typedef uint16x8_t RENAME(vec);
+#define VL 8
+
+VLC_TARGET static inline uint16x8_t RENAME(VLoad8)(const uint8_t *p)
+{
+    return vmovl_u8(vld1_u8(p));
+}
+VLC_TARGET static inline uint16x8_t RENAME(VLoad8Even)(const uint8_t *p)
+{
+    return vmovl_u8(vld2_u8(p).val[0]);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VLoad8Odd)(const uint8_t *p)
+{
+    return vmovl_u8(vld2_u8(p).val[1]);
+}
+VLC_TARGET static inline void RENAME(VStore8)(uint8_t *p, uint16x8_t v)
+{
+    vst1_u8(p, vmovn_u16(v));
+}
+VLC_TARGET static inline void RENAME(VStore8Interleaved)(uint8_t *p,
+                                                        uint16x8_t e,
+                                                        uint16x8_t o)
+{
+    uint8x8x2_t x;
+    x.val[0] = vmovn_u16(e);
+    x.val[1] = vmovn_u16(o);
+    vst2_u8(p, x);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VLoad16)(const uint16_t *p)
+{
+    return vld1q_u16(p);
+}
+VLC_TARGET static inline void RENAME(VStore16)(uint16_t *p, uint16x8_t v)
+{
+    vst1q_u16(p, v);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VSet)(unsigned v)
+{
+    return vdupq_n_u16(v);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VDiv255)(uint16x8_t v)
+{
+    /* ((v >> 8) + v + 1) >> 8, v <= 255 * 255 */
+    v = vaddq_u16(vaddq_u16(v, vshrq_n_u16(v, 8)), vdupq_n_u16(1));
+    return vshrq_n_u16(v, 8);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VWeight)(uint16x8_t src_a,
+                                                    uint16x8_t alpha)
+{
+    return RENAME(VDiv255)(vmulq_u16(src_a, alpha));
+}
+VLC_TARGET static inline uint16x8_t RENAME(VMerge8)(uint16x8_t dst,
+                                                    uint16x8_t src,
+                                                    uint16x8_t a)
+{
+    uint16x8_t na = vsubq_u16(vdupq_n_u16(255), a);
+    return RENAME(VDiv255)(vmlaq_u16(vmulq_u16(dst, na), src, a));
+}
+VLC_TARGET static inline uint32x4_t RENAME(VDiv255x32)(uint32x4_t v)
+{
+    v = vaddq_u32(vaddq_u32(v, vshrq_n_u32(v, 8)), vdupq_n_u32(1));
+    return vshrq_n_u32(v, 8);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VMerge10)(uint16x8_t dst,
+                                                     uint16x8_t src,
+                                                     uint16x8_t a)
+{
+    uint16x8_t na = vsubq_u16(vdupq_n_u16(255), a);
+    uint32x4_t lo = vmlal_u16(vmull_u16(vget_low_u16(dst), vget_low_u16(na)),
+                              vget_low_u16(src), vget_low_u16(a));
+    uint32x4_t hi = vmlal_u16(vmull_u16(vget_high_u16(dst), vget_high_u16(na)),
+                              vget_high_u16(src), vget_high_u16(a));
+    uint16x8_t r = vcombine_u16(vmovn_u32(RENAME(VDiv255x32)(lo)),
+                                vmovn_u32(RENAME(VDiv255x32)(hi)));
+    /* div255() does not keep 1023, null weights must leave dst alone */
+    return vbslq_u16(vceqq_u16(a, vdupq_n_u16(0)), dst, r);
+}
+VLC_TARGET static inline uint16x8_t RENAME(VTo10Bits)(uint16x8_t v)
+{
+    /* v * 1023 / 255 == 4 * v + (v > 84) + (v > 169) + (v > 254) */
+    uint16x8_t r = vshlq_n_u16(v, 2);
+    r = vsubq_u16(r, vcgtq_u16(v, vdupq_n_u16(84)));
+    r = vsubq_u16(r, vcgtq_u16(v, vdupq_n_u16(169)));
+    return vsubq_u16(r, vcgtq_u16(v, vdupq_n_u16(254)));
+}
+
+#endif
+
+/* dst[i] over src[i] with alpha src_a[i] */
+VLC_TARGET static void RENAME(MergeRow8)(uint8_t *dst, const uint8_t *src,
+                                         const uint8_t *src_a,
+                                         unsigned count, unsigned alpha)
+{
+    const RENAME(vec) valpha = RENAME(VSet)(alpha);
+    unsigned i = 0;
+
+    for (; i + VL <= count; i += VL) {
+        RENAME(vec) a = RENAME(VWeight)(RENAME(VLoad8)(&src_a[i]), valpha);
+        RENAME(VStore8)(&dst[i], RENAME(VMerge8)(RENAME(VLoad8)(&dst[i]),
+                                                 RENAME(VLoad8)(&src[i]), a));
+    }
+    for (; i < count; i++)
+        merge(&dst[i], src[i], div255(alpha * src_a[i]));
+}
+
+/* dst[i] over src[2 * i] with alpha src_a[2 * i] */
+VLC_TARGET static void RENAME(MergeRow8Sub2)(uint8_t *dst, const uint8_t *src,
+                                             const uint8_t *src_a,
+                                             unsigned count, unsigned alpha)
+{
+    const RENAME(vec) valpha = RENAME(VSet)(alpha);
+    unsigned i = 0;
+
+    /* Keep the even samples loads inside the source row */
+    for (; i + VL < count; i += VL) {
+        RENAME(vec) a = RENAME(VWeight)(RENAME(VLoad8Even)(&src_a[2 * i]),
+                                        valpha);
+        RENAME(VStore8)(&dst[i],
+                        RENAME(VMerge8)(RENAME(VLoad8)(&dst[i]),
+                                        RENAME(VLoad8Even)(&src[2 * i]), a));
+    }
+    for (; i < count; i++)
+        merge(&dst[i], src[2 * i], div255(alpha * src_a[2 * i]));
+}
+
+/* dst[2 * i] over src_u[2 * i] and dst[2 * i + 1] over src_v[2 * i] */
+VLC_TARGET static void RENAME(MergeRow8Interleaved)(uint8_t *dst,
+                                                    const uint8_t *src_u,
+                                                    const uint8_t *src_v,
+                                                    const uint8_t *src_a,
+                                                    unsigned count,
+                                                    unsigned alpha)
+{
+    const RENAME(vec) valpha = RENAME(VSet)(alpha);
+    unsigned i = 0;
+
+    /* Keep the even samples loads inside the source row */
+    for (; i + VL < count; i += VL) {
+        RENAME(vec) a = RENAME(VWeight)(RENAME(VLoad8Even)(&src_a[2 * i]),
+                                        valpha);
+        RENAME(vec) u = RENAME(VMerge8)(RENAME(VLoad8Even)(&dst[2 * i]),
+                                        RENAME(VLoad8Even)(&src_u[2 * i]), a);
+        RENAME(vec) v = RENAME(VMerge8)(RENAME(VLoad8Odd)(&dst[2 * i]),
+                                        RENAME(VLoad8Even)(&src_v[2 * i]), a);
+        RENAME(VStore8Interleaved)(&dst[2 * i], u, v);
+    }
+    for (; i < count; i++) {
+        unsigned a = div255(alpha * src_a[2 * i]);
+        merge(&dst[2 * i + 0], src_u[2 * i], a);
+        merge(&dst[2 * i + 1], src_v[2 * i], a);
+    }
+}
+
+/* 10 bits dst[i] over 8 bits src[i] with alpha src_a[i] */
+VLC_TARGET static void RENAME(MergeRow10)(uint16_t *dst, const uint8_t *src,
+                                          const uint8_t *src_a,
+                                          unsigned count, unsigned alpha)
+{
+    const RENAME(vec) valpha = RENAME(VSet)(alpha);
+    unsigned i = 0;
+
+    for (; i + VL <= count; i += VL) {
+        RENAME(vec) a = RENAME(VWeight)(RENAME(VLoad8)(&src_a[i]), valpha);
+        RENAME(vec) s = RENAME(VTo10Bits)(RENAME(VLoad8)(&src[i]));
+        RENAME(VStore16)(&dst[i],
+                         RENAME(VMerge10)(RENAME(VLoad16)(&dst[i]), s, a));
+    }
+    for (; i < count; i++) {
+        unsigned a = div255(alpha * src_a[i]);
+        if (a > 0)
+            merge(&dst[i], src[i] * 1023 / 255, a);
+    }
+}
+
+/* 10 bits dst[i] over 8 bits src[2 * i] with alpha src_a[2 * i] */
+VLC_TARGET static void RENAME(MergeRow10Sub2)(uint16_t *dst,
+                                              const uint8_t *src,
+                                              const uint8_t *src_a,
+                                              unsigned count, unsigned alpha)
+{
+    const RENAME(vec) valpha = RENAME(VSet)(alpha);
+    unsigned i = 0;
+
+    /* Keep the even samples loads inside the source row */
+    for (; i + VL < count; i += VL) {
+        RENAME(vec) a = RENAME(VWeight)(RENAME(VLoad8Even)(&src_a[2 * i]),
+                                        valpha);
+        RENAME(vec) s = RENAME(VTo10Bits)(RENAME(VLoad8Even)(&src[2 * i]));
+        RENAME(VStore16)(&dst[i],
+                         RENAME(VMerge10)(RENAME(VLoad16)(&dst[i]), s, a));
+    }
+    for (; i < count; i++) {
+        unsigned a = div255(alpha * src_a[2 * i]);
+        if (a > 0)
+            merge(&dst[i], src[2 * i] * 1023 / 255, a);
+    }
+}
+
+/* 32 bits RGB dst (without alpha) over RGBA src */
+VLC_TARGET static void RENAME(MergeRowRGBX)(uint8_t *dst, const uint8_t *src,
+                                            unsigned count, unsigned alpha,
+                                            const unsigned offset[3])
+{
+    unsigned i = 0;
+
+#if defined(COMPILE_TEMPLATE_NEON)
+    const uint16x8_t valpha = vdupq_n_u16(alpha);
+
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t s = vld4_u8(&src[4 * i]);
+        uint8x8x4_t d = vld4_u8(&dst[4 * i]);
+        uint16x8_t a = RENAME(VWeight)(vmovl_u8(s.val[3]), valpha);
+
+        for (unsigned c = 0; c < 3; c++)
+            d.val[offset[c]] =
+                vmovn_u16(RENAME(VMerge8)(vmovl_u8(d.val[offset[c]]),
+                                          vmovl_u8(s.val[c]), a));
+        vst4_u8(&dst[4 * i], d);
+    }
+#else
+    /* Move the RGBA source bytes to the destination positions and
+     * replicate the source alpha on them, the padding byte gets a null
+     * weight and is therefore kept untouched */
+    uint8_t shuffle_src[16], shuffle_a[16];
+    for (unsigned p = 0; p < 4; p++) {
+        for (unsigned b = 0; b < 4; b++) {
+            shuffle_src[4 * p + b] = 0x80;
+            shuffle_a[4 * p + b]   = 0x80;
+        }
+        for (unsigned c = 0; c < 3; c++) {
+            shuffle_src[4 * p + offset[c]] = 4 * p + c;
+            shuffle_a[4 * p + offset[c]]   = 4 * p + 3;
+        }
+    }
+    const __m128i mask_src = _mm_loadu_si128((const __m128i *)shuffle_src);
+    const __m128i mask_a   = _mm_loadu_si128((const __m128i *)shuffle_a);
+
+# if defined(COMPILE_TEMPLATE_AVX2)
+    const __m256i mask_src2 = _mm256_broadcastsi128_si256(mask_src);
+    const __m256i mask_a2   = _mm256_broadcastsi128_si256(mask_a);
+    const __m256i valpha    = _mm256_set1_epi16(alpha);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)&src[4 * i]);
+        __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * i]);
+        __m256i sv = _mm256_shuffle_epi8(s, mask_src2);
+        __m256i av = _mm256_shuffle_epi8(s, mask_a2);
+
+        __m256i lo = RENAME(VMerge8)(
+            _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)),
+            _mm256_cvtepu8_epi16(_mm256_castsi256_si128(sv)),
+            RENAME(VWeight)(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(av)),
+                            valpha));
+        __m256i hi = RENAME(VMerge8)(
+            _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)),
+            _mm256_cvtepu8_epi16(_mm256_extracti128_si256(sv, 1)),
+            RENAME(VWeight)(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(av, 1)),
+                            valpha));
+        d = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+        _mm256_storeu_si256((__m256i *)&dst[4 * i], d);
+    }
+# else
+    const __m128i valpha = _mm_set1_epi16(alpha);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * i]);
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        __m128i sv = _mm_shuffle_epi8(s, mask_src);
+        __m128i av = _mm_shuffle_epi8(s, mask_a);
+
+        __m128i lo = RENAME(VMerge8)(_mm_cvtepu8_epi16(d),
+                                     _mm_cvtepu8_epi16(sv),
+                                     RENAME(VWeight)(_mm_cvtepu8_epi16(av),
+                                                     valpha));
+        __m128i hi = RENAME(VMerge8)(_mm_cvtepu8_epi16(_mm_srli_si128(d, 8)),
+                                     _mm_cvtepu8_epi16(_mm_srli_si128(sv, 8)),
+                                     RENAME(VWeight)(
+                                         _mm_cvtepu8_epi16(_mm_srli_si128(av, 8)),
+                                         valpha));
+        _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(lo, hi));
+    }
+# endif
+#endif
+
+    for (; i < count; i++) {
+        const uint8_t *s = &src[4 * i];
+        uint8_t *d = &dst[4 * i];
+        unsigned a = div255(alpha * s[3]);
+
+        for (unsigned c = 0; c < 3; c++)
+            merge(&d[offset[c]], s[c], a);
+    }
+}
+
+static const blend_rows_t RENAME(blend_rows) = {
+    BLEND_TEMPLATE_NAME,
+    RENAME(MergeRow8),
+    RENAME(MergeRow8Sub2),
+    RENAME(MergeRow8Interleaved),
+    RENAME(MergeRow10),
+    RENAME(MergeRow10Sub2),
+    RENAME(MergeRowRGBX),
+};
+
+#undef VL
@@ -225,52 +225,115 @@ static void Destroy( vlc_object_t *p_this )
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * Run: blends the images with the SIMD routines enabled or not
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static int blendbench_Run( filter_t *p_filter, bool b_simd,
+                           picture_t *p_base, mtime_t *pi_time )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     filter_t *p_blend;
 
-    if( p_sys->b_done )
-        return p_pic;
-
     p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
+        return VLC_ENOMEM;
+
+    /* Overrides the blend module option for this instance only */
+    var_Create( p_blend, "blend-simd", VLC_VAR_BOOL );
+    var_SetBool( p_blend, "blend-simd", b_simd );
+
+    p_blend->fmt_out.video = p_base->format;
     p_blend->fmt_in.video = p_sys->p_blend_image->format;
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
         vlc_object_release( p_blend );
-        return NULL;
+        return VLC_EGENERIC;
     }
 
     mtime_t time = mdate();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
         p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
+                                 p_base, p_sys->p_blend_image,
                                  0, 0, p_sys->i_alpha );
     }
-    time = mdate() - time;
+    *pi_time = mdate() - time;
+
+    module_unneed( p_blend, p_blend->p_module );
+
+    vlc_object_release( p_blend );
+    return VLC_SUCCESS;
+}
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
+static bool blendbench_IsEqual( const picture_t *p_a, const picture_t *p_b )
+{
+    for( int i = 0; i < p_a->i_planes; i++ )
+    {
+        const plane_t *a = &p_a->p[i], *b = &p_b->p[i];
+        for( int y = 0; y < a->i_visible_lines; y++ )
+            if( memcmp( &a->p_pixels[y * a->i_pitch],
+                        &b->p_pixels[y * b->i_pitch], a->i_visible_pitch ) )
+                return false;
+    }
+    return true;
+}
+
+static void blendbench_Report( filter_t *p_filter, const char *psz_name,
+                               mtime_t i_time )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( i_time <= 0 )
+        i_time = 1;
+
+    msg_Info( p_filter, "%s: blended %d images in %f sec", psz_name,
+              p_sys->i_loops, i_time / 1000000.0f );
+    msg_Info( p_filter, "%s: speed is: %f images/second, %f pixels/second",
+              psz_name,
+              (float) p_sys->i_loops / i_time * 1000000,
+              (float) p_sys->i_loops / i_time * 1000000 *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+}
 
-    module_unneed( p_blend, p_blend->p_module );
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
 
-    vlc_object_release( p_blend );
+    if( p_sys->b_done )
+        return p_pic;
+
+    /* Both runs start from the same base image so that their results can
+     * be compared */
+    picture_t *p_base_c =
+        picture_NewFromFormat( &p_sys->p_base_image->format );
+    if( !p_base_c )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+    picture_Copy( p_base_c, p_sys->p_base_image );
+
+    mtime_t i_time_c, i_time_simd;
+    if( blendbench_Run( p_filter, false, p_base_c, &i_time_c )
+     || blendbench_Run( p_filter, true, p_sys->p_base_image, &i_time_simd ) )
+    {
+        picture_Release( p_base_c );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    blendbench_Report( p_filter, "C", i_time_c );
+    blendbench_Report( p_filter, "SIMD", i_time_simd );
+    msg_Info( p_filter, "SIMD speedup is: %.2fx",
+              (float) i_time_c / __MAX( i_time_simd, 1 ) );
+    if( !blendbench_IsEqual( p_base_c, p_sys->p_base_image ) )
+        msg_Warn( p_filter, "SIMD and C blending results differ" );
+
+    picture_Release( p_base_c );
 
     p_sys->b_done = true;
     return p_pic;
@@ -290,8 +290,15 @@ stream_t *stream_AccessNew(vlc_object_t *parent, input_thread_t *input,
 
     if (access->pf_block != NULL)
     {
+        bool mapped;
+
         s->pf_block = AStreamReadBlock;
-        cachename = "prefetch,cache_block";
+        /* Blocks of mapped files are handed out as is, caching them would
+         * only copy them. */
+        if (vlc_stream_Control(access, STREAM_IS_MAPPED, &mapped) || !mapped)
+            cachename = "prefetch,cache_block";
+        else
+            cachename = NULL;
     }
     else
     if (access->pf_read != NULL)
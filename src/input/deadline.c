@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * deadline.c: decoding deadline scheduler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include "deadline.h"
+
+/* Time left to the video output to filter and display a picture */
+#define DEADLINE_MARGIN ((mtime_t)(0.010*CLOCK_FREQ))
+/* Delay after which the cost of an unused level is measured again */
+#define DEADLINE_REPROBE_DELAY ((mtime_t)(5*CLOCK_FREQ))
+
+static int CostCmp( const void *a, const void *b )
+{
+    const mtime_t x = *(const mtime_t *)a;
+    const mtime_t y = *(const mtime_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+void decoder_deadline_Init( decoder_deadline_t *p_dl, int i_policy )
+{
+    p_dl->i_policy = VLC_CLIP( i_policy, DECODER_SKIP_NONE, DECODER_SKIP_NONREF );
+    p_dl->i_hint = DECODER_SKIP_NONE;
+
+    for( int i = 0; i <= DECODER_SKIP_NONREF; i++ )
+    {
+        p_dl->level[i].i_count = 0;
+        p_dl->level[i].i_next = 0;
+        p_dl->level[i].i_estimate = 0;
+        p_dl->level[i].i_last_use = VLC_TS_INVALID;
+    }
+}
+
+void decoder_deadline_Reset( decoder_deadline_t *p_dl )
+{
+    p_dl->i_hint = DECODER_SKIP_NONE;
+}
+
+int decoder_deadline_Schedule( decoder_deadline_t *p_dl, mtime_t i_now,
+                               mtime_t i_display_date )
+{
+    if( p_dl->i_policy == DECODER_SKIP_NONE ||
+        i_display_date <= VLC_TS_INVALID )
+    {
+        p_dl->level[DECODER_SKIP_NONE].i_last_use = i_now;
+        p_dl->i_hint = DECODER_SKIP_NONE;
+        return p_dl->i_hint;
+    }
+
+    const mtime_t i_slack = i_display_date - i_now - DEADLINE_MARGIN;
+
+    /* Select the cheapest level predicted to meet the deadline. A level that
+     * has never been used, or not for a while, is assumed to fit, so that
+     * its cost gets known again after the load changed. Going back to a
+     * more expensive level requires some headroom, to avoid switching at
+     * every block. */
+    int i_hint = p_dl->i_policy;
+    for( int i = DECODER_SKIP_NONE; i < p_dl->i_policy; i++ )
+    {
+        decoder_deadline_level_t *p_level = &p_dl->level[i];
+
+        if( p_level->i_count > 0 &&
+            i_now - p_level->i_last_use > DEADLINE_REPROBE_DELAY )
+        {
+            p_level->i_count = 0;
+            p_level->i_next = 0;
+        }
+
+        mtime_t i_estimate = p_level->i_count > 0 ? p_level->i_estimate : 0;
+        if( i < p_dl->i_hint )
+            i_estimate += i_estimate / 4;
+
+        if( i_estimate <= i_slack )
+        {
+            i_hint = i;
+            break;
+        }
+    }
+
+    p_dl->level[i_hint].i_last_use = i_now;
+    p_dl->i_hint = i_hint;
+    return i_hint;
+}
+
+void decoder_deadline_Report( decoder_deadline_t *p_dl, int i_hint,
+                              mtime_t i_cost )
+{
+    assert( i_hint >= DECODER_SKIP_NONE && i_hint <= DECODER_SKIP_NONREF );
+
+    if( i_cost < 0 )
+        return;
+
+    decoder_deadline_level_t *p_level = &p_dl->level[i_hint];
+
+    p_level->pi_cost[p_level->i_next] = i_cost;
+    p_level->i_next = (p_level->i_next + 1) % DECODER_DEADLINE_HISTORY;
+    if( p_level->i_count < DECODER_DEADLINE_HISTORY )
+        p_level->i_count++;
+
+    mtime_t pi_sorted[DECODER_DEADLINE_HISTORY];
+    memcpy( pi_sorted, p_level->pi_cost,
+            p_level->i_count * sizeof(*pi_sorted) );
+    qsort( pi_sorted, p_level->i_count, sizeof(*pi_sorted), CostCmp );
+
+    p_level->i_estimate = pi_sorted[(p_level->i_count * 9) / 10];
+}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * deadline.h: decoding deadline scheduler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_INPUT_DEADLINE_H
+#define LIBVLC_INPUT_DEADLINE_H 1
+
+#include <vlc_common.h>
+#include <vlc_codec.h>
+
+#define DECODER_DEADLINE_HISTORY 32
+
+/* Decoding times observed for one decoder_skip_hint level */
+typedef struct
+{
+    mtime_t  pi_cost[DECODER_DEADLINE_HISTORY];
+    unsigned i_count;
+    unsigned i_next;
+    mtime_t  i_estimate; /**< 90th percentile of pi_cost */
+    mtime_t  i_last_use; /**< date the level was last selected */
+} decoder_deadline_level_t;
+
+/** @struct decoder_deadline_t
+ * This structure predicts the decoding time of the next blocks of a stream
+ * from the distribution of the previous ones, separately for each
+ * decoder_skip_hint level, and selects the cheapest level that still lets
+ * the next picture reach the video output before its display date.
+ * The history of a level that has not been selected for a while is
+ * forgotten, so that it gets measured again once the load drops.
+ *
+ * It must be used from the decoder thread only.
+ */
+typedef struct
+{
+    int      i_policy;   /**< highest decoder_skip_hint level allowed */
+    int      i_hint;     /**< level selected for the last block */
+
+    decoder_deadline_level_t level[DECODER_SKIP_NONREF + 1];
+} decoder_deadline_t;
+
+/**
+ * Initializes a decoder_deadline_t with the highest decoder_skip_hint level
+ * it can select.
+ */
+void decoder_deadline_Init( decoder_deadline_t *, int i_policy );
+
+/**
+ * Forgets the current level, to be called on discontinuities.
+ * The decoding time history is kept.
+ */
+void decoder_deadline_Reset( decoder_deadline_t * );
+
+/**
+ * Returns the decoder_skip_hint level to use for the next block.
+ *
+ * \param i_now the current date
+ * \param i_display_date the date at which the block is due for display, or
+ * VLC_TS_INVALID if unknown
+ */
+int  decoder_deadline_Schedule( decoder_deadline_t *, mtime_t i_now,
+                                mtime_t i_display_date );
+
+/**
+ * Records the time spent to decode a block with the given level.
+ */
+void decoder_deadline_Report( decoder_deadline_t *, int i_hint,
+                              mtime_t i_cost );
+
+#endif
@@ -48,6 +48,7 @@
 #include "stream_output/stream_output.h"
 #include "input_internal.h"
 #include "clock.h"
+#include "deadline.h"
 #include "decoder.h"
 #include "event.h"
 #include "resource.h"
@@ -141,6 +142,9 @@ struct decoder_owner_sys_t
 
     /* Delay */
     mtime_t i_ts_delay;
+
+    /* Decoding shortcuts to meet the display deadlines */
+    decoder_deadline_t deadline;
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -158,6 +162,7 @@ static int LoadDecoder( decoder_t *p_dec, bool b_packetizer,
                         const es_format_t *restrict p_fmt )
 {
     p_dec->b_frame_drop_allowed = true;
+    p_dec->i_skip_hint = DECODER_SKIP_NONE;
     p_dec->i_extra_picture_buffers = 0;
 
     p_dec->pf_decode = NULL;
@@ -1115,6 +1120,21 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
     vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
 }
 
+static void DecoderUpdateStatSkip( decoder_owner_sys_t *p_owner, int i_hint )
+{
+    input_thread_t *p_input = p_owner->p_input;
+
+    if( p_input == NULL || i_hint == DECODER_SKIP_NONE )
+        return;
+
+    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
+    if( i_hint >= DECODER_SKIP_NONREF )
+        stats_Update( input_priv(p_input)->counters.p_skipped_video, 1, NULL );
+    else
+        stats_Update( input_priv(p_input)->counters.p_hurried_video, 1, NULL );
+    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
+}
+
 static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
 {
     assert( p_pic );
@@ -1337,7 +1357,37 @@ static void DecoderDecode( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    /* Predict whether the block can be decoded in time and ask the decoder
+     * to take shortcuts before the deadline is missed */
+    const bool b_scheduled = p_block != NULL &&
+                             p_owner->deadline.i_policy != DECODER_SKIP_NONE &&
+                             p_dec->b_frame_drop_allowed &&
+                             !(p_block->i_flags & BLOCK_FLAG_PREROLL);
+    mtime_t i_start = 0;
+    if( b_scheduled )
+    {
+        const mtime_t i_ts = p_block->i_dts > VLC_TS_INVALID ?
+                             p_block->i_dts : p_block->i_pts;
+        mtime_t i_display_date = VLC_TS_INVALID;
+        if( i_ts > VLC_TS_INVALID )
+            i_display_date = DecoderGetDisplayDate( p_dec, i_ts );
+
+        i_start = mdate();
+        p_dec->i_skip_hint = decoder_deadline_Schedule( &p_owner->deadline,
+                                                        i_start,
+                                                        i_display_date );
+    }
+    else
+        p_dec->i_skip_hint = DECODER_SKIP_NONE;
+
     int ret = p_dec->pf_decode( p_dec, p_block );
+
+    if( b_scheduled && ret == VLCDEC_SUCCESS )
+    {
+        decoder_deadline_Report( &p_owner->deadline, p_dec->i_skip_hint,
+                                 mdate() - i_start );
+        DecoderUpdateStatSkip( p_owner, p_dec->i_skip_hint );
+    }
     switch( ret )
     {
         case VLCDEC_SUCCESS:
@@ -1396,6 +1446,11 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
         if( p_block->i_buffer <= 0 )
             goto error;
 
+        /* Packetizers and decoders may modify the data in place */
+        p_block = block_Unshare( p_block );
+        if( p_block == NULL )
+            return;
+
         vlc_mutex_lock( &p_owner->lock );
         DecoderUpdatePreroll( &p_owner->i_preroll_end, p_block );
         vlc_mutex_unlock( &p_owner->lock );
@@ -1482,6 +1537,8 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     if ( p_dec->pf_flush != NULL )
         p_dec->pf_flush( p_dec );
 
+    decoder_deadline_Reset( &p_owner->deadline );
+
     /* flush CC sub decoders */
     if( p_owner->cc.b_supported )
     {
@@ -1703,6 +1760,10 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
 
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
+    decoder_deadline_Init( &p_owner->deadline, fmt->i_cat == VIDEO_ES && p_sout == NULL ?
+                           var_InheritInteger( p_dec, "video-deadline-skip" ) :
+                           DECODER_SKIP_NONE );
+
     /* decoder fifo */
     p_owner->p_fifo = block_FifoNew();
     if( unlikely(p_owner->p_fifo == NULL) )
@@ -2113,7 +2113,15 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     /* Decode */
     if( es->p_dec_record )
     {
-        block_t *p_dup = block_Duplicate( p_block );
+        /* The decoders only copy the data if they need to modify it */
+        p_block = block_Shareable( p_block );
+        if( p_block == NULL )
+        {
+            vlc_mutex_unlock( &p_sys->lock );
+            return VLC_ENOMEM;
+        }
+
+        block_t *p_dup = block_Share( p_block );
         if( p_dup )
             input_DecoderDecode( es->p_dec_record, p_dup,
                                  input_priv(p_input)->b_out_pace_control );
@@ -2885,6 +2893,10 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_SET_TIMESHIFT_TIME:
+        /* Only the timeshift es_out keeps what was played */
+        return VLC_EGENERIC;
+
     default:
         msg_Err( p_sys->p_input, "unknown query 0x%x in %s", i_query,
                  __func__  );
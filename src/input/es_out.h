@@ -88,6 +88,9 @@ enum es_out_query_private_e
 
     /* Set End Of Stream */
     ES_OUT_SET_EOS,                                 /* res=cannot fail */
+
+    /* Move within the timeshift buffer */
+    ES_OUT_SET_TIMESHIFT_TIME,                      /* arg1=mtime_t i_time      res=can fail */
 };
 
 static inline void es_out_SetMode( es_out_t *p_out, int i_mode )
@@ -37,6 +37,9 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -84,7 +87,8 @@ typedef struct attribute_packed
 {
     es_out_id_t *p_es;
     block_t *p_block;
-    int     i_offset;  /* We do not use file > INT_MAX */
+    int     i_offset;  /* We do not use file > INT_MAX, -1 once overwritten */
+    int     i_size;    /* Stored size, header included */
 } ts_cmd_send_t;
 
 typedef struct attribute_packed
@@ -161,25 +165,47 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Header of a block stored in the ring buffer, followed by its data */
+typedef struct
+{
+    mtime_t  i_dts;
+    mtime_t  i_pts;
+    mtime_t  i_length;
+    uint32_t i_flags;
+    unsigned i_nb_samples;
+    size_t   i_buffer;
+} ts_block_header_t;
+
+/* The storage is a single temporary file used as a ring buffer for the
+ * blocks, mapped in memory when possible. The commands are kept in
+ * memory by sequence number and date order, which is the time index used to
+ * move within the buffer: the commands already executed are kept, until
+ * their data get overwritten or they get older than the maximum duration, so
+ * that they can be replayed. */
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
-    ts_storage_t *p_next;
-
     /* */
 #ifdef _WIN32
     char    *psz_file;  /* Filename */
 #endif
-    size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
-
-    /* */
-    int      i_cmd_r;
-    int      i_cmd_w;
-    int      i_cmd_max;
+    FILE    *p_file;    /* FILE handle, used when the file is not mapped */
+    uint8_t *p_map;     /* Mapping of the whole file */
+    size_t  i_file_max; /* Ring buffer size in bytes */
+    size_t  i_file_w;   /* Next write offset */
+
+    /* Commands, indexed by sequence number modulo i_cmd_max */
+    uint64_t i_cmd_first;   /* Oldest command kept */
+    uint64_t i_cmd_data;    /* Oldest command whose data can be in the file */
+    uint64_t i_cmd_r;       /* Next command to execute */
+    uint64_t i_cmd_w;       /* Next command to store */
+    uint64_t i_cmd_busy;    /* Command being executed, UINT64_MAX if none */
+    uint64_t i_skip_start;  /* Commands to skip to, without waiting */
+    uint64_t i_skip_end;
+    size_t   i_cmd_max;     /* Power of 2 */
     ts_cmd_t *p_cmd;
+
+    mtime_t  i_duration_max; /* Maximum duration of executed commands kept */
 };
 
 typedef struct
@@ -188,6 +214,7 @@ typedef struct
     input_thread_t *p_input;
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
+    mtime_t        i_tmp_duration_max;
     const char     *psz_tmp_path;
 
     /* Lock for all following fields */
@@ -208,16 +235,24 @@ typedef struct
     mtime_t        i_buffering_delay;
 
     /* */
-    ts_storage_t   *p_storage_r;
-    ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage;
 
     mtime_t        i_cmd_delay;
 
+    /* */
+    mtime_t        i_skip_date;
+    bool           b_discontinuity;
+
+    /* Last stream time executed, and the date it was stored at */
+    mtime_t        i_time_ref;
+    mtime_t        i_time_ref_date;
+
 } ts_thread_t;
 
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+    es_format_t fmt;    /* To add it again when replaying past its deletion */
 };
 
 struct es_out_sys_t
@@ -227,6 +262,7 @@ struct es_out_sys_t
 
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    mtime_t        i_tmp_duration_max;/* Maximal duration kept once played */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -258,24 +294,32 @@ static void         TsAutoStop( es_out_t * );
 
 static void         TsStop( ts_thread_t * );
 static void         TsPushCmd( ts_thread_t *, ts_cmd_t * );
-static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool b_flush );
+static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool *pb_skip );
 static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, mtime_t i_date );
 static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
+static int          TsChangeTime( ts_thread_t *, mtime_t i_time );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max,
+                                   mtime_t i_tmp_duration_max );
 static void         TsStorageDelete( ts_storage_t * );
-static void         TsStoragePack( ts_storage_t *p_storage );
-static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
-static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
+static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool *pb_skip );
+static int          TsStorageSeek( ts_storage_t *, mtime_t i_date, mtime_t *pi_delta );
 
 static void CmdClean( ts_cmd_t * );
-static void cmd_cleanup_routine( void *p ) { CmdClean( p ); }
+static void cmd_cleanup_routine( void *p )
+{
+    /* Only the popped blocks belong to the caller, the storage keeps the
+     * other commands data to replay them */
+    ts_cmd_t *p_cmd = p;
+    if( p_cmd->i_type == C_SEND )
+        CmdClean( p_cmd );
+}
 
 static int  CmdInitAdd    ( ts_cmd_t *, es_out_id_t *, const es_format_t *, bool b_copy );
 static void CmdInitSend   ( ts_cmd_t *, es_out_id_t *, block_t * );
@@ -285,6 +329,7 @@ static int  CmdInitControl( ts_cmd_t *, int i_query, va_list, bool b_copy );
 /* */
 static void CmdCleanAdd    ( ts_cmd_t * );
 static void CmdCleanSend   ( ts_cmd_t * );
+static void CmdCleanDel    ( ts_cmd_t * );
 static void CmdCleanControl( ts_cmd_t *p_cmd );
 
 /* XXX these functions will take the destination es_out_t */
@@ -336,13 +381,12 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     TAB_INIT( p_sys->i_es, p_sys->pp_es );
 
     /* */
-    const int i_tmp_size_max = var_CreateGetInteger( p_input, "input-timeshift-granularity" );
-    if( i_tmp_size_max < 0 )
-        p_sys->i_tmp_size_max = 50*1024*1024;
-    else
-        p_sys->i_tmp_size_max = __MAX( i_tmp_size_max, 1*1024*1024 );
-    msg_Dbg( p_input, "using timeshift granularity of %d MiB",
-             (int)p_sys->i_tmp_size_max/(1024*1024) );
+    const int64_t i_tmp_size_max = var_InheritInteger( p_input, "input-timeshift-size" );
+    p_sys->i_tmp_size_max = VLC_CLIP( i_tmp_size_max, 1, 2047 ) * 1024 * 1024;
+    const int64_t i_tmp_duration_max = var_InheritInteger( p_input, "input-timeshift-duration" );
+    p_sys->i_tmp_duration_max = __MAX( i_tmp_duration_max, 0 ) * CLOCK_FREQ;
+    msg_Dbg( p_input, "using timeshift buffer of %d MiB",
+             (int)(p_sys->i_tmp_size_max/(1024*1024)) );
 
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
@@ -432,6 +476,12 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
     es_out_id_t *p_es = malloc( sizeof( *p_es ) );
     if( !p_es )
         return NULL;
+    p_es->p_es = NULL;
+    if( es_format_Copy( &p_es->fmt, p_fmt ) )
+    {
+        free( p_es );
+        return NULL;
+    }
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -440,6 +490,7 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
     if( CmdInitAdd( &cmd, p_es, p_fmt, p_sys->b_delayed ) )
     {
         vlc_mutex_unlock( &p_sys->lock );
+        es_format_Clean( &p_es->fmt );
         free( p_es );
         return NULL;
     }
@@ -488,7 +539,10 @@ static void Del( es_out_t *p_out, es_out_id_t *p_es )
     if( p_sys->b_delayed )
         TsPushCmd( p_sys->p_ts, &cmd );
     else
+    {
         CmdExecuteDel( p_sys->p_out, &cmd );
+        CmdCleanDel( &cmd );
+    }
 
     TAB_REMOVE( p_sys->i_es, p_sys->pp_es, p_es );
 
@@ -604,6 +658,15 @@ static int ControlLockedSetRate( es_out_t *p_out, int i_src_rate, int i_rate )
     }
     return i_ret;
 }
+static int ControlLockedSetTimeshiftTime( es_out_t *p_out, mtime_t i_time )
+{
+    es_out_sys_t *p_sys = p_out->p_sys;
+
+    if( !p_sys->b_delayed )
+        return VLC_EGENERIC;
+
+    return TsChangeTime( p_sys->p_ts, i_time );
+}
 static int ControlLockedSetTime( es_out_t *p_out, mtime_t i_date )
 {
     es_out_sys_t *p_sys = p_out->p_sys;
@@ -675,6 +738,11 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
             *pb_enabled = true;
             return VLC_SUCCESS;
         }
+        if( !p_es->p_es )
+        {
+            *pb_enabled = false;
+            return VLC_SUCCESS;
+        }
         return es_out_Control( p_sys->p_out, ES_OUT_GET_ES_STATE, p_es->p_es, pb_enabled );
     }
     /* Special internal input control */
@@ -718,6 +786,12 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
     {
         return ControlLockedSetFrameNext( p_out );
     }
+    case ES_OUT_SET_TIMESHIFT_TIME:
+    {
+        const mtime_t i_time = (mtime_t)va_arg( args, mtime_t );
+
+        return ControlLockedSetTimeshiftTime( p_out, i_time );
+    }
 
     case ES_OUT_GET_PCR_SYSTEM:
         if( p_sys->b_delayed )
@@ -789,6 +863,7 @@ static int TsStart( es_out_t *p_out )
         return VLC_EGENERIC;
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
+    p_ts->i_tmp_duration_max = p_sys->i_tmp_duration_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
@@ -802,8 +877,11 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
-    p_ts->p_storage_r = NULL;
-    p_ts->p_storage_w = NULL;
+    p_ts->p_storage = NULL;
+    p_ts->i_skip_date = -1;
+    p_ts->b_discontinuity = false;
+    p_ts->i_time_ref = -1;
+    p_ts->i_time_ref_date = -1;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -836,18 +914,8 @@ static void TsStop( ts_thread_t *p_ts )
     vlc_join( p_ts->thread, NULL );
 
     vlc_mutex_lock( &p_ts->lock );
-    for( ;; )
-    {
-        ts_cmd_t cmd;
-
-        if( TsPopCmdLocked( p_ts, &cmd, true ) )
-            break;
-
-        CmdClean( &cmd );
-    }
-    assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage )
+        TsStorageDelete( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -856,54 +924,41 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    if( !p_ts->p_storage )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
-
-        if( !p_storage )
+        p_ts->p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max,
+                                        p_ts->i_tmp_duration_max );
+        if( !p_ts->p_storage )
         {
             CmdClean( p_cmd );
             vlc_mutex_unlock( &p_ts->lock );
             /* TODO warn the user (but only once) */
             return;
         }
-
-        if( !p_ts->p_storage_w )
-        {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
-        }
-        else
-        {
-            TsStoragePack( p_ts->p_storage_w );
-            p_ts->p_storage_w->p_next = p_storage;
-            p_ts->p_storage_w = p_storage;
-        }
     }
 
     /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    TsStoragePushCmd( p_ts->p_storage, p_cmd );
 
     vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
 }
-static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool *pb_skip )
 {
     vlc_assert_locked( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+    if( TsStorageIsEmpty( p_ts->p_storage ) )
         return VLC_EGENERIC;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+    TsStoragePopCmd( p_ts->p_storage, p_cmd, pb_skip );
 
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
+    /* Keep the date of the stream time, to move in the buffer by time */
+    if( p_cmd->i_type == C_CONTROL &&
+        p_cmd->u.control.i_query == ES_OUT_SET_TIMES )
     {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
-            break;
-
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
+        p_ts->i_time_ref = p_cmd->u.control.u.times.i_time;
+        p_ts->i_time_ref_date = p_cmd->i_date;
     }
 
     return VLC_SUCCESS;
@@ -913,7 +968,7 @@ static bool TsHasCmd( ts_thread_t *p_ts )
     bool b_cmd;
 
     vlc_mutex_lock( &p_ts->lock );
-    b_cmd =  TsStorageIsEmpty( p_ts->p_storage_r );
+    b_cmd = !TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_cmd;
@@ -922,10 +977,13 @@ static bool TsIsUnused( ts_thread_t *p_ts )
 {
     bool b_unused;
 
+    /* Once something has been played, it is kept to be able to move back in
+     * time, so the timeshift is not stopped anymore */
     vlc_mutex_lock( &p_ts->lock );
     b_unused = !p_ts->b_paused &&
                p_ts->i_rate == p_ts->i_rate_source &&
-               TsStorageIsEmpty( p_ts->p_storage_r );
+               ( !p_ts->p_storage ||
+                 p_ts->p_storage->i_cmd_first == p_ts->p_storage->i_cmd_w );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_unused;
@@ -979,6 +1037,44 @@ static int TsChangeRate( ts_thread_t *p_ts, int i_src_rate, int i_rate )
 
     return i_ret;
 }
+static int TsChangeTime( ts_thread_t *p_ts, mtime_t i_time )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_ts->lock );
+    if( p_ts->p_storage && p_ts->i_time_ref >= 0 )
+    {
+        /* Commands are stored in real time, as the stream is not paced */
+        const mtime_t i_date = p_ts->i_time_ref_date + i_time - p_ts->i_time_ref;
+        const mtime_t i_now = p_ts->b_paused ? p_ts->i_pause_date : mdate();
+        mtime_t i_delta;
+
+        /* Date of the command that was going to be executed */
+        i_delta = i_now - p_ts->i_cmd_delay - p_ts->i_rate_delay - p_ts->i_buffering_delay;
+
+        const uint64_t i_cmd_r = p_ts->p_storage->i_cmd_r;
+        i_ret = TsStorageSeek( p_ts->p_storage, i_date, &i_delta );
+        if( !i_ret )
+        {
+            msg_Dbg( p_ts->p_input, "es out timeshift: moving by %"PRId64" ms",
+                     -i_delta / 1000 );
+
+            /* Forward moves are done while skipping the commands */
+            if( p_ts->p_storage->i_cmd_r < i_cmd_r )
+            {
+                p_ts->i_cmd_delay += p_ts->i_rate_delay + i_delta;
+                p_ts->i_rate_date = -1;
+                p_ts->i_rate_delay = 0;
+                p_ts->i_skip_date = -1;
+                p_ts->b_discontinuity = true;
+            }
+            vlc_cond_signal( &p_ts->wait );
+        }
+    }
+    vlc_mutex_unlock( &p_ts->lock );
+
+    return i_ret;
+}
 
 static void *TsRun( void *p_data )
 {
@@ -990,17 +1086,22 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         mtime_t  i_deadline;
         bool b_buffering;
+        bool b_skip;
+        bool b_discontinuity;
 
         /* Pop a command to execute */
         vlc_mutex_lock( &p_ts->lock );
         mutex_cleanup_push( &p_ts->lock );
 
+        if( p_ts->p_storage )
+            p_ts->p_storage->i_cmd_busy = UINT64_MAX;
+
         for( ;; )
         {
             const int canc = vlc_savecancel();
             b_buffering = es_out_GetBuffering( p_ts->p_out );
 
-            if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
+            if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, &b_skip ) )
             {
                 vlc_restorecancel( canc );
                 break;
@@ -1010,6 +1111,28 @@ static void *TsRun( void *p_data )
             vlc_cond_wait( &p_ts->wait, &p_ts->lock );
         }
 
+        /* Commands that are skipped (lost or moved over) are executed at once,
+         * the delay is then shifted by their duration */
+        if( b_skip )
+        {
+            if( p_ts->i_skip_date < 0 )
+                p_ts->i_skip_date = cmd.i_date;
+        }
+        else if( p_ts->i_skip_date >= 0 )
+        {
+            p_ts->i_cmd_delay += p_ts->i_rate_delay + p_ts->i_skip_date - cmd.i_date;
+            p_ts->i_rate_date = -1;
+            p_ts->i_rate_delay = 0;
+            p_ts->i_skip_date = -1;
+            p_ts->b_discontinuity = true;
+        }
+        b_discontinuity = !b_skip && p_ts->b_discontinuity;
+        if( b_discontinuity )
+        {
+            p_ts->b_discontinuity = false;
+            i_buffering_date = -1;
+        }
+
         if( b_buffering && i_buffering_date < 0 )
         {
             i_buffering_date = cmd.i_date;
@@ -1066,25 +1189,28 @@ static void *TsRun( void *p_data )
          * reading  */
         vlc_cleanup_push( cmd_cleanup_routine, &cmd );
 
-        mwait( i_deadline );
+        if( !b_skip )
+            mwait( i_deadline );
 
         vlc_cleanup_pop();
 
         /* Execute the command  */
         const int canc = vlc_savecancel();
+        if( b_discontinuity )
+            es_out_Control( p_ts->p_out, ES_OUT_RESET_PCR );
         switch( cmd.i_type )
         {
         case C_ADD:
             CmdExecuteAdd( p_ts->p_out, &cmd );
-            CmdCleanAdd( &cmd );
             break;
         case C_SEND:
-            CmdExecuteSend( p_ts->p_out, &cmd );
-            CmdCleanSend( &cmd );
+            if( b_skip )
+                CmdCleanSend( &cmd );
+            else
+                CmdExecuteSend( p_ts->p_out, &cmd );
             break;
         case C_CONTROL:
             CmdExecuteControl( p_ts->p_out, &cmd );
-            CmdCleanControl( &cmd );
             break;
         case C_DEL:
             CmdExecuteDel( p_ts->p_out, &cmd );
@@ -1102,7 +1228,8 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max,
+                                   mtime_t i_tmp_duration_max )
 {
     ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
     if( unlikely(p_storage == NULL) )
@@ -1116,40 +1243,46 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+    p_storage->p_file = fdopen( fd, "w+b" );
+    if( p_storage->p_file == NULL )
     {
         vlc_close( fd );
         vlc_unlink( psz_file );
         goto error;
     }
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
-    {
-        fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
-        goto error;
-    }
-
 #ifndef _WIN32
     vlc_unlink( psz_file );
     free( psz_file );
 #else
     p_storage->psz_file = psz_file;
 #endif
-    p_storage->p_next = NULL;
 
     /* */
     p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
+    p_storage->i_file_w = 0;
+    p_storage->p_map = NULL;
+#ifdef HAVE_MMAP
+    if( ftruncate( fd, p_storage->i_file_max ) == 0 )
+    {
+        void *p_map = mmap( NULL, p_storage->i_file_max, PROT_READ|PROT_WRITE,
+                            MAP_SHARED, fd, 0 );
+        if( p_map != MAP_FAILED )
+            p_storage->p_map = p_map;
+    }
+#endif
 
     /* */
-    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_first = 0;
+    p_storage->i_cmd_data = 0;
     p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_busy = UINT64_MAX;
+    p_storage->i_skip_start = 0;
+    p_storage->i_skip_end = 0;
+    p_storage->i_cmd_max = 4096;
+    p_storage->i_duration_max = i_tmp_duration_max;
     p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
     if( !p_storage->p_cmd )
     {
@@ -1163,20 +1296,25 @@ error:
     return NULL;
 }
 
+static inline ts_cmd_t *TsStorageCmd( ts_storage_t *p_storage, uint64_t i_cmd )
+{
+    return &p_storage->p_cmd[i_cmd & (p_storage->i_cmd_max - 1)];
+}
+
 static void TsStorageDelete( ts_storage_t *p_storage )
 {
-    while( p_storage->i_cmd_r < p_storage->i_cmd_w )
+    if( p_storage->p_cmd )
     {
-        ts_cmd_t cmd;
-
-        TsStoragePopCmd( p_storage, &cmd, true );
-
-        CmdClean( &cmd );
+        for( uint64_t i = p_storage->i_cmd_first; i < p_storage->i_cmd_w; i++ )
+            CmdClean( TsStorageCmd( p_storage, i ) );
+        free( p_storage->p_cmd );
     }
-    free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+#ifdef HAVE_MMAP
+    if( p_storage->p_map )
+        munmap( p_storage->p_map, p_storage->i_file_max );
+#endif
+    fclose( p_storage->p_file );
 #ifdef _WIN32
     vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
@@ -1184,99 +1322,248 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     free( p_storage );
 }
 
-static void TsStoragePack( ts_storage_t *p_storage )
+static int TsStorageWrite( ts_storage_t *p_storage, size_t i_offset,
+                           const void *p_data, size_t i_size )
 {
-    /* Try to release a bit of memory */
-    if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
-        return;
+    if( p_storage->p_map )
+    {
+        memcpy( &p_storage->p_map[i_offset], p_data, i_size );
+        return VLC_SUCCESS;
+    }
+    if( fseek( p_storage->p_file, i_offset, SEEK_SET ) ||
+        fwrite( p_data, i_size, 1, p_storage->p_file ) != 1 )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+static int TsStorageRead( ts_storage_t *p_storage, size_t i_offset,
+                          void *p_data, size_t i_size )
+{
+    if( p_storage->p_map )
+    {
+        memcpy( p_data, &p_storage->p_map[i_offset], i_size );
+        return VLC_SUCCESS;
+    }
+    if( fflush( p_storage->p_file ) ||
+        fseek( p_storage->p_file, i_offset, SEEK_SET ) ||
+        fread( p_data, i_size, 1, p_storage->p_file ) != 1 )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+/* Drops the oldest commands that are not needed anymore */
+static void TsStorageTrim( ts_storage_t *p_storage, mtime_t i_date )
+{
+    const uint64_t i_limit = __MIN( p_storage->i_cmd_r, p_storage->i_cmd_busy );
 
-    p_storage->i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
+    while( p_storage->i_cmd_first < i_limit )
+    {
+        ts_cmd_t *p_cmd = TsStorageCmd( p_storage, p_storage->i_cmd_first );
+
+        if( p_storage->i_cmd_first >= p_storage->i_cmd_data &&
+            ( p_storage->i_duration_max <= 0 ||
+              i_date - p_cmd->i_date <= p_storage->i_duration_max ) )
+            break;
+
+        CmdClean( p_cmd );
+        p_storage->i_cmd_first++;
+    }
+    if( p_storage->i_cmd_data < p_storage->i_cmd_first )
+        p_storage->i_cmd_data = p_storage->i_cmd_first;
+}
 
-    ts_cmd_t *p_new = realloc( p_storage->p_cmd, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
-    if( p_new )
-        p_storage->p_cmd = p_new;
+static bool TsStorageOverlaps( size_t i_start, size_t i_end,
+                               const ts_cmd_send_t *p_send )
+{
+    return (size_t)p_send->i_offset < i_end &&
+           i_start < (size_t)p_send->i_offset + p_send->i_size;
 }
-static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+
+/* Returns the offset of i_size free bytes, overwriting the oldest data */
+static int TsStorageAlloc( ts_storage_t *p_storage, size_t i_size )
 {
-    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
+    if( i_size > p_storage->i_file_max )
+        return -1;
+
+    size_t i_offset = p_storage->i_file_w;
+    size_t i_wrap = 0;
+    if( i_offset + i_size > p_storage->i_file_max )
+    {
+        /* The end of the file is left unused */
+        i_wrap = i_size;
+        i_size = p_storage->i_file_max - i_offset;
+    }
+
+    while( p_storage->i_cmd_data < p_storage->i_cmd_w )
     {
-        size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+        ts_cmd_t *p_cmd = TsStorageCmd( p_storage, p_storage->i_cmd_data );
+
+        if( p_cmd->i_type == C_SEND && p_cmd->u.send.i_offset >= 0 )
+        {
+            if( !TsStorageOverlaps( i_offset, i_offset + i_size, &p_cmd->u.send ) &&
+                ( !i_wrap || !TsStorageOverlaps( 0, i_wrap, &p_cmd->u.send ) ) )
+                break;
+
+            p_cmd->u.send.i_offset = -1;
 
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
-            return true;
+            /* Not yet executed: the reader has to move forward */
+            if( p_storage->i_cmd_data >= p_storage->i_cmd_r )
+            {
+                if( p_storage->i_skip_end <= p_storage->i_cmd_r )
+                    p_storage->i_skip_start = p_storage->i_cmd_r;
+                p_storage->i_skip_end = p_storage->i_cmd_data + 1;
+            }
+        }
+        p_storage->i_cmd_data++;
     }
-    return p_storage->i_cmd_w >= p_storage->i_cmd_max;
+
+    if( i_wrap )
+        i_offset = 0;
+    return i_offset;
 }
+
+static int TsStorageGrow( ts_storage_t *p_storage )
+{
+    const size_t i_max = p_storage->i_cmd_max;
+    if( unlikely(i_max > SIZE_MAX / 2 / sizeof(*p_storage->p_cmd)) )
+        return VLC_ENOMEM;
+
+    ts_cmd_t *p_new = realloc( p_storage->p_cmd, 2 * i_max * sizeof(*p_storage->p_cmd) );
+    if( !p_new )
+        return VLC_ENOMEM;
+
+    /* Commands now indexed in the second half have to be moved */
+    for( uint64_t i = p_storage->i_cmd_first; i < p_storage->i_cmd_w; i++ )
+    {
+        if( i & i_max )
+            p_new[(i & (i_max - 1)) + i_max] = p_new[i & (i_max - 1)];
+    }
+    p_storage->p_cmd = p_new;
+    p_storage->i_cmd_max = 2 * i_max;
+    return VLC_SUCCESS;
+}
+
 static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     ts_cmd_t cmd = *p_cmd;
 
-    assert( !TsStorageIsFull( p_storage, p_cmd ) );
+    TsStorageTrim( p_storage, cmd.i_date );
+
+    if( p_storage->i_cmd_w - p_storage->i_cmd_first >= p_storage->i_cmd_max &&
+        TsStorageGrow( p_storage ) )
+    {
+        CmdClean( &cmd );
+        return;
+    }
 
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
+        const ts_block_header_t hdr = {
+            .i_dts        = p_block->i_dts,
+            .i_pts        = p_block->i_pts,
+            .i_length     = p_block->i_length,
+            .i_flags      = p_block->i_flags,
+            .i_nb_samples = p_block->i_nb_samples,
+            .i_buffer     = p_block->i_buffer,
+        };
+        const size_t i_size = sizeof(hdr) + p_block->i_buffer;
+        const int i_offset = TsStorageAlloc( p_storage, i_size );
 
         cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        cmd.u.send.i_offset = -1;
+        cmd.u.send.i_size = i_size;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        if( i_offset >= 0 &&
+            !TsStorageWrite( p_storage, i_offset, &hdr, sizeof(hdr) ) &&
+            !TsStorageWrite( p_storage, i_offset + sizeof(hdr),
+                             p_block->p_buffer, p_block->i_buffer ) )
         {
-            block_Release( p_block );
-            return;
+            cmd.u.send.i_offset = i_offset;
+            p_storage->i_file_w = i_offset + i_size;
         }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
-        }
-        p_storage->i_file_size += p_block->i_buffer;
         block_Release( p_block );
-
-        if( b_flush )
-            fflush( p_storage->p_filew );
     }
-    p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+    *TsStorageCmd( p_storage, p_storage->i_cmd_w++ ) = cmd;
 }
-static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool *pb_skip )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
-    *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
+    const uint64_t i_cmd = p_storage->i_cmd_r++;
+
+    *p_cmd = *TsStorageCmd( p_storage, i_cmd );
+    *pb_skip = i_cmd >= p_storage->i_skip_start && i_cmd < p_storage->i_skip_end;
+    p_storage->i_cmd_busy = i_cmd;
+
     if( p_cmd->i_type == C_SEND )
     {
-        block_t block;
+        ts_block_header_t hdr;
+        block_t *p_block = NULL;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+        if( !*pb_skip && p_cmd->u.send.i_offset >= 0 &&
+            !TsStorageRead( p_storage, p_cmd->u.send.i_offset, &hdr, sizeof(hdr) ) &&
+            (p_block = block_Alloc( hdr.i_buffer )) != NULL )
         {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
+            p_block->i_dts      = hdr.i_dts;
+            p_block->i_pts      = hdr.i_pts;
+            p_block->i_flags    = hdr.i_flags;
+            p_block->i_length   = hdr.i_length;
+            p_block->i_nb_samples = hdr.i_nb_samples;
+            if( TsStorageRead( p_storage, p_cmd->u.send.i_offset + sizeof(hdr),
+                               p_block->p_buffer, hdr.i_buffer ) )
             {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+                block_Release( p_block );
+                p_block = NULL;
             }
-            p_cmd->u.send.p_block = p_block;
         }
+        p_cmd->u.send.p_block = p_block;
+    }
+}
+/* Moves the reader to the first command at or after i_date. *pi_delta gives
+ * the date of the current reading point and returns the jump duration */
+static int TsStorageSeek( ts_storage_t *p_storage, mtime_t i_date, mtime_t *pi_delta )
+{
+    uint64_t i_first = __MAX( p_storage->i_cmd_first, p_storage->i_cmd_data );
+    uint64_t i_low = i_first;
+    uint64_t i_high = p_storage->i_cmd_w;
+
+    if( i_low >= i_high )
+        return VLC_EGENERIC;
+
+    /* Commands are stored by date order */
+    while( i_low < i_high )
+    {
+        const uint64_t i_mid = i_low + (i_high - i_low) / 2;
+        if( TsStorageCmd( p_storage, i_mid )->i_date < i_date )
+            i_low = i_mid + 1;
         else
-        {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
-        }
+            i_high = i_mid;
     }
+    if( i_low >= p_storage->i_cmd_w )
+        i_low = p_storage->i_cmd_w - 1;
+
+    const mtime_t i_read_date = p_storage->i_cmd_r < p_storage->i_cmd_w ?
+                                TsStorageCmd( p_storage, p_storage->i_cmd_r )->i_date :
+                                *pi_delta;
+    *pi_delta = i_read_date - TsStorageCmd( p_storage, i_low )->i_date;
+
+    if( i_low >= p_storage->i_cmd_r )
+    {
+        /* The commands in between are still executed, the blocks dropped */
+        p_storage->i_skip_start = p_storage->i_cmd_r;
+        p_storage->i_skip_end = i_low;
+    }
+    else
+    {
+        /* The commands in between are executed again */
+        p_storage->i_skip_start = __MAX( p_storage->i_skip_start, p_storage->i_cmd_r );
+        p_storage->i_cmd_r = i_low;
+    }
+    return VLC_SUCCESS;
 }
 
 /*****************************************************************************
@@ -1296,6 +1583,7 @@ static void CmdClean( ts_cmd_t *p_cmd )
         CmdCleanControl( p_cmd );
         break;
     case C_DEL:
+        CmdCleanDel( p_cmd );
         break;
     default:
         vlc_assert_unreachable();
@@ -1323,6 +1611,9 @@ static int CmdInitAdd( ts_cmd_t *p_cmd, es_out_id_t *p_es, const es_format_t *p_
 }
 static void CmdExecuteAdd( es_out_t *p_out, ts_cmd_t *p_cmd )
 {
+    /* Already added when moving back in time */
+    if( p_cmd->u.add.p_es->p_es )
+        return;
     p_cmd->u.add.p_es->p_es = es_out_Add( p_out, p_cmd->u.add.p_fmt );
 }
 static void CmdCleanAdd( ts_cmd_t *p_cmd )
@@ -1331,6 +1622,15 @@ static void CmdCleanAdd( ts_cmd_t *p_cmd )
     free( p_cmd->u.add.p_fmt );
 }
 
+/* Returns the es of the destination, adding it again when the commands are
+ * replayed from before its deletion, NULL if it cannot be added */
+static es_out_id_t *CmdGetEs( es_out_t *p_out, es_out_id_t *p_es )
+{
+    if( !p_es->p_es )
+        p_es->p_es = es_out_Add( p_out, &p_es->fmt );
+    return p_es->p_es;
+}
+
 static void CmdInitSend( ts_cmd_t *p_cmd, es_out_id_t *p_es, block_t *p_block )
 {
     p_cmd->i_type = C_SEND;
@@ -1346,8 +1646,9 @@ static int CmdExecuteSend( es_out_t *p_out, ts_cmd_t *p_cmd )
 
     if( p_block )
     {
-        if( p_cmd->u.send.p_es->p_es )
-            return es_out_Send( p_out, p_cmd->u.send.p_es->p_es, p_block );
+        es_out_id_t *p_es = CmdGetEs( p_out, p_cmd->u.send.p_es );
+        if( p_es )
+            return es_out_Send( p_out, p_es, p_block );
         block_Release( p_block );
     }
     return VLC_EGENERIC;
@@ -1369,6 +1670,12 @@ static void CmdExecuteDel( es_out_t *p_out, ts_cmd_t *p_cmd )
 {
     if( p_cmd->u.del.p_es->p_es )
         es_out_Del( p_out, p_cmd->u.del.p_es->p_es );
+    p_cmd->u.del.p_es->p_es = NULL;
+}
+static void CmdCleanDel( ts_cmd_t *p_cmd )
+{
+    /* Commands referencing the es are older, and so already cleaned */
+    es_format_Clean( &p_cmd->u.del.p_es->fmt );
     free( p_cmd->u.del.p_es );
 }
 
@@ -1537,6 +1844,7 @@ static int CmdInitControl( ts_cmd_t *p_cmd, int i_query, va_list args, bool b_co
 static int CmdExecuteControl( es_out_t *p_out, ts_cmd_t *p_cmd )
 {
     const int i_query = p_cmd->u.control.i_query;
+    es_out_id_t *p_es;
 
     switch( i_query )
     {
@@ -1575,7 +1883,10 @@ static int CmdExecuteControl( es_out_t *p_out, ts_cmd_t *p_cmd )
         return es_out_Control( p_out, i_query, p_cmd->u.control.u.i_i64 );
 
     case ES_OUT_SET_ES_SCRAMBLED_STATE: /* arg1=int es_out_id_t* arg2=bool */
-        return es_out_Control( p_out, i_query, p_cmd->u.control.u.es_bool.p_es->p_es,
+        p_es = CmdGetEs( p_out, p_cmd->u.control.u.es_bool.p_es );
+        if( !p_es )
+            return VLC_EGENERIC;
+        return es_out_Control( p_out, i_query, p_es,
                                                p_cmd->u.control.u.es_bool.b_bool );
 
     case ES_OUT_SET_META:  /* arg1=const vlc_meta_t* */
@@ -1585,11 +1896,17 @@ static int CmdExecuteControl( es_out_t *p_out, ts_cmd_t *p_cmd )
     case ES_OUT_SET_ES:      /* arg1= es_out_id_t*                   */
     case ES_OUT_RESTART_ES:  /* arg1= es_out_id_t*                   */
     case ES_OUT_SET_ES_DEFAULT: /* arg1= es_out_id_t*                */
-        return es_out_Control( p_out, i_query, !p_cmd->u.control.u.p_es ? NULL :
-                                               p_cmd->u.control.u.p_es->p_es );
+        p_es = NULL;
+        if( p_cmd->u.control.u.p_es &&
+            !(p_es = CmdGetEs( p_out, p_cmd->u.control.u.p_es )) )
+            return VLC_EGENERIC;
+        return es_out_Control( p_out, i_query, p_es );
 
     case ES_OUT_SET_ES_STATE:/* arg1= es_out_id_t* arg2=bool   */
-        return es_out_Control( p_out, i_query, p_cmd->u.control.u.es_bool.p_es->p_es,
+        p_es = CmdGetEs( p_out, p_cmd->u.control.u.es_bool.p_es );
+        if( !p_es )
+            return VLC_EGENERIC;
+        return es_out_Control( p_out, i_query, p_es,
                                                p_cmd->u.control.u.es_bool.b_bool );
 
     case ES_OUT_SET_ES_CAT_POLICY:
@@ -1597,7 +1914,10 @@ static int CmdExecuteControl( es_out_t *p_out, ts_cmd_t *p_cmd )
                                                p_cmd->u.control.u.es_policy.i_policy );
 
     case ES_OUT_SET_ES_FMT:     /* arg1= es_out_id_t* arg2=es_format_t* */
-        return es_out_Control( p_out, i_query, p_cmd->u.control.u.es_fmt.p_es->p_es,
+        p_es = CmdGetEs( p_out, p_cmd->u.control.u.es_fmt.p_es );
+        if( !p_es )
+            return VLC_EGENERIC;
+        return es_out_Control( p_out, i_query, p_es,
                                                p_cmd->u.control.u.es_fmt.p_fmt );
 
     case ES_OUT_SET_TIMES:
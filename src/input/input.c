@@ -837,6 +837,8 @@ static void InitStatistics( input_thread_t *p_input )
         INIT_COUNTER( lost_pictures, COUNTER );
         INIT_COUNTER( decoded_audio, COUNTER );
         INIT_COUNTER( decoded_video, COUNTER );
+        INIT_COUNTER( hurried_video, COUNTER );
+        INIT_COUNTER( skipped_video, COUNTER );
         INIT_COUNTER( decoded_sub, COUNTER );
         priv->counters.p_sout_send_bitrate = NULL;
         priv->counters.p_sout_sent_packets = NULL;
@@ -1449,6 +1451,8 @@ error:
         EXIT_COUNTER( lost_pictures );
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
+        EXIT_COUNTER( hurried_video );
+        EXIT_COUNTER( skipped_video );
         EXIT_COUNTER( decoded_sub );
 
         if( input_priv(p_input)->p_sout )
@@ -1525,6 +1529,8 @@ do { \
             CL_CO( lost_pictures );
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
+            CL_CO( hurried_video );
+            CL_CO( skipped_video );
             CL_CO( decoded_sub) ;
         }
 
@@ -2047,6 +2053,12 @@ static bool Control( input_thread_t *p_input,
                 }
             }
             if( i_ret )
+            {
+                /* Move within the timeshift buffer of a live stream */
+                i_ret = es_out_Control( input_priv(p_input)->p_es_out,
+                                        ES_OUT_SET_TIMESHIFT_TIME, i_time );
+            }
+            if( i_ret )
             {
                 msg_Warn( p_input, "INPUT_CONTROL_SET_TIME %"PRId64
                          " failed or not possible", i_time );
@@ -157,6 +157,8 @@ typedef struct input_thread_private_t
         counter_t *p_demux_discontinuity;
         counter_t *p_decoded_audio;
         counter_t *p_decoded_video;
+        counter_t *p_hurried_video;
+        counter_t *p_skipped_video;
         counter_t *p_decoded_sub;
         counter_t *p_sout_sent_packets;
         counter_t *p_sout_sent_bytes;
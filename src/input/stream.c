@@ -52,6 +52,7 @@ typedef struct stream_priv_t
     block_t *peek;
     uint64_t offset;
     bool eof;
+    signed char mapped; /* -1 if not known yet */
 
     /* UTF-16 and UTF-32 file reading */
     struct {
@@ -89,6 +90,7 @@ stream_t *vlc_stream_CommonNew(vlc_object_t *parent,
     priv->peek = NULL;
     priv->offset = 0;
     priv->eof = false;
+    priv->mapped = -1;
 
     /* UTF16 and UTF32 text file conversion */
     priv->text.conv = (vlc_iconv_t)(-1);
@@ -688,6 +690,54 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
     return s->pf_control(s, cmd, args);
 }
 
+/* Splits the data of mapped files off their current block */
+static block_t *vlc_stream_ShareBlock( stream_t *s, size_t size )
+{
+    stream_priv_t *priv = (stream_priv_t *)s;
+
+    if( priv->block == NULL )
+    {
+        if( vlc_killed() )
+            return NULL;
+        priv->eof = false;
+        priv->block = s->pf_block( s, &priv->eof );
+        if( priv->block == NULL )
+            return NULL;
+    }
+
+    block_t *block = priv->block;
+
+    if( block->i_buffer < size )
+        return NULL; /* the data must be gathered */
+
+    if( block->i_buffer == size )
+        priv->block = NULL;
+    else
+    {
+        priv->block = block = block_Shareable( block );
+        if( unlikely(block == NULL) )
+            return NULL;
+
+        block = block_Share( priv->block );
+        if( unlikely(block == NULL) )
+            return NULL;
+
+        block->i_buffer = size;
+        priv->block->p_buffer += size;
+        priv->block->i_buffer -= size;
+    }
+
+    /* like copied data, the slice carries none of the source block
+     * properties */
+    block->p_next = NULL;
+    block->i_flags = 0;
+    block->i_nb_samples = 0;
+    block->i_pts = block->i_dts = VLC_TS_INVALID;
+    block->i_length = 0;
+    priv->offset += size;
+    return block;
+}
+
 /**
  * Read data into a block.
  *
@@ -699,9 +749,29 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
  */
 block_t *vlc_stream_Block( stream_t *s, size_t size )
 {
+    stream_priv_t *priv = (stream_priv_t *)s;
+
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
+    /* Data of mapped files is returned without copying if it is in one
+     * piece, which is mostly the case as their blocks are big */
+    if( priv->mapped < 0 )
+    {
+        bool mapped;
+
+        priv->mapped = s->pf_block != NULL
+                    && vlc_stream_Control( s, STREAM_IS_MAPPED, &mapped ) == 0
+                    && mapped;
+    }
+
+    if( priv->mapped && priv->peek == NULL && size > 0 )
+    {
+        block_t *block = vlc_stream_ShareBlock( s, size );
+        if( block != NULL || priv->eof )
+            return block;
+    }
+
     block_t *block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
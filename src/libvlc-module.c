@@ -475,6 +475,23 @@ static const char *const ppsz_pos_descriptions[] =
     "This drops frames that are late (arrive to the video output after " \
     "their intended display date)." )
 
+#define PREPARE_DEPTH_TEXT N_("Pictures prepared ahead")
+#define PREPARE_DEPTH_LONGTEXT N_( \
+    "Number of pictures that are filtered on a separate thread ahead of " \
+    "their display. The subtitles of the next picture are also rendered " \
+    "while the current one is displayed. This avoids dropping frames " \
+    "with heavy video filters on multi-core systems. 0 disables it." )
+
+#define DEADLINE_SKIP_TEXT N_("Predictive decoding shortcuts")
+#define DEADLINE_SKIP_LONGTEXT N_( \
+    "Predicts from the previous decoding times whether the next video " \
+    "frames can be decoded before their display date, and if not asks the " \
+    "decoder to take shortcuts before frames get late." )
+static const int pi_deadline_skip_values[] = { 0, 1, 2 };
+static const char *const ppsz_deadline_skip_descriptions[] = {
+    N_("None"), N_("Skip the loop filter"),
+    N_("Skip the loop filter and non-reference frames") };
+
 #define QUIET_SYNCHRO_TEXT N_("Quiet synchro")
 #define QUIET_SYNCHRO_LONGTEXT N_( \
     "This avoids flooding the message log with debug output from the " \
@@ -647,6 +664,12 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define INPUT_INDEX_CACHE_TEXT N_("Cache seek indexes")
+#define INPUT_INDEX_CACHE_LONGTEXT N_( \
+    "Store the seek indexes built by demuxers for local files in the " \
+    "user cache directory, so that they do not need to be rebuilt the " \
+    "next time the same file is opened." )
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -681,10 +704,17 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
     "Directory used to store the timeshift temporary files." )
 
-#define INPUT_TIMESHIFT_GRANULARITY_TEXT N_("Timeshift granularity")
-#define INPUT_TIMESHIFT_GRANULARITY_LONGTEXT N_( \
-    "This is the maximum size in bytes of the temporary files " \
-    "that will be used to store the timeshifted streams." )
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift size (MiB)")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "This is the size of the temporary file used as a ring buffer " \
+    "to store the timeshifted streams. Once full, the oldest data " \
+    "are overwritten." )
+
+#define INPUT_TIMESHIFT_DURATION_TEXT N_("Timeshift duration")
+#define INPUT_TIMESHIFT_DURATION_LONGTEXT N_( \
+    "Maximum duration in seconds of the already played part of the " \
+    "timeshift buffer that is kept to move back in time " \
+    "(0 for no limit other than the size)." )
 
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
@@ -814,6 +844,21 @@ static const char *const ppsz_prefres[] = {
     "Specify an IP address (e.g. ::1 or 127.0.0.1) or a host name " \
     "(e.g. localhost) to restrict them to a specific network interface." )
 
+#define HTTP_THREADS_TEXT N_( "HTTP streaming threads" )
+#define HTTP_THREADS_LONGTEXT N_( \
+    "Number of threads sending the HTTP streams to their clients. " \
+    "0 selects a value based on the number of processors." )
+
+#define HTTP_BACKLOG_TEXT N_( "HTTP client backlog (kB)" )
+#define HTTP_BACKLOG_LONGTEXT N_( \
+    "Amount of stream data a HTTP client may lag behind before it skips " \
+    "to the most recent data." )
+
+#define HTTP_ZEROCOPY_TEXT N_( "Zero-copy HTTP streaming" )
+#define HTTP_ZEROCOPY_LONGTEXT N_( \
+    "Let the kernel send the HTTP stream data without copying it, " \
+    "where supported. This helps with many clients but pins more memory." )
+
 #define HTTP_PORT_TEXT N_( "HTTP server port" )
 #define HTTP_PORT_LONGTEXT N_( \
     "The HTTP server will listen on this TCP port. " \
@@ -1563,9 +1608,15 @@ vlc_module_begin ()
         change_private ()
     add_bool( "drop-late-frames", 1, DROP_LATE_FRAMES_TEXT,
               DROP_LATE_FRAMES_LONGTEXT, true )
+    add_integer_with_range( "video-prepare-depth", 0, 0, 8,
+                            PREPARE_DEPTH_TEXT, PREPARE_DEPTH_LONGTEXT, true )
     /* Used in vout_synchro */
     add_bool( "skip-frames", 1, SKIP_FRAMES_TEXT,
               SKIP_FRAMES_LONGTEXT, true )
+    add_integer( "video-deadline-skip", 0, DEADLINE_SKIP_TEXT,
+                 DEADLINE_SKIP_LONGTEXT, true )
+        change_integer_list( pi_deadline_skip_values,
+                             ppsz_deadline_skip_descriptions )
     add_bool( "quiet-synchro", 0, QUIET_SYNCHRO_TEXT,
               QUIET_SYNCHRO_LONGTEXT, true )
     add_bool( "keyboard-events", true, KEYBOARD_EVENTS_TEXT,
@@ -1767,6 +1818,8 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_bool( "index-cache", true,
+              INPUT_INDEX_CACHE_TEXT, INPUT_INDEX_CACHE_LONGTEXT, true )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -1800,6 +1853,14 @@ vlc_module_begin ()
         change_integer_range( 1, 65535 )
     add_integer( "https-port", 8443, HTTPS_PORT_TEXT, HTTPS_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
+    add_integer( "http-threads", 0, HTTP_THREADS_TEXT,
+                 HTTP_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 16 )
+    add_integer( "http-client-backlog", 4096, HTTP_BACKLOG_TEXT,
+                 HTTP_BACKLOG_LONGTEXT, true )
+        change_integer_range( 64, 1 << 20 )
+    add_bool( "http-zerocopy", false, HTTP_ZEROCOPY_TEXT,
+              HTTP_ZEROCOPY_LONGTEXT, true )
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT, true )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
@@ -1925,8 +1986,12 @@ vlc_module_begin ()
 
     add_directory( "input-timeshift-path", NULL, INPUT_TIMESHIFT_PATH_TEXT,
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
-    add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
-                 INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_obsolete_integer( "input-timeshift-granularity" ) /* since 3.0.11.1 */
+    add_integer_with_range( "input-timeshift-size", 512, 1, 2047,
+                            INPUT_TIMESHIFT_SIZE_TEXT,
+                            INPUT_TIMESHIFT_SIZE_LONGTEXT, true )
+    add_integer( "input-timeshift-duration", 0, INPUT_TIMESHIFT_DURATION_TEXT,
+                 INPUT_TIMESHIFT_DURATION_LONGTEXT, true )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
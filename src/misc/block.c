@@ -32,6 +32,7 @@
 #include <fcntl.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
 
@@ -145,6 +146,132 @@ block_t *block_Alloc (size_t size)
     return b;
 }
 
+/**
+ * Reference counted payload of shared blocks.
+ * The original block is kept untouched until the last reference is gone.
+ */
+typedef struct
+{
+    atomic_uint refs;
+    block_t    *block;
+} block_payload_t;
+
+typedef struct
+{
+    block_t          self;
+    block_payload_t *payload;
+} block_shared_t;
+
+static void block_shared_Release (block_t *block)
+{
+    block_shared_t *sh = container_of (block, block_shared_t, self);
+    block_payload_t *payload = sh->payload;
+
+    block_Invalidate (block);
+    free (sh);
+
+    if (atomic_fetch_sub_explicit (&payload->refs, 1,
+                                   memory_order_acq_rel) == 1)
+    {
+        block_Release (payload->block);
+        free (payload);
+    }
+}
+
+static bool block_IsShared (const block_t *block)
+{
+    return block->pf_release == block_shared_Release;
+}
+
+/* Whether the payload of a block can be modified in place */
+static bool block_IsWritable (const block_t *block)
+{
+    if (!block_IsShared (block))
+        return true;
+
+    const block_shared_t *sh = container_of (block, block_shared_t, self);
+    return atomic_load_explicit (&sh->payload->refs,
+                                 memory_order_acquire) == 1;
+}
+
+static block_t *block_shared_New (block_payload_t *payload,
+                                  const block_t *ref)
+{
+    block_shared_t *sh = malloc (sizeof (*sh));
+    if (unlikely(sh == NULL))
+        return NULL;
+
+    /* No spare space around the payload: growing it always copies */
+    block_t *block = &sh->self;
+    block_Init (block, ref->p_buffer, ref->i_buffer);
+    block->i_flags = ref->i_flags;
+    block->i_nb_samples = ref->i_nb_samples;
+    block->i_dts = ref->i_dts;
+    block->i_pts = ref->i_pts;
+    block->i_length = ref->i_length;
+    block->pf_release = block_shared_Release;
+    sh->payload = payload;
+    return block;
+}
+
+block_t *block_Shareable (block_t *block)
+{
+    if (block_IsShared (block))
+        return block;
+
+    block_payload_t *payload = malloc (sizeof (*payload));
+    if (unlikely(payload == NULL))
+    {
+        block_Release (block);
+        return NULL;
+    }
+    atomic_init (&payload->refs, 1);
+    payload->block = block;
+
+    block_t *sh = block_shared_New (payload, block);
+    if (unlikely(sh == NULL))
+    {
+        free (payload);
+        block_Release (block);
+        return NULL;
+    }
+
+    sh->p_next = block->p_next;
+    block->p_next = NULL;
+    return sh;
+}
+
+block_t *block_Share (block_t *block)
+{
+    if (!block_IsShared (block))
+        return block_Duplicate (block);
+
+    block_shared_t *sh = container_of (block, block_shared_t, self);
+    block_t *dup = block_shared_New (sh->payload, block);
+    if (likely(dup != NULL))
+        atomic_fetch_add_explicit (&sh->payload->refs, 1,
+                                   memory_order_relaxed);
+    return dup;
+}
+
+block_t *block_Unshare (block_t *block)
+{
+    if (block_IsWritable (block))
+        return block;
+
+    block_t *copy = block_Alloc (block->i_buffer);
+    if (unlikely(copy == NULL))
+    {
+        block_Release (block);
+        return NULL;
+    }
+
+    memcpy (copy->p_buffer, block->p_buffer, block->i_buffer);
+    BlockMetaCopy (copy, block);
+    block_Release (block);
+    return copy;
+}
+
 block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 {
     block_Check( p_block );
@@ -181,7 +308,7 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && block_IsWritable( p_block ) )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -203,10 +330,12 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     uint8_t *p_start = p_block->p_start;
     uint8_t *p_end = p_start + p_block->i_size;
 
-    /* Second, reallocate the buffer if we lack space. */
+    /* Second, reallocate the buffer if we lack space, or if it is shared
+     * with other blocks and cannot be modified. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || ( requested > p_block->i_buffer && !block_IsWritable( p_block ) ) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
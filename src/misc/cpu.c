@@ -127,6 +127,7 @@ void vlc_CPU_init (void)
 
 #if defined( __i386__ ) || defined( __x86_64__ )
      unsigned int i_eax, i_ebx, i_ecx, i_edx;
+     unsigned int i_max_level;
      bool b_amd;
 
     /* Needed for x86 CPU capabilities detection */
@@ -136,13 +137,13 @@ void vlc_CPU_init (void)
                    "cpuid\n\t" \
                    "xchgl %%ebx,%1\n\t" \
                    : "=a" (i_eax), "=r" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # else
 #  define cpuid(reg) \
      asm volatile ("cpuid\n\t" \
                    : "=a" (i_eax), "=b" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # endif
      /* Check if the OS really supports the requested instructions */
@@ -172,6 +173,7 @@ void vlc_CPU_init (void)
 
     /* the CPU supports the CPUID instruction - get its level */
     cpuid( 0x00000000 );
+    i_max_level = i_eax;
 
 # if defined (__i386__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -210,6 +212,29 @@ void vlc_CPU_init (void)
             i_capabilities |= VLC_CPU_SSE4_1;
         if (i_ecx & 0x00100000)
             i_capabilities |= VLC_CPU_SSE4_2;
+
+        /* AVX needs the OS to save the YMM registers (OSXSAVE + XCR0) */
+        if ((i_ecx & 0x18000000) == 0x18000000)
+        {
+            unsigned int i_xcr0_lo, i_xcr0_hi;
+
+            asm volatile ("xgetbv\n\t"
+                          : "=a" (i_xcr0_lo), "=d" (i_xcr0_hi)
+                          : "c" (0));
+            (void) i_xcr0_hi;
+
+            if ((i_xcr0_lo & 0x6) == 0x6)
+            {
+                i_capabilities |= VLC_CPU_AVX;
+
+                if (i_max_level >= 7)
+                {
+                    cpuid( 0x00000007 );
+                    if (i_ebx & 0x00000020)
+                        i_capabilities |= VLC_CPU_AVX2;
+                }
+            }
+        }
     }
 
     /* test for additional capabilities */
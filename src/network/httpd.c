@@ -40,10 +40,12 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
@@ -59,6 +61,18 @@
 #   include <sys/socket.h>
 #endif
 
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_EVENTFD_H)
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+# define HTTPD_WORKERS 1
+# if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) \
+  && defined(HAVE_LINUX_ERRQUEUE_H)
+#  include <netinet/in.h>
+#  include <linux/errqueue.h>
+#  define HTTPD_ZEROCOPY 1
+# endif
+#endif
+
 #if defined(_WIN32)
 /* We need HUGE buffer otherwise TCP throughput is very limited */
 #define HTTPD_CL_BUFSIZE 1000000
@@ -67,7 +81,23 @@
 #endif
 
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+
+/* Stream data is stored once, in chunks shared by all the clients.
+ * Each chunk holds a reference to the next one, so that a client holding its
+ * current chunk can always walk to the most recent data. */
+typedef struct httpd_chunk_t httpd_chunk_t;
+struct httpd_chunk_t
+{
+    atomic_uint    refs;
+    httpd_chunk_t *next;  /* set once, under the stream lock */
+    int64_t        i_pos; /* absolute position of the first byte */
+    size_t         i_size;
+    uint8_t        p_data[];
+};
+
+#ifdef HTTPD_WORKERS
+typedef struct httpd_worker_t httpd_worker_t;
+#endif
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -98,6 +128,15 @@ struct httpd_host_t
 
     /* TLS data */
     vlc_tls_creds_t *p_tls;
+
+#ifdef HTTPD_WORKERS
+    /* streaming clients are moved to the workers once the stream starts;
+     * the workers are created on first use */
+    atomic_uint     i_worker;
+    httpd_worker_t *worker;
+    bool            b_worker_failed;
+    bool            b_zerocopy;
+#endif
 };
 
 
@@ -164,6 +203,30 @@ struct httpd_client_t
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
 
+    /* Stream clients: the stream, once its answer has been sent, and the
+     * position in its data */
+    httpd_stream_t *stream;
+    int64_t         i_stream_pos;
+    httpd_chunk_t  *chunk;  /* chunk containing i_stream_pos, or NULL */
+    bool            b_blocked;
+
+    uint64_t        i_sent;
+    uint64_t        i_dropped;
+    unsigned        i_overruns;
+
+#ifdef HTTPD_ZEROCOPY
+    /* chunks sent with MSG_ZEROCOPY and not yet released by the kernel */
+#define HTTPD_ZEROCOPY_MAX 64
+    bool            b_zerocopy;
+    uint32_t        i_zc_next;
+    unsigned        i_zc_first;
+    unsigned        i_zc_count;
+    struct
+    {
+        uint32_t       id;
+        httpd_chunk_t *chunk;
+    } zc[HTTPD_ZEROCOPY_MAX];
+#endif
 };
 
 
@@ -606,17 +669,161 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* data */
+    httpd_chunk_t *p_first;         /* oldest chunk, the stream holds it */
+    httpd_chunk_t *p_last;          /* most recent chunk */
+    int64_t     i_buffer_size;      /* amount of data kept for the clients */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
+    int64_t     i_backlog;          /* a client lagging more than that skips */
+
+    /* statistics */
+    httpd_stream_stats_t stats;
 
     /* custom headers */
     size_t        i_http_headers;
     httpd_header * p_http_headers;
 };
 
+static httpd_chunk_t *httpd_ChunkNew(const uint8_t *p_data, size_t i_size,
+                                     int64_t i_pos)
+{
+    httpd_chunk_t *chunk = malloc(sizeof(*chunk) + i_size);
+    if (unlikely(chunk == NULL))
+        return NULL;
+
+    atomic_init(&chunk->refs, 1);
+    chunk->next = NULL;
+    chunk->i_pos = i_pos;
+    chunk->i_size = i_size;
+    memcpy(chunk->p_data, p_data, i_size);
+    return chunk;
+}
+
+static httpd_chunk_t *httpd_ChunkHold(httpd_chunk_t *chunk)
+{
+    atomic_fetch_add(&chunk->refs, 1);
+    return chunk;
+}
+
+static void httpd_ChunkRelease(httpd_chunk_t *chunk)
+{
+    /* A chunk that is not referenced anymore is never the last one of its
+     * stream, so its next pointer cannot change anymore. */
+    while (chunk != NULL && atomic_fetch_sub(&chunk->refs, 1) == 1) {
+        httpd_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+/* Moves a client to a new position in the stream data. */
+static void httpd_StreamClientSeek(httpd_client_t *cl, int64_t i_pos)
+{
+    if (cl->chunk != NULL) {
+        httpd_ChunkRelease(cl->chunk);
+        cl->chunk = NULL;
+    }
+    cl->i_stream_pos = i_pos;
+}
+
+/*
+ * Checks where a client stands in the stream and updates its position:
+ * keyframe waiting, lagging too far behind, chunk lookup.
+ * Returns the number of bytes available to the client.
+ * The stream lock must be held.
+ */
+static int64_t httpd_StreamClientUpdate(httpd_stream_t *stream,
+                                        httpd_client_t *cl)
+{
+    if (cl->i_stream_pos >= stream->i_buffer_pos)
+        return 0;    /* wait, no data available */
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            return 0;
+
+        /* seek to the new keyframe */
+        httpd_StreamClientSeek(cl, stream->i_last_keyframe_seen_pos);
+        cl->i_keyframe_wait_to_pass = -1;
+    }
+
+    if (stream->i_buffer_pos - cl->i_stream_pos > stream->i_backlog
+     || cl->i_stream_pos < stream->p_first->i_pos) {
+        /* this client isn't fast enough, but let it finish the current block
+         * first, it is still there */
+        if (cl->chunk != NULL && cl->i_stream_pos > cl->chunk->i_pos
+         && cl->i_stream_pos < cl->chunk->i_pos + (int64_t)cl->chunk->i_size)
+            return cl->chunk->i_pos + cl->chunk->i_size - cl->i_stream_pos;
+
+        /* resume at the latest keyframe if it is still within the backlog,
+         * otherwise skip everything and wait for the next one */
+        int64_t i_resume = stream->i_buffer_last_pos;
+        bool b_wait = false;
+
+        if (stream->b_has_keyframes) {
+            i_resume = stream->i_last_keyframe_seen_pos;
+            if (i_resume <= cl->i_stream_pos
+             || i_resume < stream->p_first->i_pos
+             || stream->i_buffer_pos - i_resume > stream->i_backlog) {
+                i_resume = stream->i_buffer_pos;
+                b_wait = true;
+            }
+        }
+
+        int64_t i_dropped = i_resume - cl->i_stream_pos;
+
+        cl->i_dropped += i_dropped;
+        cl->i_overruns++;
+        stream->stats.i_dropped += i_dropped;
+        stream->stats.i_overruns++;
+        httpd_StreamClientSeek(cl, i_resume);
+
+        if (b_wait) {
+            cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
+            return 0;
+        }
+    }
+
+    if (cl->chunk == NULL) {
+        httpd_chunk_t *chunk = stream->p_first;
+
+        while (chunk->i_pos + (int64_t)chunk->i_size <= cl->i_stream_pos)
+            chunk = chunk->next;
+        cl->chunk = httpd_ChunkHold(chunk);
+    } else if (cl->chunk->i_pos + (int64_t)cl->chunk->i_size
+                                                    == cl->i_stream_pos) {
+        /* the client had reached the end of the data */
+        httpd_chunk_t *chunk = httpd_ChunkHold(cl->chunk->next);
+
+        httpd_ChunkRelease(cl->chunk);
+        cl->chunk = chunk;
+    }
+
+    return stream->i_buffer_pos - cl->i_stream_pos;
+}
+
+/* Advances a client after some data was sent. The chunks up to the new
+ * position must have been reached from the client chunk. */
+static void httpd_StreamClientAdvance(httpd_client_t *cl, size_t i_len)
+{
+    httpd_chunk_t *chunk = cl->chunk;
+
+    cl->i_stream_pos += i_len;
+    cl->i_sent += i_len;
+
+    while (chunk->i_pos + (int64_t)chunk->i_size <= cl->i_stream_pos
+        && chunk->next != NULL)
+        chunk = chunk->next;
+
+    if (chunk != cl->chunk) {
+        httpd_ChunkHold(chunk);
+        httpd_ChunkRelease(cl->chunk);
+        cl->chunk = chunk;
+    }
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -627,34 +834,17 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        vlc_mutex_lock(&stream->lock);
+        cl->i_stream_pos = answer->i_body_offset;
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
+        int64_t i_write = httpd_StreamClientUpdate(stream, cl);
+        if (i_write <= 0) {
+            vlc_mutex_unlock(&stream->lock);
             return VLC_EGENERIC;    /* wait, no data available */
-
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
-
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
         if (i_write > HTTPD_CL_BUFSIZE)
             i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
@@ -663,9 +853,24 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         answer->i_body = i_write;
         answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
 
-        answer->i_body_offset += i_write;
+        /* This is the only copy for clients served by the host thread */
+        httpd_chunk_t *chunk = cl->chunk;
+        size_t i_offset = cl->i_stream_pos - chunk->i_pos;
+        for (int64_t i_copied = 0; i_copied < i_write; ) {
+            size_t i_copy = __MIN(chunk->i_size - i_offset,
+                                  (size_t)(i_write - i_copied));
+
+            memcpy(&answer->p_body[i_copied], &chunk->p_data[i_offset], i_copy);
+            i_copied += i_copy;
+            i_offset = 0;
+            chunk = chunk->next;
+        }
+        httpd_StreamClientAdvance(cl, i_write);
+        stream->stats.i_sent += i_write;
+
+        answer->i_body_offset = cl->i_stream_pos;
+        vlc_mutex_unlock(&stream->lock);
 
         return VLC_SUCCESS;
     } else {
@@ -705,6 +910,10 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
             else
                 cl->i_keyframe_wait_to_pass = -1;
+            if (cl->stream == NULL) {
+                cl->stream = stream;
+                stream->stats.i_clients++;
+            }
             vlc_mutex_unlock(&stream->lock);
         } else {
             httpd_MsgAdd(answer, "Content-Length", "0");
@@ -764,7 +973,12 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc(stream->i_buffer_size);
+    stream->i_backlog = INT64_C(1024) *
+                        var_InheritInteger(host, "http-client-backlog");
+    if (stream->i_backlog <= 0 || stream->i_backlog > stream->i_buffer_size)
+        stream->i_backlog = stream->i_buffer_size;
+    stream->p_first = NULL;
+    stream->p_last = NULL;
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -773,6 +987,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_last_keyframe_seen_pos = 0;
     stream->i_http_headers = 0;
     stream->p_http_headers = NULL;
+    memset(&stream->stats, 0, sizeof(stream->stats));
 
     httpd_UrlCatch(stream->url, HTTPD_MSG_HEAD, httpd_StreamCallBack,
                     (httpd_callback_sys_t*)stream);
@@ -800,31 +1015,27 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
-{
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
-
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
-
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
-    }
-
-    stream->i_buffer_pos += i_data;
-}
+#ifdef HTTPD_WORKERS
+static void httpd_WorkersWake(httpd_host_t *);
+static void httpd_WorkersDetachStream(httpd_host_t *, httpd_stream_t *);
+static void httpd_HostStopWorkers(httpd_host_t *);
+#endif
 
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 {
-    if (!p_block || !p_block->p_buffer)
+    if (!p_block || !p_block->p_buffer || p_block->i_buffer == 0)
         return VLC_SUCCESS;
 
     vlc_mutex_lock(&stream->lock);
 
+    httpd_chunk_t *chunk = httpd_ChunkNew(p_block->p_buffer,
+                                          p_block->i_buffer,
+                                          stream->i_buffer_pos);
+    if (unlikely(chunk == NULL)) {
+        vlc_mutex_unlock(&stream->lock);
+        return VLC_ENOMEM;
+    }
+
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
 
@@ -833,15 +1044,50 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    /* the previous chunk holds the reference */
+    if (stream->p_last != NULL)
+        stream->p_last->next = chunk;
+    else
+        stream->p_first = chunk;
+    stream->p_last = chunk;
+    stream->i_buffer_pos += p_block->i_buffer;
+
+    /* forget the oldest data, clients still sending it keep it alive */
+    while (stream->p_first != stream->p_last
+        && stream->i_buffer_pos - stream->p_first->next->i_pos
+                                                    >= stream->i_buffer_size) {
+        httpd_chunk_t *first = stream->p_first;
+
+        stream->p_first = httpd_ChunkHold(first->next);
+        httpd_ChunkRelease(first);
+    }
 
     vlc_mutex_unlock(&stream->lock);
+
+#ifdef HTTPD_WORKERS
+    httpd_WorkersWake(stream->url->host);
+#endif
     return VLC_SUCCESS;
 }
 
+void httpd_StreamGetStats(httpd_stream_t *stream, httpd_stream_stats_t *stats)
+{
+    vlc_mutex_lock(&stream->lock);
+    *stats = stream->stats;
+    vlc_mutex_unlock(&stream->lock);
+}
+
 void httpd_StreamDelete(httpd_stream_t *stream)
 {
+#ifdef HTTPD_WORKERS
+    httpd_host_t *host = stream->url->host;
+#endif
+
+    /* No more clients can start the stream after this */
     httpd_UrlDelete(stream->url);
+#ifdef HTTPD_WORKERS
+    httpd_WorkersDetachStream(host, stream);
+#endif
     for (size_t i = 0; i < stream->i_http_headers; i++) {
         free(stream->p_http_headers[i].name);
         free(stream->p_http_headers[i].value);
@@ -850,7 +1096,7 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    httpd_ChunkRelease(stream->p_first);
     free(stream);
 }
 
@@ -964,6 +1210,12 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->i_client = 0;
     host->client   = NULL;
     host->p_tls    = p_tls;
+#ifdef HTTPD_WORKERS
+    atomic_init(&host->i_worker, 0);
+    host->worker   = NULL;
+    host->b_worker_failed = false;
+    host->b_zerocopy = var_InheritBool(p_this, "http-zerocopy");
+#endif
 
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
@@ -1014,6 +1266,9 @@ void httpd_HostDelete(httpd_host_t *host)
 
     vlc_cancel(host->thread);
     vlc_join(host->thread, NULL);
+#ifdef HTTPD_WORKERS
+    httpd_HostStopWorkers(host);
+#endif
 
     msg_Dbg(host, "HTTP host removed");
 
@@ -1190,6 +1445,20 @@ static void httpd_ClientInit(httpd_client_t *cl, mtime_t now)
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
 
+    cl->stream = NULL;
+    cl->i_stream_pos = 0;
+    cl->chunk = NULL;
+    cl->b_blocked = false;
+    cl->i_sent = 0;
+    cl->i_dropped = 0;
+    cl->i_overruns = 0;
+#ifdef HTTPD_ZEROCOPY
+    cl->b_zerocopy = false;
+    cl->i_zc_next = 0;
+    cl->i_zc_first = 0;
+    cl->i_zc_count = 0;
+#endif
+
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
 }
@@ -1204,8 +1473,27 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
     return net_GetSockAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
 }
 
+void httpd_ClientModeStream(httpd_client_t *cl)
+{
+    cl->b_stream_mode = true;
+}
+
 static void httpd_ClientDestroy(httpd_client_t *cl)
 {
+    if (cl->stream != NULL) {
+        httpd_stream_t *stream = cl->stream;
+
+        vlc_mutex_lock(&stream->lock);
+        stream->stats.i_clients--;
+        vlc_mutex_unlock(&stream->lock);
+    }
+    if (cl->chunk != NULL)
+        httpd_ChunkRelease(cl->chunk);
+#ifdef HTTPD_ZEROCOPY
+    for (unsigned i = 0; i < cl->i_zc_count; i++)
+        httpd_ChunkRelease(cl->zc[(cl->i_zc_first + i) % HTTPD_ZEROCOPY_MAX].chunk);
+#endif
+
     vlc_tls_Close(cl->sock);
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
@@ -1698,6 +1986,470 @@ auth_failed:
     return false;
 }
 
+#ifdef HTTPD_WORKERS
+/*****************************************************************************
+ * Stream workers
+ *****************************************************************************
+ * Once the answer and the stream header have been sent, the clients of a
+ * plain HTTP stream are moved from the host thread to one of the workers.
+ * Each worker waits for its sockets with epoll, and sends the stream chunks
+ * to them with scatter-gather I/O, without copying.
+ *****************************************************************************/
+#define HTTPD_WORKER_EVENTS 64
+#define HTTPD_WORKER_MAX    16
+#define HTTPD_SEND_IOV      64
+#define HTTPD_SEND_MAX      (1 << 20)
+#define HTTPD_ZEROCOPY_MIN  16384
+
+struct httpd_worker_t
+{
+    httpd_host_t    *host;
+    vlc_thread_t     thread;
+    vlc_mutex_t      lock;
+    vlc_cond_t       wait;  /* signaled when clients have been removed */
+    int              epfd;
+    int              evfd;  /* wakes the worker up */
+    bool             b_exit;
+
+    int              i_client;
+    httpd_client_t **client;
+};
+
+static void httpd_WorkerWake(httpd_worker_t *w)
+{
+    const uint64_t val = 1;
+    ssize_t ret = write(w->evfd, &val, sizeof (val));
+
+    assert(ret == sizeof (val));
+    (void) ret;
+}
+
+static void httpd_WorkersWake(httpd_host_t *host)
+{
+    unsigned count = atomic_load(&host->i_worker);
+
+    for (unsigned i = 0; i < count; i++)
+        httpd_WorkerWake(&host->worker[i]);
+}
+
+static int httpd_WorkerWatch(httpd_worker_t *w, httpd_client_t *cl, int op)
+{
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLRDHUP | (cl->b_blocked ? EPOLLOUT : 0),
+        .data = { .ptr = cl },
+    };
+
+    return epoll_ctl(w->epfd, op, vlc_tls_GetFD(cl->sock), &ev);
+}
+
+#ifdef HTTPD_ZEROCOPY
+/* Releases the chunks of the MSG_ZEROCOPY sends completed by the kernel */
+static int httpd_ClientZerocopyDone(httpd_client_t *cl)
+{
+    int fd = vlc_tls_GetFD(cl->sock);
+
+    for (;;) {
+        union {
+            char buf[CMSG_SPACE(sizeof (struct sock_extended_err)) + 64];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg = {
+            .msg_control = control.buf,
+            .msg_controllen = sizeof (control.buf),
+        };
+
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return errno == EAGAIN ? 0 : -1;
+
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+             && !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+                continue;
+
+            const struct sock_extended_err *err =
+                (const struct sock_extended_err *)CMSG_DATA(cmsg);
+            if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                return -1; /* actual socket error */
+
+            /* sends up to ee_data are complete */
+            while (cl->i_zc_count > 0
+                && (int32_t)(err->ee_data - cl->zc[cl->i_zc_first].id) >= 0) {
+                httpd_ChunkRelease(cl->zc[cl->i_zc_first].chunk);
+                cl->i_zc_first = (cl->i_zc_first + 1) % HTTPD_ZEROCOPY_MAX;
+                cl->i_zc_count--;
+            }
+        }
+    }
+}
+#endif
+
+/*
+ * Sends the available stream data to a client.
+ * Returns the number of bytes sent, 0 if there is nothing to send or the
+ * socket is full, -1 if the connection failed.
+ */
+static ssize_t httpd_WorkerSend(httpd_client_t *cl)
+{
+    httpd_stream_t *stream = cl->stream;
+    struct iovec iov[HTTPD_SEND_IOV];
+    unsigned n = 0;
+    size_t i_total = 0;
+
+    vlc_mutex_lock(&stream->lock);
+    int64_t i_avail = httpd_StreamClientUpdate(stream, cl);
+    if (i_avail > 0) {
+        httpd_chunk_t *chunk = cl->chunk;
+        size_t i_offset = cl->i_stream_pos - chunk->i_pos;
+
+        /* The client reference to its chunk keeps all the next ones alive,
+         * the lock is not needed while sending. */
+        while (chunk != NULL && n < HTTPD_SEND_IOV && i_total < HTTPD_SEND_MAX
+            && (int64_t)i_total < i_avail) {
+            iov[n].iov_base = chunk->p_data + i_offset;
+            iov[n].iov_len = __MIN(chunk->i_size - i_offset,
+                                   (size_t)(i_avail - i_total));
+            i_total += iov[n].iov_len;
+            n++;
+            i_offset = 0;
+            chunk = chunk->next;
+        }
+    }
+    vlc_mutex_unlock(&stream->lock);
+
+    if (n == 0)
+        return 0;
+
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = n };
+    int flags = MSG_NOSIGNAL;
+#ifdef HTTPD_ZEROCOPY
+    const bool b_zerocopy = cl->b_zerocopy && i_total >= HTTPD_ZEROCOPY_MIN
+                         && cl->i_zc_count < HTTPD_ZEROCOPY_MAX;
+    if (b_zerocopy)
+        flags |= MSG_ZEROCOPY;
+#endif
+
+    ssize_t val = sendmsg(vlc_tls_GetFD(cl->sock), &msg, flags);
+    if (val < 0) {
+#ifdef HTTPD_ZEROCOPY
+        if (b_zerocopy && errno == ENOBUFS) {
+            /* out of pinned memory, copy from now on */
+            cl->b_zerocopy = false;
+            return httpd_WorkerSend(cl);
+        }
+#endif
+        if (errno == EAGAIN) {
+            cl->b_blocked = true;
+            return 0;
+        }
+        return -1;
+    }
+
+#ifdef HTTPD_ZEROCOPY
+    if (b_zerocopy) {
+        /* the kernel reads the data until the send completes */
+        unsigned i = (cl->i_zc_first + cl->i_zc_count++) % HTTPD_ZEROCOPY_MAX;
+
+        cl->zc[i].id = cl->i_zc_next++;
+        cl->zc[i].chunk = httpd_ChunkHold(cl->chunk);
+    }
+#endif
+
+    vlc_mutex_lock(&stream->lock);
+    httpd_StreamClientAdvance(cl, val);
+    stream->stats.i_sent += val;
+    vlc_mutex_unlock(&stream->lock);
+
+    if ((size_t)val < i_total)
+        cl->b_blocked = true; /* socket buffer full */
+    return val;
+}
+
+static void httpd_WorkerEvent(httpd_client_t *cl, uint32_t events)
+{
+    if (events & EPOLLERR) {
+#ifdef HTTPD_ZEROCOPY
+        if (!cl->b_zerocopy && cl->i_zc_count == 0)
+            cl->i_state = HTTPD_CLIENT_DEAD;
+        else if (httpd_ClientZerocopyDone(cl))
+#endif
+            cl->i_state = HTTPD_CLIENT_DEAD;
+    }
+
+    if (events & (EPOLLHUP | EPOLLRDHUP))
+        cl->i_state = HTTPD_CLIENT_DEAD;
+
+    if (events & EPOLLIN) {
+        /* nothing is expected from a stream client */
+        uint8_t buf[256];
+
+        if (recv(vlc_tls_GetFD(cl->sock), buf, sizeof (buf), MSG_DONTWAIT) == 0)
+            cl->i_state = HTTPD_CLIENT_DEAD;
+    }
+
+    if (events & EPOLLOUT)
+        cl->b_blocked = false;
+}
+
+static void httpd_WorkerRemove(httpd_worker_t *w, httpd_client_t *cl)
+{
+    char ip[NI_MAXNUMERICHOST];
+    int port;
+
+    if (httpd_ClientIP(cl, ip, &port) == NULL)
+        strcpy(ip, "?");
+    msg_Dbg(w->host, "stream client %s closed: %"PRIu64" bytes sent, "
+            "%u overrun(s), %"PRIu64" bytes skipped", ip, cl->i_sent,
+            cl->i_overruns, cl->i_dropped);
+
+    TAB_REMOVE(w->i_client, w->client, cl);
+    epoll_ctl(w->epfd, EPOLL_CTL_DEL, vlc_tls_GetFD(cl->sock), NULL);
+    httpd_ClientDestroy(cl);
+}
+
+static void *httpd_WorkerThread(void *data)
+{
+    httpd_worker_t *w = data;
+    struct epoll_event ev[HTTPD_WORKER_EVENTS];
+
+    vlc_mutex_lock(&w->lock);
+    while (!w->b_exit) {
+        vlc_mutex_unlock(&w->lock);
+        /* wake up regularly to check the timeouts */
+        int n = epoll_wait(w->epfd, ev, HTTPD_WORKER_EVENTS, 1000);
+        if (n < 0) {
+            if (errno != EINTR)
+                msg_Err(w->host, "polling error: %s", vlc_strerror_c(errno));
+            n = 0;
+        }
+        vlc_mutex_lock(&w->lock);
+
+        for (int i = 0; i < n; i++) {
+            httpd_client_t *cl = ev[i].data.ptr;
+
+            if (cl == NULL) {
+                uint64_t val;
+
+                if (read(w->evfd, &val, sizeof (val)) < 0)
+                    assert(errno == EAGAIN);
+                continue;
+            }
+            /* Clients are only removed below, so cl is still valid */
+            httpd_WorkerEvent(cl, ev[i].events);
+        }
+
+        mtime_t now = mdate();
+        bool b_removed = false;
+
+        for (int i = 0; i < w->i_client; i++) {
+            httpd_client_t *cl = w->client[i];
+            const bool b_blocked = cl->b_blocked;
+
+            while (cl->i_state != HTTPD_CLIENT_DEAD && !cl->b_blocked) {
+                ssize_t val = httpd_WorkerSend(cl);
+
+                if (val < 0)
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                if (val <= 0)
+                    break;
+                cl->i_activity_date = now;
+            }
+
+            if (cl->i_state == HTTPD_CLIENT_DEAD
+             || (cl->b_blocked && cl->i_activity_timeout > 0
+              && cl->i_activity_date + cl->i_activity_timeout < now)) {
+                httpd_WorkerRemove(w, cl);
+                b_removed = true;
+                i--;
+                continue;
+            }
+
+            if (cl->b_blocked != b_blocked)
+                httpd_WorkerWatch(w, cl, EPOLL_CTL_MOD);
+        }
+
+        if (b_removed)
+            vlc_cond_broadcast(&w->wait);
+    }
+    vlc_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+static void httpd_WorkerClean(httpd_worker_t *w)
+{
+    vlc_close(w->evfd);
+    vlc_close(w->epfd);
+    vlc_cond_destroy(&w->wait);
+    vlc_mutex_destroy(&w->lock);
+}
+
+static int httpd_WorkerInit(httpd_host_t *host, httpd_worker_t *w)
+{
+    w->host = host;
+    w->b_exit = false;
+    w->i_client = 0;
+    w->client = NULL;
+
+    w->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (w->epfd == -1)
+        return VLC_EGENERIC;
+
+    w->evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (w->evfd == -1) {
+        vlc_close(w->epfd);
+        return VLC_EGENERIC;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data = { .ptr = NULL } };
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->evfd, &ev)) {
+        vlc_close(w->evfd);
+        vlc_close(w->epfd);
+        return VLC_EGENERIC;
+    }
+
+    vlc_mutex_init(&w->lock);
+    vlc_cond_init(&w->wait);
+
+    if (vlc_clone(&w->thread, httpd_WorkerThread, w,
+                  VLC_THREAD_PRIORITY_LOW)) {
+        httpd_WorkerClean(w);
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Starts the workers on first use. The host lock must be held. */
+static unsigned httpd_HostStartWorkers(httpd_host_t *host)
+{
+    unsigned count = atomic_load(&host->i_worker);
+    if (count > 0 || host->b_worker_failed)
+        return count;
+
+    int64_t val = var_InheritInteger(host, "http-threads");
+    count = val > 0 ? val : __MIN(vlc_GetCPUCount(), 4);
+    count = VLC_CLIP(count, 1, HTTPD_WORKER_MAX);
+
+    host->worker = vlc_alloc(count, sizeof (*host->worker));
+    if (host->worker == NULL) {
+        host->b_worker_failed = true;
+        return 0;
+    }
+
+    unsigned i;
+    for (i = 0; i < count; i++)
+        if (httpd_WorkerInit(host, &host->worker[i]))
+            break;
+
+    if (i == 0) {
+        msg_Err(host, "cannot start the HTTP stream workers");
+        free(host->worker);
+        host->worker = NULL;
+        host->b_worker_failed = true;
+        return 0;
+    }
+
+    msg_Dbg(host, "%u HTTP stream worker(s) started", i);
+    atomic_store(&host->i_worker, i);
+    return i;
+}
+
+static void httpd_HostStopWorkers(httpd_host_t *host)
+{
+    unsigned count = atomic_load(&host->i_worker);
+
+    for (unsigned i = 0; i < count; i++) {
+        httpd_worker_t *w = &host->worker[i];
+
+        vlc_mutex_lock(&w->lock);
+        w->b_exit = true;
+        vlc_mutex_unlock(&w->lock);
+        httpd_WorkerWake(w);
+        vlc_join(w->thread, NULL);
+
+        while (w->i_client > 0)
+            httpd_WorkerRemove(w, w->client[0]);
+        httpd_WorkerClean(w);
+    }
+    free(host->worker);
+}
+
+/* Moves a stream client to the least loaded worker. The host lock must be
+ * held. */
+static bool httpd_WorkerAdd(httpd_host_t *host, httpd_client_t *cl)
+{
+    unsigned count = httpd_HostStartWorkers(host);
+    httpd_worker_t *w = NULL;
+    int i_min = INT_MAX;
+
+    for (unsigned i = 0; i < count; i++) {
+        vlc_mutex_lock(&host->worker[i].lock);
+        if (host->worker[i].i_client < i_min) {
+            w = &host->worker[i];
+            i_min = w->i_client;
+        }
+        vlc_mutex_unlock(&host->worker[i].lock);
+    }
+    if (w == NULL)
+        return false;
+
+    vlc_mutex_lock(&w->lock);
+    cl->b_blocked = false;
+    if (httpd_WorkerWatch(w, cl, EPOLL_CTL_ADD)) {
+        vlc_mutex_unlock(&w->lock);
+        return false;
+    }
+
+#ifdef HTTPD_ZEROCOPY
+    if (host->b_zerocopy)
+        cl->b_zerocopy = setsockopt(vlc_tls_GetFD(cl->sock), SOL_SOCKET,
+                                    SO_ZEROCOPY, &(int){ 1 }, sizeof (int)) == 0;
+#endif
+
+    /* the stream data now goes directly from the chunks to the socket */
+    cl->i_stream_pos = cl->answer.i_body_offset;
+    httpd_MsgClean(&cl->answer);
+    free(cl->p_buffer);
+    cl->p_buffer = NULL;
+    cl->i_buffer = 0;
+    cl->i_buffer_size = 0;
+    cl->i_state = HTTPD_CLIENT_SENDING;
+
+    TAB_APPEND(w->i_client, w->client, cl);
+    vlc_mutex_unlock(&w->lock);
+
+    httpd_WorkerWake(w);
+    return true;
+}
+
+/* Closes the worker clients of a stream being deleted */
+static void httpd_WorkersDetachStream(httpd_host_t *host,
+                                      httpd_stream_t *stream)
+{
+    unsigned count = atomic_load(&host->i_worker);
+
+    for (unsigned i = 0; i < count; i++) {
+        httpd_worker_t *w = &host->worker[i];
+        bool b_found;
+
+        vlc_mutex_lock(&w->lock);
+        do {
+            b_found = false;
+            for (int j = 0; j < w->i_client; j++)
+                if (w->client[j]->stream == stream) {
+                    w->client[j]->i_state = HTTPD_CLIENT_DEAD;
+                    b_found = true;
+                }
+
+            if (b_found) {
+                httpd_WorkerWake(w);
+                vlc_cond_wait(&w->wait, &w->lock);
+            }
+        } while (b_found);
+        vlc_mutex_unlock(&w->lock);
+    }
+}
+#endif
+
 static void httpdLoop(httpd_host_t *host)
 {
     struct pollfd ufd[host->nfd + host->i_client];
@@ -1943,6 +2695,14 @@ static void httpdLoop(httpd_host_t *host)
                         cl->i_state = HTTPD_CLIENT_DEAD;
                     httpd_MsgClean(&cl->answer);
                 } else {
+#ifdef HTTPD_WORKERS
+                    if (cl->stream != NULL && host->p_tls == NULL
+                     && httpd_WorkerAdd(host, cl)) {
+                        TAB_REMOVE(host->i_client, host->client, cl);
+                        i_client--;
+                        continue;
+                    }
+#endif
                     int64_t i_offset = cl->answer.i_body_offset;
                     httpd_MsgClean(&cl->answer);
 
@@ -0,0 +1,240 @@
+/*****************************************************************************
+ * timeshift.c: test the replay of src/input/es_out_timeshift.c commands
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../input/es_out_timeshift.c"
+
+#undef NDEBUG
+#include <assert.h>
+
+const char vlc_module_name[] = "test_timeshift";
+
+/* Not exported by libvlccore, and not reached by the commands tested */
+void input_ControlPush( input_thread_t *p_input, int i_type, vlc_value_t *p_val )
+{
+    (void) p_input; (void) i_type; (void) p_val;
+    abort();
+}
+
+#ifndef vlc_assert_locked /* not a no-op macro in debug builds */
+void vlc_assert_locked( vlc_mutex_t *p_mutex )
+{
+    (void) p_mutex;
+}
+#endif
+
+/* Destination es_out, checking the es it is given. The counters are
+ * updated by the timeshift thread. */
+static vlc_mutex_t dest_lock = VLC_STATIC_MUTEX;
+static vlc_cond_t dest_wait = VLC_STATIC_COND;
+static int i_added;
+static int i_deleted;
+static int i_sent;
+static es_out_id_t dest_es;
+
+static es_out_id_t *DestAdd( es_out_t *out, const es_format_t *fmt )
+{
+    (void) out;
+    assert( fmt->i_cat == AUDIO_ES );
+    vlc_mutex_lock( &dest_lock );
+    assert( i_added == i_deleted );
+    i_added++;
+    vlc_mutex_unlock( &dest_lock );
+    return &dest_es;
+}
+
+static int DestSend( es_out_t *out, es_out_id_t *es, block_t *block )
+{
+    (void) out;
+    assert( es == &dest_es );
+    vlc_mutex_lock( &dest_lock );
+    assert( i_added == i_deleted + 1 );
+    i_sent++;
+    vlc_mutex_unlock( &dest_lock );
+    block_Release( block );
+    return VLC_SUCCESS;
+}
+
+static void DestDel( es_out_t *out, es_out_id_t *es )
+{
+    (void) out;
+    assert( es == &dest_es );
+    vlc_mutex_lock( &dest_lock );
+    i_deleted++;
+    assert( i_added == i_deleted );
+    vlc_cond_signal( &dest_wait );
+    vlc_mutex_unlock( &dest_lock );
+}
+
+static int DestControl( es_out_t *out, int query, va_list args )
+{
+    (void) out;
+    switch( query )
+    {
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+        case ES_OUT_SET_ES_FMT:
+            assert( va_arg( args, es_out_id_t * ) == &dest_es );
+            vlc_mutex_lock( &dest_lock );
+            assert( i_added == i_deleted + 1 );
+            vlc_mutex_unlock( &dest_lock );
+            break;
+        case ES_OUT_GET_BUFFERING:
+            *va_arg( args, bool * ) = false;
+            break;
+        default:
+            break;
+    }
+    return VLC_SUCCESS;
+}
+
+static es_out_t dest = {
+    .pf_add     = DestAdd,
+    .pf_send    = DestSend,
+    .pf_del     = DestDel,
+    .pf_control = DestControl,
+};
+
+static void Push( ts_thread_t *p_ts, ts_cmd_t *cmd, mtime_t date )
+{
+    cmd->i_date = date;
+    TsPushCmd( p_ts, cmd );
+}
+
+static void PushControl( ts_thread_t *p_ts, mtime_t date, int query, ... )
+{
+    ts_cmd_t cmd;
+    va_list args;
+
+    va_start( args, query );
+    int ret = CmdInitControl( &cmd, query, args, true );
+    va_end( args );
+    assert( ret == VLC_SUCCESS );
+    Push( p_ts, &cmd, date );
+}
+
+/* Waits for the timeshift thread to have deleted the es a number of times */
+static void WaitDeleted( int i_count )
+{
+    vlc_mutex_lock( &dest_lock );
+    while( i_deleted < i_count )
+        vlc_cond_wait( &dest_wait, &dest_lock );
+    vlc_mutex_unlock( &dest_lock );
+}
+
+/* Starts the timeshift thread like TsStart does, without es_out_sys_t */
+static ts_thread_t *Start( input_thread_t *p_input )
+{
+    ts_thread_t *p_ts = calloc( 1, sizeof (*p_ts) );
+    assert( p_ts != NULL );
+
+    p_ts->i_tmp_size_max = 1 << 20;
+    p_ts->i_tmp_duration_max = 0;
+    p_ts->psz_tmp_path = NULL;
+    p_ts->p_input = p_input;
+    p_ts->p_out = &dest;
+    vlc_mutex_init( &p_ts->lock );
+    vlc_cond_init( &p_ts->wait );
+    p_ts->b_paused = false;
+    p_ts->i_pause_date = -1;
+    p_ts->i_rate_source = p_ts->i_rate = INPUT_RATE_DEFAULT;
+    p_ts->i_rate_date = -1;
+    p_ts->p_storage = NULL;
+    p_ts->i_skip_date = -1;
+    p_ts->i_time_ref = -1;
+    p_ts->i_time_ref_date = -1;
+
+    int ret = vlc_clone( &p_ts->thread, TsRun, p_ts,
+                         VLC_THREAD_PRIORITY_INPUT );
+    assert( ret == 0 );
+    return p_ts;
+}
+
+static void test_replay_deleted_es( void )
+{
+    /* only used to log, quietly */
+    input_thread_t input = { .obj = { .flags = OBJECT_FLAGS_QUIET } };
+    ts_thread_t *p_ts = Start( &input );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, AUDIO_ES, VLC_CODEC_MPGA );
+
+    es_out_id_t *es = malloc( sizeof (*es) );
+    assert( es != NULL );
+    es->p_es = NULL;
+    es_format_Copy( &es->fmt, &fmt );
+
+    /* The stream time is the date offset of the commands */
+    ts_cmd_t cmd;
+    const mtime_t base = mdate();
+    mtime_t date = base;
+
+    PushControl( p_ts, date++, ES_OUT_SET_TIMES, 0., (mtime_t)0, (mtime_t)0 );
+    CmdInitAdd( &cmd, es, &fmt, true );
+    Push( p_ts, &cmd, date++ );
+    for( int i = 0; i < 10; i++ )
+    {
+        block_t *block = block_Alloc( 100 );
+        assert( block != NULL );
+        memset( block->p_buffer, i, block->i_buffer );
+        CmdInitSend( &cmd, es, block );
+        Push( p_ts, &cmd, date++ );
+
+        if( i == 5 )
+        {
+            PushControl( p_ts, date++, ES_OUT_SET_ES_STATE, es, true );
+            PushControl( p_ts, date++, ES_OUT_SET_ES_SCRAMBLED_STATE, es,
+                         false );
+            PushControl( p_ts, date++, ES_OUT_SET_ES_FMT, es, &fmt );
+        }
+    }
+    CmdInitDel( &cmd, es );
+    Push( p_ts, &cmd, date++ );
+
+    WaitDeleted( 1 );
+    vlc_mutex_lock( &dest_lock );
+    assert( i_added == 1 && i_sent == 10 );
+    vlc_mutex_unlock( &dest_lock );
+
+    /* Go back before the controls, after the es was added */
+    int ret = TsChangeTime( p_ts, 4 );
+    assert( ret == VLC_SUCCESS );
+    WaitDeleted( 2 );
+    vlc_mutex_lock( &dest_lock );
+    assert( i_added == 2 && i_sent == 10 + 8 );
+    vlc_mutex_unlock( &dest_lock );
+
+    /* Go back before the es was added */
+    ret = TsChangeTime( p_ts, 0 );
+    assert( ret == VLC_SUCCESS );
+    WaitDeleted( 3 );
+    vlc_mutex_lock( &dest_lock );
+    assert( i_added == 3 && i_sent == 18 + 10 );
+    vlc_mutex_unlock( &dest_lock );
+
+    /* the es is released with the stored deletion command */
+    TsStop( p_ts );
+    es_format_Clean( &fmt );
+}
+
+int main( void )
+{
+    test_replay_deleted_es();
+    return 0;
+}
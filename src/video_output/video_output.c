@@ -112,6 +112,20 @@ static bool VideoFormatIsCropArEqual(video_format_t *dst,
            dst->i_visible_width  == src->i_visible_width &&
            dst->i_visible_height == src->i_visible_height;
 }
+static bool VideoFormatIsRenderEqual(const video_format_t *a,
+                                     const video_format_t *b)
+{
+    return a->i_chroma         == b->i_chroma &&
+           a->i_width          == b->i_width &&
+           a->i_height         == b->i_height &&
+           a->i_x_offset       == b->i_x_offset &&
+           a->i_y_offset       == b->i_y_offset &&
+           a->i_visible_width  == b->i_visible_width &&
+           a->i_visible_height == b->i_visible_height &&
+           a->i_sar_num        == b->i_sar_num &&
+           a->i_sar_den        == b->i_sar_den &&
+           a->orientation      == b->orientation;
+}
 
 static vout_thread_t *VoutCreate(vlc_object_t *object,
                                  const vout_configuration_t *cfg)
@@ -145,6 +159,8 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
     /* Initialize locks */
     vlc_mutex_init(&vout->p->filter.lock);
     vlc_mutex_init(&vout->p->spu_lock);
+    vlc_mutex_init(&vout->p->prepare.lock);
+    vlc_cond_init(&vout->p->prepare.wait);
 
     /* Take care of some "interface/control" related initialisations */
     vout_IntfInit(vout);
@@ -291,6 +307,8 @@ static void VoutDestructor(vlc_object_t *object)
     free(vout->p->splitter_name);
 
     /* Destroy the locks */
+    vlc_cond_destroy(&vout->p->prepare.wait);
+    vlc_mutex_destroy(&vout->p->prepare.lock);
     vlc_mutex_destroy(&vout->p->spu_lock);
     vlc_mutex_destroy(&vout->p->filter.lock);
     vout_control_Clean(&vout->p->control);
@@ -336,11 +354,20 @@ void vout_Flush(vout_thread_t *vout, mtime_t date)
 
 bool vout_IsEmpty(vout_thread_t *vout)
 {
-    picture_t *picture = picture_fifo_Peek(vout->p->decoder_fifo);
-    if (picture)
+    vout_thread_sys_t *sys = vout->p;
+
+    picture_t *picture = picture_fifo_Peek(sys->decoder_fifo);
+    if (picture) {
         picture_Release(picture);
+        return false;
+    }
 
-    return !picture;
+    /* Pictures taken from the fifo may still wait for their display */
+    vlc_mutex_lock(&sys->prepare.lock);
+    const bool empty = sys->prepare.count == 0 && !sys->prepare.busy &&
+                       !sys->displayed.next;
+    vlc_mutex_unlock(&sys->prepare.lock);
+    return empty;
 }
 
 void vout_NextPicture(vout_thread_t *vout, mtime_t *duration)
@@ -429,6 +456,13 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     {
         picture_fifo_Push(vout->p->decoder_fifo, picture);
 
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        if (vout->p->prepare.running) {
+            vout->p->prepare.wake = true;
+            vlc_cond_broadcast(&vout->p->prepare.wait);
+        }
+        vlc_mutex_unlock(&vout->p->prepare.lock);
+
         vout_control_Wake(&vout->p->control);
     }
     else
@@ -701,15 +735,207 @@ static picture_t *VoutVideoFilterStaticNewPicture(filter_t *filter)
     return picture_NewFromFormat(&filter->fmt_out.video);
 }
 
+/*****************************************************************************
+ * Prepare thread
+ *****************************************************************************
+ * When enabled, the static filters are run on a separate thread up to
+ * prepare.depth pictures ahead of their display, and the subpictures of the
+ * next picture are rendered while the current one is being displayed.
+ *****************************************************************************/
+static void VoutPreparedClean(vout_prepared_t *prepared)
+{
+    if (prepared->picture)
+        picture_Release(prepared->picture);
+    if (prepared->decoded)
+        picture_Release(prepared->decoded);
+}
+
+/* Waits for the prepare thread to be idle and keeps it so until resumed */
+static void ThreadPrepareSuspend(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    sys->prepare.suspended++;
+    while (sys->prepare.busy)
+        vlc_cond_wait(&sys->prepare.wait, &sys->prepare.lock);
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+static void ThreadPrepareResume(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    assert(sys->prepare.suspended > 0);
+    sys->prepare.suspended--;
+    sys->prepare.wake = true;
+    vlc_cond_broadcast(&sys->prepare.wait);
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+/* Releases all the prepared pictures, the prepare thread must be idle */
+static void ThreadPrepareDrain(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    assert(!sys->prepare.busy);
+    while (sys->prepare.count > 0) {
+        VoutPreparedClean(&sys->prepare.queue[sys->prepare.first]);
+        sys->prepare.first = (sys->prepare.first + 1) % VOUT_MAX_PREPARED_PICTURES;
+        sys->prepare.count--;
+    }
+    sys->prepare.blocked = false;
+    sys->prepare.wake    = true;
+    vlc_cond_broadcast(&sys->prepare.wait);
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+/* Releases the prepared pictures dated up to date if below is set, or from
+ * date otherwise, like picture_fifo_Flush(). The prepare thread must be
+ * idle */
+static void ThreadPrepareFlush(vout_thread_t *vout, bool below, mtime_t date)
+{
+    vout_thread_sys_t *sys = vout->p;
+    unsigned kept = 0;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    assert(!sys->prepare.busy);
+    for (unsigned i = 0; i < sys->prepare.count; i++) {
+        vout_prepared_t prepared =
+            sys->prepare.queue[(sys->prepare.first + i) % VOUT_MAX_PREPARED_PICTURES];
+        const mtime_t prepared_date = prepared.decoded ? prepared.decoded->date
+                                                       : prepared.picture->date;
+
+        if (( below && prepared_date <= date) ||
+            (!below && prepared_date >= date))
+            VoutPreparedClean(&prepared);
+        else
+            sys->prepare.queue[(sys->prepare.first + kept++) % VOUT_MAX_PREPARED_PICTURES] =
+                prepared;
+    }
+    sys->prepare.count = kept;
+    /* A format change waiting for the vout thread may have been flushed */
+    sys->prepare.blocked = kept > 0 &&
+        !sys->prepare.queue[(sys->prepare.first + kept - 1) % VOUT_MAX_PREPARED_PICTURES].picture;
+    sys->prepare.wake    = true;
+    vlc_cond_broadcast(&sys->prepare.wait);
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+/* Drops the subpictures rendered ahead, if any */
+static void ThreadPrerenderReset(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    while (sys->prepare.spu.state == VOUT_PRERENDER_RUNNING)
+        vlc_cond_wait(&sys->prepare.wait, &sys->prepare.lock);
+    if (sys->prepare.spu.subpic)
+        subpicture_Delete(sys->prepare.spu.subpic);
+    sys->prepare.spu.subpic = NULL;
+    sys->prepare.spu.state  = VOUT_PRERENDER_NONE;
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+static void VoutCopyChromas(vlc_fourcc_t *dst, size_t size,
+                            const vlc_fourcc_t *src)
+{
+    size_t i = 0;
+    if (src)
+        for (; i < size - 1 && src[i] != 0; i++)
+            dst[i] = src[i];
+    dst[i] = 0;
+}
+
+/* Asks the prepare thread to render the subpictures for the given date */
+static void ThreadPrerenderRequest(vout_thread_t *vout,
+                                   const vlc_fourcc_t *chromas,
+                                   const video_format_t *fmt_dst,
+                                   const video_format_t *fmt_src,
+                                   mtime_t date)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    if (sys->prepare.spu.state != VOUT_PRERENDER_RUNNING) {
+        if (sys->prepare.spu.subpic)
+            subpicture_Delete(sys->prepare.spu.subpic);
+        sys->prepare.spu.subpic = NULL;
+        sys->prepare.spu.state  = VOUT_PRERENDER_REQUESTED;
+        sys->prepare.spu.date   = date;
+        VoutCopyChromas(sys->prepare.spu.chromas,
+                        ARRAY_SIZE(sys->prepare.spu.chromas), chromas);
+        sys->prepare.spu.fmt_dst = *fmt_dst;
+        sys->prepare.spu.fmt_dst.p_palette = NULL;
+        sys->prepare.spu.fmt_src = *fmt_src;
+        sys->prepare.spu.fmt_src.p_palette = NULL;
+        vlc_cond_broadcast(&sys->prepare.wait);
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+/* Retrieves the subpictures rendered ahead for the given date and setup.
+ * It returns false if they must be rendered by the caller. */
+static bool ThreadPrerenderTake(vout_thread_t *vout,
+                                const vlc_fourcc_t *chromas,
+                                const video_format_t *fmt_dst,
+                                const video_format_t *fmt_src,
+                                mtime_t date, bool ignore_osd,
+                                subpicture_t **subpic)
+{
+    vout_thread_sys_t *sys = vout->p;
+    bool taken = false;
+
+    if (!sys->prepare.running)
+        return false;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    /* Older or current requests are not worth waiting for */
+    if (sys->prepare.spu.state == VOUT_PRERENDER_REQUESTED &&
+        sys->prepare.spu.date <= date)
+        sys->prepare.spu.state = VOUT_PRERENDER_NONE;
+    while (sys->prepare.spu.state == VOUT_PRERENDER_RUNNING &&
+           sys->prepare.spu.date == date)
+        vlc_cond_wait(&sys->prepare.wait, &sys->prepare.lock);
+
+    if (sys->prepare.spu.state == VOUT_PRERENDER_DONE &&
+        sys->prepare.spu.date <= date) {
+        vlc_fourcc_t list[ARRAY_SIZE(sys->prepare.spu.chromas)];
+        VoutCopyChromas(list, ARRAY_SIZE(list), chromas);
+
+        taken = !ignore_osd &&
+                sys->prepare.spu.date == date &&
+                !memcmp(list, sys->prepare.spu.chromas, sizeof(list)) &&
+                VideoFormatIsRenderEqual(fmt_dst, &sys->prepare.spu.fmt_dst) &&
+                VideoFormatIsRenderEqual(fmt_src, &sys->prepare.spu.fmt_src) &&
+                sys->prepare.spu.revision == spu_GetRevision(sys->spu);
+        if (taken)
+            *subpic = sys->prepare.spu.subpic;
+        else if (sys->prepare.spu.subpic)
+            subpicture_Delete(sys->prepare.spu.subpic);
+        sys->prepare.spu.subpic = NULL;
+        sys->prepare.spu.state  = VOUT_PRERENDER_NONE;
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
+    return taken;
+}
+
 static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
 {
     if (vout->p->displayed.current)
         picture_Release( vout->p->displayed.current );
     vout->p->displayed.current = NULL;
 
-    if (vout->p->displayed.next)
-        picture_Release( vout->p->displayed.next );
+    vlc_mutex_lock(&vout->p->prepare.lock);
+    picture_t *next = vout->p->displayed.next;
     vout->p->displayed.next = NULL;
+    vlc_mutex_unlock(&vout->p->prepare.lock);
+    if (next)
+        picture_Release(next);
+
+    ThreadPrerenderReset(vout);
 
     if (!is_locked)
         vlc_mutex_lock(&vout->p->filter.lock);
@@ -785,6 +1011,10 @@ static void ThreadChangeFilters(vout_thread_t *vout,
     if (!is_locked)
         vlc_mutex_lock(&vout->p->filter.lock);
 
+    /* Output format of the pictures already prepared */
+    const video_format_t fmt_prepared =
+        filter_chain_GetFmtOut(vout->p->filter.chain_static)->video;
+
     es_format_t fmt_target;
     es_format_InitFromVideo(&fmt_target, source ? source : &vout->p->filter.format);
 
@@ -830,6 +1060,11 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 
     es_format_Clean(&fmt_target);
 
+    /* The prepared pictures are kept, unless the interactive filters cannot
+     * take them anymore */
+    const bool drain = !VideoFormatIsRenderEqual(&fmt_prepared,
+        &filter_chain_GetFmtOut(vout->p->filter.chain_static)->video);
+
     if (vout->p->filter.configuration != filters) {
         free(vout->p->filter.configuration);
         vout->p->filter.configuration = filters ? strdup(filters) : NULL;
@@ -841,11 +1076,56 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 
     if (!is_locked)
         vlc_mutex_unlock(&vout->p->filter.lock);
+
+    if (drain)
+        ThreadPrepareDrain(vout);
 }
 
 
 /* */
-static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
+static bool ThreadIsPictureLate(vout_thread_t *vout, const picture_t *decoded)
+{
+    mtime_t late_threshold;
+    if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
+        late_threshold = ((CLOCK_FREQ/2) * decoded->format.i_frame_rate_base) / decoded->format.i_frame_rate;
+    else
+        late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
+    const mtime_t predicted = mdate() + 0; /* TODO improve */
+    const mtime_t late = predicted - decoded->date;
+    if (late > late_threshold) {
+        msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", late/1000);
+        vout_statistic_AddLost(&vout->p->statistic, 1);
+        return true;
+    } else if (late > 0) {
+        msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", late/1000);
+    }
+    return false;
+}
+
+static void ThreadDisplayQueuePicture(vout_thread_t *vout, picture_t *picture)
+{
+    assert(!vout->p->displayed.next);
+    if (!vout->p->displayed.current)
+        vout->p->displayed.current = picture;
+    else {
+        /* Locked for vout_IsEmpty() */
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        vout->p->displayed.next    = picture;
+        vlc_mutex_unlock(&vout->p->prepare.lock);
+    }
+}
+
+static void ThreadDisplaySetDecoded(vout_thread_t *vout, picture_t *decoded)
+{
+    if (vout->p->displayed.decoded)
+        picture_Release(vout->p->displayed.decoded);
+
+    vout->p->displayed.decoded       = decoded;
+    vout->p->displayed.timestamp     = decoded->date;
+    vout->p->displayed.is_interlaced = !decoded->b_progressive;
+}
+
+static int ThreadDisplayFilterPicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
 {
     bool is_late_dropped = vout->p->is_late_dropped && !vout->p->pause.is_on && !frame_by_frame;
 
@@ -861,22 +1141,10 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
         } else {
             decoded = picture_fifo_Pop(vout->p->decoder_fifo);
             if (decoded) {
-                if (is_late_dropped && !decoded->b_force) {
-                    mtime_t late_threshold;
-                    if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
-                        late_threshold = ((CLOCK_FREQ/2) * decoded->format.i_frame_rate_base) / decoded->format.i_frame_rate;
-                    else
-                        late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
-                    const mtime_t predicted = mdate() + 0; /* TODO improve */
-                    const mtime_t late = predicted - decoded->date;
-                    if (late > late_threshold) {
-                        msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", late/1000);
-                        picture_Release(decoded);
-                        vout_statistic_AddLost(&vout->p->statistic, 1);
-                        continue;
-                    } else if (late > 0) {
-                        msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", late/1000);
-                    }
+                if (is_late_dropped && !decoded->b_force &&
+                    ThreadIsPictureLate(vout, decoded)) {
+                    picture_Release(decoded);
+                    continue;
                 }
                 if (!VideoFormatIsCropArEqual(&decoded->format, &vout->p->filter.format))
                     ThreadChangeFilters(vout, &decoded->format, vout->p->filter.configuration, -1, true);
@@ -887,12 +1155,7 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
             break;
         reuse = false;
 
-        if (vout->p->displayed.decoded)
-            picture_Release(vout->p->displayed.decoded);
-
-        vout->p->displayed.decoded       = picture_Hold(decoded);
-        vout->p->displayed.timestamp     = decoded->date;
-        vout->p->displayed.is_interlaced = !decoded->b_progressive;
+        ThreadDisplaySetDecoded(vout, picture_Hold(decoded));
 
         picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
     }
@@ -902,11 +1165,196 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
     if (!picture)
         return VLC_EGENERIC;
 
-    assert(!vout->p->displayed.next);
-    if (!vout->p->displayed.current)
-        vout->p->displayed.current = picture;
-    else
-        vout->p->displayed.next    = picture;
+    ThreadDisplayQueuePicture(vout, picture);
+    return VLC_SUCCESS;
+}
+
+/* Runs the static filters on the next picture, on the prepare thread */
+static bool ThreadPrepareNext(vout_thread_t *vout, vout_prepared_t *prepared)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *decoded = NULL;
+
+    vlc_mutex_lock(&sys->filter.lock);
+
+    picture_t *picture = filter_chain_VideoFilter(sys->filter.chain_static, NULL);
+    while (!picture) {
+        decoded = picture_fifo_Pop(sys->decoder_fifo);
+        if (!decoded)
+            break;
+        if (sys->is_late_dropped && !decoded->b_force &&
+            ThreadIsPictureLate(vout, decoded)) {
+            picture_Release(decoded);
+            decoded = NULL;
+            continue;
+        }
+        /* The filters are reconfigured by the vout thread */
+        if (!VideoFormatIsCropArEqual(&decoded->format, &sys->filter.format))
+            break;
+
+        picture = filter_chain_VideoFilter(sys->filter.chain_static,
+                                           picture_Hold(decoded));
+        if (!picture) {
+            picture_Release(decoded);
+            decoded = NULL;
+        }
+    }
+
+    vlc_mutex_unlock(&sys->filter.lock);
+
+    prepared->picture = picture;
+    prepared->decoded = decoded;
+    return picture || decoded;
+}
+
+static void ThreadPrerender(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    const mtime_t date = sys->prepare.spu.date;
+    vlc_fourcc_t chromas[ARRAY_SIZE(sys->prepare.spu.chromas)];
+    memcpy(chromas, sys->prepare.spu.chromas, sizeof(chromas));
+    video_format_t fmt_dst = sys->prepare.spu.fmt_dst;
+    video_format_t fmt_src = sys->prepare.spu.fmt_src;
+    sys->prepare.spu.state = VOUT_PRERENDER_RUNNING;
+    vlc_mutex_unlock(&sys->prepare.lock);
+
+    /* The OSD is rendered for the display date too: rendering it for the
+     * current date would miss the subpictures starting until then. Those
+     * put meanwhile change the revision, and are rendered again when the
+     * picture is displayed. */
+    const unsigned revision = spu_GetRevision(sys->spu);
+    subpicture_t *subpic = spu_Render(sys->spu, chromas, &fmt_dst, &fmt_src,
+                                      date, date, false);
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    sys->prepare.spu.subpic   = subpic;
+    sys->prepare.spu.revision = revision;
+    sys->prepare.spu.state    = VOUT_PRERENDER_DONE;
+    vlc_cond_broadcast(&sys->prepare.wait);
+}
+
+static void *PrepareThread(void *object)
+{
+    vout_thread_t *vout = object;
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    for (;;) {
+        while (!sys->prepare.exit &&
+               sys->prepare.spu.state != VOUT_PRERENDER_REQUESTED &&
+               (!sys->prepare.wake || sys->prepare.suspended > 0 ||
+                sys->prepare.paused || sys->prepare.blocked ||
+                sys->prepare.count >= sys->prepare.depth))
+            vlc_cond_wait(&sys->prepare.wait, &sys->prepare.lock);
+        if (sys->prepare.exit)
+            break;
+
+        /* The subpictures are needed first, for the next display */
+        if (sys->prepare.spu.state == VOUT_PRERENDER_REQUESTED) {
+            ThreadPrerender(vout);
+            continue;
+        }
+
+        sys->prepare.wake = false;
+        sys->prepare.busy = true;
+        vlc_mutex_unlock(&sys->prepare.lock);
+
+        vout_prepared_t prepared;
+        const bool has_prepared = ThreadPrepareNext(vout, &prepared);
+
+        vlc_mutex_lock(&sys->prepare.lock);
+        if (has_prepared) {
+            const unsigned index = (sys->prepare.first + sys->prepare.count) %
+                                   VOUT_MAX_PREPARED_PICTURES;
+            sys->prepare.queue[index] = prepared;
+            sys->prepare.count++;
+            sys->prepare.blocked = !prepared.picture;
+            sys->prepare.wake    = true;
+        }
+        sys->prepare.busy = false;
+        vlc_cond_broadcast(&sys->prepare.wait);
+
+        if (has_prepared) {
+            vlc_mutex_unlock(&sys->prepare.lock);
+            vout_control_Wake(&sys->control);
+            vlc_mutex_lock(&sys->prepare.lock);
+        }
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
+    return NULL;
+}
+
+static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
+{
+    vout_thread_sys_t *sys = vout->p;
+    int ret;
+
+    if (!sys->prepare.running)
+        return ThreadDisplayFilterPicture(vout, reuse, frame_by_frame);
+
+    /* Refilter the last decoded picture, as the serial path does */
+    if (reuse && sys->displayed.decoded) {
+        ThreadPrepareSuspend(vout);
+        vlc_mutex_lock(&sys->filter.lock);
+        picture_t *picture =
+            filter_chain_VideoFilter(sys->filter.chain_static,
+                                     picture_Hold(sys->displayed.decoded));
+        vlc_mutex_unlock(&sys->filter.lock);
+        ThreadPrepareResume(vout);
+
+        if (!picture)
+            return VLC_EGENERIC;
+        ThreadDisplayQueuePicture(vout, picture);
+        return VLC_SUCCESS;
+    }
+
+    vout_prepared_t prepared;
+    vlc_mutex_lock(&sys->prepare.lock);
+    const bool has_prepared = sys->prepare.count > 0;
+    if (has_prepared) {
+        prepared = sys->prepare.queue[sys->prepare.first];
+        sys->prepare.first = (sys->prepare.first + 1) % VOUT_MAX_PREPARED_PICTURES;
+        sys->prepare.count--;
+        sys->prepare.wake = true;
+        vlc_cond_broadcast(&sys->prepare.wait);
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
+
+    if (!has_prepared) {
+        /* The prepare thread is idle while paused, frame stepping is done
+         * here */
+        if (!sys->pause.is_on)
+            return VLC_EGENERIC;
+        ThreadPrepareSuspend(vout);
+        ret = ThreadDisplayFilterPicture(vout, false, frame_by_frame);
+        ThreadPrepareResume(vout);
+        return ret;
+    }
+
+    if (prepared.decoded)
+        ThreadDisplaySetDecoded(vout, picture_Hold(prepared.decoded));
+
+    if (!prepared.picture) {
+        /* Format change: reconfigure the filters and filter the picture
+         * here, then let the prepare thread continue */
+        ThreadPrepareSuspend(vout);
+        ThreadChangeFilters(vout, &prepared.decoded->format,
+                            sys->filter.configuration, -1, false);
+        vlc_mutex_lock(&sys->filter.lock);
+        prepared.picture = filter_chain_VideoFilter(sys->filter.chain_static,
+                                                    prepared.decoded);
+        vlc_mutex_unlock(&sys->filter.lock);
+        prepared.decoded = NULL;
+        ThreadPrepareResume(vout);
+
+        if (!prepared.picture)
+            return VLC_EGENERIC;
+    }
+
+    if (prepared.decoded)
+        picture_Release(prepared.decoded);
+    ThreadDisplayQueuePicture(vout, prepared.picture);
     return VLC_SUCCESS;
 }
 
@@ -1054,11 +1502,15 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     video_format_t fmt_spu_rot;
     video_format_ApplyRotation(&fmt_spu_rot, &fmt_spu);
-    subpicture_t *subpic = spu_Render(vout->p->spu,
-                                      subpicture_chromas, &fmt_spu_rot,
-                                      &vd->source,
-                                      render_subtitle_date, render_osd_date,
-                                      do_snapshot);
+    subpicture_t *subpic;
+    if (!ThreadPrerenderTake(vout, subpicture_chromas, &fmt_spu_rot,
+                             &vd->source, render_subtitle_date, do_snapshot,
+                             &subpic))
+        subpic = spu_Render(vout->p->spu,
+                            subpicture_chromas, &fmt_spu_rot,
+                            &vd->source,
+                            render_subtitle_date, render_osd_date,
+                            do_snapshot);
     /*
      * Perform rendering
      *
@@ -1164,6 +1616,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         }
 #endif
 
+    /* Render the subpictures of the next picture while this one waits for
+     * its date and is displayed */
+    if (sys->prepare.running && !sys->pause.is_on &&
+        sys->displayed.next && sys->displayed.next->date > 1)
+        ThreadPrerenderRequest(vout, subpicture_chromas, &fmt_spu_rot,
+                               &vd->source, sys->displayed.next->date);
+
     /* Wait the real date (for rendering jitter) */
 #if 0
     mtime_t delay = todisplay->date - mdate();
@@ -1238,8 +1697,10 @@ static int ThreadDisplayPicture(vout_thread_t *vout, mtime_t *deadline)
 
     if (drop_next_frame) {
         picture_Release(vout->p->displayed.current);
+        vlc_mutex_lock(&vout->p->prepare.lock);
         vout->p->displayed.current = vout->p->displayed.next;
         vout->p->displayed.next    = NULL;
+        vlc_mutex_unlock(&vout->p->prepare.lock);
     }
 
     if (!vout->p->displayed.current)
@@ -1287,6 +1748,24 @@ static void ThreadChangeSubMargin(vout_thread_t *vout, int margin)
     spu_ChangeMargin(vout->p->spu, margin);
 }
 
+/* Shifts the prepared pictures, the prepare thread must be idle */
+static void ThreadPrepareOffsetDate(vout_thread_t *vout, mtime_t duration)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    assert(!sys->prepare.busy);
+    for (unsigned i = 0; i < sys->prepare.count; i++) {
+        vout_prepared_t *prepared =
+            &sys->prepare.queue[(sys->prepare.first + i) % VOUT_MAX_PREPARED_PICTURES];
+        if (prepared->picture)
+            prepared->picture->date += duration;
+        if (prepared->decoded && prepared->decoded != prepared->picture)
+            prepared->decoded->date += duration;
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
 static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
 {
     assert(!vout->p->pause.is_on || !is_paused);
@@ -1301,6 +1780,7 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
         picture_fifo_OffsetDate(vout->p->decoder_fifo, duration);
         if (vout->p->displayed.decoded)
             vout->p->displayed.decoded->date += duration;
+        ThreadPrepareOffsetDate(vout, duration);
         spu_OffsetSubtitleDate(vout->p->spu, duration);
 
         ThreadFilterFlush(vout, false);
@@ -1311,6 +1791,10 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
     vout->p->pause.is_on = is_paused;
     vout->p->pause.date  = date;
 
+    vlc_mutex_lock(&vout->p->prepare.lock);
+    vout->p->prepare.paused = is_paused;
+    vlc_mutex_unlock(&vout->p->prepare.lock);
+
     vout_window_t *window = vout->p->window;
     if (window != NULL)
         vout_window_SetInhibition(window, !is_paused);
@@ -1322,6 +1806,7 @@ static void ThreadFlush(vout_thread_t *vout, bool below, mtime_t date)
     vout->p->step.last      = VLC_TS_INVALID;
 
     ThreadFilterFlush(vout, false); /* FIXME too much */
+    ThreadPrepareFlush(vout, below, date);
 
     picture_t *last = vout->p->displayed.decoded;
     if (last) {
@@ -1550,6 +2035,27 @@ static int ThreadStart(vout_thread_t *vout, vout_display_state_t *state)
     vout->p->spu_blend_chroma        = 0;
     vout->p->spu_blend               = NULL;
 
+    vout->p->prepare.exit            = false;
+    vout->p->prepare.wake            = true;
+    vout->p->prepare.busy            = false;
+    vout->p->prepare.paused          = false;
+    vout->p->prepare.blocked         = false;
+    vout->p->prepare.suspended       = 0;
+    vout->p->prepare.first           = 0;
+    vout->p->prepare.count           = 0;
+    vout->p->prepare.spu.state       = VOUT_PRERENDER_NONE;
+    vout->p->prepare.spu.subpic      = NULL;
+    if (vout->p->prepare.depth > 0) {
+        if (vlc_clone(&vout->p->prepare.thread, PrepareThread, vout,
+                      VLC_THREAD_PRIORITY_VIDEO))
+            msg_Err(vout, "cannot start the prepare thread");
+        else {
+            vlc_mutex_lock(&vout->p->prepare.lock);
+            vout->p->prepare.running = true;
+            vlc_mutex_unlock(&vout->p->prepare.lock);
+        }
+    }
+
     video_format_Print(VLC_OBJECT(vout), "original format", &vout->p->original);
     return VLC_SUCCESS;
 error:
@@ -1568,6 +2074,21 @@ error:
 
 static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
 {
+    if (vout->p->prepare.running) {
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        vout->p->prepare.exit = true;
+        vlc_cond_broadcast(&vout->p->prepare.wait);
+        vlc_mutex_unlock(&vout->p->prepare.lock);
+
+        vlc_join(vout->p->prepare.thread, NULL);
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        vout->p->prepare.running = false;
+        vlc_mutex_unlock(&vout->p->prepare.lock);
+
+        ThreadPrepareDrain(vout);
+        ThreadPrerenderReset(vout);
+    }
+
     if (vout->p->spu_blend)
         filter_DeleteBlend(vout->p->spu_blend);
 
@@ -1596,6 +2117,8 @@ static void ThreadInit(vout_thread_t *vout)
 {
     vout->p->dead            = false;
     vout->p->is_late_dropped = var_InheritBool(vout, "drop-late-frames");
+    vout->p->prepare.depth   = __MIN(__MAX(var_InheritInteger(vout, "video-prepare-depth"), 0),
+                                     VOUT_MAX_PREPARED_PICTURES);
     vout->p->pause.is_on     = false;
     vout->p->pause.date      = VLC_TS_INVALID;
 
@@ -1680,6 +2203,17 @@ static void ThreadCancel(vout_thread_t *vout, bool canceled)
 
 static int ThreadControl(vout_thread_t *vout, vout_control_cmd_t cmd)
 {
+    /* These commands modify the filters or the pictures waiting for display,
+     * the prepare thread must not run meanwhile */
+    const bool suspend = vout->p->prepare.running &&
+                         (cmd.type == VOUT_CONTROL_CHANGE_FILTERS ||
+                          cmd.type == VOUT_CONTROL_CHANGE_INTERLACE ||
+                          cmd.type == VOUT_CONTROL_PAUSE ||
+                          cmd.type == VOUT_CONTROL_FLUSH ||
+                          cmd.type == VOUT_CONTROL_STEP);
+    if (suspend)
+        ThreadPrepareSuspend(vout);
+
     switch(cmd.type) {
     case VOUT_CONTROL_INIT:
         ThreadInit(vout);
@@ -1775,6 +2309,8 @@ static int ThreadControl(vout_thread_t *vout, vout_control_cmd_t cmd)
     default:
         break;
     }
+    if (suspend)
+        ThreadPrepareResume(vout);
     vout_control_cmd_Clean(&cmd);
     return 0;
 }
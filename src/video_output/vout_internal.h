@@ -43,6 +43,25 @@
  */
 #define VOUT_MAX_PICTURES (20)
 
+/* Maximum number of pictures that can be prepared ahead of their display by
+ * the prepare thread.
+ */
+#define VOUT_MAX_PREPARED_PICTURES (8)
+
+/* Picture prepared by the prepare thread */
+typedef struct {
+    picture_t   *picture;   /* filtered picture, NULL on format change */
+    picture_t   *decoded;   /* decoded picture it comes from if any */
+} vout_prepared_t;
+
+/* State of the subpicture rendering done ahead by the prepare thread */
+enum {
+    VOUT_PRERENDER_NONE,
+    VOUT_PRERENDER_REQUESTED,
+    VOUT_PRERENDER_RUNNING,
+    VOUT_PRERENDER_DONE,
+};
+
 /* */
 struct vout_thread_sys_t
 {
@@ -127,6 +146,39 @@ struct vout_thread_sys_t
         bool            has_deint;
     } filter;
 
+    /* Pipelined prepare stage: static filtering and subpicture rendering of
+     * the next pictures run on a separate thread */
+    struct {
+        unsigned        depth;      /* 0 if disabled */
+        bool            running;
+        vlc_thread_t    thread;
+        vlc_mutex_t     lock;
+        vlc_cond_t      wait;
+
+        bool            exit;
+        bool            wake;       /* new input or room available */
+        bool            busy;       /* the thread is preparing a picture */
+        bool            paused;
+        bool            blocked;    /* waiting for filters reconfiguration */
+        unsigned        suspended;
+
+        vout_prepared_t queue[VOUT_MAX_PREPARED_PICTURES];
+        unsigned        first;
+        unsigned        count;
+
+        /* Subpictures of the next picture, rendered while the current one
+         * is displayed */
+        struct {
+            int             state;
+            mtime_t         date;
+            unsigned        revision;
+            vlc_fourcc_t    chromas[16];
+            video_format_t  fmt_dst;
+            video_format_t  fmt_src;
+            subpicture_t    *subpic;
+        } spu;
+    } prepare;
+
     /* */
     vlc_mouse_t     mouse;
 
@@ -168,5 +220,6 @@ void vout_ManageWrapper(vout_thread_t *);
 int spu_ProcessMouse(spu_t *, const vlc_mouse_t *, const video_format_t *);
 void spu_Attach( spu_t *, vlc_object_t *input, bool );
 void spu_ChangeMargin(spu_t *, int);
+unsigned spu_GetRevision(spu_t *);
 
 #endif
@@ -61,6 +61,42 @@ typedef struct {
     spu_heap_entry_t entry[VOUT_MAX_SUBPICTURES];
 } spu_heap_t;
 
+/* Number of rendered text regions kept around */
+#define SPU_TEXT_CACHE_SIZE (8)
+#define SPU_TEXT_CACHE_CHROMAS (8)
+
+/* */
+typedef struct {
+    /* Key */
+    text_segment_t *text;                 /**< copy of the source segments */
+    video_format_t fmt_src;              /**< region format before render */
+    int            x_src;                /**< region position before render */
+    int            y_src;
+    int            align;
+    int            text_align;
+    bool           noregionbg;
+    bool           gridmode;
+    bool           balanced_text;
+    int            max_width;
+    int            max_height;
+    unsigned       width;                /**< text renderer output size */
+    unsigned       height;
+    int            text_scale;
+    vlc_fourcc_t   chroma[SPU_TEXT_CACHE_CHROMAS + 1];
+
+    /* Value */
+    video_format_t fmt;                       /**< rendered region format */
+    picture_t      *picture;                /**< rendered region picture */
+    int            x;                       /**< rendered region position */
+    int            y;
+    uint64_t       last_use;
+} spu_text_cache_entry_t;
+
+typedef struct {
+    spu_text_cache_entry_t entry[SPU_TEXT_CACHE_SIZE];
+    uint64_t               counter;
+} spu_text_cache_t;
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     vlc_object_t *input;
@@ -71,6 +107,7 @@ struct spu_private_t {
     filter_t *text;                              /**< text renderer module */
     filter_t *scale_yuvp;                     /**< scaling module for YUVP */
     filter_t *scale;                    /**< scaling module (all but YUVP) */
+    spu_text_cache_t text_cache;              /**< rendered text regions */
     bool force_crop;                     /**< force cropping of subpicture */
     struct {
         int x;
@@ -96,6 +133,7 @@ struct spu_private_t {
     /* */
     mtime_t             last_sort_date;
     vout_thread_t       *vout;
+    unsigned            revision;    /**< bumped whenever the setup changes */
 };
 
 /*****************************************************************************
@@ -159,6 +197,214 @@ static void SpuHeapClean(spu_heap_t *heap)
     }
 }
 
+/*****************************************************************************
+ * rendered text cache
+ *****************************************************************************
+ * Text regions are regenerated by their updater whenever the output format
+ * changes or an animation step is due, and some decoders (closed captions)
+ * resend the same text in new subpictures. Keep the last rendered pictures
+ * keyed by text, style and target size so that identical text is laid out
+ * and rasterized only once.
+ *****************************************************************************/
+static void SpuTextCacheEntryClean(spu_text_cache_entry_t *e)
+{
+    if (e->picture)
+        picture_Release(e->picture);
+    text_segment_ChainDelete(e->text);
+    video_format_Clean(&e->fmt);
+    e->picture = NULL;
+    e->text = NULL;
+}
+
+static void SpuTextCacheInit(spu_text_cache_t *cache)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *e = &cache->entry[i];
+
+        e->text    = NULL;
+        e->picture = NULL;
+        video_format_Init(&e->fmt, 0);
+    }
+    cache->counter = 0;
+}
+
+static void SpuTextCacheClean(spu_text_cache_t *cache)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++)
+        SpuTextCacheEntryClean(&cache->entry[i]);
+}
+
+static bool SpuTextStyleIsEqual(const text_style_t *a, const text_style_t *b)
+{
+    if (a == b)
+        return true;
+    if (!a || !b)
+        return false;
+
+    return a->i_features                 == b->i_features &&
+           a->i_style_flags              == b->i_style_flags &&
+           a->f_font_relsize             == b->f_font_relsize &&
+           a->i_font_size                == b->i_font_size &&
+           a->i_font_color               == b->i_font_color &&
+           a->i_font_alpha               == b->i_font_alpha &&
+           a->i_spacing                  == b->i_spacing &&
+           a->i_outline_color            == b->i_outline_color &&
+           a->i_outline_alpha            == b->i_outline_alpha &&
+           a->i_outline_width            == b->i_outline_width &&
+           a->i_shadow_color             == b->i_shadow_color &&
+           a->i_shadow_alpha             == b->i_shadow_alpha &&
+           a->i_shadow_width             == b->i_shadow_width &&
+           a->i_background_color         == b->i_background_color &&
+           a->i_background_alpha         == b->i_background_alpha &&
+           a->i_karaoke_background_color == b->i_karaoke_background_color &&
+           a->i_karaoke_background_alpha == b->i_karaoke_background_alpha &&
+           a->e_wrapinfo                 == b->e_wrapinfo &&
+           !strcmp(a->psz_fontname ? a->psz_fontname : "",
+                   b->psz_fontname ? b->psz_fontname : "") &&
+           !strcmp(a->psz_monofontname ? a->psz_monofontname : "",
+                   b->psz_monofontname ? b->psz_monofontname : "");
+}
+
+static bool SpuTextSegmentIsEqual(const text_segment_t *a,
+                                  const text_segment_t *b)
+{
+    for (; a && b; a = a->p_next, b = b->p_next) {
+        if (strcmp(a->psz_text ? a->psz_text : "",
+                   b->psz_text ? b->psz_text : "") ||
+            !SpuTextStyleIsEqual(a->style, b->style))
+            return false;
+    }
+    return a == NULL && b == NULL;
+}
+
+static bool SpuTextCacheMatch(const spu_text_cache_entry_t *e,
+                              const subpicture_region_t *region,
+                              unsigned width, unsigned height,
+                              int text_scale,
+                              const vlc_fourcc_t *chroma_list)
+{
+    const video_format_t *fmt = &region->fmt;
+
+    if (!e->picture ||
+        e->width != width || e->height != height ||
+        e->text_scale != text_scale ||
+        e->x_src != region->i_x || e->y_src != region->i_y ||
+        e->align != region->i_align ||
+        e->text_align != region->i_text_align ||
+        e->noregionbg != region->b_noregionbg ||
+        e->gridmode != region->b_gridmode ||
+        e->balanced_text != region->b_balanced_text ||
+        e->max_width != region->i_max_width ||
+        e->max_height != region->i_max_height ||
+        e->fmt_src.i_width != fmt->i_width ||
+        e->fmt_src.i_height != fmt->i_height ||
+        e->fmt_src.i_visible_width != fmt->i_visible_width ||
+        e->fmt_src.i_visible_height != fmt->i_visible_height ||
+        e->fmt_src.i_x_offset != fmt->i_x_offset ||
+        e->fmt_src.i_y_offset != fmt->i_y_offset ||
+        e->fmt_src.i_sar_num != fmt->i_sar_num ||
+        e->fmt_src.i_sar_den != fmt->i_sar_den ||
+        e->fmt_src.transfer != fmt->transfer ||
+        e->fmt_src.primaries != fmt->primaries ||
+        e->fmt_src.space != fmt->space)
+        return false;
+
+    for (int i = 0; i <= SPU_TEXT_CACHE_CHROMAS; i++) {
+        if (e->chroma[i] != chroma_list[i])
+            return false;
+        if (!chroma_list[i])
+            break;
+    }
+
+    return SpuTextSegmentIsEqual(e->text, region->p_text);
+}
+
+static bool SpuTextCacheGet(spu_text_cache_t *cache,
+                            subpicture_region_t *region,
+                            unsigned width, unsigned height, int text_scale,
+                            const vlc_fourcc_t *chroma_list)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *e = &cache->entry[i];
+
+        if (!SpuTextCacheMatch(e, region, width, height, text_scale,
+                               chroma_list))
+            continue;
+
+        video_format_t fmt;
+        if (video_format_Copy(&fmt, &e->fmt) != VLC_SUCCESS)
+            return false;
+
+        if (region->p_picture)
+            picture_Release(region->p_picture);
+        region->p_picture = picture_Hold(e->picture);
+        video_format_Clean(&region->fmt);
+        region->fmt = fmt;
+        /* the renderer moves the region to the text bounding box */
+        region->i_x = e->x;
+        region->i_y = e->y;
+
+        e->last_use = ++cache->counter;
+        return true;
+    }
+    return false;
+}
+
+static void SpuTextCachePut(spu_text_cache_t *cache,
+                            const video_format_t *fmt_src,
+                            int x_src, int y_src,
+                            const subpicture_region_t *region,
+                            unsigned width, unsigned height, int text_scale,
+                            const vlc_fourcc_t *chroma_list)
+{
+    int i_chroma_count = 0;
+    while (chroma_list[i_chroma_count])
+        if (++i_chroma_count > SPU_TEXT_CACHE_CHROMAS)
+            return;
+
+    /* Replace the least recently used entry */
+    spu_text_cache_entry_t *e = &cache->entry[0];
+    for (int i = 1; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *c = &cache->entry[i];
+
+        if (!e->picture)
+            break;
+        if (!c->picture || c->last_use < e->last_use)
+            e = c;
+    }
+    SpuTextCacheEntryClean(e);
+
+    text_segment_t *text = text_segment_Copy(region->p_text);
+    if (!text)
+        return;
+    if (video_format_Copy(&e->fmt, &region->fmt) != VLC_SUCCESS) {
+        video_format_Init(&e->fmt, 0);
+        text_segment_ChainDelete(text);
+        return;
+    }
+
+    e->text          = text;
+    e->fmt_src       = *fmt_src;
+    e->fmt_src.p_palette = NULL;
+    e->x_src         = x_src;
+    e->y_src         = y_src;
+    e->align         = region->i_align;
+    e->text_align    = region->i_text_align;
+    e->noregionbg    = region->b_noregionbg;
+    e->gridmode      = region->b_gridmode;
+    e->balanced_text = region->b_balanced_text;
+    e->max_width     = region->i_max_width;
+    e->max_height    = region->i_max_height;
+    e->width         = width;
+    e->height        = height;
+    e->text_scale    = text_scale;
+    memcpy(e->chroma, chroma_list, (i_chroma_count + 1) * sizeof(*chroma_list));
+    e->picture       = picture_Hold(region->p_picture);
+    e->x             = region->i_x;
+    e->y             = region->i_y;
+    e->last_use      = ++cache->counter;
+}
+
 static void FilterRelease(filter_t *filter)
 {
     if (filter->p_module)
@@ -275,12 +521,33 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
      * least show up on screen, but the effect won't change
      * the text over time.
      */
+    const unsigned width  = text->fmt_out.video.i_visible_width;
+    const unsigned height = text->fmt_out.video.i_visible_height;
+    const int text_scale  = var_InheritInteger(text, "sub-text-scale");
+
+    if (region->p_text &&
+        SpuTextCacheGet(&spu->p->text_cache, region, width, height,
+                        text_scale, chroma_list)) {
+        *rerender_text = false;
+        return;
+    }
+
+    const video_format_t fmt_src = region->fmt;
+    const int x_src = region->i_x;
+    const int y_src = region->i_y;
+
     var_SetInteger(text, "spu-elapsed", elapsed_time);
     var_SetBool(text, "text-rerender", false);
 
     if ( region->p_text )
         text->pf_render(text, region, region, chroma_list);
     *rerender_text = var_GetBool(text, "text-rerender");
+
+    /* Time dependent renderings (karaoke) cannot be reused */
+    if (!*rerender_text && region->p_text && region->p_picture &&
+        region->fmt.i_chroma != VLC_CODEC_TEXT)
+        SpuTextCachePut(&spu->p->text_cache, &fmt_src, x_src, y_src, region,
+                        width, height, text_scale, chroma_list);
 }
 
 /**
@@ -1162,6 +1429,7 @@ static void UpdateSPU(spu_t *spu, vlc_object_t *object)
 
     sys->force_palette = false;
     sys->force_crop = false;
+    sys->revision++;
 
     if (var_Get(object, "highlight", &val) || !val.b_bool) {
         vlc_mutex_unlock(&sys->lock);
@@ -1306,6 +1574,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     vlc_mutex_init(&sys->lock);
 
     SpuHeapInit(&sys->heap);
+    SpuTextCacheInit(&sys->text_cache);
 
     sys->text = NULL;
     sys->scale = NULL;
@@ -1338,6 +1607,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
 
     /* */
     sys->last_sort_date = -1;
+    sys->revision = 0;
     sys->vout = vout;
 
     return spu;
@@ -1379,6 +1649,7 @@ void spu_Destroy(spu_t *spu)
 
     /* Destroy all remaining subpictures */
     SpuHeapClean(&sys->heap);
+    SpuTextCacheClean(&sys->text_cache);
 
     vlc_mutex_destroy(&sys->lock);
 
@@ -1430,6 +1701,10 @@ int spu_ProcessMouse(spu_t *spu,
     filter_chain_MouseEvent(sys->source_chain, mouse, fmt);
     vlc_mutex_unlock(&sys->source_chain_lock);
 
+    vlc_mutex_lock(&sys->lock);
+    sys->revision++;
+    vlc_mutex_unlock(&sys->lock);
+
     return VLC_SUCCESS;
 }
 
@@ -1520,6 +1795,7 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
         subpicture_Delete(subpic);
         return;
     }
+    sys->revision++;
     vlc_mutex_unlock(&sys->lock);
 }
 
@@ -1635,6 +1911,7 @@ void spu_OffsetSubtitleDate(spu_t *spu, mtime_t duration)
                 current->i_stop  += duration;
         }
     }
+    sys->revision++;
     vlc_mutex_unlock(&sys->lock);
 }
 
@@ -1667,6 +1944,7 @@ void spu_ClearChannel(spu_t *spu, int channel)
         /* You cannot delete subpicture outside of SpuSelectSubpictures */
         entry->reject = true;
     }
+    sys->revision++;
 
     vlc_mutex_unlock(&sys->lock);
 }
@@ -1686,6 +1964,7 @@ void spu_ChangeSources(spu_t *spu, const char *filters)
     }
     else if (sys->source_chain_current)
         sys->source_chain_update = strdup(sys->source_chain_current);
+    sys->revision++;
 
     vlc_mutex_unlock(&sys->lock);
 }
@@ -1705,6 +1984,7 @@ void spu_ChangeFilters(spu_t *spu, const char *filters)
     }
     else if (sys->filter_chain_current)
         sys->filter_chain_update = strdup(sys->filter_chain_current);
+    sys->revision++;
 
     vlc_mutex_unlock(&sys->lock);
 }
@@ -1715,6 +1995,22 @@ void spu_ChangeMargin(spu_t *spu, int margin)
 
     vlc_mutex_lock(&sys->lock);
     sys->margin = margin;
+    sys->revision++;
+    vlc_mutex_unlock(&sys->lock);
+}
+
+/**
+ * Returns a counter that changes whenever something that affects the output
+ * of spu_Render(), other than the dates, may have changed.
+ */
+unsigned spu_GetRevision(spu_t *spu)
+{
+    spu_private_t *sys = spu->p;
+
+    vlc_mutex_lock(&sys->lock);
+    unsigned revision = sys->revision;
     vlc_mutex_unlock(&sys->lock);
+
+    return revision;
 }
 